@@ -0,0 +1,1190 @@
+/*
+** Memory manager benchmark. This replays allocation traces against
+** both the red-black tree allocator and the two-level segregated
+** fit allocator, and reports the average time per operation.
+**
+** Usage: memoryBench [-r repeats] [-h heap MiB] [-s seed] [-t threads] [trace...]
+**
+** Traces can either be files recorded by the global memory manager
+** when MEMORY_GLOBAL_MANAGER_TRACE is defined, or one of the built-in
+** synthetic traces "particles", "models" and "mixed". If no traces are
+** specified, all of the synthetic ones are run. Every block's first
+** word is checked whenever it is resized or freed, so the benchmark
+** will also report any allocator that loses the user's data.
+**
+** The "contention" trace instead has 1 to "threads" threads (16 by
+** default) allocating and freeing small blocks at the same time. It
+** compares a tree behind a single lock, which is how the global
+** memory manager used to work, with the global memory manager. It
+** also compares a pool behind a single lock with a lock-free pool,
+** both with and without per-thread magazines. The pools' blocks are
+** all the size of the largest block used by the other allocators.
+**
+** The "stress" trace uses the same threads on the lock-free pool,
+** but fills each block with a value unique to its allocation and
+** checks it before the block is freed. Afterwards, every block is
+** taken from the pool to make sure that none were lost or returned
+** twice. It isn't run unless it's specified.
+**
+** This only uses the memory and threading code, so it can be built with
+** "make membench" without SDL or OpenGL.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "settingsMemory.h"
+
+#include "memoryManager.h"
+#include "memoryPool.h"
+#include "memoryTree.h"
+#include "memoryTLSF.h"
+#include "thread.h"
+#include "timer.h"
+#include "utilTypes.h"
+
+
+#define BENCH_DEFAULT_NUM_REPEATS 5
+#define BENCH_DEFAULT_HEAPSIZE    256
+#define BENCH_DEFAULT_RANDOM_SEED 12345
+
+#define BENCH_OP_ALLOC   'a'
+#define BENCH_OP_RESIZE  'r'
+#define BENCH_OP_REALLOC 'z'
+#define BENCH_OP_FREE    'f'
+
+// Addresses are always aligned, so this
+// can never be a valid block's address.
+#define BENCH_ADDRESS_EMPTY   0
+#define BENCH_ADDRESS_REMOVED 1
+
+#define BENCH_PARTICLE_MAX_LIVE 4096
+#define BENCH_PARTICLE_STEPS    200
+#define BENCH_MODEL_COUNT       200
+#define BENCH_MODEL_MAX_LIVE    24
+#define BENCH_MIXED_MAX_LIVE    2000
+#define BENCH_MIXED_NUM_OPS     200000
+
+#define BENCH_CONTENTION_MAX_THREADS 16
+#define BENCH_CONTENTION_NUM_OPS     500000
+#define BENCH_CONTENTION_MAX_LIVE    64
+#define BENCH_CONTENTION_MIN_SIZE    16
+#define BENCH_CONTENTION_MAX_SIZE    256
+#define BENCH_CONTENTION_POOL_BLOCKS \
+	(BENCH_CONTENTION_MAX_THREADS * (BENCH_CONTENTION_MAX_LIVE + MEMORY_MAGAZINE_SIZE))
+
+#define BENCH_STRESS_NUM_REPEATS 10
+#define BENCH_STRESS_NUM_WORDS   (BENCH_CONTENTION_MAX_SIZE/sizeof(size_t))
+
+
+// Blocks are referred to by the index of the allocation that
+// created them, so traces don't depend on where memory is.
+typedef struct benchOp {
+	byte_t type;
+	size_t slot;
+	size_t size;
+} benchOp;
+
+typedef struct benchTrace {
+	const char *name;
+	benchOp *ops;
+	size_t numOps;
+	size_t capacity;
+	size_t numSlots;
+} benchTrace;
+
+typedef struct benchAllocator {
+	const char *name;
+	void *(*init)(void *const restrict allocator, void *const restrict memory, const size_t memorySize);
+	void *(*alloc)(void *const restrict allocator, const size_t blockSize);
+	void *(*resize)(void *const restrict allocator, void *const restrict block, const size_t blockSize);
+	void *(*realloc)(void *const restrict allocator, void *const restrict block, const size_t blockSize);
+	void (*free)(void *const restrict allocator, void *const restrict block);
+} benchAllocator;
+
+typedef struct benchResult {
+	float bestTime;
+	float totalTime;
+	size_t numFailed;
+	size_t numCorrupt;
+} benchResult;
+
+// Each of the contention benchmark's threads uses one of these.
+typedef struct benchContentionArgs {
+	void *(*alloc)(const size_t blockSize);
+	void (*free)(void *const restrict block);
+	uint_least32_t seed;
+	size_t numFailed;
+	// This is only used by the stress test.
+	size_t numCorrupt;
+} benchContentionArgs;
+
+// Maps the addresses in a recorded trace to slots.
+typedef struct benchAddressEntry {
+	uintptr_t address;
+	size_t slot;
+} benchAddressEntry;
+
+typedef struct benchAddressTable {
+	benchAddressEntry *entries;
+	size_t capacity;
+	// Removed entries still count as being used.
+	size_t numUsed;
+} benchAddressTable;
+
+
+// Forward-declare any helper functions!
+static void runTrace(const benchTrace *const restrict trace, const size_t numRepeats, const size_t heapSize);
+static void replayTrace(
+	const benchAllocator *const restrict allocator, const benchTrace *const restrict trace,
+	void *const restrict memory, const size_t heapSize, void **const restrict blocks, benchResult *const restrict result
+);
+
+static void runContention(const size_t maxThreads, const size_t heapSize, const uint_least32_t seed);
+static float timeContention(
+	benchContentionArgs *const restrict args, const size_t numThreads, const uint_least32_t seed,
+	const threadFunction mainFunc, void *(*const allocFunc)(const size_t blockSize),
+	void (*const freeFunc)(void *const restrict block), size_t *const restrict numFailed
+);
+static threadReturn_t THREAD_CALL contentionMain(void *const arg);
+static void runStress(const size_t maxThreads, const uint_least32_t seed);
+static size_t stressCheckPool(benchContentionArgs *const restrict args, const size_t numThreads, const size_t numBlocks);
+static size_t concurrentPoolDrain();
+static threadReturn_t THREAD_CALL stressMain(void *const arg);
+static byte_t stressFree(const benchContentionArgs *const restrict args, void *const restrict block, const size_t stamp);
+static void *lockedAlloc(const size_t blockSize);
+static void lockedFree(void *const restrict block);
+static void *lockedPoolAlloc(const size_t blockSize);
+static void lockedPoolFree(void *const restrict block);
+static void *concurrentPoolAlloc(const size_t blockSize);
+static void concurrentPoolFree(void *const restrict block);
+static void *magazinePoolAlloc(const size_t blockSize);
+static void magazinePoolFree(void *const restrict block);
+
+static return_t loadTrace(benchTrace *const restrict trace, const char *const restrict path);
+static benchAddressEntry *addressTableFind(const benchAddressTable *const restrict table, const uintptr_t address);
+static return_t addressTableInsert(benchAddressTable *const restrict table, const uintptr_t address, const size_t slot);
+static void addressTableRemove(const benchAddressTable *const restrict table, const uintptr_t address);
+
+static void buildParticles(benchTrace *const restrict trace);
+static void buildModels(benchTrace *const restrict trace);
+static void buildMixed(benchTrace *const restrict trace);
+static size_t randomSize(const size_t minLog2, const size_t maxLog2);
+
+static return_t traceInit(benchTrace *const restrict trace, const char *const restrict name);
+static return_t traceAdd(benchTrace *const restrict trace, const byte_t type, const size_t slot, const size_t size);
+static void traceDelete(benchTrace *const restrict trace);
+
+static void *treeInit(void *const restrict allocator, void *const restrict memory, const size_t memorySize);
+static void *treeAlloc(void *const restrict allocator, const size_t blockSize);
+static void *treeResize(void *const restrict allocator, void *const restrict block, const size_t blockSize);
+static void *treeRealloc(void *const restrict allocator, void *const restrict block, const size_t blockSize);
+static void treeFree(void *const restrict allocator, void *const restrict block);
+static void *tlsfInit(void *const restrict allocator, void *const restrict memory, const size_t memorySize);
+static void *tlsfAlloc(void *const restrict allocator, const size_t blockSize);
+static void *tlsfResize(void *const restrict allocator, void *const restrict block, const size_t blockSize);
+static void *tlsfRealloc(void *const restrict allocator, void *const restrict block, const size_t blockSize);
+static void tlsfFree(void *const restrict allocator, void *const restrict block);
+
+static void randomSeed(const uint_least32_t seed);
+static uint_least32_t randomInt(const uint_least32_t max);
+static uint_least32_t randomNext(uint_least32_t *const restrict state, const uint_least32_t max);
+
+
+static const benchAllocator allocators[] = {
+	{
+		.name = "tree", .init = &treeInit, .alloc = &treeAlloc,
+		.resize = &treeResize, .realloc = &treeRealloc, .free = &treeFree
+	},
+	{
+		.name = "tlsf", .init = &tlsfInit, .alloc = &tlsfAlloc,
+		.resize = &tlsfResize, .realloc = &tlsfRealloc, .free = &tlsfFree
+	}
+};
+#define BENCH_NUM_ALLOCATORS (sizeof(allocators)/sizeof(*allocators))
+
+static const struct {
+	const char *name;
+	void (*build)(benchTrace *const restrict trace);
+} synthetics[] = {
+	{.name = "particles", .build = &buildParticles},
+	{.name = "models",    .build = &buildModels},
+	{.name = "mixed",     .build = &buildMixed}
+};
+#define BENCH_NUM_SYNTHETICS (sizeof(synthetics)/sizeof(*synthetics))
+
+static uint_least32_t randomState;
+
+// The contention benchmark's baseline allocators.
+static memoryTree lockedTree;
+static threadMutex lockedTreeLock;
+static memoryPool lockedPool;
+static threadMutex lockedPoolLock;
+// These are compared with the pools above.
+static memoryPoolConcurrent concurrentPool;
+static _Thread_local memoryMagazine poolMagazine;
+
+
+int main(int argc, char **argv){
+	size_t numRepeats = BENCH_DEFAULT_NUM_REPEATS;
+	size_t heapSize = BENCH_DEFAULT_HEAPSIZE * MEMORY_MEBIBYTE;
+	uint_least32_t seed = BENCH_DEFAULT_RANDOM_SEED;
+	size_t maxThreads = BENCH_CONTENTION_MAX_THREADS;
+	byte_t traceSpecified = 0;
+	benchTrace trace;
+	int i;
+
+
+	timerInit();
+
+	for(i = 1; i < argc; ++i){
+		const char *const arg = argv[i];
+
+		if(arg[0] == '-' && i + 1 < argc){
+			const size_t value = strtoul(argv[++i], NULL, 10);
+
+			switch(arg[1]){
+				case 'r':
+					numRepeats = (value > 0) ? value : 1;
+				break;
+				case 'h':
+					heapSize = value * MEMORY_MEBIBYTE;
+				break;
+				case 's':
+					seed = value;
+				break;
+				case 't':
+					maxThreads = (value < 1) ? 1 : (value > BENCH_CONTENTION_MAX_THREADS) ? BENCH_CONTENTION_MAX_THREADS : value;
+				break;
+				default:
+					printf("Ignoring unknown option '%s'.\n", arg);
+			}
+		}else if(strcmp(arg, "contention") == 0){
+			runContention(maxThreads, heapSize, seed);
+			traceSpecified = 1;
+		}else if(strcmp(arg, "stress") == 0){
+			runStress(maxThreads, seed);
+			traceSpecified = 1;
+		}else{
+			size_t j;
+			for(j = 0; j < BENCH_NUM_SYNTHETICS; ++j){
+				if(strcmp(arg, synthetics[j].name) == 0){
+					if(traceInit(&trace, arg)){
+						randomSeed(seed);
+						synthetics[j].build(&trace);
+						runTrace(&trace, numRepeats, heapSize);
+						traceDelete(&trace);
+					}
+					break;
+				}
+			}
+			// If it isn't a synthetic trace, it should be a file.
+			if(j == BENCH_NUM_SYNTHETICS){
+				if(loadTrace(&trace, arg)){
+					runTrace(&trace, numRepeats, heapSize);
+					traceDelete(&trace);
+				}else{
+					printf("Unable to load trace '%s'!\n", arg);
+				}
+			}
+			traceSpecified = 1;
+		}
+	}
+
+	// If no traces were specified, run all of the synthetic ones.
+	if(!traceSpecified){
+		size_t j;
+		for(j = 0; j < BENCH_NUM_SYNTHETICS; ++j){
+			if(traceInit(&trace, synthetics[j].name)){
+				randomSeed(seed);
+				synthetics[j].build(&trace);
+				runTrace(&trace, numRepeats, heapSize);
+				traceDelete(&trace);
+			}
+		}
+		runContention(maxThreads, heapSize, seed);
+	}
+
+
+	return(0);
+}
+
+
+/*
+** Replay a trace against each of the allocators "numRepeats"
+** times. Each replay starts from a freshly initialized heap,
+** so the allocators always start in the same state.
+*/
+static void runTrace(const benchTrace *const restrict trace, const size_t numRepeats, const size_t heapSize){
+	void *const memory = malloc(heapSize);
+	void **const blocks = malloc(trace->numSlots * sizeof(*blocks));
+	size_t i;
+
+	if(memory == NULL || blocks == NULL){
+		printf("Unable to allocate memory for trace '%s'!\n", trace->name);
+		free(memory);
+		free(blocks);
+		return;
+	}
+
+	printf("%-10s  %8u ops  %7u blocks\n", trace->name, (unsigned int)trace->numOps, (unsigned int)trace->numSlots);
+	for(i = 0; i < BENCH_NUM_ALLOCATORS; ++i){
+		benchResult result = {
+			.bestTime = 0.f,
+			.totalTime = 0.f,
+			.numFailed = 0,
+			.numCorrupt = 0
+		};
+		size_t j;
+
+		for(j = 0; j < numRepeats; ++j){
+			replayTrace(&allocators[i], trace, memory, heapSize, blocks, &result);
+		}
+
+		printf(
+			"  %-6s  ns/op: mean %8.2f  best %8.2f  failed %6u  corrupt %6u\n",
+			allocators[i].name,
+			(trace->numOps > 0) ? 1000000.f*result.totalTime/(numRepeats*trace->numOps) : 0.f,
+			(trace->numOps > 0) ? 1000000.f*result.bestTime/trace->numOps : 0.f,
+			(unsigned int)(result.numFailed/numRepeats), (unsigned int)(result.numCorrupt/numRepeats)
+		);
+	}
+
+	free(memory);
+	free(blocks);
+}
+
+/*
+** Perform every operation in the trace using the allocator.
+** Each block's slot is written to its first word when it is
+** created, so we can check that it survives until it's freed.
+*/
+static void replayTrace(
+	const benchAllocator *const restrict allocator, const benchTrace *const restrict trace,
+	void *const restrict memory, const size_t heapSize, void **const restrict blocks, benchResult *const restrict result
+){
+	union {
+		memoryTree tree;
+		memoryTLSF tlsf;
+	} state;
+	const benchOp *op = trace->ops;
+	const benchOp *const lastOp = &op[trace->numOps];
+	timerVal start;
+	float time;
+
+	memset(blocks, (uintptr_t)NULL, trace->numSlots * sizeof(*blocks));
+	allocator->init(&state, memory, heapSize);
+
+	start = timerStart();
+	for(; op < lastOp; ++op){
+		void **const block = &blocks[op->slot];
+
+		switch(op->type){
+			case BENCH_OP_ALLOC:
+				*block = allocator->alloc(&state, op->size);
+				if(*block == NULL){
+					++result->numFailed;
+				}else{
+					*((size_t *)*block) = op->slot;
+				}
+			break;
+			case BENCH_OP_RESIZE:
+			case BENCH_OP_REALLOC:
+				// If the original allocation failed, there's nothing to resize.
+				if(*block == NULL && op->type == BENCH_OP_RESIZE){
+					break;
+				}else{
+					void *const newBlock = (op->type == BENCH_OP_RESIZE) ?
+						allocator->resize(&state, *block, op->size) :
+						allocator->realloc(&state, *block, op->size);
+
+					if(newBlock == NULL){
+						++result->numFailed;
+					}else{
+						if(*block != NULL && *((size_t *)newBlock) != op->slot){
+							++result->numCorrupt;
+						}
+						*((size_t *)newBlock) = op->slot;
+						*block = newBlock;
+					}
+				}
+			break;
+			case BENCH_OP_FREE:
+				if(*block != NULL){
+					if(*((size_t *)*block) != op->slot){
+						++result->numCorrupt;
+					}
+					allocator->free(&state, *block);
+					*block = NULL;
+				}
+			break;
+		}
+	}
+	time = timerStopFloat(start);
+
+	if(result->totalTime == 0.f || time < result->bestTime){
+		result->bestTime = time;
+	}
+	result->totalTime += time;
+}
+
+
+/*
+** Time how long it takes for 1, 2, 4 and so on threads, up to
+** "maxThreads", to each perform the same number of operations
+** on small blocks, both with a tree behind a single lock and
+** with the global memory manager. We then do the same for pools.
+*/
+static void runContention(const size_t maxThreads, const size_t heapSize, const uint_least32_t seed){
+	const size_t poolSize = memPoolMemoryForBlocksRegion(BENCH_CONTENTION_POOL_BLOCKS, BENCH_CONTENTION_MAX_SIZE);
+	benchContentionArgs *const args = malloc(maxThreads * sizeof(*args));
+	void *const memory = malloc(heapSize);
+	void *const lockedPoolMemory = malloc(poolSize);
+	void *const concurrentPoolMemory = malloc(poolSize);
+	size_t numThreads;
+
+	if(
+		args == NULL || memory == NULL || lockedPoolMemory == NULL ||
+		concurrentPoolMemory == NULL || !memoryManagerGlobalInit(heapSize)
+	){
+		printf("Unable to allocate memory for the contention benchmark!\n");
+		free(args);
+		free(memory);
+		free(lockedPoolMemory);
+		free(concurrentPoolMemory);
+		return;
+	}
+	memTreeInit(&lockedTree, memory, heapSize);
+	threadMutexInit(&lockedTreeLock);
+	memPoolInit(&lockedPool, lockedPoolMemory, poolSize, BENCH_CONTENTION_MAX_SIZE);
+	threadMutexInit(&lockedPoolLock);
+	memPoolConcurrentInit(&concurrentPool, concurrentPoolMemory, poolSize, BENCH_CONTENTION_MAX_SIZE);
+
+	printf(
+		"contention  %8u ops per thread  thread caches %s\n",
+		BENCH_CONTENTION_NUM_OPS,
+		#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+		"on"
+		#else
+		"off"
+		#endif
+	);
+	for(numThreads = 1; numThreads <= maxThreads; numThreads *= 2){
+		size_t lockedFailed;
+		size_t globalFailed;
+		const float lockedTime = timeContention(
+			args, numThreads, seed, &contentionMain, &lockedAlloc, &lockedFree, &lockedFailed
+		);
+		const float globalTime = timeContention(
+			args, numThreads, seed, &contentionMain, &memoryManagerGlobalAlloc, &memoryManagerGlobalFree, &globalFailed
+		);
+
+		// Operations per microsecond is the same as millions per second.
+		printf(
+			"  %2u threads  Mops/s: locked %8.2f  global %8.2f  failed %6u %6u\n",
+			(unsigned int)numThreads,
+			(lockedTime > 0.f) ? numThreads*BENCH_CONTENTION_NUM_OPS/(1000.f*lockedTime) : 0.f,
+			(globalTime > 0.f) ? numThreads*BENCH_CONTENTION_NUM_OPS/(1000.f*globalTime) : 0.f,
+			(unsigned int)lockedFailed, (unsigned int)globalFailed
+		);
+	}
+
+	printf("contention pools  %8u ops per thread\n", BENCH_CONTENTION_NUM_OPS);
+	for(numThreads = 1; numThreads <= maxThreads; numThreads *= 2){
+		size_t lockedFailed;
+		size_t concurrentFailed;
+		size_t magazineFailed;
+		const float lockedTime = timeContention(
+			args, numThreads, seed, &contentionMain, &lockedPoolAlloc, &lockedPoolFree, &lockedFailed
+		);
+		const float concurrentTime = timeContention(
+			args, numThreads, seed, &contentionMain, &concurrentPoolAlloc, &concurrentPoolFree, &concurrentFailed
+		);
+		const float magazineTime = timeContention(
+			args, numThreads, seed, &contentionMain, &magazinePoolAlloc, &magazinePoolFree, &magazineFailed
+		);
+
+		printf(
+			"  %2u threads  Mops/s: locked %8.2f  lock-free %8.2f  magazine %8.2f  failed %6u %6u %6u\n",
+			(unsigned int)numThreads,
+			(lockedTime > 0.f) ? numThreads*BENCH_CONTENTION_NUM_OPS/(1000.f*lockedTime) : 0.f,
+			(concurrentTime > 0.f) ? numThreads*BENCH_CONTENTION_NUM_OPS/(1000.f*concurrentTime) : 0.f,
+			(magazineTime > 0.f) ? numThreads*BENCH_CONTENTION_NUM_OPS/(1000.f*magazineTime) : 0.f,
+			(unsigned int)lockedFailed, (unsigned int)concurrentFailed, (unsigned int)magazineFailed
+		);
+	}
+
+	threadMutexDelete(&lockedTreeLock);
+	threadMutexDelete(&lockedPoolLock);
+	memoryManagerGlobalDelete();
+	free(args);
+	free(memory);
+	free(lockedPoolMemory);
+	free(concurrentPoolMemory);
+}
+
+/*
+** Run "numThreads" threads using the allocator specified and return
+** how long it took for all of them to finish. Every thread is given
+** the same seed each time, so they perform the same operations.
+*/
+static float timeContention(
+	benchContentionArgs *const restrict args, const size_t numThreads, const uint_least32_t seed,
+	const threadFunction mainFunc, void *(*const allocFunc)(const size_t blockSize),
+	void (*const freeFunc)(void *const restrict block), size_t *const restrict numFailed
+){
+	thread threads[BENCH_CONTENTION_MAX_THREADS - 1];
+	timerVal start;
+	float time;
+	size_t numStarted = 0;
+	size_t i;
+
+	for(i = 0; i < numThreads; ++i){
+		args[i].alloc = allocFunc;
+		args[i].free = freeFunc;
+		args[i].seed = seed + i;
+	}
+
+	start = timerStart();
+	// The calling thread does the first thread's work. If we
+	// can't start a thread, we'll have to do its work too.
+	for(i = 1; i < numThreads; ++i){
+		if(threadCreate(&threads[numStarted], mainFunc, &args[i])){
+			++numStarted;
+		}else{
+			mainFunc(&args[i]);
+		}
+	}
+	mainFunc(&args[0]);
+	for(i = 0; i < numStarted; ++i){
+		threadJoin(threads[i]);
+	}
+	time = timerStopFloat(start);
+
+	*numFailed = 0;
+	for(i = 0; i < numThreads; ++i){
+		*numFailed += args[i].numFailed;
+	}
+
+	return(time);
+}
+
+/*
+** Keep a small number of blocks alive, freeing or
+** allocating a random one of them for each operation.
+*/
+static threadReturn_t THREAD_CALL contentionMain(void *const arg){
+	benchContentionArgs *const args = (benchContentionArgs *)arg;
+	void *blocks[BENCH_CONTENTION_MAX_LIVE];
+	uint_least32_t state = args->seed;
+	size_t i;
+
+	memset(blocks, (uintptr_t)NULL, sizeof(blocks));
+	args->numFailed = 0;
+	for(i = 0; i < BENCH_CONTENTION_NUM_OPS; ++i){
+		void **const block = &blocks[randomNext(&state, BENCH_CONTENTION_MAX_LIVE)];
+
+		if(*block == NULL){
+			*block = args->alloc(
+				BENCH_CONTENTION_MIN_SIZE + randomNext(&state, BENCH_CONTENTION_MAX_SIZE - BENCH_CONTENTION_MIN_SIZE)
+			);
+			if(*block == NULL){
+				++args->numFailed;
+			}else{
+				// Touch the block, like a real program would.
+				*((size_t *)*block) = i;
+			}
+		}else{
+			args->free(*block);
+			*block = NULL;
+		}
+	}
+	for(i = 0; i < BENCH_CONTENTION_MAX_LIVE; ++i){
+		if(blocks[i] != NULL){
+			args->free(blocks[i]);
+		}
+	}
+	#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+	memoryManagerGlobalFlushCache();
+	#endif
+	memPoolMagazineFlush(&concurrentPool, &poolMagazine);
+
+	return(THREAD_RETURN_SUCCESS);
+}
+
+/*
+** Run the stress test's threads on the lock-free pool, both with
+** and without magazines, for 1, 2, 4 and so on threads up to
+** "maxThreads". Each thread count is repeated several times, as
+** races that lose blocks will usually only happen occasionally.
+*/
+static void runStress(const size_t maxThreads, const uint_least32_t seed){
+	const size_t poolSize = memPoolMemoryForBlocksRegion(BENCH_CONTENTION_POOL_BLOCKS, BENCH_CONTENTION_MAX_SIZE);
+	benchContentionArgs *const args = malloc(maxThreads * sizeof(*args));
+	void *const poolMemory = malloc(poolSize);
+	size_t numBlocks;
+	size_t numThreads;
+
+	if(args == NULL || poolMemory == NULL){
+		printf("Unable to allocate memory for the stress test!\n");
+		free(args);
+		free(poolMemory);
+		return;
+	}
+	memPoolConcurrentInit(&concurrentPool, poolMemory, poolSize, BENCH_CONTENTION_MAX_SIZE);
+	numBlocks = concurrentPoolDrain();
+	memPoolConcurrentClear(&concurrentPool);
+
+	printf(
+		"stress  %8u ops per thread  %u repeats  %u blocks\n",
+		BENCH_CONTENTION_NUM_OPS, BENCH_STRESS_NUM_REPEATS, (unsigned int)numBlocks
+	);
+	for(numThreads = 1; numThreads <= maxThreads; numThreads *= 2){
+		size_t concurrentErrors = 0;
+		size_t magazineErrors = 0;
+		float concurrentTime = 0.f;
+		float magazineTime = 0.f;
+		size_t i;
+
+		for(i = 0; i < BENCH_STRESS_NUM_REPEATS; ++i){
+			size_t numFailed;
+
+			concurrentTime += timeContention(
+				args, numThreads, seed + i, &stressMain, &concurrentPoolAlloc, &concurrentPoolFree, &numFailed
+			);
+			concurrentErrors += stressCheckPool(args, numThreads, numBlocks);
+			magazineTime += timeContention(
+				args, numThreads, seed + i, &stressMain, &magazinePoolAlloc, &magazinePoolFree, &numFailed
+			);
+			magazineErrors += stressCheckPool(args, numThreads, numBlocks);
+		}
+
+		printf(
+			"  %2u threads  Mops/s: lock-free %8.2f  magazine %8.2f  errors %6u %6u\n",
+			(unsigned int)numThreads,
+			(concurrentTime > 0.f) ? BENCH_STRESS_NUM_REPEATS*numThreads*BENCH_CONTENTION_NUM_OPS/(1000.f*concurrentTime) : 0.f,
+			(magazineTime > 0.f) ? BENCH_STRESS_NUM_REPEATS*numThreads*BENCH_CONTENTION_NUM_OPS/(1000.f*magazineTime) : 0.f,
+			(unsigned int)concurrentErrors, (unsigned int)magazineErrors
+		);
+	}
+
+	free(args);
+	free(poolMemory);
+}
+
+/*
+** Return the number of errors found by the stress test's threads,
+** plus the number of blocks that were lost or returned twice.
+** The pool is cleared afterwards, so it's ready for the next run.
+*/
+static size_t stressCheckPool(benchContentionArgs *const restrict args, const size_t numThreads, const size_t numBlocks){
+	const size_t numFree = concurrentPoolDrain();
+	size_t numErrors = (numFree > numBlocks) ? numFree - numBlocks : numBlocks - numFree;
+	size_t i;
+
+	for(i = 0; i < numThreads; ++i){
+		numErrors += args[i].numCorrupt;
+	}
+	memPoolConcurrentClear(&concurrentPool);
+
+	return(numErrors);
+}
+
+// Allocate every free block in the lock-free pool and return how many there were.
+static size_t concurrentPoolDrain(){
+	size_t numFree = 0;
+
+	while(memPoolConcurrentAlloc(&concurrentPool) != NULL){
+		++numFree;
+	}
+
+	return(numFree);
+}
+
+/*
+** This is similar to "contentionMain", but we fill every block
+** with a value unique to its allocation. If it has changed when
+** we free the block, another thread must have been given it too.
+*/
+static threadReturn_t THREAD_CALL stressMain(void *const arg){
+	benchContentionArgs *const args = (benchContentionArgs *)arg;
+	void *blocks[BENCH_CONTENTION_MAX_LIVE];
+	size_t stamps[BENCH_CONTENTION_MAX_LIVE];
+	uint_least32_t state = args->seed;
+	size_t i;
+
+	memset(blocks, (uintptr_t)NULL, sizeof(blocks));
+	args->numFailed = 0;
+	args->numCorrupt = 0;
+	for(i = 0; i < BENCH_CONTENTION_NUM_OPS; ++i){
+		const size_t slot = randomNext(&state, BENCH_CONTENTION_MAX_LIVE);
+
+		if(blocks[slot] == NULL){
+			blocks[slot] = args->alloc(BENCH_CONTENTION_MAX_SIZE);
+			if(blocks[slot] == NULL){
+				++args->numFailed;
+			}else{
+				size_t *curWord = blocks[slot];
+				const size_t *const lastWord = &curWord[BENCH_STRESS_NUM_WORDS];
+
+				// Threads have consecutive seeds, so this is unique.
+				stamps[slot] = (size_t)args->seed * BENCH_CONTENTION_NUM_OPS + i;
+				for(; curWord < lastWord; ++curWord){
+					*curWord = stamps[slot];
+				}
+			}
+		}else{
+			args->numCorrupt += stressFree(args, blocks[slot], stamps[slot]);
+			blocks[slot] = NULL;
+		}
+	}
+	for(i = 0; i < BENCH_CONTENTION_MAX_LIVE; ++i){
+		if(blocks[i] != NULL){
+			args->numCorrupt += stressFree(args, blocks[i], stamps[i]);
+		}
+	}
+	memPoolMagazineFlush(&concurrentPool, &poolMagazine);
+
+	return(THREAD_RETURN_SUCCESS);
+}
+
+// Free a block, returning 1 if any of its words don't match "stamp".
+static byte_t stressFree(const benchContentionArgs *const restrict args, void *const restrict block, const size_t stamp){
+	const size_t *curWord = block;
+	const size_t *const lastWord = &curWord[BENCH_STRESS_NUM_WORDS];
+	byte_t corrupt = 0;
+
+	for(; curWord < lastWord; ++curWord){
+		if(*curWord != stamp){
+			corrupt = 1;
+			break;
+		}
+	}
+	args->free(block);
+
+	return(corrupt);
+}
+
+
+static void *lockedAlloc(const size_t blockSize){
+	void *block;
+
+	threadMutexLock(&lockedTreeLock);
+	block = memTreeAlloc(&lockedTree, blockSize);
+	threadMutexUnlock(&lockedTreeLock);
+
+	return(block);
+}
+
+static void lockedFree(void *const restrict block){
+	threadMutexLock(&lockedTreeLock);
+	memTreeFree(&lockedTree, block);
+	threadMutexUnlock(&lockedTreeLock);
+}
+
+static void *lockedPoolAlloc(const size_t blockSize){
+	void *block;
+
+	threadMutexLock(&lockedPoolLock);
+	block = memPoolAlloc(&lockedPool);
+	threadMutexUnlock(&lockedPoolLock);
+
+	return(block);
+}
+
+static void lockedPoolFree(void *const restrict block){
+	threadMutexLock(&lockedPoolLock);
+	memPoolFree(&lockedPool, block);
+	threadMutexUnlock(&lockedPoolLock);
+}
+
+static void *concurrentPoolAlloc(const size_t blockSize){
+	return(memPoolConcurrentAlloc(&concurrentPool));
+}
+
+static void concurrentPoolFree(void *const restrict block){
+	memPoolConcurrentFree(&concurrentPool, block);
+}
+
+static void *magazinePoolAlloc(const size_t blockSize){
+	return(memPoolMagazineAlloc(&concurrentPool, &poolMagazine));
+}
+
+static void magazinePoolFree(void *const restrict block){
+	memPoolMagazineFree(&concurrentPool, &poolMagazine, block);
+}
+
+
+/*
+** Load a trace recorded by the global memory manager. The
+** addresses in the file are converted to slots, and a new
+** slot is created whenever a block is allocated.
+*/
+static return_t loadTrace(benchTrace *const restrict trace, const char *const restrict path){
+	FILE *const file = fopen(path, "r");
+	benchAddressTable table = {.entries = NULL, .capacity = 0, .numUsed = 0};
+	char line[256];
+	return_t success = 1;
+
+	if(file == NULL){
+		return(0);
+	}
+	if(!traceInit(trace, path)){
+		fclose(file);
+		return(0);
+	}
+
+	while(success && fgets(line, sizeof(line), file) != NULL){
+		char *end = &line[1];
+		unsigned long long values[3] = {0, 0, 0};
+		size_t numValues = 0;
+		const benchAddressEntry *entry;
+
+		// Read up to three integers after the operation's type.
+		while(numValues < 3){
+			char *const start = end;
+			values[numValues] = strtoull(start, &end, 10);
+			if(end == start){
+				break;
+			}
+			++numValues;
+		}
+
+		switch(line[0]){
+			case BENCH_OP_ALLOC:
+				if(numValues == 2){
+					success = traceAdd(trace, BENCH_OP_ALLOC, trace->numSlots, values[0]);
+					if(success && values[1] != BENCH_ADDRESS_EMPTY){
+						success = addressTableInsert(&table, values[1], trace->numSlots);
+					}
+					++trace->numSlots;
+				}
+			break;
+			case BENCH_OP_RESIZE:
+			case BENCH_OP_REALLOC:
+				if(numValues == 3){
+					entry = addressTableFind(&table, values[0]);
+					// A reallocation of a NULL block is just an allocation.
+					if(entry == NULL){
+						if(line[0] == BENCH_OP_REALLOC && values[0] == BENCH_ADDRESS_EMPTY){
+							success = traceAdd(trace, BENCH_OP_REALLOC, trace->numSlots, values[1]);
+							if(success && values[2] != BENCH_ADDRESS_EMPTY){
+								success = addressTableInsert(&table, values[2], trace->numSlots);
+							}
+							++trace->numSlots;
+						}
+					}else{
+						const size_t curSlot = entry->slot;
+						success = traceAdd(trace, line[0], curSlot, values[1]);
+						// If the block moved, update its address.
+						if(success && values[2] != BENCH_ADDRESS_EMPTY && values[2] != values[0]){
+							addressTableRemove(&table, values[0]);
+							success = addressTableInsert(&table, values[2], curSlot);
+						}
+					}
+				}
+			break;
+			case BENCH_OP_FREE:
+				if(numValues == 1){
+					entry = addressTableFind(&table, values[0]);
+					if(entry != NULL){
+						success = traceAdd(trace, BENCH_OP_FREE, entry->slot, 0);
+						addressTableRemove(&table, values[0]);
+					}
+				}
+			break;
+		}
+	}
+
+	fclose(file);
+	free(table.entries);
+	if(!success){
+		traceDelete(trace);
+	}
+
+	return(success);
+}
+
+// Return the entry for the block at "address", or NULL if there isn't one.
+static benchAddressEntry *addressTableFind(const benchAddressTable *const restrict table, const uintptr_t address){
+	if(table->capacity > 0){
+		size_t i = (address >> 3) & (table->capacity - 1);
+		for(;;){
+			benchAddressEntry *const entry = &table->entries[i];
+			if(entry->address == address){
+				return(entry);
+			}else if(entry->address == BENCH_ADDRESS_EMPTY){
+				break;
+			}
+			i = (i + 1) & (table->capacity - 1);
+		}
+	}
+
+	return(NULL);
+}
+
+/*
+** Add an address to the table using linear probing. We never
+** reuse removed entries, so the table is rebuilt whenever it
+** becomes half full, which also clears them out.
+*/
+static return_t addressTableInsert(benchAddressTable *const restrict table, const uintptr_t address, const size_t slot){
+	size_t i;
+
+	if(2*(table->numUsed + 1) > table->capacity){
+		const benchAddressEntry *const oldEntries = table->entries;
+		const size_t oldCapacity = table->capacity;
+
+		table->capacity = (oldCapacity > 0) ? 2*oldCapacity : 1024;
+		table->entries = calloc(table->capacity, sizeof(*table->entries));
+		if(table->entries == NULL){
+			return(0);
+		}
+
+		table->numUsed = 0;
+		for(i = 0; i < oldCapacity; ++i){
+			if(oldEntries[i].address > BENCH_ADDRESS_REMOVED){
+				addressTableInsert(table, oldEntries[i].address, oldEntries[i].slot);
+			}
+		}
+		free((void *)oldEntries);
+	}
+
+	i = (address >> 3) & (table->capacity - 1);
+	while(table->entries[i].address > BENCH_ADDRESS_REMOVED){
+		i = (i + 1) & (table->capacity - 1);
+	}
+	if(table->entries[i].address == BENCH_ADDRESS_EMPTY){
+		++table->numUsed;
+	}
+	table->entries[i].address = address;
+	table->entries[i].slot = slot;
+
+	return(1);
+}
+
+static void addressTableRemove(const benchAddressTable *const restrict table, const uintptr_t address){
+	benchAddressEntry *const entry = addressTableFind(table, address);
+	if(entry != NULL){
+		entry->address = BENCH_ADDRESS_REMOVED;
+	}
+}
+
+
+/*
+** Particle systems create and destroy a lot of small objects of
+** only a few different sizes. Every step, a random number of the
+** live particles die and are replaced by new ones.
+*/
+static void buildParticles(benchTrace *const restrict trace){
+	static const size_t sizes[3] = {48, 64, 96};
+	size_t live[BENCH_PARTICLE_MAX_LIVE];
+	size_t numLive = 0;
+	size_t i;
+
+	for(i = 0; i < BENCH_PARTICLE_STEPS; ++i){
+		size_t numDead = randomInt(numLive/8 + 1);
+		// Kill some of the particles at random.
+		while(numDead > 0 && numLive > 0){
+			const size_t index = randomInt(numLive);
+			traceAdd(trace, BENCH_OP_FREE, live[index], 0);
+			live[index] = live[--numLive];
+			--numDead;
+		}
+		// Then emit new ones until we hit the limit.
+		while(numLive < BENCH_PARTICLE_MAX_LIVE){
+			traceAdd(trace, BENCH_OP_ALLOC, trace->numSlots, sizes[randomInt(3)]);
+			live[numLive++] = trace->numSlots++;
+		}
+	}
+	// Free everything at the end, like a particle system being destroyed.
+	while(numLive > 0){
+		traceAdd(trace, BENCH_OP_FREE, live[--numLive], 0);
+	}
+}
+
+/*
+** Model loading reads arrays of unknown length, so it grows them
+** by reallocating and shrinks them to fit once they're loaded.
+** Models are also kept around for a while before being freed.
+*/
+static void buildModels(benchTrace *const restrict trace){
+	size_t live[BENCH_MODEL_MAX_LIVE][4];
+	size_t numLive = 0;
+	size_t i;
+
+	for(i = 0; i < BENCH_MODEL_COUNT; ++i){
+		size_t j;
+
+		// If we have too many models loaded, unload one at random.
+		if(numLive == BENCH_MODEL_MAX_LIVE){
+			const size_t index = randomInt(numLive);
+			for(j = 0; j < 4; ++j){
+				traceAdd(trace, BENCH_OP_FREE, live[index][j], 0);
+			}
+			--numLive;
+			memcpy(live[index], live[numLive], sizeof(*live));
+		}
+
+		// Load the model's vertices, indices, bones and names.
+		for(j = 0; j < 4; ++j){
+			static const size_t elementSizes[4] = {32, 4, 64, 16};
+			const size_t slot = trace->numSlots++;
+			const size_t numElements = 16 + randomInt(j < 2 ? 20000 : 64);
+			size_t capacity = 16;
+
+			traceAdd(trace, BENCH_OP_ALLOC, slot, capacity*elementSizes[j]);
+			while(capacity < numElements){
+				capacity *= 2;
+				traceAdd(trace, BENCH_OP_REALLOC, slot, capacity*elementSizes[j]);
+			}
+			traceAdd(trace, BENCH_OP_RESIZE, slot, numElements*elementSizes[j]);
+			live[numLive][j] = slot;
+		}
+		++numLive;
+
+		// Loading also creates some temporary buffers.
+		for(j = randomInt(8); j > 0; --j){
+			const size_t slot = trace->numSlots++;
+			traceAdd(trace, BENCH_OP_ALLOC, slot, randomSize(6, 16));
+			traceAdd(trace, BENCH_OP_FREE, slot, 0);
+		}
+	}
+	while(numLive > 0){
+		size_t j;
+		--numLive;
+		for(j = 0; j < 4; ++j){
+			traceAdd(trace, BENCH_OP_FREE, live[numLive][j], 0);
+		}
+	}
+}
+
+/*
+** A general purpose workload, with sizes roughly uniformly
+** distributed in log space and blocks being freed and grown
+** at random. This fragments the heap much more than the others.
+*/
+static void buildMixed(benchTrace *const restrict trace){
+	size_t live[BENCH_MIXED_MAX_LIVE];
+	size_t numLive = 0;
+	size_t i;
+
+	for(i = 0; i < BENCH_MIXED_NUM_OPS; ++i){
+		const uint_least32_t choice = randomInt(8);
+
+		// Allocate more often than we free until we're near the limit.
+		if(numLive == 0 || (numLive < BENCH_MIXED_MAX_LIVE && choice < 4)){
+			traceAdd(trace, BENCH_OP_ALLOC, trace->numSlots, randomSize(4, 16));
+			live[numLive++] = trace->numSlots++;
+		}else if(choice == 7){
+			traceAdd(trace, (randomInt(2) == 0) ? BENCH_OP_REALLOC : BENCH_OP_RESIZE, live[randomInt(numLive)], randomSize(4, 16));
+		}else{
+			const size_t index = randomInt(numLive);
+			traceAdd(trace, BENCH_OP_FREE, live[index], 0);
+			live[index] = live[--numLive];
+		}
+	}
+	while(numLive > 0){
+		traceAdd(trace, BENCH_OP_FREE, live[--numLive], 0);
+	}
+}
+
+// Return a random size whose base 2 logarithm is roughly uniform in [minLog2, maxLog2).
+static size_t randomSize(const size_t minLog2, const size_t maxLog2){
+	const size_t log2 = minLog2 + randomInt(maxLog2 - minLog2);
+	return(((size_t)1 << log2) + randomInt((uint_least32_t)1 << log2));
+}
+
+
+static return_t traceInit(benchTrace *const restrict trace, const char *const restrict name){
+	trace->name = name;
+	trace->numOps = 0;
+	trace->capacity = 1024;
+	trace->numSlots = 0;
+	trace->ops = malloc(trace->capacity * sizeof(*trace->ops));
+
+	return(trace->ops != NULL);
+}
+
+static return_t traceAdd(benchTrace *const restrict trace, const byte_t type, const size_t slot, const size_t size){
+	benchOp *op;
+
+	if(trace->numOps == trace->capacity){
+		benchOp *const newOps = realloc(trace->ops, 2 * trace->capacity * sizeof(*trace->ops));
+		if(newOps == NULL){
+			return(0);
+		}
+		trace->ops = newOps;
+		trace->capacity *= 2;
+	}
+
+	op = &trace->ops[trace->numOps++];
+	op->type = type;
+	op->slot = slot;
+	op->size = size;
+
+	return(1);
+}
+
+static void traceDelete(benchTrace *const restrict trace){
+	free(trace->ops);
+	trace->ops = NULL;
+}
+
+
+static void *treeInit(void *const restrict allocator, void *const restrict memory, const size_t memorySize){
+	return(memTreeInit(allocator, memory, memorySize));
+}
+
+static void *treeAlloc(void *const restrict allocator, const size_t blockSize){
+	return(memTreeAlloc(allocator, blockSize));
+}
+
+static void *treeResize(void *const restrict allocator, void *const restrict block, const size_t blockSize){
+	return(memTreeResize(allocator, block, blockSize));
+}
+
+static void *treeRealloc(void *const restrict allocator, void *const restrict block, const size_t blockSize){
+	return(memTreeRealloc(allocator, block, blockSize));
+}
+
+static void treeFree(void *const restrict allocator, void *const restrict block){
+	memTreeFree(allocator, block);
+}
+
+static void *tlsfInit(void *const restrict allocator, void *const restrict memory, const size_t memorySize){
+	return(memTLSFInit(allocator, memory, memorySize));
+}
+
+static void *tlsfAlloc(void *const restrict allocator, const size_t blockSize){
+	return(memTLSFAlloc(allocator, blockSize));
+}
+
+static void *tlsfResize(void *const restrict allocator, void *const restrict block, const size_t blockSize){
+	return(memTLSFResize(allocator, block, blockSize));
+}
+
+static void *tlsfRealloc(void *const restrict allocator, void *const restrict block, const size_t blockSize){
+	return(memTLSFRealloc(allocator, block, blockSize));
+}
+
+static void tlsfFree(void *const restrict allocator, void *const restrict block){
+	memTLSFFree(allocator, block);
+}
+
+
+static void randomSeed(const uint_least32_t seed){
+	randomState = seed;
+}
+
+static uint_least32_t randomInt(const uint_least32_t max){
+	return(randomNext(&randomState, max));
+}
+
+// Return a pseudorandom integer in the range [0, max) using a linear congruential generator.
+static uint_least32_t randomNext(uint_least32_t *const restrict state, const uint_least32_t max){
+	*state = (*state*1664525u + 1013904223u) & 0xFFFFFFFF;
+	return((uint_least32_t)(((uint_least64_t)(*state >> 8) * max) >> 24));
+}
\ No newline at end of file
@@ -0,0 +1,1590 @@
+/*
+** Headless physics benchmark. This builds a handful of canonical
+** scenes, steps each of them a fixed number of times and reports
+** the time taken per step along with a checksum of the final state.
+**
+** Usage: physicsBench [-n steps] [-c count] [-t threads] [-b broadphase] [-p] [-s] [-d] [-g] [-r] [scene...]
+**
+** The scenes are "pyramid", "spheres", "rubble", "chains" and
+** "mixed". If no scenes are specified, all of them are run. The
+** count overrides the size of each scene, the broadphase is one of
+** the island's PHYSISLAND_BROADPHASE_* values and "-p" prints the
+** island's profiler after each scene if it has been enabled.
+**
+** If "-s" is given, the final contacts of each scene are solved by
+** both the scalar and SIMD contact solvers, and the impulses they
+** produce are compared. This only works if the SIMD solver is enabled.
+**
+** If "-d" is given, each scene is also run twice more without any
+** threads and twice more with them, and snapshots of the island at
+** the end of each pair of runs are compared. The simulation should
+** be deterministic, so both runs should finish in the same state.
+**
+** Scenes with joints also report how far apart the anchors of their
+** joints are after each step, which shows how well the solver has
+** converged. Comparing this with the time per step for different
+** numbers of substeps and iterations tells us which is cheapest.
+**
+** "-g" times the SAT and GJK narrowphase tests on the same pairs of
+** barely touching hulls, and "-r" casts rays into the spheres scene
+** one at a time and in batches, which are traversed in packets by
+** the tree. Like scenes, these are run when they're given, and the
+** scenes are only run by default if none of them have been given.
+**
+** This only uses the physics, memory and mathematics code,
+** so it can be built with "make bench" without SDL or OpenGL.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "settingsPhysics.h"
+#include "settingsMemory.h"
+
+#include "memoryManager.h"
+#include "memoryArena.h"
+#include "modulePhysics.h"
+#include "sortTimsort.h"
+#include "thread.h"
+#include "threadPool.h"
+#include "timer.h"
+
+#include "colliderGJK.h"
+#include "physicsCollider.h"
+#include "physicsRigidBody.h"
+#include "physicsJoint.h"
+#include "physicsIsland.h"
+
+
+// The larger scenes need much more memory than the
+// application, and the global manager can't grow.
+#ifndef BENCH_HEAPSIZE
+	#define BENCH_HEAPSIZE (1024 * MEMORY_MEBIBYTE)
+#endif
+
+#define BENCH_DEFAULT_NUM_STEPS 500
+#define BENCH_TIMESTEP (1.f/PHYSICS_UPDATE_RATE)
+// All of the scenes are seeded with this, so
+// every run starts from exactly the same state.
+#define BENCH_RANDOM_SEED 12345
+
+// The spheres are approximated by icospheres, as
+// hulls are the only colliders with a narrowphase.
+#define BENCH_SPHERE_RADIUS       0.5f
+#define BENCH_SPHERE_SUBDIVISIONS 1
+#define BENCH_SPHERE_MAX_VERTICES 42
+#define BENCH_SPHERE_MAX_FACES    80
+
+#define BENCH_NUM_RUBBLE_SHAPES 16
+
+#define BENCH_CHAIN_LENGTH      10
+#define BENCH_CHAIN_LINK_LENGTH 0.5f
+#define BENCH_CHAIN_LINK_GAP    0.05f
+
+#define BENCH_GROUND_SIZE 200.f
+
+#define BENCH_FRICTION    0.5f
+#define BENCH_RESTITUTION 0.1f
+
+// The SIMD solver doesn't use fused multiply-adds in the same
+// places as the scalar one, so they won't agree exactly.
+#define BENCH_SOLVER_TOLERANCE 1e-4f
+
+// If "-t" isn't given, the threaded
+// determinism check uses this many.
+#define BENCH_DETERMINISM_NUM_THREADS 4
+
+#define BENCH_NARROWPHASE_NUM_PAIRS   2000
+#define BENCH_NARROWPHASE_NUM_REPEATS 20
+// Pairs are moved apart until they just touch,
+// then pushed back together by at most this much.
+#define BENCH_NARROWPHASE_MAX_PENETRATION 0.03f
+#define BENCH_NARROWPHASE_MAX_DISTANCE    4.f
+#define BENCH_NARROWPHASE_NUM_SEARCH_STEPS 32
+
+#define BENCH_RAYCAST_NUM_RAYS      65536
+#define BENCH_RAYCAST_NUM_REPEATS   5
+#define BENCH_RAYCAST_MAX_DISTANCE  100.f
+// Rays in each packet start this close together.
+#define BENCH_RAYCAST_PACKET_SPREAD 0.25f
+#define BENCH_RAYCAST_TOLERANCE     1e-4f
+
+
+// Rigid body definitions shared by the scenes.
+typedef struct benchShapes {
+	physicsRigidBodyDef *ground;
+	physicsRigidBodyDef *box;
+	physicsRigidBodyDef *sphere;
+	physicsRigidBodyDef *rubble[BENCH_NUM_RUBBLE_SHAPES];
+
+	physicsRigidBodyDef *anchor;
+	physicsRigidBodyDef *link;
+} benchShapes;
+
+typedef struct benchScene {
+	const char *name;
+	// Add "count" objects to the island. What an
+	// object is depends on the scene being built.
+	void (*build)(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count);
+	size_t defaultCount;
+} benchScene;
+
+typedef struct benchOptions {
+	size_t numSteps;
+	size_t count;
+	size_t numThreads;
+	byte_t broadphase;
+	byte_t profile;
+	byte_t compareSolvers;
+	byte_t checkDeterminism;
+} benchOptions;
+
+
+// Forward-declare any helper functions!
+static void runScene(const benchScene *const restrict scene, const benchOptions *const restrict options);
+static float measureJointError(const physicsIsland *const restrict island, float *const restrict maxError);
+static return_t setupScene(
+	const benchScene *const restrict scene, const benchOptions *const restrict options, const size_t numThreads,
+	physicsIsland *const restrict island, threadPool *const restrict workers
+);
+static void cleanupScene(physicsIsland *const restrict island);
+static void checkDeterminism(const benchScene *const restrict scene, const benchOptions *const restrict options);
+static return_t simulationIsDeterministic(
+	const benchScene *const restrict scene, const benchOptions *const restrict options, const size_t numThreads
+);
+#ifdef PHYSCONTACT_SOLVER_SIMD
+static void compareContactSolvers(physicsIsland *const restrict island);
+static size_t solverBodyIndex(const physicsRigidBody *const restrict body);
+static float relativeError(const float a, const float b);
+#endif
+static void runNarrowphase();
+static void benchNarrowphase(const char *const restrict name, const physicsRigidBodyDef *const restrict bodyDef);
+static void placeCollider(
+	collider *const restrict c, const physicsRigidBodyDef *const restrict bodyDef,
+	const vec3 *const restrict pos, const quat *const restrict rot
+);
+static void runRaycasts(const benchOptions *const restrict options);
+static void benchRaycasts(
+	physicsIsland *const restrict island, const char *const restrict name,
+	const vec3 *const restrict origins, const vec3 *const restrict dirs, const float *const restrict maxDistances,
+	physicsRaycastHit *const restrict hits, physicsRaycastHit *const restrict batchHits
+);
+static void buildPyramid(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count);
+static void buildSpheres(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count);
+static void buildRubble(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count);
+static void buildChains(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count);
+static void buildMixed(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count);
+
+static void addPyramid(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t baseSize, const vec3 origin);
+static void addSpheres(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count, const vec3 origin);
+static void addRubble(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count, const vec3 origin);
+static void addChains(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count, const vec3 origin);
+static void addChain(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const vec3 origin);
+static void addGround(physicsIsland *const restrict island, const benchShapes *const restrict shapes);
+static void makeStatic(physicsRigidBody *const restrict body);
+
+static physicsRigidBody *createBody(const physicsRigidBodyDef *const restrict bodyDef, const vec3 pos, const quat rot);
+static void insertBody(physicsIsland *const restrict island, physicsRigidBody *const restrict body);
+static void addSphereJoint(
+	physicsRigidBody *const restrict bodyA, physicsRigidBody *const restrict bodyB, const vec3 anchor,
+	const float minX, const float maxX, const float minY, const float maxY, const float minZ, const float maxZ
+);
+
+static return_t createShapes(benchShapes *const restrict shapes);
+static physicsRigidBodyDef *createBoxDef(const vec3 halfSize, const float mass);
+static physicsRigidBodyDef *createOctahedronDef(const vec3 halfSize, const float mass);
+static physicsRigidBodyDef *createWedgeDef(const vec3 halfSize, const float mass);
+static physicsRigidBodyDef *createIcosphereDef(const float radius, const float mass);
+static physicsRigidBodyDef *createHullDef(
+	const vec3 *const restrict vertices, const size_t numVertices,
+	const size_t *restrict faces, const size_t numFaces, const float mass
+);
+
+static uint_least32_t checksumIsland(const physicsIsland *const restrict island);
+static uint_least32_t checksumBytes(uint_least32_t hash, const void *const restrict data, const size_t size);
+static float percentile(const float *const restrict sortedTimes, const size_t numTimes, const float p);
+static sort_t compareTimes(const void *const restrict t1, const void *const restrict t2);
+
+static void randomSeed(const uint_least32_t seed);
+static float randomFloat(const float min, const float max);
+
+
+static const benchScene scenes[] = {
+	{.name = "pyramid",  .build = &buildPyramid,  .defaultCount = 12},
+	{.name = "spheres",  .build = &buildSpheres,  .defaultCount = 10000},
+	{.name = "rubble",   .build = &buildRubble,   .defaultCount = 1000},
+	{.name = "chains",   .build = &buildChains,   .defaultCount = 100},
+	{.name = "mixed",    .build = &buildMixed,    .defaultCount = 2000}
+};
+#define BENCH_NUM_SCENES (sizeof(scenes)/sizeof(*scenes))
+
+static uint_least32_t randomState;
+
+
+int main(int argc, char **argv){
+	benchOptions options = {
+		.numSteps = BENCH_DEFAULT_NUM_STEPS,
+		.count = 0,
+		.numThreads = 1,
+		.broadphase = PHYSISLAND_BROADPHASE_AABBTREE,
+		.profile = 0,
+		.compareSolvers = 0,
+		.checkDeterminism = 0
+	};
+	byte_t sceneSpecified = 0;
+	int i;
+
+
+	timerInit();
+	if(!memoryManagerGlobalInit(BENCH_HEAPSIZE)){
+		printf("Unable to initialize the global memory manager!\n");
+		return(1);
+	}
+
+
+	for(i = 1; i < argc; ++i){
+		const char *const arg = argv[i];
+
+		if(strcmp(arg, "-p") == 0){
+			options.profile = 1;
+		}else if(strcmp(arg, "-d") == 0){
+			options.checkDeterminism = 1;
+		}else if(strcmp(arg, "-g") == 0){
+			runNarrowphase();
+			sceneSpecified = 1;
+		}else if(strcmp(arg, "-r") == 0){
+			runRaycasts(&options);
+			sceneSpecified = 1;
+		}else if(strcmp(arg, "-s") == 0){
+			#ifdef PHYSCONTACT_SOLVER_SIMD
+			options.compareSolvers = 1;
+			#else
+			printf("The SIMD contact solver is disabled, ignoring '-s'.\n");
+			#endif
+		}else if(arg[0] == '-' && i + 1 < argc){
+			const size_t value = strtoul(argv[++i], NULL, 10);
+
+			switch(arg[1]){
+				case 'n':
+					options.numSteps = value;
+				break;
+				case 'c':
+					options.count = value;
+				break;
+				case 't':
+					options.numThreads = (value > 0) ? value : threadNumProcessors();
+				break;
+				case 'b':
+					options.broadphase = value;
+				break;
+				default:
+					printf("Ignoring unknown option '%s'.\n", arg);
+			}
+		}else{
+			size_t j;
+			for(j = 0; j < BENCH_NUM_SCENES; ++j){
+				if(strcmp(arg, scenes[j].name) == 0){
+					runScene(&scenes[j], &options);
+					break;
+				}
+			}
+			if(j == BENCH_NUM_SCENES){
+				printf("Ignoring unknown scene '%s'.\n", arg);
+			}
+			sceneSpecified = 1;
+		}
+	}
+
+	// If no scenes were specified, run all of them.
+	if(!sceneSpecified){
+		size_t j;
+		for(j = 0; j < BENCH_NUM_SCENES; ++j){
+			runScene(&scenes[j], &options);
+		}
+	}
+
+
+	#ifdef MEMORY_REGION_LARGE_PAGES
+	memoryRegionPrintPages(g_memManager.region);
+	#endif
+	memArenaThreadDelete();
+	memoryManagerGlobalDelete();
+
+	return(0);
+}
+
+
+/*
+** Build a scene in a new island, then step it forward a fixed
+** number of times, recording how long each of the steps took.
+*/
+static void runScene(const benchScene *const restrict scene, const benchOptions *const restrict options){
+	physicsIsland island;
+	threadPool workers;
+
+	float *const times = memoryManagerGlobalAlloc(options->numSteps * sizeof(*times));
+	float totalTime = 0.f;
+	float totalJointError = 0.f;
+	float maxJointError = 0.f;
+	size_t numBodies = 0;
+	size_t numJoints = 0;
+	size_t numContacts = 0;
+	const physicsRigidBody *body;
+	const physicsJoint *joint;
+	const physicsContactPair *pair;
+	size_t i;
+
+
+	if(times == NULL){
+		/** MALLOC FAILED **/
+	}
+	if(!setupScene(scene, options, options->numThreads, &island, &workers)){
+		memoryManagerGlobalFree(times);
+		return;
+	}
+
+
+	for(i = 0; i < options->numSteps; ++i){
+		const timerVal start = timerStart();
+		// Each step is treated as a frame, like an update would be.
+		memArenaGlobalNextFrame();
+		physIslandUpdate(&island, BENCH_TIMESTEP);
+		times[i] = timerStopFloat(start);
+		totalTime += times[i];
+
+		// This is done outside of the timer, as it isn't part of the update.
+		totalJointError += measureJointError(&island, &maxJointError);
+	}
+
+	for(body = island.bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		++numBodies;
+	}
+	for(joint = island.joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		++numJoints;
+	}
+	for(pair = island.contacts; pair != NULL; pair = modulePhysicsContactPairNext(pair)){
+		++numContacts;
+	}
+
+	printf(
+		"%-8s  %6u bodies  %5u joints  %6u contacts  %5u steps  checksum %08lx\n",
+		scene->name, (unsigned int)numBodies, (unsigned int)numJoints, (unsigned int)numContacts,
+		(unsigned int)options->numSteps, (unsigned long)checksumIsland(&island)
+	);
+	if(options->numSteps > 0){
+		timsort(times, options->numSteps, sizeof(*times), &compareTimes);
+		printf(
+			"          ms/step: mean %.4f  min %.4f  p50 %.4f  p95 %.4f  p99 %.4f  max %.4f  (total %.2f ms)\n",
+			totalTime/options->numSteps, times[0],
+			percentile(times, options->numSteps, 0.5f),
+			percentile(times, options->numSteps, 0.95f),
+			percentile(times, options->numSteps, 0.99f),
+			times[options->numSteps - 1], totalTime
+		);
+	}
+	if(numJoints > 0 && options->numSteps > 0){
+		printf(
+			"          joint error: mean %.6f  max %.6f\n",
+			totalJointError/options->numSteps, maxJointError
+		);
+	}
+	#ifdef PHYSISLAND_PROFILE
+	if(options->profile){
+		physProfilerPrint(&island.profiler);
+	}
+	#endif
+	#ifdef PHYSCONTACT_SOLVER_SIMD
+	if(options->compareSolvers){
+		compareContactSolvers(&island);
+	}
+	#endif
+
+
+	cleanupScene(&island);
+	memoryManagerGlobalFree(times);
+
+	if(options->checkDeterminism){
+		checkDeterminism(scene, options);
+	}
+}
+
+/*
+** Return the mean distance between the anchors of the island's
+** sphere joints, which is zero if they've converged perfectly.
+** The largest distance is also written to "maxError" if it's
+** larger than the value that's already there.
+*/
+static float measureJointError(const physicsIsland *const restrict island, float *const restrict maxError){
+	const physicsJoint *joint;
+	float totalError = 0.f;
+	size_t numJoints = 0;
+
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		if(joint->type == PHYSJOINT_TYPE_SPHERE){
+			vec3 anchorA;
+			vec3 anchorB;
+			float error;
+
+			// Transform the anchors into global space.
+			vec3SubtractVec3Out(&joint->data.sphere.anchorA, &joint->bodyA->base->centroid, &anchorA);
+			transformDirection(&joint->bodyA->state, &anchorA);
+			vec3AddVec3(&anchorA, &joint->bodyA->centroid);
+			vec3SubtractVec3Out(&joint->data.sphere.anchorB, &joint->bodyB->base->centroid, &anchorB);
+			transformDirection(&joint->bodyB->state, &anchorB);
+			vec3AddVec3(&anchorB, &joint->bodyB->centroid);
+
+			error = vec3DistanceVec3(&anchorA, &anchorB);
+			if(error > *maxError){
+				*maxError = error;
+			}
+			totalError += error;
+			++numJoints;
+		}
+	}
+
+	return((numJoints > 0) ? totalError/numJoints : 0.f);
+}
+
+/*
+** Build a scene in a new island, which will be split between
+** "numThreads" threads if there's more than one. Every scene
+** gets a fresh set of physics modules, so the allocators start
+** in the same state for each of them.
+*/
+static return_t setupScene(
+	const benchScene *const restrict scene, const benchOptions *const restrict options, const size_t numThreads,
+	physicsIsland *const restrict island, threadPool *const restrict workers
+){
+
+	benchShapes shapes;
+
+	// The rubble's shapes are random too, so seed the generator first.
+	randomSeed(BENCH_RANDOM_SEED);
+	if(!modulePhysicsSetup() || !createShapes(&shapes)){
+		printf("Unable to set up scene '%s'!\n", scene->name);
+		modulePhysicsCleanup();
+		return(0);
+	}
+
+	physIslandInit(island);
+	if(!physIslandSetBroadphase(island, options->broadphase)){
+		printf("Invalid broadphase %u, using the default.\n", (unsigned int)options->broadphase);
+	}
+	if(numThreads > 1 && threadPoolInit(workers, numThreads)){
+		island->workers = workers;
+	}
+
+	scene->build(island, &shapes, (options->count > 0) ? options->count : scene->defaultCount);
+
+	return(1);
+}
+
+// Delete a scene's island, along with its workers and physics modules.
+static void cleanupScene(physicsIsland *const restrict island){
+	if(island->workers != NULL){
+		threadPoolDelete(island->workers);
+	}
+	physIslandDelete(island);
+	modulePhysicsCleanup();
+}
+
+/*
+** Make sure that running a scene twice gives exactly the same
+** results, both with and without threads. The parallel solver
+** solves constraints in a different order to the serial one,
+** so only runs with the same number of threads are compared.
+*/
+static void checkDeterminism(const benchScene *const restrict scene, const benchOptions *const restrict options){
+	const size_t numThreads = (options->numThreads > 1) ? options->numThreads : BENCH_DETERMINISM_NUM_THREADS;
+
+	printf(
+		"          determinism: serial %s  %u threads %s\n",
+		simulationIsDeterministic(scene, options, 1) ? "ok" : "MISMATCH",
+		(unsigned int)numThreads, simulationIsDeterministic(scene, options, numThreads) ? "ok" : "MISMATCH"
+	);
+}
+
+// Run a scene twice and return whether both runs finished in the same state.
+static return_t simulationIsDeterministic(
+	const benchScene *const restrict scene, const benchOptions *const restrict options, const size_t numThreads
+){
+
+	physicsIslandSnapshot snapshots[2];
+	return_t equal;
+	size_t i;
+
+	for(i = 0; i < 2; ++i){
+		physicsIsland island;
+		threadPool workers;
+		size_t j;
+
+		physIslandSnapshotInit(&snapshots[i]);
+		if(!setupScene(scene, options, numThreads, &island, &workers)){
+			if(i > 0){
+				physIslandSnapshotDelete(&snapshots[0]);
+			}
+			return(0);
+		}
+		for(j = 0; j < options->numSteps; ++j){
+			memArenaGlobalNextFrame();
+			physIslandUpdate(&island, BENCH_TIMESTEP);
+		}
+		physIslandSnapshotSave(&island, &snapshots[i]);
+		cleanupScene(&island);
+	}
+
+	equal = physIslandSnapshotEqual(&snapshots[0], &snapshots[1]);
+	physIslandSnapshotDelete(&snapshots[1]);
+	physIslandSnapshotDelete(&snapshots[0]);
+
+	return(equal);
+}
+
+
+#ifdef PHYSCONTACT_SOLVER_SIMD
+/*
+** Solve the island's current contacts using both the scalar and
+** SIMD contact solvers, starting from the same packed state, and
+** print the largest differences between their impulses and the
+** velocities they produce.
+**
+** Like the island's parallel solver, the contacts are split into
+** colours that don't share any simulated bodies, and each colour
+** is solved in order. The contacts within a colour don't affect
+** each other, so both solvers should give the same results up to
+** rounding. Blocks are packed before the scalar solver is run, as
+** it updates the packed impulses in place.
+**
+** This reassigns the bodies' island indices, so the island should
+** only be updated again after it has rebuilt its constraint graphs.
+*/
+static void compareContactSolvers(physicsIsland *const restrict island){
+	physicsSolverBody *scalarBodies;
+	physicsSolverBody *simdBodies;
+	physicsContactConstraints constraints;
+	physicsContactBlock *blocks;
+	const physicsContactPair **pairs;
+	size_t *colourBlocks;
+	byte_t *bodyUsed;
+	size_t numBodies = 0;
+	size_t numContacts = 0;
+	size_t numPacked = 0;
+	size_t numBlocks = 0;
+	size_t numColours = 0;
+	size_t pointOffset = 0;
+	float maxImpulseError = 0.f;
+	float maxVelocityError = 0.f;
+	physicsRigidBody *body;
+	const physicsContactPair *pair;
+	size_t i;
+
+
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		body->islandIndex = numBodies;
+		++numBodies;
+	}
+	for(pair = island->contacts; pair != NULL; pair = modulePhysicsContactPairNext(pair)){
+		++numContacts;
+	}
+	if(numContacts == 0){
+		printf("          solvers: no contacts to compare\n");
+		return;
+	}
+
+	scalarBodies = memoryManagerGlobalAlloc(numBodies * sizeof(*scalarBodies));
+	if(scalarBodies == NULL){
+		/** MALLOC FAILED **/
+	}
+	simdBodies = memoryManagerGlobalAlloc(numBodies * sizeof(*simdBodies));
+	if(simdBodies == NULL){
+		/** MALLOC FAILED **/
+	}
+	pairs = memoryManagerGlobalAlloc(numContacts * sizeof(*pairs));
+	if(pairs == NULL){
+		/** MALLOC FAILED **/
+	}
+	// Each colour needs at most one partially filled block.
+	blocks = memoryManagerGlobalAlloc(2 * numContacts * sizeof(*blocks));
+	if(blocks == NULL){
+		/** MALLOC FAILED **/
+	}
+	colourBlocks = memoryManagerGlobalAlloc((numContacts + 1) * sizeof(*colourBlocks));
+	if(colourBlocks == NULL){
+		/** MALLOC FAILED **/
+	}
+	bodyUsed = memoryManagerGlobalAlloc(numBodies * sizeof(*bodyUsed));
+	if(bodyUsed == NULL){
+		/** MALLOC FAILED **/
+	}
+	physContactConstraintsInit(&constraints);
+	physContactConstraintsReserve(&constraints, numContacts, numContacts * CONTACT_MAX_POINTS);
+
+	i = 0;
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		physRigidBodyPackVelocity(body, &scalarBodies[i]);
+		++i;
+	}
+	memcpy(simdBodies, scalarBodies, numBodies * sizeof(*simdBodies));
+
+	// Greedily colour the contacts, packing them in colour order.
+	while(numPacked < numContacts){
+		const size_t firstManifold = numPacked;
+
+		memset(bodyUsed, 0, numBodies * sizeof(*bodyUsed));
+		for(pair = island->contacts; pair != NULL; pair = modulePhysicsContactPairNext(pair)){
+			const size_t bodyA = solverBodyIndex(pair->cA->owner);
+			const size_t bodyB = solverBodyIndex(pair->cB->owner);
+
+			// Skip pairs that have already been packed.
+			for(i = 0; i < numPacked; ++i){
+				if(pairs[i] == pair){
+					break;
+				}
+			}
+			if(i < numPacked ||
+			   (bodyA != PHYSCONTACT_STATIC_SOLVER_BODY && bodyUsed[bodyA]) ||
+			   (bodyB != PHYSCONTACT_STATIC_SOLVER_BODY && bodyUsed[bodyB])){
+
+				continue;
+			}
+
+			if(bodyA != PHYSCONTACT_STATIC_SOLVER_BODY){
+				bodyUsed[bodyA] = 1;
+			}
+			if(bodyB != PHYSCONTACT_STATIC_SOLVER_BODY){
+				bodyUsed[bodyB] = 1;
+			}
+			pairs[numPacked] = pair;
+			pointOffset = physContactConstraintsPack(&constraints, numPacked, pointOffset, &pair->manifold, bodyA, bodyB);
+			++numPacked;
+		}
+
+		colourBlocks[numColours] = numBlocks;
+		++numColours;
+		for(i = firstManifold; i < numPacked; i += PHYSCONTACT_SOLVER_SIMD_WIDTH){
+			const size_t numLeft = numPacked - i;
+			physContactBlockPack(
+				&blocks[numBlocks], &constraints, i,
+				(numLeft < PHYSCONTACT_SOLVER_SIMD_WIDTH) ? numLeft : PHYSCONTACT_SOLVER_SIMD_WIDTH
+			);
+			++numBlocks;
+		}
+	}
+	colourBlocks[numColours] = numBlocks;
+
+	for(i = 0; i < PHYSICS_VELOCITY_SOLVER_NUM_ITERATIONS; ++i){
+		size_t c;
+		for(c = 0; c < numColours; ++c){
+			size_t b;
+			for(b = colourBlocks[c]; b < colourBlocks[c + 1]; ++b){
+				const physicsContactBlock *const block = &blocks[b];
+				byte_t lane;
+
+				for(lane = 0; lane < block->numLanes; ++lane){
+					physContactConstraintsSolveVelocity(&constraints, block->manifold[lane], scalarBodies);
+				}
+				physContactBlockSolveVelocity(&blocks[b], simdBodies);
+			}
+		}
+	}
+
+	for(i = 0; i < numBlocks; ++i){
+		const physicsContactBlock *const block = &blocks[i];
+		byte_t lane;
+
+		for(lane = 0; lane < block->numLanes; ++lane){
+			const size_t manifold = block->manifold[lane];
+			contactPointIndex p;
+
+			for(p = 0; p < constraints.numPoints[manifold]; ++p){
+				const size_t point = constraints.pointOffset[manifold] + p;
+				float error = relativeError(constraints.normalImpulse[point], block->normalImpulse[p][lane]);
+				if(error > maxImpulseError){
+					maxImpulseError = error;
+				}
+				error = relativeError(constraints.tangentImpulseA[point], block->tangentImpulseA[p][lane]);
+				if(error > maxImpulseError){
+					maxImpulseError = error;
+				}
+				error = relativeError(constraints.tangentImpulseB[point], block->tangentImpulseB[p][lane]);
+				if(error > maxImpulseError){
+					maxImpulseError = error;
+				}
+			}
+		}
+	}
+	for(i = 0; i < numBodies; ++i){
+		const float *const scalarVelocity = (const float *)&scalarBodies[i];
+		const float *const simdVelocity = (const float *)&simdBodies[i];
+		size_t j;
+
+		// Compare both the linear and angular velocities.
+		for(j = 0; j < 6; ++j){
+			const float error = relativeError(scalarVelocity[j], simdVelocity[j]);
+			if(error > maxVelocityError){
+				maxVelocityError = error;
+			}
+		}
+	}
+
+	printf(
+		"          solvers: %u contacts  %u colours  max impulse error %g  max velocity error %g  %s\n",
+		(unsigned int)numContacts, (unsigned int)numColours, maxImpulseError, maxVelocityError,
+		(maxImpulseError <= BENCH_SOLVER_TOLERANCE && maxVelocityError <= BENCH_SOLVER_TOLERANCE) ? "ok" : "MISMATCH"
+	);
+
+
+	physContactConstraintsDelete(&constraints);
+	memoryManagerGlobalFree(bodyUsed);
+	memoryManagerGlobalFree(colourBlocks);
+	memoryManagerGlobalFree(blocks);
+	memoryManagerGlobalFree(pairs);
+	memoryManagerGlobalFree(simdBodies);
+	memoryManagerGlobalFree(scalarBodies);
+}
+
+// Return the index the island's solver would give a body.
+static size_t solverBodyIndex(const physicsRigidBody *const restrict body){
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE)){
+		return(body->islandIndex);
+	}
+	return(PHYSCONTACT_STATIC_SOLVER_BODY);
+}
+
+// Return the difference between two values, relative to the larger of them if it exceeds one.
+static float relativeError(const float a, const float b){
+	const float scale = fmaxf(1.f, fmaxf(fabsf(a), fabsf(b)));
+	return(fabsf(a - b)/scale);
+}
+#endif
+
+
+/*
+** Compare the SAT and GJK narrowphase tests for hulls.
+** The sphere has enough faces that the island would use
+** GJK for it, whereas boxes use SAT by default.
+*/
+static void runNarrowphase(){
+	benchShapes shapes;
+
+	randomSeed(BENCH_RANDOM_SEED);
+	if(!modulePhysicsSetup() || !createShapes(&shapes)){
+		printf("Unable to set up the narrowphase benchmark!\n");
+		modulePhysicsCleanup();
+		return;
+	}
+
+	benchNarrowphase("box", shapes.box);
+	benchNarrowphase("sphere", shapes.sphere);
+
+	modulePhysicsCleanup();
+}
+
+/*
+** Time both narrowphase tests on pairs of randomly rotated
+** instances of a body's hull. Each pair is placed so that
+** the hulls barely overlap, which is where the tests do the
+** most work and where contacts usually are in a simulation.
+*/
+static void benchNarrowphase(const char *const restrict name, const physicsRigidBodyDef *const restrict bodyDef){
+	const collider *const base = &bodyDef->colliders->global;
+	collider *const hulls = memoryManagerGlobalAlloc(2 * BENCH_NARROWPHASE_NUM_PAIRS * sizeof(*hulls));
+	const vec3 origin = vec3InitSetC(0.f, 0.f, 0.f);
+	unsigned int numHitsSAT = 0;
+	unsigned int numHitsGJK = 0;
+	unsigned int numAgreed = 0;
+	float timeSAT;
+	float timeGJK;
+	timerVal start;
+	size_t i;
+	size_t j;
+
+
+	if(hulls == NULL){
+		/** MALLOC FAILED **/
+	}
+
+	for(i = 0; i < 2 * BENCH_NARROWPHASE_NUM_PAIRS; i += 2){
+		const quat rotA = quatInitEulerXYZC(randomFloat(-M_PI, M_PI), randomFloat(-M_PI_2, M_PI_2), randomFloat(-M_PI, M_PI));
+		const quat rotB = quatInitEulerXYZC(randomFloat(-M_PI, M_PI), randomFloat(-M_PI_2, M_PI_2), randomFloat(-M_PI, M_PI));
+		const vec3 dir = vec3NormalizeC(randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f));
+		float minDistance = 0.f;
+		float maxDistance = BENCH_NARROWPHASE_MAX_DISTANCE;
+		vec3 pos;
+
+		colliderInstantiate(&hulls[i], base);
+		colliderInstantiate(&hulls[i + 1], base);
+		placeCollider(&hulls[i], bodyDef, &origin, &rotA);
+		placeCollider(&hulls[i + 1], bodyDef, &origin, &rotB);
+
+		// Find how far along "dir" the second hull must be
+		// moved so that it's just touching the first one.
+		for(j = 0; j < BENCH_NARROWPHASE_NUM_SEARCH_STEPS; ++j){
+			const float distance = 0.5f*(minDistance + maxDistance);
+			colliderGJKSimplex simplex;
+			vec3 normal;
+
+			vec3MultiplySOut(&dir, distance, &pos);
+			if(colliderGJKDistance(&hulls[i + 1], &pos, &hulls[i], &colliderSupport, &simplex, &normal) > 0.f){
+				maxDistance = distance;
+			}else{
+				minDistance = distance;
+			}
+		}
+		vec3MultiplySOut(&dir, maxDistance - randomFloat(0.f, BENCH_NARROWPHASE_MAX_PENETRATION), &pos);
+		placeCollider(&hulls[i + 1], bodyDef, &pos, &rotB);
+	}
+
+	for(i = 0; i < 2 * BENCH_NARROWPHASE_NUM_PAIRS; i += 2){
+		contactSeparation separation;
+		contactManifold manifold;
+		const return_t collidingSAT = colliderHullCollidingSAT(&hulls[i].data.hull, &hulls[i + 1].data.hull, &separation, &manifold);
+		const return_t collidingGJK = colliderHullCollidingGJK(&hulls[i].data.hull, &hulls[i + 1].data.hull, &separation, &manifold);
+
+		numHitsSAT += collidingSAT;
+		numHitsGJK += collidingGJK;
+		numAgreed += (collidingSAT == collidingGJK);
+	}
+
+	start = timerStart();
+	for(j = 0; j < BENCH_NARROWPHASE_NUM_REPEATS; ++j){
+		for(i = 0; i < 2 * BENCH_NARROWPHASE_NUM_PAIRS; i += 2){
+			contactSeparation separation;
+			contactManifold manifold;
+			colliderHullCollidingSAT(&hulls[i].data.hull, &hulls[i + 1].data.hull, &separation, &manifold);
+		}
+	}
+	timeSAT = timerStopFloat(start);
+	start = timerStart();
+	for(j = 0; j < BENCH_NARROWPHASE_NUM_REPEATS; ++j){
+		for(i = 0; i < 2 * BENCH_NARROWPHASE_NUM_PAIRS; i += 2){
+			contactSeparation separation;
+			contactManifold manifold;
+			colliderHullCollidingGJK(&hulls[i].data.hull, &hulls[i + 1].data.hull, &separation, &manifold);
+		}
+	}
+	timeGJK = timerStopFloat(start);
+
+	// Timers are in milliseconds, but we want microseconds per pair.
+	printf(
+		"%-8s  %4u faces  SAT %8.2f us/pair  GJK %8.2f us/pair  colliding %u/%u  %u/%u  agreed %u/%u\n",
+		name, (unsigned int)base->data.hull.numFaces,
+		1000.f*timeSAT/(BENCH_NARROWPHASE_NUM_REPEATS * BENCH_NARROWPHASE_NUM_PAIRS),
+		1000.f*timeGJK/(BENCH_NARROWPHASE_NUM_REPEATS * BENCH_NARROWPHASE_NUM_PAIRS),
+		numHitsSAT, BENCH_NARROWPHASE_NUM_PAIRS, numHitsGJK, BENCH_NARROWPHASE_NUM_PAIRS,
+		numAgreed, BENCH_NARROWPHASE_NUM_PAIRS
+	);
+
+
+	for(i = 0; i < 2 * BENCH_NARROWPHASE_NUM_PAIRS; ++i){
+		colliderDeleteInstance(&hulls[i]);
+	}
+	memoryManagerGlobalFree(hulls);
+}
+
+// Move an instance of a body's collider so that the body's centroid is at "pos".
+static void placeCollider(
+	collider *const restrict c, const physicsRigidBodyDef *const restrict bodyDef,
+	const vec3 *const restrict pos, const quat *const restrict rot
+){
+
+	transform trans;
+	colliderAABB aabb;
+
+	transformInit(&trans);
+	trans.pos = *pos;
+	trans.rot = *rot;
+	colliderUpdate(c, pos, &bodyDef->colliders->global, &bodyDef->centroid, &trans, &aabb);
+}
+
+
+/*
+** Cast rays into the spheres scene, which has 10,000 spheres by
+** default, after it has been stepped once to insert them into the
+** broadphase. We try both coherent rays, which point down into the
+** spheres in tight groups like the rays of a camera would, and rays
+** going in random directions from random points.
+*/
+static void runRaycasts(const benchOptions *const restrict options){
+	physicsIsland island;
+	threadPool workers;
+	byte_t hasWorkers = 0;
+	benchShapes shapes;
+
+	const size_t count = (options->count > 0) ? options->count : scenes[1].defaultCount;
+	// The spheres are spread out over a square grid.
+	const float halfWidth = 2.f*BENCH_SPHERE_RADIUS*ceilf(sqrtf((float)count/4.f));
+	vec3 *const origins = memoryManagerGlobalAlloc(BENCH_RAYCAST_NUM_RAYS * sizeof(*origins));
+	vec3 *const dirs = memoryManagerGlobalAlloc(BENCH_RAYCAST_NUM_RAYS * sizeof(*dirs));
+	float *const maxDistances = memoryManagerGlobalAlloc(BENCH_RAYCAST_NUM_RAYS * sizeof(*maxDistances));
+	physicsRaycastHit *const hits = memoryManagerGlobalAlloc(BENCH_RAYCAST_NUM_RAYS * sizeof(*hits));
+	physicsRaycastHit *const batchHits = memoryManagerGlobalAlloc(BENCH_RAYCAST_NUM_RAYS * sizeof(*batchHits));
+	size_t i;
+
+
+	if(origins == NULL || dirs == NULL || maxDistances == NULL || hits == NULL || batchHits == NULL){
+		/** MALLOC FAILED **/
+	}
+	randomSeed(BENCH_RANDOM_SEED);
+	if(!modulePhysicsSetup() || !createShapes(&shapes)){
+		printf("Unable to set up the raycast benchmark!\n");
+		modulePhysicsCleanup();
+		return;
+	}
+
+	physIslandInit(&island);
+	if(!physIslandSetBroadphase(&island, options->broadphase)){
+		printf("Invalid broadphase %u, using the default.\n", (unsigned int)options->broadphase);
+	}
+	if(options->numThreads > 1 && threadPoolInit(&workers, options->numThreads)){
+		island.workers = &workers;
+		hasWorkers = 1;
+	}
+	buildSpheres(&island, &shapes, count);
+	memArenaGlobalNextFrame();
+	physIslandUpdate(&island, BENCH_TIMESTEP);
+
+	for(i = 0; i < BENCH_RAYCAST_NUM_RAYS; i += AABBTREE_RAY_PACKET_WIDTH){
+		const float x = randomFloat(-halfWidth, halfWidth);
+		const float z = randomFloat(-halfWidth, halfWidth);
+		size_t j;
+
+		for(j = i; j < i + AABBTREE_RAY_PACKET_WIDTH && j < BENCH_RAYCAST_NUM_RAYS; ++j){
+			origins[j] = vec3InitSetC(
+				x + randomFloat(-BENCH_RAYCAST_PACKET_SPREAD, BENCH_RAYCAST_PACKET_SPREAD), 20.f,
+				z + randomFloat(-BENCH_RAYCAST_PACKET_SPREAD, BENCH_RAYCAST_PACKET_SPREAD)
+			);
+			dirs[j] = vec3NormalizeC(randomFloat(-0.1f, 0.1f), -1.f, randomFloat(-0.1f, 0.1f));
+			maxDistances[j] = BENCH_RAYCAST_MAX_DISTANCE;
+		}
+	}
+	benchRaycasts(&island, "coherent", origins, dirs, maxDistances, hits, batchHits);
+
+	for(i = 0; i < BENCH_RAYCAST_NUM_RAYS; ++i){
+		origins[i] = vec3InitSetC(randomFloat(-halfWidth, halfWidth), randomFloat(0.f, 10.f), randomFloat(-halfWidth, halfWidth));
+		dirs[i] = vec3NormalizeC(randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f), randomFloat(-1.f, 1.f));
+	}
+	benchRaycasts(&island, "random", origins, dirs, maxDistances, hits, batchHits);
+
+
+	if(hasWorkers){
+		threadPoolDelete(&workers);
+	}
+	physIslandDelete(&island);
+	modulePhysicsCleanup();
+	memoryManagerGlobalFree(batchHits);
+	memoryManagerGlobalFree(hits);
+	memoryManagerGlobalFree(maxDistances);
+	memoryManagerGlobalFree(dirs);
+	memoryManagerGlobalFree(origins);
+}
+
+/*
+** Time casting a set of rays one at a time and as a batch, then
+** make sure both methods found the same hits. If the island has
+** workers, the batch is split between them.
+*/
+static void benchRaycasts(
+	physicsIsland *const restrict island, const char *const restrict name,
+	const vec3 *const restrict origins, const vec3 *const restrict dirs, const float *const restrict maxDistances,
+	physicsRaycastHit *const restrict hits, physicsRaycastHit *const restrict batchHits
+){
+
+	const physicsColliderLayer mask = valueInvalid(physicsColliderLayer);
+	unsigned int numHits = 0;
+	unsigned int numMismatches = 0;
+	float timeSingle;
+	float timeBatch;
+	timerVal start;
+	size_t i;
+	size_t j;
+
+	start = timerStart();
+	for(j = 0; j < BENCH_RAYCAST_NUM_REPEATS; ++j){
+		for(i = 0; i < BENCH_RAYCAST_NUM_RAYS; ++i){
+			if(!physIslandRaycast(island, &origins[i], &dirs[i], maxDistances[i], mask, &hits[i])){
+				hits[i].collider = NULL;
+			}
+		}
+	}
+	timeSingle = timerStopFloat(start);
+	start = timerStart();
+	for(j = 0; j < BENCH_RAYCAST_NUM_REPEATS; ++j){
+		physIslandRaycastBatch(island, origins, dirs, maxDistances, BENCH_RAYCAST_NUM_RAYS, mask, batchHits);
+	}
+	timeBatch = timerStopFloat(start);
+
+	for(i = 0; i < BENCH_RAYCAST_NUM_RAYS; ++i){
+		if(hits[i].collider != NULL){
+			++numHits;
+		}
+		if(
+			hits[i].collider != batchHits[i].collider ||
+			(hits[i].collider != NULL && fabsf(hits[i].distance - batchHits[i].distance) > BENCH_RAYCAST_TOLERANCE)
+		){
+			++numMismatches;
+		}
+	}
+
+	// Timers are in milliseconds, so this gives millions of rays per second.
+	printf(
+		"%-8s  %6u rays  single %6.2f Mrays/s  batched %6.2f Mrays/s  hits %6u  mismatches %u\n",
+		name, BENCH_RAYCAST_NUM_RAYS,
+		BENCH_RAYCAST_NUM_REPEATS * BENCH_RAYCAST_NUM_RAYS/(1000.f*timeSingle),
+		BENCH_RAYCAST_NUM_REPEATS * BENCH_RAYCAST_NUM_RAYS/(1000.f*timeBatch),
+		numHits, numMismatches
+	);
+}
+
+
+// A pyramid of boxes, where "count" is the number of boxes along each side of its base.
+static void buildPyramid(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count){
+	addGround(island, shapes);
+	addPyramid(island, shapes, count, vec3InitZeroC());
+}
+
+// A large number of spheres dropped onto the ground in a loose grid.
+static void buildSpheres(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count){
+	addGround(island, shapes);
+	addSpheres(island, shapes, count, vec3InitZeroC());
+}
+
+// Randomly shaped and oriented hulls dropped into a tight pile.
+static void buildRubble(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count){
+	addGround(island, shapes);
+	addRubble(island, shapes, count, vec3InitZeroC());
+}
+
+// Chains of bodies connected by sphere joints, hanging from static anchors.
+static void buildChains(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count){
+	addGround(island, shapes);
+	addChains(island, shapes, count, vec3InitZeroC());
+}
+
+/*
+** Each of the other scenes side-by-side, with "count" split
+** between them. The scenes are far enough apart that they
+** don't interact until the spheres start to spread out.
+*/
+static void buildMixed(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count){
+	addGround(island, shapes);
+	addPyramid(island, shapes, 8, vec3InitSetC(-30.f, 0.f, -30.f));
+	addSpheres(island, shapes, count/2, vec3InitSetC(30.f, 0.f, -30.f));
+	addRubble(island, shapes, count/4, vec3InitSetC(-30.f, 0.f, 30.f));
+	addChains(island, shapes, count/40, vec3InitSetC(30.f, 0.f, 30.f));
+}
+
+
+static void addPyramid(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t baseSize, const vec3 origin){
+	// Leave a small gap between the boxes so
+	// they don't start off touching their sides.
+	const float spacing = 1.05f;
+	size_t layer;
+
+	for(layer = 0; layer < baseSize; ++layer){
+		const size_t layerSize = baseSize - layer;
+		const float offset = 0.5f*spacing*(layerSize - 1);
+		size_t x;
+
+		for(x = 0; x < layerSize; ++x){
+			size_t z;
+			for(z = 0; z < layerSize; ++z){
+				const vec3 pos = vec3InitSetC(
+					origin.x + spacing*x - offset,
+					origin.y + 0.5f + layer,
+					origin.z + spacing*z - offset
+				);
+				insertBody(island, createBody(shapes->box, pos, quatInitIdentityC()));
+			}
+		}
+	}
+}
+
+static void addSpheres(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count, const vec3 origin){
+	const size_t rowSize = (size_t)ceilf(sqrtf((float)count/4.f));
+	const float spacing = 4.f*BENCH_SPHERE_RADIUS;
+	const float offset = 0.5f*spacing*(rowSize - 1);
+	size_t i;
+
+	for(i = 0; i < count; ++i){
+		const size_t layer = i/(rowSize*rowSize);
+		const size_t x = (i/rowSize) % rowSize;
+		const size_t z = i % rowSize;
+		// Jitter the spheres slightly so the
+		// stacks don't stay perfectly balanced.
+		const vec3 pos = vec3InitSetC(
+			origin.x + spacing*x - offset + randomFloat(-0.1f, 0.1f),
+			origin.y + 2.f + spacing*layer,
+			origin.z + spacing*z - offset + randomFloat(-0.1f, 0.1f)
+		);
+		insertBody(island, createBody(shapes->sphere, pos, quatInitIdentityC()));
+	}
+}
+
+static void addRubble(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count, const vec3 origin){
+	const size_t rowSize = 10;
+	const float spacing = 1.3f;
+	const float offset = 0.5f*spacing*(rowSize - 1);
+	size_t i;
+
+	for(i = 0; i < count; ++i){
+		const size_t layer = i/(rowSize*rowSize);
+		const size_t x = (i/rowSize) % rowSize;
+		const size_t z = i % rowSize;
+		const vec3 pos = vec3InitSetC(
+			origin.x + spacing*x - offset + randomFloat(-0.1f, 0.1f),
+			origin.y + 2.f + spacing*layer,
+			origin.z + spacing*z - offset + randomFloat(-0.1f, 0.1f)
+		);
+		const quat rot = quatInitEulerXYZC(
+			randomFloat(-M_PI, M_PI), randomFloat(-M_PI_2, M_PI_2), randomFloat(-M_PI, M_PI)
+		);
+		const physicsRigidBodyDef *const bodyDef = shapes->rubble[(size_t)randomFloat(0.f, BENCH_NUM_RUBBLE_SHAPES - 0.5f)];
+		insertBody(island, createBody(bodyDef, pos, rot));
+	}
+}
+
+static void addChains(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const size_t count, const vec3 origin){
+	const size_t rowSize = (size_t)ceilf(sqrtf((float)count));
+	// The chains start off horizontal, so we need to
+	// leave enough room between the rows for them.
+	const float spacingX = (BENCH_CHAIN_LINK_LENGTH + BENCH_CHAIN_LINK_GAP)*BENCH_CHAIN_LENGTH + 1.f;
+	// Neighbouring chains in each row are
+	// close enough to swing into each other.
+	const float spacingZ = 0.5f;
+	const float offsetX = 0.5f*spacingX*(rowSize - 1);
+	const float offsetZ = 0.5f*spacingZ*(rowSize - 1);
+	size_t i;
+
+	for(i = 0; i < count; ++i){
+		addChain(island, shapes, vec3InitSetC(
+			origin.x + spacingX*(i/rowSize) - offsetX,
+			origin.y + 2.f + (BENCH_CHAIN_LINK_LENGTH + BENCH_CHAIN_LINK_GAP)*BENCH_CHAIN_LENGTH,
+			origin.z + spacingZ*(i % rowSize) - offsetZ
+		));
+	}
+}
+
+/*
+** Build a horizontal chain hanging from a static anchor at
+** "origin", which will swing down when the simulation starts.
+** Every second joint is a cone, and the rest are hinges.
+**
+** The revolute joint hasn't been implemented yet, so the
+** hinges are sphere joints that only allow rotation about
+** the z-axis. Jointed bodies still collide with each other,
+** so we leave a small gap between each pair of links.
+*/
+static void addChain(physicsIsland *const restrict island, const benchShapes *const restrict shapes, const vec3 origin){
+	physicsRigidBody *links[BENCH_CHAIN_LENGTH + 1];
+	const float spacing = BENCH_CHAIN_LINK_LENGTH + BENCH_CHAIN_LINK_GAP;
+	size_t i;
+
+	links[0] = createBody(shapes->anchor, vec3InitSetC(origin.x - 0.1f - BENCH_CHAIN_LINK_GAP, origin.y, origin.z), quatInitIdentityC());
+	makeStatic(links[0]);
+
+	for(i = 1; i <= BENCH_CHAIN_LENGTH; ++i){
+		// Joints are placed halfway between each pair of links.
+		const float jointX = origin.x + spacing*(i - 1);
+		links[i] = createBody(shapes->link, vec3InitSetC(jointX + 0.5f*spacing, origin.y, origin.z), quatInitIdentityC());
+
+		if(i & 1){
+			addSphereJoint(
+				links[i - 1], links[i], vec3InitSetC(jointX, origin.y, origin.z),
+				-M_PI_4, M_PI_4, -M_PI_4, M_PI_4, -M_PI_4, M_PI_4
+			);
+		}else{
+			addSphereJoint(
+				links[i - 1], links[i], vec3InitSetC(jointX, origin.y, origin.z),
+				-0.1f, 0.1f, -0.1f, 0.1f, -M_PI_2, M_PI_2
+			);
+		}
+	}
+
+	// The joints need to be added before the
+	// bodies so the island can find them.
+	for(i = 0; i <= BENCH_CHAIN_LENGTH; ++i){
+		insertBody(island, links[i]);
+	}
+}
+
+// Add a large static box for everything else to land on.
+static void addGround(physicsIsland *const restrict island, const benchShapes *const restrict shapes){
+	physicsRigidBody *const ground = createBody(shapes->ground, vec3InitSetC(0.f, -0.5f, 0.f), quatInitIdentityC());
+	makeStatic(ground);
+	insertBody(island, ground);
+}
+
+static void makeStatic(physicsRigidBody *const restrict body){
+	body->mass = 0.f;
+	mat3InitZero(&body->invInertiaLocal);
+	mat3InitZero(&body->invInertiaGlobal);
+	body->invMass = 0.f;
+	physRigidBodyIgnoreSimulation(body);
+}
+
+
+static physicsRigidBody *createBody(const physicsRigidBodyDef *const restrict bodyDef, const vec3 pos, const quat rot){
+	physicsRigidBody *const body = modulePhysicsRigidBodyAlloc();
+	if(body == NULL){
+		/** MALLOC FAILED **/
+	}
+
+	physRigidBodyInit(body, bodyDef);
+	body->state.pos = pos;
+	body->state.rot = rot;
+	physRigidBodyCentroidFromPosition(body);
+	physRigidBodyUpdateGlobalInertia(body);
+
+	return(body);
+}
+
+static void insertBody(physicsIsland *const restrict island, physicsRigidBody *const restrict body){
+	physIslandInsertRigidBody(island, body);
+}
+
+// Join two bodies that haven't been rotated yet at the global point "anchor".
+static void addSphereJoint(
+	physicsRigidBody *const restrict bodyA, physicsRigidBody *const restrict bodyB, const vec3 anchor,
+	const float minX, const float maxX, const float minY, const float maxY, const float minZ, const float maxZ
+){
+
+	physicsJoint *const joint = modulePhysicsJointAlloc();
+	const vec3 anchorA = vec3SubtractVec3C(anchor, bodyA->state.pos);
+	const vec3 anchorB = vec3SubtractVec3C(anchor, bodyB->state.pos);
+	const quat rotOffset = quatInitIdentityC();
+
+	if(joint == NULL){
+		/** MALLOC FAILED **/
+	}
+
+	physJointSphereInit(
+		&joint->data.sphere,
+		&anchorA, &anchorB,
+		&rotOffset, &rotOffset,
+		0.f,
+		minX, maxX,
+		minY, maxY,
+		minZ, maxZ
+	);
+	joint->type = PHYSJOINT_TYPE_SPHERE;
+	physJointAdd(joint, bodyA, bodyB);
+}
+
+
+// Create the rigid body definitions used by every scene.
+static return_t createShapes(benchShapes *const restrict shapes){
+	size_t i;
+
+	shapes->ground = createBoxDef(vec3InitSetC(0.5f*BENCH_GROUND_SIZE, 0.5f, 0.5f*BENCH_GROUND_SIZE), 0.f);
+	shapes->box = createBoxDef(vec3InitSetC(0.5f, 0.5f, 0.5f), 1.f);
+	shapes->sphere = createIcosphereDef(BENCH_SPHERE_RADIUS, 1.f);
+	if(shapes->ground == NULL || shapes->box == NULL || shapes->sphere == NULL){
+		return(0);
+	}
+
+	// Rubble is made up of boxes, octahedra and wedges with random proportions.
+	for(i = 0; i < BENCH_NUM_RUBBLE_SHAPES; ++i){
+		const vec3 halfSize = vec3InitSetC(randomFloat(0.2f, 0.6f), randomFloat(0.2f, 0.6f), randomFloat(0.2f, 0.6f));
+		const float mass = 8.f*halfSize.x*halfSize.y*halfSize.z;
+
+		switch(i % 3){
+			case 0:
+				shapes->rubble[i] = createBoxDef(halfSize, mass);
+			break;
+			case 1:
+				shapes->rubble[i] = createOctahedronDef(halfSize, mass);
+			break;
+			default:
+				shapes->rubble[i] = createWedgeDef(halfSize, mass);
+		}
+		if(shapes->rubble[i] == NULL){
+			return(0);
+		}
+	}
+
+	shapes->anchor = createBoxDef(vec3InitSetC(0.1f, 0.1f, 0.1f), 0.f);
+	shapes->link = createBoxDef(vec3InitSetC(0.5f*BENCH_CHAIN_LINK_LENGTH, 0.06f, 0.06f), 2.f);
+
+	return(shapes->anchor != NULL && shapes->link != NULL);
+}
+
+static physicsRigidBodyDef *createBoxDef(const vec3 halfSize, const float mass){
+	const vec3 vertices[8] = {
+		{.x = -halfSize.x, .y = -halfSize.y, .z = -halfSize.z},
+		{.x = -halfSize.x, .y = -halfSize.y, .z =  halfSize.z},
+		{.x = -halfSize.x, .y =  halfSize.y, .z = -halfSize.z},
+		{.x = -halfSize.x, .y =  halfSize.y, .z =  halfSize.z},
+		{.x =  halfSize.x, .y = -halfSize.y, .z = -halfSize.z},
+		{.x =  halfSize.x, .y = -halfSize.y, .z =  halfSize.z},
+		{.x =  halfSize.x, .y =  halfSize.y, .z = -halfSize.z},
+		{.x =  halfSize.x, .y =  halfSize.y, .z =  halfSize.z}
+	};
+	const size_t faces[] = {
+		4, 0, 1, 3, 2,
+		4, 4, 6, 7, 5,
+		4, 0, 4, 5, 1,
+		4, 2, 3, 7, 6,
+		4, 0, 2, 6, 4,
+		4, 1, 5, 7, 3
+	};
+
+	return(createHullDef(vertices, 8, faces, 6, mass));
+}
+
+static physicsRigidBodyDef *createOctahedronDef(const vec3 halfSize, const float mass){
+	const vec3 vertices[6] = {
+		{.x = -halfSize.x, .y = 0.f, .z = 0.f},
+		{.x =  halfSize.x, .y = 0.f, .z = 0.f},
+		{.x = 0.f, .y = -halfSize.y, .z = 0.f},
+		{.x = 0.f, .y =  halfSize.y, .z = 0.f},
+		{.x = 0.f, .y = 0.f, .z = -halfSize.z},
+		{.x = 0.f, .y = 0.f, .z =  halfSize.z}
+	};
+	const size_t faces[] = {
+		3, 0, 2, 4,
+		3, 0, 2, 5,
+		3, 0, 3, 4,
+		3, 0, 3, 5,
+		3, 1, 2, 4,
+		3, 1, 2, 5,
+		3, 1, 3, 4,
+		3, 1, 3, 5
+	};
+
+	return(createHullDef(vertices, 6, faces, 8, mass));
+}
+
+// A triangular prism, which is good at landing on its side.
+static physicsRigidBodyDef *createWedgeDef(const vec3 halfSize, const float mass){
+	const vec3 vertices[6] = {
+		{.x = -halfSize.x, .y = -halfSize.y, .z = -halfSize.z},
+		{.x =  halfSize.x, .y = -halfSize.y, .z = -halfSize.z},
+		{.x =  0.f,        .y =  halfSize.y, .z = -halfSize.z},
+		{.x = -halfSize.x, .y = -halfSize.y, .z =  halfSize.z},
+		{.x =  halfSize.x, .y = -halfSize.y, .z =  halfSize.z},
+		{.x =  0.f,        .y =  halfSize.y, .z =  halfSize.z}
+	};
+	const size_t faces[] = {
+		3, 0, 1, 2,
+		3, 3, 4, 5,
+		4, 0, 1, 4, 3,
+		4, 1, 2, 5, 4,
+		4, 2, 0, 3, 5
+	};
+
+	return(createHullDef(vertices, 6, faces, 5, mass));
+}
+
+/*
+** Create an icosphere by repeatedly splitting each face
+** of an icosahedron into four and projecting the new
+** vertices onto the sphere.
+*/
+static physicsRigidBodyDef *createIcosphereDef(const float radius, const float mass){
+	// Golden ratio, used for the icosahedron's vertices.
+	const float t = 0.5f*(1.f + sqrtf(5.f));
+	vec3 vertices[BENCH_SPHERE_MAX_VERTICES] = {
+		{.x = -1.f, .y =  t,   .z =  0.f}, {.x =  1.f, .y =  t,   .z =  0.f},
+		{.x = -1.f, .y = -t,   .z =  0.f}, {.x =  1.f, .y = -t,   .z =  0.f},
+		{.x =  0.f, .y = -1.f, .z =  t  }, {.x =  0.f, .y =  1.f, .z =  t  },
+		{.x =  0.f, .y = -1.f, .z = -t  }, {.x =  0.f, .y =  1.f, .z = -t  },
+		{.x =  t,   .y =  0.f, .z = -1.f}, {.x =  t,   .y =  0.f, .z =  1.f},
+		{.x = -t,   .y =  0.f, .z = -1.f}, {.x = -t,   .y =  0.f, .z =  1.f}
+	};
+	size_t faces[2][4*BENCH_SPHERE_MAX_FACES] = {{
+		3, 0, 11, 5,  3, 0, 5, 1,   3, 0, 1, 7,   3, 0, 7, 10,  3, 0, 10, 11,
+		3, 1, 5, 9,   3, 5, 11, 4,  3, 11, 10, 2, 3, 10, 7, 6,  3, 7, 1, 8,
+		3, 3, 9, 4,   3, 3, 4, 2,   3, 3, 2, 6,   3, 3, 6, 8,   3, 3, 8, 9,
+		3, 4, 9, 5,   3, 2, 4, 11,  3, 6, 2, 10,  3, 8, 6, 7,   3, 9, 8, 1
+	}};
+	size_t numVertices = 12;
+	size_t numFaces = 20;
+	size_t curFaces = 0;
+	size_t i;
+
+	for(i = 0; i < BENCH_SPHERE_SUBDIVISIONS; ++i){
+		const size_t *oldFace = faces[curFaces];
+		size_t *newFace = faces[!curFaces];
+		size_t j;
+
+		for(j = 0; j < numFaces; ++j, oldFace += 4){
+			size_t midpoints[3];
+			size_t k;
+
+			// Find the midpoint of each edge, reusing
+			// any that were added by neighbouring faces.
+			for(k = 0; k < 3; ++k){
+				const vec3 midpoint = vec3MultiplySC(vec3AddVec3C(vertices[oldFace[k + 1]], vertices[oldFace[(k + 1) % 3 + 1]]), 0.5f);
+				size_t l;
+
+				for(l = 12; l < numVertices; ++l){
+					if(vec3DistanceSquaredVec3C(vertices[l], midpoint) < 1e-6f){
+						break;
+					}
+				}
+				if(l == numVertices){
+					vertices[numVertices++] = midpoint;
+				}
+				midpoints[k] = l;
+			}
+
+			newFace[0] = 3; newFace[1] = oldFace[1]; newFace[2] = midpoints[0]; newFace[3] = midpoints[2];
+			newFace[4] = 3; newFace[5] = oldFace[2]; newFace[6] = midpoints[1]; newFace[7] = midpoints[0];
+			newFace[8] = 3; newFace[9] = oldFace[3]; newFace[10] = midpoints[2]; newFace[11] = midpoints[1];
+			newFace[12] = 3; newFace[13] = midpoints[0]; newFace[14] = midpoints[1]; newFace[15] = midpoints[2];
+			newFace += 16;
+		}
+
+		numFaces *= 4;
+		curFaces = !curFaces;
+	}
+
+	// Move every vertex onto the sphere.
+	for(i = 0; i < numVertices; ++i){
+		vertices[i] = vec3MultiplySC(vec3NormalizeVec3C(vertices[i]), radius);
+	}
+
+	return(createHullDef(vertices, numVertices, faces[curFaces], numFaces, mass));
+}
+
+/*
+** Create a rigid body definition with a single hull collider.
+** Rather than building the hull ourselves, we write it out in
+** the format used by rigid body files and load it back in, so
+** it's set up exactly the same way as the application's hulls.
+**
+** The faces are given as a list of vertex counts, each of which
+** is followed by that many vertex indices. Their winding doesn't
+** matter, as we make them anticlockwise when they're written.
+** The vertices' weights are chosen so the hull's inertia tensor
+** corresponds to a body with the given mass.
+*/
+static physicsRigidBodyDef *createHullDef(
+	const vec3 *const restrict vertices, const size_t numVertices,
+	const size_t *restrict faces, const size_t numFaces, const float mass
+){
+
+	physicsRigidBodyDef bodyDef;
+	physicsRigidBodyDef *newDef;
+	physicsCollider *collider;
+	vec3 centroid;
+	mat3 inertia;
+	FILE *const hullFile = tmpfile();
+	size_t i;
+
+	if(hullFile == NULL){
+		printf("Unable to create temporary file for hull!\n");
+		return(NULL);
+	}
+
+	for(i = 0; i < numVertices; ++i){
+		fprintf(hullFile, "v %.9g %.9g %.9g %.9g\n", vertices[i].x, vertices[i].y, vertices[i].z, mass/numVertices);
+	}
+	for(i = 0; i < numFaces; ++i){
+		const size_t numFaceVertices = *faces;
+		const vec3 *const v0 = &vertices[faces[1]];
+		// Every hull contains the origin, so an outward-facing
+		// normal must point away from it. Note that this only
+		// uses the first three vertices, so faces must be planar.
+		const vec3 normal = vec3CrossVec3C(
+			vec3SubtractVec3C(vertices[faces[2]], *v0),
+			vec3SubtractVec3C(vertices[faces[3]], *v0)
+		);
+		const byte_t reverse = (vec3DotVec3C(normal, *v0) < 0.f);
+		size_t j;
+
+		fputc('f', hullFile);
+		for(j = 1; j <= numFaceVertices; ++j){
+			fprintf(hullFile, " %u", (unsigned int)faces[reverse ? numFaceVertices + 1 - j : j]);
+		}
+		fputc('\n', hullFile);
+
+		faces += numFaceVertices + 1;
+	}
+	fputs("}\n", hullFile);
+	rewind(hullFile);
+
+
+	physRigidBodyDefInit(&bodyDef);
+	bodyDef.colliders = modulePhysicsColliderPrepend(&bodyDef.colliders);
+	if(bodyDef.colliders == NULL){
+		/** MALLOC FAILED **/
+	}
+	collider = bodyDef.colliders;
+	// Hulls are loaded as type 0, the same as in "physRigidBodyDefLoad".
+	physColliderInit(collider, 0);
+	if(!colliderLoad(&collider->global, hullFile, &centroid, &inertia)){
+		fclose(hullFile);
+		physColliderDeleteBase(collider);
+		return(NULL);
+	}
+	fclose(hullFile);
+
+	collider->friction = BENCH_FRICTION;
+	collider->restitution = BENCH_RESTITUTION;
+	physRigidBodyDefAddCollider(&bodyDef, mass, &centroid, inertia);
+
+	newDef = modulePhysicsRigidBodyDefAlloc();
+	if(newDef == NULL){
+		/** MALLOC FAILED **/
+	}
+	*newDef = bodyDef;
+
+	return(newDef);
+}
+
+
+/*
+** Hash the state of every rigid body in the island. As the
+** simulation is deterministic, two runs of the same scene
+** should give the same checksum on the same build.
+*/
+static uint_least32_t checksumIsland(const physicsIsland *const restrict island){
+	// FNV-1a offset basis.
+	uint_least32_t hash = 2166136261u;
+	const physicsRigidBody *body;
+
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		hash = checksumBytes(hash, &body->state.pos, sizeof(body->state.pos));
+		hash = checksumBytes(hash, &body->state.rot, sizeof(body->state.rot));
+		hash = checksumBytes(hash, &body->linearVelocity, sizeof(body->linearVelocity));
+		hash = checksumBytes(hash, &body->angularVelocity, sizeof(body->angularVelocity));
+	}
+
+	return(hash);
+}
+
+static uint_least32_t checksumBytes(uint_least32_t hash, const void *const restrict data, const size_t size){
+	const byte_t *curByte = data;
+	const byte_t *const lastByte = &curByte[size];
+
+	for(; curByte < lastByte; ++curByte){
+		hash = ((hash ^ *curByte) * 16777619u) & 0xFFFFFFFF;
+	}
+
+	return(hash);
+}
+
+// Return the "p"th percentile of an array of sorted times.
+static float percentile(const float *const restrict sortedTimes, const size_t numTimes, const float p){
+	return(sortedTimes[(size_t)(p*(numTimes - 1) + 0.5f)]);
+}
+
+static sort_t compareTimes(const void *const restrict t1, const void *const restrict t2){
+	return(compareFloatFast(*((const float *)t1), *((const float *)t2)));
+}
+
+
+static void randomSeed(const uint_least32_t seed){
+	randomState = seed;
+}
+
+// Return a pseudorandom number in the range [min, max] using a linear congruential generator.
+static float randomFloat(const float min, const float max){
+	randomState = (randomState*1664525u + 1013904223u) & 0xFFFFFFFF;
+	return(min + (max - min)*((randomState >> 8)/(float)(1 << 24)));
+}
\ No newline at end of file
@@ -0,0 +1,941 @@
+#include "aabbArrayTree.h"
+
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "memoryManager.h"
+
+
+#define AABBARRAYTREE_NODE_ALIGNMENT 64
+// Leaves deeper than this are only possible if the tree has become
+// very unbalanced, so we rebuild it to keep the query stacks small.
+#define AABBARRAYTREE_MAX_DEPTH 64
+// Past this depth, the bulk build splits nodes in half rather than
+// using the surface area heuristic, which guarantees the depth
+// limit above for any number of leaves that can be indexed.
+#define AABBARRAYTREE_BUILD_SAH_DEPTH (AABBARRAYTREE_MAX_DEPTH/2)
+// Each step of a traversal adds at most two entries to the stack.
+#define AABBARRAYTREE_QUERY_STACK_SIZE (4*AABBARRAYTREE_MAX_DEPTH)
+
+#define isLeaf(child)              ((child) & AABBARRAYTREE_LEAF_FLAG)
+#define proxyIndex(child)          ((child) & ~AABBARRAYTREE_LEAF_FLAG)
+#define makeReference(node, slot)  (((node) << 1) | (slot))
+#define referenceNode(reference)   ((reference) >> 1)
+#define referenceSlot(reference)   ((reference) & 1)
+#define vec3Axis(v, axis)          (((const float *)(v))[axis])
+
+
+// A leaf's bounding box and centre, used by the bulk build.
+typedef struct aabbArrayTreeBuildItem {
+	colliderAABB aabb;
+	// We only need to compare centres, so we
+	// store double the centre to save a multiply.
+	vec3 centre;
+	aabbArrayTreeIndex proxy;
+} aabbArrayTreeBuildItem;
+
+// Range of build items that still need a node.
+typedef struct aabbArrayTreeBuildTask {
+	size_t begin;
+	size_t count;
+	aabbArrayTreeIndex parent;
+	aabbArrayTreeIndex depth;
+} aabbArrayTreeBuildTask;
+
+typedef struct aabbArrayTreeBuildBin {
+	colliderAABB aabb;
+	size_t count;
+} aabbArrayTreeBuildBin;
+
+// Pair of children whose bounding boxes overlap. If both
+// children are the same node, we check it against itself.
+typedef struct aabbArrayTreePair {
+	aabbArrayTreeIndex childA;
+	aabbArrayTreeIndex childB;
+	const colliderAABB *aabbA;
+	const colliderAABB *aabbB;
+} aabbArrayTreePair;
+
+
+// Forward-declare any helper functions!
+static aabbArrayTreeIndex allocateNode(aabbArrayTree *const restrict tree);
+static void freeNode(aabbArrayTree *const restrict tree, const aabbArrayTreeIndex node);
+static void setChild(aabbArrayTree *const restrict tree, const aabbArrayTreeIndex parent, const aabbArrayTreeIndex child);
+static aabbArrayTreeIndex attachProxy(aabbArrayTree *const restrict tree, const aabbArrayTreeIndex proxy);
+static void detachProxy(aabbArrayTree *const restrict tree, const aabbArrayTreeIndex proxy);
+static void refitHierarchy(aabbArrayTree *const restrict tree, aabbArrayTreeIndex node);
+static size_t splitItems(
+	aabbArrayTreeBuildItem *const restrict items, const size_t count, const return_t halve,
+	colliderAABB *const restrict left, colliderAABB *const restrict right
+);
+static void selectMedian(aabbArrayTreeBuildItem *const restrict items, const size_t count, const unsigned int axis);
+
+
+void aabbArrayTreeInit(aabbArrayTree *const restrict tree){
+	memset(tree, 0, sizeof(*tree));
+	tree->root = AABBARRAYTREE_INVALID_INDEX;
+}
+
+
+/*
+** Add the user's data to the tree. The new leaf
+** will be added to the hierarchy on the next query.
+*/
+aabbNode *aabbArrayTreeInsertNode(
+	aabbArrayTree *const restrict tree, const colliderAABB *const restrict aabb,
+	void *const restrict value, aabbNode *(*const allocate)()
+){
+
+	aabbArrayTreeProxy *proxy;
+	aabbNode *const node = (*allocate)();
+	if(node == NULL){
+		/** MALLOC FAILED **/
+	}
+
+	node->aabb = *aabb;
+	node->parent = NULL;
+	node->data.leaf.value = value;
+	node->data.leaf.next = tree->leaves;
+	node->data.leaf.index = tree->numProxies;
+	node->height = AABBNODE_HEIGHT_LEAF;
+	tree->leaves = node;
+
+	// Double the size of the proxy array if it's full.
+	if(tree->numProxies >= tree->proxyCapacity){
+		tree->proxyCapacity = (tree->proxyCapacity > 0) ? 2*tree->proxyCapacity : 16;
+		tree->proxies = memoryManagerGlobalRealloc(tree->proxies, tree->proxyCapacity * sizeof(*tree->proxies));
+		if(tree->proxies == NULL){
+			/** MALLOC FAILED **/
+		}
+	}
+	proxy = &tree->proxies[tree->numProxies];
+	proxy->node = node;
+	proxy->parent = AABBARRAYTREE_INVALID_INDEX;
+	++tree->numProxies;
+
+	// Double the size of the pending array if it's full.
+	if(tree->numPending >= tree->pendingCapacity){
+		tree->pendingCapacity = (tree->pendingCapacity > 0) ? 2*tree->pendingCapacity : 16;
+		tree->pending = memoryManagerGlobalRealloc(tree->pending, tree->pendingCapacity * sizeof(*tree->pending));
+		if(tree->pending == NULL){
+			/** MALLOC FAILED **/
+		}
+	}
+	tree->pending[tree->numPending] = node;
+	++tree->numPending;
+
+	return(node);
+}
+
+/*
+** Remove a node whose bounding box has changed from the
+** hierarchy. It will be reinserted on the next query.
+*/
+void aabbArrayTreeUpdateNode(aabbArrayTree *const restrict tree, aabbNode *const restrict node){
+	const aabbArrayTreeIndex proxy = node->data.leaf.index;
+
+	// Nodes that aren't in the hierarchy are already pending.
+	if(tree->proxies[proxy].parent != AABBARRAYTREE_INVALID_INDEX){
+		detachProxy(tree, proxy);
+
+		if(tree->numPending >= tree->pendingCapacity){
+			tree->pendingCapacity = (tree->pendingCapacity > 0) ? 2*tree->pendingCapacity : 16;
+			tree->pending = memoryManagerGlobalRealloc(tree->pending, tree->pendingCapacity * sizeof(*tree->pending));
+			if(tree->pending == NULL){
+				/** MALLOC FAILED **/
+			}
+		}
+		tree->pending[tree->numPending] = node;
+		++tree->numPending;
+	}
+}
+
+/*
+** Remove a node from the tree. The last proxy is moved into
+** the removed one's place, so we don't have to shift them.
+** The node's leaf is removed from the list before it's
+** passed to "deallocate".
+*/
+void aabbArrayTreeRemoveNode(
+	aabbArrayTree *const restrict tree, aabbNode *const restrict node, void (*const deallocate)(aabbNode *node, void *args), void *args
+){
+
+	const aabbArrayTreeIndex proxy = node->data.leaf.index;
+	const aabbArrayTreeIndex lastProxy = tree->numProxies - 1;
+
+	if(tree->proxies[proxy].parent != AABBARRAYTREE_INVALID_INDEX){
+		detachProxy(tree, proxy);
+
+	// If the node hasn't been added to the hierarchy
+	// yet, we need to remove it from the pending array.
+	}else{
+		aabbNode **curPending = tree->pending;
+		aabbNode **const lastPending = &curPending[tree->numPending];
+		for(; curPending < lastPending; ++curPending){
+			if(*curPending == node){
+				*curPending = NULL;
+				break;
+			}
+		}
+	}
+
+	if(proxy != lastProxy){
+		aabbArrayTreeProxy *const moved = &tree->proxies[proxy];
+
+		*moved = tree->proxies[lastProxy];
+		moved->node->data.leaf.index = proxy;
+		if(moved->parent != AABBARRAYTREE_INVALID_INDEX){
+			tree->nodes[referenceNode(moved->parent)].children[referenceSlot(moved->parent)] = proxy | AABBARRAYTREE_LEAF_FLAG;
+		}
+	}
+	--tree->numProxies;
+
+	// Remove the node from the list of leaves.
+	if(tree->leaves == node){
+		tree->leaves = node->data.leaf.next;
+	}else{
+		aabbNode *prevNode = tree->leaves;
+		while(prevNode->data.leaf.next != node){
+			prevNode = prevNode->data.leaf.next;
+		}
+		prevNode->data.leaf.next = node->data.leaf.next;
+	}
+
+	(*deallocate)(node, args);
+}
+
+/*
+** Rebuild the entire hierarchy from scratch using the surface
+** area heuristic. Rather than trying every possible split, we
+** sort the leaves' centres into a small number of bins along the
+** longest axis and only consider splits between bins, so each
+** level of the tree takes linear time. Nodes are allocated in
+** depth-first order, so a node's left child immediately follows it.
+*/
+void aabbArrayTreeBuild(aabbArrayTree *const restrict tree){
+	const size_t numProxies = tree->numProxies;
+
+	tree->numNodes = 0;
+	tree->root = AABBARRAYTREE_INVALID_INDEX;
+	tree->numPending = 0;
+	tree->numReinserted = 0;
+
+	if(numProxies <= 1){
+		if(numProxies == 1){
+			attachProxy(tree, 0);
+		}
+	}else{
+		aabbArrayTreeBuildItem *const items = memoryManagerGlobalAlloc(numProxies * sizeof(*items));
+		aabbArrayTreeBuildTask *const tasks = memoryManagerGlobalAlloc(numProxies * sizeof(*tasks));
+		size_t numTasks = 1;
+		size_t i;
+
+		if(items == NULL || tasks == NULL){
+			/** MALLOC FAILED **/
+		}
+
+		for(i = 0; i < numProxies; ++i){
+			items[i].aabb = tree->proxies[i].node->aabb;
+			vec3AddVec3Out(&items[i].aabb.min, &items[i].aabb.max, &items[i].centre);
+			items[i].proxy = i;
+		}
+		tasks[0].begin = 0;
+		tasks[0].count = numProxies;
+		tasks[0].parent = AABBARRAYTREE_INVALID_INDEX;
+		tasks[0].depth = 1;
+
+		// A tree with n leaves has n - 1 nodes.
+		while(numTasks > 0){
+			const aabbArrayTreeBuildTask task = tasks[--numTasks];
+			const aabbArrayTreeIndex node = allocateNode(tree);
+			aabbArrayTreeNode *const curNode = &tree->nodes[node];
+			size_t counts[2];
+			size_t begins[2];
+			unsigned int slot;
+
+			curNode->parent = task.parent;
+			setChild(tree, task.parent, node);
+
+			counts[0] = splitItems(
+				&items[task.begin], task.count, task.depth > AABBARRAYTREE_BUILD_SAH_DEPTH,
+				&curNode->aabbs[0], &curNode->aabbs[1]
+			);
+			counts[1] = task.count - counts[0];
+			begins[0] = task.begin;
+			begins[1] = task.begin + counts[0];
+
+			// Push the right child first so the left is built next.
+			for(slot = 2; slot-- > 0;){
+				const aabbArrayTreeIndex reference = makeReference(node, slot);
+				if(counts[slot] == 1){
+					const aabbArrayTreeIndex proxy = items[begins[slot]].proxy;
+					curNode->children[slot] = proxy | AABBARRAYTREE_LEAF_FLAG;
+					tree->proxies[proxy].parent = reference;
+				}else{
+					aabbArrayTreeBuildTask *const newTask = &tasks[numTasks];
+					newTask->begin = begins[slot];
+					newTask->count = counts[slot];
+					newTask->parent = reference;
+					newTask->depth = task.depth + 1;
+					++numTasks;
+				}
+			}
+		}
+
+		memoryManagerGlobalFree(items);
+		memoryManagerGlobalFree(tasks);
+	}
+}
+
+
+/*
+** Add any pending leaves to the hierarchy. If enough leaves have
+** been added one at a time since the tree was last built, or the
+** tree has become too deep, we rebuild it from scratch instead.
+** Queries do this themselves, but calling it beforehand means
+** that they won't modify the tree, so they can run concurrently.
+*/
+void aabbArrayTreeFlush(aabbArrayTree *const restrict tree){
+	if(tree->numPending > 0){
+		tree->numReinserted += tree->numPending;
+		if(tree->numReinserted * AABBARRAYTREE_REBUILD_DIVISOR >= tree->numProxies){
+			aabbArrayTreeBuild(tree);
+		}else{
+			aabbNode **curPending = tree->pending;
+			aabbNode **const lastPending = &curPending[tree->numPending];
+			return_t rebuild = 0;
+
+			for(; curPending < lastPending; ++curPending){
+				if(*curPending != NULL){
+					if(attachProxy(tree, (*curPending)->data.leaf.index) > AABBARRAYTREE_MAX_DEPTH){
+						rebuild = 1;
+					}
+				}
+			}
+			tree->numPending = 0;
+
+			if(rebuild){
+				aabbArrayTreeBuild(tree);
+			}
+		}
+	}
+}
+
+
+// Call "callback" on every leaf node in the tree.
+void aabbArrayTreeTraverse(aabbArrayTree *const restrict tree, void (*const callback)(aabbNode *node, void *args), void *args){
+	const aabbArrayTreeProxy *proxy = tree->proxies;
+	const aabbArrayTreeProxy *const lastProxy = &proxy[tree->numProxies];
+
+	for(; proxy < lastProxy; ++proxy){
+		(*callback)(proxy->node, args);
+	}
+}
+
+/*
+** Find every pair of leaves whose bounding boxes overlap and call
+** "callback" on their values. Like "aabbTreeQueryPairs", we descend
+** the tree once, checking each node against itself and each pair of
+** overlapping subtrees against each other, so each pair is only
+** reported once and the order of the values is arbitrary.
+*/
+void aabbArrayTreeQueryCollisions(
+	aabbArrayTree *const restrict tree,
+	void (*const callback)(void *const restrict d1, void *const restrict d2, void *args), void *args
+){
+
+	aabbArrayTreePair stack[AABBARRAYTREE_QUERY_STACK_SIZE];
+	aabbArrayTreePair *curPair = stack;
+
+	aabbArrayTreeFlush(tree);
+	if(tree->root == AABBARRAYTREE_INVALID_INDEX){
+		return;
+	}
+	curPair->childA = tree->root;
+	curPair->childB = tree->root;
+
+	for(;;){
+		const aabbArrayTreePair pair = *curPair;
+
+		if(pair.childA == pair.childB){
+			const aabbArrayTreeNode *const node = &tree->nodes[pair.childA];
+			unsigned int slot;
+
+			// The node's children may overlap each other.
+			if(node->children[1] != AABBARRAYTREE_INVALID_INDEX && colliderAABBCollidingAABB(&node->aabbs[0], &node->aabbs[1])){
+				curPair->childA = node->children[0];
+				curPair->childB = node->children[1];
+				curPair->aabbA = &node->aabbs[0];
+				curPair->aabbB = &node->aabbs[1];
+				++curPair;
+			}
+			// They may also contain overlapping leaves.
+			for(slot = 0; slot < 2; ++slot){
+				const aabbArrayTreeIndex child = node->children[slot];
+				if(child != AABBARRAYTREE_INVALID_INDEX && !isLeaf(child)){
+					curPair->childA = child;
+					curPair->childB = child;
+					++curPair;
+				}
+			}
+
+		// The children overlap, so if they're both
+		// leaves, we can report them as a pair.
+		}else if(isLeaf(pair.childA) && isLeaf(pair.childB)){
+			(*callback)(
+				tree->proxies[proxyIndex(pair.childA)].node->data.leaf.value,
+				tree->proxies[proxyIndex(pair.childB)].node->data.leaf.value, args
+			);
+
+		// Otherwise, descend into the larger one.
+		}else{
+			aabbArrayTreeIndex child;
+			const colliderAABB *aabb;
+			const aabbArrayTreeNode *node;
+			unsigned int slot;
+
+			if(isLeaf(pair.childB) || (!isLeaf(pair.childA) &&
+			   colliderAABBSurfaceAreaHalf(pair.aabbA) >= colliderAABBSurfaceAreaHalf(pair.aabbB))){
+
+				node = &tree->nodes[pair.childA];
+				child = pair.childB;
+				aabb = pair.aabbB;
+			}else{
+				node = &tree->nodes[pair.childB];
+				child = pair.childA;
+				aabb = pair.aabbA;
+			}
+
+			for(slot = 0; slot < 2; ++slot){
+				if(node->children[slot] != AABBARRAYTREE_INVALID_INDEX && colliderAABBCollidingAABB(&node->aabbs[slot], aabb)){
+					curPair->childA = node->children[slot];
+					curPair->childB = child;
+					curPair->aabbA = &node->aabbs[slot];
+					curPair->aabbB = aabb;
+					++curPair;
+				}
+			}
+		}
+
+		if(curPair == stack){
+			break;
+		}
+		--curPair;
+	}
+}
+
+/*
+** Call "callback" on the value of every
+** node whose bounding box overlaps "aabb".
+*/
+void aabbArrayTreeQueryAABB(
+	aabbArrayTree *const restrict tree, const colliderAABB *const restrict aabb,
+	void (*const callback)(void *const restrict value, void *args), void *args
+){
+
+	aabbArrayTreeIndex stack[AABBARRAYTREE_QUERY_STACK_SIZE];
+	aabbArrayTreeIndex *curNode = stack;
+
+	aabbArrayTreeFlush(tree);
+	if(tree->root == AABBARRAYTREE_INVALID_INDEX){
+		return;
+	}
+	*curNode = tree->root;
+
+	for(;;){
+		const aabbArrayTreeNode *const node = &tree->nodes[*curNode];
+		unsigned int slot;
+
+		for(slot = 0; slot < 2; ++slot){
+			const aabbArrayTreeIndex child = node->children[slot];
+			if(child != AABBARRAYTREE_INVALID_INDEX && colliderAABBCollidingAABB(&node->aabbs[slot], aabb)){
+				if(isLeaf(child)){
+					(*callback)(tree->proxies[proxyIndex(child)].node->data.leaf.value, args);
+				}else{
+					*curNode = child;
+					++curNode;
+				}
+			}
+		}
+
+		if(curNode == stack){
+			break;
+		}
+		--curNode;
+	}
+}
+
+
+/*
+** Call "callback" on the value of every leaf whose bounding box is hit
+** by a ray starting at "origin" before it has travelled "maxDistance".
+** Like "aabbTreeQueryRay", the callback returns the new maximum distance,
+** and a negative distance stops the query.
+*/
+void aabbArrayTreeQueryRay(
+	aabbArrayTree *const restrict tree, const vec3 *const restrict origin, const vec3 *const restrict invDir, float maxDistance,
+	float (*const callback)(void *const restrict value, const float maxDistance, void *args), void *args
+){
+
+	aabbArrayTreeIndex stack[AABBARRAYTREE_QUERY_STACK_SIZE];
+	aabbArrayTreeIndex *curNode = stack;
+
+	aabbArrayTreeFlush(tree);
+	if(tree->root == AABBARRAYTREE_INVALID_INDEX){
+		return;
+	}
+	*curNode = tree->root;
+
+	for(;;){
+		const aabbArrayTreeNode *const node = &tree->nodes[*curNode];
+		unsigned int slot;
+
+		for(slot = 0; slot < 2; ++slot){
+			const aabbArrayTreeIndex child = node->children[slot];
+			if(child != AABBARRAYTREE_INVALID_INDEX && colliderAABBCollidingRay(&node->aabbs[slot], origin, invDir, maxDistance)){
+				if(isLeaf(child)){
+					maxDistance = (*callback)(tree->proxies[proxyIndex(child)].node->data.leaf.value, maxDistance, args);
+					if(maxDistance < 0.f){
+						return;
+					}
+				}else{
+					*curNode = child;
+					++curNode;
+				}
+			}
+		}
+
+		if(curNode == stack){
+			break;
+		}
+		--curNode;
+	}
+}
+
+
+// Free the tree's arrays. The nodes should be removed first.
+void aabbArrayTreeDelete(aabbArrayTree *const restrict tree){
+	if(tree->nodeBlock != NULL){
+		memoryManagerGlobalFree(tree->nodeBlock);
+	}
+	if(tree->proxies != NULL){
+		memoryManagerGlobalFree(tree->proxies);
+	}
+	if(tree->pending != NULL){
+		memoryManagerGlobalFree(tree->pending);
+	}
+}
+
+
+/*
+** Add a new node to the end of the node array. If we need to
+** grow the array, we allocate extra memory so we can keep the
+** nodes aligned to a cache line.
+*/
+static aabbArrayTreeIndex allocateNode(aabbArrayTree *const restrict tree){
+	if(tree->numNodes >= tree->nodeCapacity){
+		const aabbArrayTreeIndex capacity = (tree->nodeCapacity > 0) ? 2*tree->nodeCapacity : 16;
+		void *const block = memoryManagerGlobalAlloc(capacity * sizeof(*tree->nodes) + AABBARRAYTREE_NODE_ALIGNMENT - 1);
+		aabbArrayTreeNode *nodes;
+		if(block == NULL){
+			/** MALLOC FAILED **/
+		}
+
+		nodes = (aabbArrayTreeNode *)(
+			((uintptr_t)block + AABBARRAYTREE_NODE_ALIGNMENT - 1) & ~(uintptr_t)(AABBARRAYTREE_NODE_ALIGNMENT - 1)
+		);
+		if(tree->nodeBlock != NULL){
+			memcpy(nodes, tree->nodes, tree->numNodes * sizeof(*tree->nodes));
+			memoryManagerGlobalFree(tree->nodeBlock);
+		}
+		tree->nodes = nodes;
+		tree->nodeBlock = block;
+		tree->nodeCapacity = capacity;
+	}
+
+	return(tree->numNodes++);
+}
+
+/*
+** Remove a node from the node array by moving the
+** last node into its place, keeping the array compact.
+*/
+static void freeNode(aabbArrayTree *const restrict tree, const aabbArrayTreeIndex node){
+	const aabbArrayTreeIndex lastNode = tree->numNodes - 1;
+
+	if(node != lastNode){
+		aabbArrayTreeNode *const moved = &tree->nodes[node];
+		unsigned int slot;
+
+		*moved = tree->nodes[lastNode];
+		setChild(tree, moved->parent, node);
+		for(slot = 0; slot < 2; ++slot){
+			const aabbArrayTreeIndex child = moved->children[slot];
+			if(child != AABBARRAYTREE_INVALID_INDEX){
+				if(isLeaf(child)){
+					tree->proxies[proxyIndex(child)].parent = makeReference(node, slot);
+				}else{
+					tree->nodes[child].parent = makeReference(node, slot);
+				}
+			}
+		}
+	}
+	--tree->numNodes;
+}
+
+// Point the slot referenced by "parent" at a node.
+static void setChild(aabbArrayTree *const restrict tree, const aabbArrayTreeIndex parent, const aabbArrayTreeIndex child){
+	if(parent == AABBARRAYTREE_INVALID_INDEX){
+		tree->root = child;
+	}else{
+		tree->nodes[referenceNode(parent)].children[referenceSlot(parent)] = child;
+	}
+}
+
+/*
+** Add a proxy's leaf to the hierarchy. This chooses a sibling using
+** the same cost function as "insertLeaf" for the dynamic tree, and
+** expands the bounding boxes along the way. We return the depth of
+** the new leaf, so we know if the tree has become too unbalanced.
+*/
+static aabbArrayTreeIndex attachProxy(aabbArrayTree *const restrict tree, const aabbArrayTreeIndex proxy){
+	const colliderAABB aabb = tree->proxies[proxy].node->aabb;
+	const aabbArrayTreeIndex leaf = proxy | AABBARRAYTREE_LEAF_FLAG;
+	aabbArrayTreeIndex depth = 1;
+	aabbArrayTreeIndex node;
+	unsigned int slot;
+	aabbArrayTreeNode *curNode;
+	colliderAABB siblingAABB;
+	aabbArrayTreeIndex sibling;
+
+	// If the tree is empty, the leaf becomes the root's only child.
+	if(tree->root == AABBARRAYTREE_INVALID_INDEX){
+		node = allocateNode(tree);
+		curNode = &tree->nodes[node];
+		curNode->aabbs[0] = aabb;
+		curNode->children[0] = leaf;
+		curNode->children[1] = AABBARRAYTREE_INVALID_INDEX;
+		curNode->parent = AABBARRAYTREE_INVALID_INDEX;
+		tree->root = node;
+		tree->proxies[proxy].parent = makeReference(node, 0);
+
+		return(depth);
+	}
+
+	node = tree->root;
+	curNode = &tree->nodes[node];
+	if(curNode->children[1] == AABBARRAYTREE_INVALID_INDEX){
+		curNode->aabbs[1] = aabb;
+		curNode->children[1] = leaf;
+		tree->proxies[proxy].parent = makeReference(node, 1);
+
+		return(depth);
+	}
+
+	// Find a child slot of the root to descend into.
+	slot = (
+		colliderAABBCombinedSurfaceAreaHalf(&aabb, &curNode->aabbs[0]) - colliderAABBSurfaceAreaHalf(&curNode->aabbs[0]) * !isLeaf(curNode->children[0]) >
+		colliderAABBCombinedSurfaceAreaHalf(&aabb, &curNode->aabbs[1]) - colliderAABBSurfaceAreaHalf(&curNode->aabbs[1]) * !isLeaf(curNode->children[1])
+	);
+
+	// Descend until it's cheapest to create a
+	// new branch containing the slot's child.
+	for(;;){
+		siblingAABB = curNode->aabbs[slot];
+		sibling = curNode->children[slot];
+		colliderAABBCombine(&siblingAABB, &aabb, &curNode->aabbs[slot]);
+		++depth;
+
+		if(!isLeaf(sibling)){
+			const aabbArrayTreeNode *const child = &tree->nodes[sibling];
+
+			// Calculate the cost of starting a new branch.
+			const float combinedArea  = colliderAABBCombinedSurfaceAreaHalf(&aabb, &siblingAABB);
+			const float branchCost    = 2.f * combinedArea;
+			const float inheritedCost = 2.f * (combinedArea - colliderAABBSurfaceAreaHalf(&siblingAABB));
+
+			float leftCost  = colliderAABBCombinedSurfaceAreaHalf(&aabb, &child->aabbs[0]) + inheritedCost;
+			float rightCost = colliderAABBCombinedSurfaceAreaHalf(&aabb, &child->aabbs[1]) + inheritedCost;
+			if(!isLeaf(child->children[0])){
+				leftCost -= colliderAABBSurfaceAreaHalf(&child->aabbs[0]);
+			}
+			if(!isLeaf(child->children[1])){
+				rightCost -= colliderAABBSurfaceAreaHalf(&child->aabbs[1]);
+			}
+
+			if(branchCost >= leftCost || branchCost >= rightCost){
+				slot = (leftCost > rightCost);
+				node = sibling;
+				curNode = &tree->nodes[node];
+				continue;
+			}
+		}
+
+		break;
+	}
+
+	// Create a new node to parent the sibling and our leaf.
+	{
+		const aabbArrayTreeIndex branch = allocateNode(tree);
+		aabbArrayTreeNode *const newNode = &tree->nodes[branch];
+
+		newNode->aabbs[0] = siblingAABB;
+		newNode->aabbs[1] = aabb;
+		newNode->children[0] = sibling;
+		newNode->children[1] = leaf;
+		newNode->parent = makeReference(node, slot);
+		tree->nodes[node].children[slot] = branch;
+
+		if(isLeaf(sibling)){
+			tree->proxies[proxyIndex(sibling)].parent = makeReference(branch, 0);
+		}else{
+			tree->nodes[sibling].parent = makeReference(branch, 0);
+		}
+		tree->proxies[proxy].parent = makeReference(branch, 1);
+	}
+
+	return(depth + 1);
+}
+
+/*
+** Remove a proxy's leaf from the hierarchy. Its parent is
+** replaced by its sibling, and the bounding boxes of the
+** nodes above it are shrunk to fit their new children.
+*/
+static void detachProxy(aabbArrayTree *const restrict tree, const aabbArrayTreeIndex proxy){
+	const aabbArrayTreeIndex reference = tree->proxies[proxy].parent;
+	const aabbArrayTreeIndex node = referenceNode(reference);
+	aabbArrayTreeNode *const curNode = &tree->nodes[node];
+	const unsigned int siblingSlot = !referenceSlot(reference);
+	const aabbArrayTreeIndex sibling = curNode->children[siblingSlot];
+
+	tree->proxies[proxy].parent = AABBARRAYTREE_INVALID_INDEX;
+
+	// If the leaf was the root's only child, the tree is now empty.
+	if(sibling == AABBARRAYTREE_INVALID_INDEX){
+		freeNode(tree, node);
+		tree->root = AABBARRAYTREE_INVALID_INDEX;
+
+	// Leaves can't be the root, so if the sibling is
+	// a leaf, it becomes the root's only child instead.
+	}else if(curNode->parent == AABBARRAYTREE_INVALID_INDEX && isLeaf(sibling)){
+		curNode->aabbs[0] = curNode->aabbs[siblingSlot];
+		curNode->children[0] = sibling;
+		curNode->children[1] = AABBARRAYTREE_INVALID_INDEX;
+		tree->proxies[proxyIndex(sibling)].parent = makeReference(node, 0);
+
+	}else{
+		const aabbArrayTreeIndex parent = curNode->parent;
+
+		setChild(tree, parent, sibling);
+		if(isLeaf(sibling)){
+			tree->proxies[proxyIndex(sibling)].parent = parent;
+		}else{
+			tree->nodes[sibling].parent = parent;
+		}
+		if(parent != AABBARRAYTREE_INVALID_INDEX){
+			tree->nodes[referenceNode(parent)].aabbs[referenceSlot(parent)] = curNode->aabbs[siblingSlot];
+			// Freeing the node may move the parent, so refit first.
+			refitHierarchy(tree, referenceNode(parent));
+		}
+		freeNode(tree, node);
+	}
+}
+
+// Shrink the bounding boxes of every node above "node" to fit their children.
+static void refitHierarchy(aabbArrayTree *const restrict tree, aabbArrayTreeIndex node){
+	const aabbArrayTreeNode *curNode = &tree->nodes[node];
+
+	while(curNode->parent != AABBARRAYTREE_INVALID_INDEX){
+		const aabbArrayTreeIndex parent = curNode->parent;
+		node = referenceNode(parent);
+		colliderAABBCombine(&curNode->aabbs[0], &curNode->aabbs[1], &tree->nodes[node].aabbs[referenceSlot(parent)]);
+		curNode = &tree->nodes[node];
+	}
+}
+
+/*
+** Partition a range of build items into two groups, storing the
+** bounds of each group in "left" and "right". We return the number
+** of items in the left group. If "halve" is set, we split the
+** items evenly rather than minimizing their surface area, which
+** stops a few distant leaves from making the tree too deep.
+*/
+static size_t splitItems(
+	aabbArrayTreeBuildItem *const restrict items, const size_t count, const return_t halve,
+	colliderAABB *const restrict left, colliderAABB *const restrict right
+){
+
+	aabbArrayTreeBuildBin bins[AABBARRAYTREE_BUILD_NUM_BINS];
+	colliderAABB rightBounds[AABBARRAYTREE_BUILD_NUM_BINS];
+	vec3 centreMin = items[0].centre;
+	vec3 centreMax = items[0].centre;
+	float extent;
+	float scale;
+	unsigned int axis;
+	unsigned int split = 0;
+	size_t numLeft = 0;
+	size_t i;
+
+	for(i = 1; i < count; ++i){
+		vec3 temp;
+		vec3Min(&centreMin, &items[i].centre, &temp);
+		centreMin = temp;
+		vec3Max(&centreMax, &items[i].centre, &temp);
+		centreMax = temp;
+	}
+	// Split along the axis with the greatest spread.
+	vec3SubtractVec3P1(&centreMax, &centreMin);
+	axis = (centreMax.x >= centreMax.y) ? 0 : 1;
+	if(centreMax.z > vec3Axis(&centreMax, axis)){
+		axis = 2;
+	}
+	extent = vec3Axis(&centreMax, axis);
+
+	if(extent > 0.f && !halve){
+		const float offset = vec3Axis(&centreMin, axis);
+		colliderAABB leftBounds;
+		size_t leftCount = 0;
+		float bestCost = INFINITY;
+		unsigned int b;
+
+		// Nudge the scale down so the last centre
+		// doesn't end up past the final bin.
+		scale = AABBARRAYTREE_BUILD_NUM_BINS * (1.f - 1e-5f) / extent;
+		for(b = 0; b < AABBARRAYTREE_BUILD_NUM_BINS; ++b){
+			vec3InitSet(&bins[b].aabb.min, INFINITY, INFINITY, INFINITY);
+			vec3InitSet(&bins[b].aabb.max, -INFINITY, -INFINITY, -INFINITY);
+			bins[b].count = 0;
+		}
+		for(i = 0; i < count; ++i){
+			aabbArrayTreeBuildBin *const bin = &bins[(unsigned int)((vec3Axis(&items[i].centre, axis) - offset) * scale)];
+			colliderAABBCombine(&bin->aabb, &items[i].aabb, &bin->aabb);
+			++bin->count;
+		}
+
+		// Accumulate the bins from the right so we know the bounds
+		// of every possible right side. Small ranges leave most bins
+		// empty, so we skip them to keep the cost proportional to
+		// the number of items.
+		rightBounds[AABBARRAYTREE_BUILD_NUM_BINS - 1] = bins[AABBARRAYTREE_BUILD_NUM_BINS - 1].aabb;
+		for(b = AABBARRAYTREE_BUILD_NUM_BINS - 1; b-- > 0;){
+			if(bins[b].count > 0){
+				colliderAABBCombine(&bins[b].aabb, &rightBounds[b + 1], &rightBounds[b]);
+			}else{
+				rightBounds[b] = rightBounds[b + 1];
+			}
+		}
+
+		// Sweep from the left to find the cheapest split. A split
+		// at bin "b" puts bins 0 to b - 1 in the left group, so if
+		// bin b - 1 is empty, it's the same as the previous split.
+		leftBounds = bins[0].aabb;
+		for(b = 1; b < AABBARRAYTREE_BUILD_NUM_BINS; ++b){
+			if(bins[b - 1].count > 0){
+				leftCount += bins[b - 1].count;
+				if(leftCount < count){
+					const float cost = colliderAABBSurfaceAreaHalf(&leftBounds) * leftCount +
+					                   colliderAABBSurfaceAreaHalf(&rightBounds[b]) * (count - leftCount);
+
+					if(cost < bestCost){
+						bestCost = cost;
+						split = b;
+						numLeft = leftCount;
+						*left = leftBounds;
+						*right = rightBounds[b];
+					}
+				}
+			}
+			if(bins[b].count > 0){
+				colliderAABBCombine(&leftBounds, &bins[b].aabb, &leftBounds);
+			}
+		}
+
+		// Move the items in the left group to the front.
+		if(split > 0){
+			aabbArrayTreeBuildItem *front = items;
+			aabbArrayTreeBuildItem *back = &items[count];
+
+			for(;;){
+				while(front < back && (unsigned int)((vec3Axis(&front->centre, axis) - offset) * scale) < split){
+					++front;
+				}
+				do {
+					--back;
+				} while(front < back && (unsigned int)((vec3Axis(&back->centre, axis) - offset) * scale) >= split);
+
+				if(front >= back){
+					break;
+				}else{
+					const aabbArrayTreeBuildItem temp = *front;
+					*front = *back;
+					*back = temp;
+					++front;
+				}
+			}
+		}
+	}
+
+	// If we're halving the items, split them at the median
+	// centre. If every centre is the same, any split will do.
+	if(split == 0){
+		numLeft = count/2;
+		if(extent > 0.f){
+			selectMedian(items, count, axis);
+		}
+		*left = items[0].aabb;
+		for(i = 1; i < numLeft; ++i){
+			colliderAABBCombine(left, &items[i].aabb, left);
+		}
+		*right = items[numLeft].aabb;
+		for(i = numLeft + 1; i < count; ++i){
+			colliderAABBCombine(right, &items[i].aabb, right);
+		}
+	}
+
+	return(numLeft);
+}
+
+
+/*
+** Partially sort the items along "axis" using quickselect, so the
+** item at "count/2" is in its sorted position, the items before it
+** have smaller centres and the items after it have larger ones.
+*/
+static void selectMedian(aabbArrayTreeBuildItem *const restrict items, const size_t count, const unsigned int axis){
+	const ptrdiff_t median = count/2;
+	ptrdiff_t first = 0;
+	ptrdiff_t last = count - 1;
+
+	while(first < last){
+		const float pivot = vec3Axis(&items[first + (last - first)/2].centre, axis);
+		ptrdiff_t i = first;
+		ptrdiff_t j = last;
+
+		while(i <= j){
+			while(vec3Axis(&items[i].centre, axis) < pivot){
+				++i;
+			}
+			while(vec3Axis(&items[j].centre, axis) > pivot){
+				--j;
+			}
+			if(i <= j){
+				const aabbArrayTreeBuildItem temp = items[i];
+				items[i] = items[j];
+				items[j] = temp;
+				++i;
+				--j;
+			}
+		}
+
+		if(median <= j){
+			last = j;
+		}else if(median >= i){
+			first = i;
+		}else{
+			break;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef aabbArrayTree_h
+#define aabbArrayTree_h
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "settingsPhysics.h"
+
+#include "colliderAABB.h"
+#include "aabbTree.h"
+
+
+// Once at least one in this many of the tree's leaves have been
+// inserted one at a time since it was built, it is rebuilt.
+#ifndef AABBARRAYTREE_REBUILD_DIVISOR
+	#define AABBARRAYTREE_REBUILD_DIVISOR 2
+#endif
+// Number of bins used when choosing splits for the bulk build.
+#ifndef AABBARRAYTREE_BUILD_NUM_BINS
+	#define AABBARRAYTREE_BUILD_NUM_BINS 16
+#endif
+
+
+typedef uint_least32_t aabbArrayTreeIndex;
+
+#define AABBARRAYTREE_INVALID_INDEX ((aabbArrayTreeIndex)0xFFFFFFFF)
+// Children with this bit set are leaves, and
+// the other bits store the index of their proxy.
+#define AABBARRAYTREE_LEAF_FLAG     ((aabbArrayTreeIndex)0x80000000)
+
+/*
+** Rather than storing its own bounding box, each node stores the
+** bounding boxes of its two children. This means that we can test
+** both children without touching them, and we only need to visit
+** the ones that overlap. Nodes are exactly 64 bytes and the array
+** is aligned, so each node fills exactly one cache line.
+**
+** Parent references store the index of the parent node shifted
+** left by one, and the bottom bit says which child we are.
+*/
+typedef struct aabbArrayTreeNode {
+	colliderAABB aabbs[2];
+	aabbArrayTreeIndex children[2];
+	aabbArrayTreeIndex parent;
+	// Pad the node out to exactly 64 bytes.
+	aabbArrayTreeIndex padding;
+} aabbArrayTreeNode;
+
+// Every leaf in the tree has a proxy, which is the
+// index stored by its leaf node's "index" member.
+typedef struct aabbArrayTreeProxy {
+	aabbNode *node;
+	// Reference to the slot in the parent node that
+	// stores this leaf, or invalid if it isn't in the
+	// hierarchy yet.
+	aabbArrayTreeIndex parent;
+} aabbArrayTreeProxy;
+
+/*
+** An alternative to the dynamic AABB tree that keeps its nodes in a
+** single array and links them with 32-bit indices, so traversals
+** don't jump all over the heap. The leaves are the same leaf nodes
+** used by the other broadphases.
+**
+** Inserted and moved leaves are queued and only added to the tree
+** by the next query or flush. If enough have been queued, we rebuild the
+** entire tree from scratch using the surface area heuristic, which
+** is much faster than inserting a level's static colliders one at
+** a time. This also keeps the tree balanced, as we don't rotate
+** nodes when inserting leaves like the pointer-based tree does.
+*/
+typedef struct aabbArrayTree {
+	// The node array is aligned to a cache line,
+	// so it starts somewhere inside "nodeBlock".
+	aabbArrayTreeNode *nodes;
+	void *nodeBlock;
+	aabbArrayTreeIndex numNodes;
+	aabbArrayTreeIndex nodeCapacity;
+	aabbArrayTreeIndex root;
+
+	aabbArrayTreeProxy *proxies;
+	aabbArrayTreeIndex numProxies;
+	aabbArrayTreeIndex proxyCapacity;
+	// Linked list of leaf nodes.
+	aabbNode *leaves;
+
+	// Leaves waiting to be added to the hierarchy.
+	// Removed leaves are replaced with NULL.
+	aabbNode **pending;
+	size_t numPending;
+	size_t pendingCapacity;
+	// Number of leaves added one at a time since the last build.
+	size_t numReinserted;
+} aabbArrayTree;
+
+
+void aabbArrayTreeInit(aabbArrayTree *const restrict tree);
+
+aabbNode *aabbArrayTreeInsertNode(
+	aabbArrayTree *const restrict tree, const colliderAABB *const restrict aabb,
+	void *const restrict value, aabbNode *(*const allocate)()
+);
+void aabbArrayTreeUpdateNode(aabbArrayTree *const restrict tree, aabbNode *const restrict node);
+void aabbArrayTreeRemoveNode(
+	aabbArrayTree *const restrict tree, aabbNode *const restrict node, void (*const deallocate)(aabbNode *node, void *args), void *args
+);
+void aabbArrayTreeBuild(aabbArrayTree *const restrict tree);
+void aabbArrayTreeFlush(aabbArrayTree *const restrict tree);
+
+void aabbArrayTreeTraverse(aabbArrayTree *const restrict tree, void (*const callback)(aabbNode *node, void *args), void *args);
+void aabbArrayTreeQueryCollisions(
+	aabbArrayTree *const restrict tree,
+	void (*const callback)(void *const restrict d1, void *const restrict d2, void *args), void *args
+);
+void aabbArrayTreeQueryAABB(
+	aabbArrayTree *const restrict tree, const colliderAABB *const restrict aabb,
+	void (*const callback)(void *const restrict value, void *args), void *args
+);
+void aabbArrayTreeQueryRay(
+	aabbArrayTree *const restrict tree, const vec3 *const restrict origin, const vec3 *const restrict invDir, float maxDistance,
+	float (*const callback)(void *const restrict value, const float maxDistance, void *args), void *args
+);
+
+void aabbArrayTreeDelete(aabbArrayTree *const restrict tree);
+
+
+#endif
\ No newline at end of file
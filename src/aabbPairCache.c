@@ -0,0 +1,410 @@
+#include "aabbPairCache.h"
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "memoryManager.h"
+
+
+#define AABBPAIRCACHE_QUERY_STACK_SIZE 256
+#define AABBPAIRCACHE_TABLE_MIN_SIZE   16
+#define AABBPAIRCACHE_TABLE_EMPTY      0
+
+
+// Forward-declare any helper functions!
+static size_t hashPair(const aabbNode *const a, const aabbNode *const b);
+static size_t findPairSlot(const aabbPairCache *const restrict cache, const size_t index);
+static void rehashPairs(aabbPairCache *const restrict cache, const size_t tableCapacity);
+static void insertPair(aabbPairCache *const restrict cache, aabbNode *a, aabbNode *b);
+static void removePair(aabbPairCache *const restrict cache, const size_t index);
+static void linkPair(aabbPairCache *const restrict cache, const size_t index);
+static size_t *findPairLink(aabbPairCache *const restrict cache, aabbNode *const node, const size_t index);
+static void queryNode(aabbPairCache *const restrict cache, const aabbTree *const restrict tree, aabbNode *const node);
+static void appendPairCallback(aabbNode *const a, aabbNode *const b, void *const restrict pairCache);
+
+
+void aabbPairCacheInit(aabbPairCache *const restrict cache){
+	memset(cache, 0, sizeof(*cache));
+}
+
+
+/*
+** Mark a node as having just been inserted into the tree. This
+** must be called for new nodes instead of "aabbPairCacheMoveNode",
+** as it also sets up the node's list of pairs.
+*/
+void aabbPairCacheInsertNode(aabbPairCache *const restrict cache, aabbNode *const node){
+	node->data.leaf.index = AABBPAIRCACHE_NO_PAIR;
+	aabbPairCacheMoveNode(cache, node);
+}
+
+/*
+** Mark a node as having been reinserted into the tree,
+** so it can look for new pairs on the next update.
+*/
+void aabbPairCacheMoveNode(aabbPairCache *const restrict cache, aabbNode *const node){
+	if(cache->numMoved >= cache->movedCapacity){
+		cache->movedCapacity = (cache->movedCapacity > 0) ? 2*cache->movedCapacity : AABBPAIRCACHE_TABLE_MIN_SIZE;
+		cache->moved = memoryManagerGlobalRealloc(cache->moved, cache->movedCapacity * sizeof(*cache->moved));
+		if(cache->moved == NULL){
+			/** MALLOC FAILED **/
+		}
+	}
+	cache->moved[cache->numMoved] = node;
+	++cache->numMoved;
+}
+
+/*
+** Remove every pair involving a node. This should be
+** called before the node is removed from its tree.
+*/
+void aabbPairCacheRemoveNode(aabbPairCache *const restrict cache, const aabbNode *const node){
+	size_t i;
+
+	// Removing a pair unlinks it from the node's list,
+	// so we just keep removing the first one until
+	// there are none left.
+	while(node->data.leaf.index != AABBPAIRCACHE_NO_PAIR){
+		removePair(cache, node->data.leaf.index);
+	}
+
+	for(i = 0; i < cache->numMoved; ++i){
+		if(cache->moved[i] == node){
+			cache->moved[i] = NULL;
+		}
+	}
+}
+
+/*
+** Add any new pairs involving nodes that have moved since the
+** last update, and remove any pairs that no longer overlap.
+*/
+void aabbPairCacheUpdate(aabbPairCache *const restrict cache, aabbTree *const restrict tree){
+	// If enough of the tree has moved, it's faster to find
+	// every pair again in a single pass over the tree. The
+	// traversal reports each pair exactly once, so we can
+	// append them without checking the hash table.
+	if(cache->numMoved >= tree->numLeaves / AABBPAIRCACHE_REBUILD_DIVISOR && cache->numMoved > 0){
+		size_t tableCapacity = AABBPAIRCACHE_TABLE_MIN_SIZE;
+		aabbNode *node;
+		size_t i;
+
+		cache->numPairs = 0;
+		aabbTreeQueryPairs(tree, &appendPairCallback, cache);
+		while(tableCapacity < 2*cache->numPairs){
+			tableCapacity *= 2;
+		}
+		rehashPairs(cache, (tableCapacity > cache->tableCapacity) ? tableCapacity : cache->tableCapacity);
+
+		// Rebuild each node's list of pairs.
+		for(node = tree->leaves; node != NULL; node = node->data.leaf.next){
+			node->data.leaf.index = AABBPAIRCACHE_NO_PAIR;
+		}
+		for(i = 0; i < cache->numPairs; ++i){
+			linkPair(cache, i);
+		}
+		cache->firstAdded = 0;
+		cache->numMoved = 0;
+
+	}else if(cache->numMoved > 0){
+		aabbNode **curNode = cache->moved;
+		aabbNode *const *const lastNode = &curNode[cache->numMoved];
+		size_t i = cache->numPairs;
+
+		// Only the pairs that existed before this update can
+		// have stopped overlapping, so check them first.
+		while(i > 0){
+			const aabbPair *pair;
+
+			--i;
+			pair = &cache->pairs[i];
+			if(!colliderAABBCollidingAABB(&pair->a->aabb, &pair->b->aabb)){
+				removePair(cache, i);
+			}
+		}
+
+		// New pairs are appended, so they come after this.
+		cache->firstAdded = cache->numPairs;
+		for(; curNode < lastNode; ++curNode){
+			if(*curNode != NULL){
+				queryNode(cache, tree, *curNode);
+			}
+		}
+		cache->numMoved = 0;
+
+	}else{
+		cache->firstAdded = cache->numPairs;
+	}
+}
+
+/*
+** Return the pair containing the nodes "a" and "b",
+** or NULL if their bounding boxes don't overlap.
+*/
+aabbPair *aabbPairCacheFind(const aabbPairCache *const restrict cache, const aabbNode *a, const aabbNode *b){
+	if(cache->numPairs > 0){
+		const size_t mask = cache->tableCapacity - 1;
+		size_t slot;
+
+		// Make sure node A's value has the greater address.
+		if(a->data.leaf.value < b->data.leaf.value){
+			const aabbNode *const temp = a;
+			a = b;
+			b = temp;
+		}
+
+		slot = hashPair(a, b) & mask;
+		while(cache->table[slot] != AABBPAIRCACHE_TABLE_EMPTY){
+			aabbPair *const pair = &cache->pairs[cache->table[slot] - 1];
+			if(pair->a == a && pair->b == b){
+				return(pair);
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	return(NULL);
+}
+
+
+void aabbPairCacheClear(aabbPairCache *const restrict cache){
+	const aabbPair *pair = cache->pairs;
+	const aabbPair *const lastPair = &pair[cache->numPairs];
+
+	// Empty each node's list of pairs.
+	for(; pair < lastPair; ++pair){
+		pair->a->data.leaf.index = AABBPAIRCACHE_NO_PAIR;
+		pair->b->data.leaf.index = AABBPAIRCACHE_NO_PAIR;
+	}
+
+	cache->numPairs = 0;
+	cache->firstAdded = 0;
+	cache->numMoved = 0;
+	if(cache->table != NULL){
+		memset(cache->table, AABBPAIRCACHE_TABLE_EMPTY, cache->tableCapacity * sizeof(*cache->table));
+	}
+}
+
+void aabbPairCacheDelete(aabbPairCache *const restrict cache){
+	if(cache->pairs != NULL){
+		memoryManagerGlobalFree(cache->pairs);
+	}
+	if(cache->table != NULL){
+		memoryManagerGlobalFree(cache->table);
+	}
+	if(cache->moved != NULL){
+		memoryManagerGlobalFree(cache->moved);
+	}
+}
+
+
+static size_t hashPair(const aabbNode *const a, const aabbNode *const b){
+	// Nodes are aligned, so the lowest bits are always zero.
+	const size_t hash = (size_t)((uintptr_t)a >> 4) * 2654435761u;
+	return(hash ^ ((size_t)((uintptr_t)b >> 4) + 0x9E3779B9u + (hash << 6) + (hash >> 2)));
+}
+
+// Return the slot in the hash table that stores the pair at "index".
+static size_t findPairSlot(const aabbPairCache *const restrict cache, const size_t index){
+	const size_t mask = cache->tableCapacity - 1;
+	size_t slot = hashPair(cache->pairs[index].a, cache->pairs[index].b) & mask;
+
+	while(cache->table[slot] != index + 1){
+		slot = (slot + 1) & mask;
+	}
+
+	return(slot);
+}
+
+// Resize the hash table and reinsert every pair.
+static void rehashPairs(aabbPairCache *const restrict cache, const size_t tableCapacity){
+	const size_t mask = tableCapacity - 1;
+	size_t i;
+
+	if(cache->table != NULL){
+		memoryManagerGlobalFree(cache->table);
+	}
+	cache->table = memoryManagerGlobalAlloc(tableCapacity * sizeof(*cache->table));
+	if(cache->table == NULL){
+		/** MALLOC FAILED **/
+	}
+	memset(cache->table, AABBPAIRCACHE_TABLE_EMPTY, tableCapacity * sizeof(*cache->table));
+	cache->tableCapacity = tableCapacity;
+
+	for(i = 0; i < cache->numPairs; ++i){
+		size_t slot = hashPair(cache->pairs[i].a, cache->pairs[i].b) & mask;
+		while(cache->table[slot] != AABBPAIRCACHE_TABLE_EMPTY){
+			slot = (slot + 1) & mask;
+		}
+		cache->table[slot] = i + 1;
+	}
+}
+
+// Add a pair to the cache if it doesn't already exist.
+static void insertPair(aabbPairCache *const restrict cache, aabbNode *a, aabbNode *b){
+	size_t mask;
+	size_t slot;
+
+	// Make sure node A's value has the greater address.
+	if(a->data.leaf.value < b->data.leaf.value){
+		aabbNode *const temp = a;
+		a = b;
+		b = temp;
+	}
+
+	// Keep the table at most half full so probe sequences stay short.
+	if(2*(cache->numPairs + 1) > cache->tableCapacity){
+		rehashPairs(cache, (cache->tableCapacity > 0) ? 2*cache->tableCapacity : AABBPAIRCACHE_TABLE_MIN_SIZE);
+	}
+
+	mask = cache->tableCapacity - 1;
+	slot = hashPair(a, b) & mask;
+	// If the pair is already in the table, we can exit early.
+	while(cache->table[slot] != AABBPAIRCACHE_TABLE_EMPTY){
+		const aabbPair *const pair = &cache->pairs[cache->table[slot] - 1];
+		if(pair->a == a && pair->b == b){
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	if(cache->numPairs >= cache->pairCapacity){
+		cache->pairCapacity = (cache->pairCapacity > 0) ? 2*cache->pairCapacity : AABBPAIRCACHE_TABLE_MIN_SIZE;
+		cache->pairs = memoryManagerGlobalRealloc(cache->pairs, cache->pairCapacity * sizeof(*cache->pairs));
+		if(cache->pairs == NULL){
+			/** MALLOC FAILED **/
+		}
+	}
+	cache->pairs[cache->numPairs].a = a;
+	cache->pairs[cache->numPairs].b = b;
+	cache->pairs[cache->numPairs].value = NULL;
+	linkPair(cache, cache->numPairs);
+	++cache->numPairs;
+	cache->table[slot] = cache->numPairs;
+}
+
+/*
+** Remove the pair at "index" by moving the last pair into its place.
+** We can't just empty its slot in the table, as this might break the
+** probe sequences of other pairs, so we shift them back to fill it.
+*/
+static void removePair(aabbPairCache *const restrict cache, const size_t index){
+	const size_t mask = cache->tableCapacity - 1;
+	const size_t lastIndex = cache->numPairs - 1;
+	size_t emptySlot = findPairSlot(cache, index);
+	size_t slot = emptySlot;
+
+	for(;;){
+		size_t home;
+
+		slot = (slot + 1) & mask;
+		if(cache->table[slot] == AABBPAIRCACHE_TABLE_EMPTY){
+			break;
+		}
+
+		// If the pair's home slot is cyclically between the
+		// empty slot and this one, it can stay where it is.
+		home = hashPair(cache->pairs[cache->table[slot] - 1].a, cache->pairs[cache->table[slot] - 1].b) & mask;
+		if((emptySlot <= slot) ? (emptySlot < home && home <= slot) : (emptySlot < home || home <= slot)){
+			continue;
+		}
+		cache->table[emptySlot] = cache->table[slot];
+		emptySlot = slot;
+	}
+	cache->table[emptySlot] = AABBPAIRCACHE_TABLE_EMPTY;
+
+	// Unlink the pair from both of its nodes' lists.
+	*findPairLink(cache, cache->pairs[index].a, index) = cache->pairs[index].nextA;
+	*findPairLink(cache, cache->pairs[index].b, index) = cache->pairs[index].nextB;
+
+	// Move the last pair into the removed pair's place.
+	if(index != lastIndex){
+		cache->table[findPairSlot(cache, lastIndex)] = index + 1;
+		*findPairLink(cache, cache->pairs[lastIndex].a, lastIndex) = index;
+		*findPairLink(cache, cache->pairs[lastIndex].b, lastIndex) = index;
+		cache->pairs[index] = cache->pairs[lastIndex];
+	}
+	cache->numPairs = lastIndex;
+}
+
+// Add the pair at "index" to the start of both of its nodes' lists.
+static void linkPair(aabbPairCache *const restrict cache, const size_t index){
+	aabbPair *const pair = &cache->pairs[index];
+
+	pair->nextA = pair->a->data.leaf.index;
+	pair->a->data.leaf.index = index;
+	pair->nextB = pair->b->data.leaf.index;
+	pair->b->data.leaf.index = index;
+}
+
+/*
+** Return a pointer to whatever refers to the pair at "index" in
+** a node's list, which is either the node or the previous pair.
+** Nodes are usually only involved in a few pairs at a time.
+*/
+static size_t *findPairLink(aabbPairCache *const restrict cache, aabbNode *const node, const size_t index){
+	size_t *link = &node->data.leaf.index;
+
+	while(*link != index){
+		aabbPair *const pair = &cache->pairs[*link];
+		link = (pair->a == node) ? &pair->nextA : &pair->nextB;
+	}
+
+	return(link);
+}
+
+/*
+** Add a pair found by a full traversal of the tree. These are
+** always unique, so we leave the hash table to be rebuilt later.
+*/
+static void appendPairCallback(aabbNode *const a, aabbNode *const b, void *const restrict pairCache){
+	aabbPairCache *const cache = (aabbPairCache *)pairCache;
+	aabbPair *pair;
+
+	if(cache->numPairs >= cache->pairCapacity){
+		cache->pairCapacity = (cache->pairCapacity > 0) ? 2*cache->pairCapacity : AABBPAIRCACHE_TABLE_MIN_SIZE;
+		cache->pairs = memoryManagerGlobalRealloc(cache->pairs, cache->pairCapacity * sizeof(*cache->pairs));
+		if(cache->pairs == NULL){
+			/** MALLOC FAILED **/
+		}
+	}
+
+	// Make sure node A's value has the greater address.
+	// The nodes' lists are rebuilt once we're finished.
+	pair = &cache->pairs[cache->numPairs];
+	if(a->data.leaf.value > b->data.leaf.value){
+		pair->a = a;
+		pair->b = b;
+	}else{
+		pair->a = b;
+		pair->b = a;
+	}
+	pair->value = NULL;
+	++cache->numPairs;
+}
+
+// Add a pair for every leaf in the tree that overlaps "node".
+static void queryNode(aabbPairCache *const restrict cache, const aabbTree *const restrict tree, aabbNode *const node){
+	aabbNode *stack[AABBPAIRCACHE_QUERY_STACK_SIZE];
+	size_t i = 1;
+
+	stack[0] = tree->root;
+
+	do {
+		aabbNode *const curNode = stack[--i];
+
+		if(colliderAABBCollidingAABB(&node->aabb, &curNode->aabb)){
+			if(aabbNodeIsLeaf(curNode)){
+				if(curNode != node){
+					insertPair(cache, node, curNode);
+				}
+			}else{
+				stack[i] = curNode->data.children.left;
+				++i;
+				stack[i] = curNode->data.children.right;
+				++i;
+			}
+		}
+	} while(i);
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef aabbPairCache_h
+#define aabbPairCache_h
+
+
+#include <stddef.h>
+
+#include "settingsPhysics.h"
+
+#include "aabbTree.h"
+
+
+// If at least one in this many of the tree's leaves have moved,
+// the cache is rebuilt using a single pass over the whole tree.
+#ifndef AABBPAIRCACHE_REBUILD_DIVISOR
+	#define AABBPAIRCACHE_REBUILD_DIVISOR 4
+#endif
+
+
+// Used by pairs to indicate the end of a node's list of pairs.
+#define AABBPAIRCACHE_NO_PAIR valueInvalid(size_t)
+
+
+// Pair of leaf nodes whose bounding boxes overlap. The
+// value of node A always has the greater address.
+typedef struct aabbPair {
+	aabbNode *a;
+	aabbNode *b;
+	// The cache's user may associate some data with each
+	// pair. This is always NULL for newly added pairs.
+	void *value;
+
+	// The pairs involving each node form singly linked lists,
+	// the first index of which is stored in the node itself.
+	// These store the indices of the next pairs in node A's
+	// and node B's lists, so removing a node is fast.
+	size_t nextA;
+	size_t nextB;
+} aabbPair;
+
+/*
+** Stores every pair of overlapping leaves in a tree between updates.
+** Only nodes that have been reinserted into the tree can start or
+** stop overlapping other nodes, so these are the only ones we need
+** to query. If nothing has moved, updating the cache is free.
+**
+** Pairs are stored contiguously so they're quick to loop through,
+** and the hash table stores the index of each pair plus one so we
+** can quickly check whether a pair already exists.
+**
+** Pairs that were added by the last update are always stored after
+** the ones that were already in the cache. The user can keep track
+** of its own data for the older pairs using their values, and only
+** needs to set it up for new pairs. A pair's value is lost when it
+** is removed, which happens when the nodes stop overlapping.
+*/
+typedef struct aabbPairCache {
+	aabbPair *pairs;
+	size_t numPairs;
+	size_t pairCapacity;
+	// Pairs from this index onwards were added by the last update.
+	// If the cache was rebuilt, this will be zero, and every pair
+	// is treated as though it was new.
+	size_t firstAdded;
+
+	// Open-addressed hash table using linear probing.
+	// Its capacity is always a power of two.
+	size_t *table;
+	size_t tableCapacity;
+
+	// Nodes that have been inserted or updated since the
+	// last update. Removed nodes are replaced with NULL.
+	aabbNode **moved;
+	size_t numMoved;
+	size_t movedCapacity;
+} aabbPairCache;
+
+
+void aabbPairCacheInit(aabbPairCache *const restrict cache);
+
+void aabbPairCacheInsertNode(aabbPairCache *const restrict cache, aabbNode *const node);
+void aabbPairCacheMoveNode(aabbPairCache *const restrict cache, aabbNode *const node);
+void aabbPairCacheRemoveNode(aabbPairCache *const restrict cache, const aabbNode *const node);
+void aabbPairCacheUpdate(aabbPairCache *const restrict cache, aabbTree *const restrict tree);
+aabbPair *aabbPairCacheFind(const aabbPairCache *const restrict cache, const aabbNode *a, const aabbNode *b);
+
+void aabbPairCacheClear(aabbPairCache *const restrict cache);
+void aabbPairCacheDelete(aabbPairCache *const restrict cache);
+
+
+#endif
\ No newline at end of file
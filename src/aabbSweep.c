@@ -0,0 +1,201 @@
+#include "aabbSweep.h"
+
+
+#include <string.h>
+
+#include "memoryManager.h"
+
+
+#define compareProxy(p1, p2) compareFloatFast((p1)->min, (p2)->min)
+
+
+void aabbSweepInit(aabbSweep *const restrict sweep){
+	sweep->proxies = NULL;
+	sweep->numProxies = 0;
+	sweep->capacity = 0;
+	sweep->leaves = NULL;
+}
+
+
+/*
+** Add the user's data to the sweep. The new proxy is added to the
+** end of the array, and will be moved into place on the next query.
+*/
+aabbNode *aabbSweepInsertNode(
+	aabbSweep *const restrict sweep, const colliderAABB *const restrict aabb,
+	void *const restrict value, aabbNode *(*const allocate)()
+){
+
+	aabbSweepProxy *proxy;
+	aabbNode *const node = (*allocate)();
+	if(node == NULL){
+		/** MALLOC FAILED **/
+	}
+
+	node->aabb = *aabb;
+	node->parent = NULL;
+	node->data.leaf.value = value;
+	node->data.leaf.next = sweep->leaves;
+	node->height = AABBNODE_HEIGHT_LEAF;
+	sweep->leaves = node;
+
+	// Double the size of the proxy array if it's full.
+	if(sweep->numProxies >= sweep->capacity){
+		sweep->capacity = (sweep->capacity > 0) ? 2*sweep->capacity : 16;
+		sweep->proxies = memoryManagerGlobalRealloc(sweep->proxies, sweep->capacity * sizeof(*sweep->proxies));
+		if(sweep->proxies == NULL){
+			/** MALLOC FAILED **/
+		}
+	}
+	proxy = &sweep->proxies[sweep->numProxies];
+	proxy->min = aabb->min.x;
+	proxy->max = aabb->max.x;
+	proxy->node = node;
+	++sweep->numProxies;
+
+	return(node);
+}
+
+/*
+** Unlike the tree, we don't need to reinsert
+** nodes when their bounding boxes change.
+*/
+void aabbSweepUpdateNode(aabbSweep *const restrict sweep, aabbNode *const restrict node){
+	// The proxies are refreshed and resorted at the
+	// beginning of each query, so there's nothing to do.
+}
+
+/*
+** Remove a node from the sweep. We need to shift the proxies
+** after it back to keep the array sorted, so this is linear
+** in the number of proxies. The node's leaf is removed from
+** the list before it's passed to "deallocate".
+*/
+void aabbSweepRemoveNode(
+	aabbSweep *const restrict sweep, aabbNode *const restrict node, void (*const deallocate)(aabbNode *node, void *args), void *args
+){
+
+	aabbSweepProxy *proxy = sweep->proxies;
+	const aabbSweepProxy *const lastProxy = &proxy[sweep->numProxies];
+
+	for(; proxy < lastProxy; ++proxy){
+		if(proxy->node == node){
+			memmove(proxy, &proxy[1], (lastProxy - proxy - 1) * sizeof(*proxy));
+			--sweep->numProxies;
+			break;
+		}
+	}
+
+	// Remove the node from the list of leaves.
+	if(sweep->leaves == node){
+		sweep->leaves = node->data.leaf.next;
+	}else{
+		aabbNode *prevNode = sweep->leaves;
+		while(prevNode->data.leaf.next != node){
+			prevNode = prevNode->data.leaf.next;
+		}
+		prevNode->data.leaf.next = node->data.leaf.next;
+	}
+
+	(*deallocate)(node, args);
+}
+
+
+// Call "callback" on every node in the sweep.
+void aabbSweepTraverse(aabbSweep *const restrict sweep, void (*const callback)(aabbNode *node, void *args), void *args){
+	const aabbSweepProxy *proxy = sweep->proxies;
+	const aabbSweepProxy *const lastProxy = &proxy[sweep->numProxies];
+
+	for(; proxy < lastProxy; ++proxy){
+		(*callback)(proxy->node, args);
+	}
+}
+
+/*
+** Find every pair of nodes whose bounding boxes overlap and call
+** "callback" on their values. Each pair is only reported once,
+** and the order of the values is arbitrary. The sort only tells
+** us which nodes overlap on the x-axis, so we check the other two
+** axes before reporting a pair.
+*/
+void aabbSweepQueryCollisions(
+	aabbSweep *const restrict sweep,
+	void (*const callback)(void *const restrict d1, void *const restrict d2, void *args), void *args
+){
+
+	aabbSweepProxy *proxy = sweep->proxies;
+	const aabbSweepProxy *const lastProxy = &proxy[sweep->numProxies];
+
+	// Refresh each proxy's interval and restore the ordering.
+	for(; proxy < lastProxy; ++proxy){
+		proxy->min = proxy->node->aabb.min.x;
+		proxy->max = proxy->node->aabb.max.x;
+	}
+	insertionSortAABBSweepProxies(sweep->proxies, sweep->numProxies);
+
+	// Every proxy that starts before the current one ends overlaps it.
+	for(proxy = sweep->proxies; proxy < lastProxy; ++proxy){
+		const aabbSweepProxy *other = &proxy[1];
+		for(; other < lastProxy && other->min <= proxy->max; ++other){
+			if(colliderAABBCollidingAABB(&proxy->node->aabb, &other->node->aabb)){
+				(*callback)(proxy->node->data.leaf.value, other->node->data.leaf.value, args);
+			}
+		}
+	}
+}
+
+/*
+** Call "callback" on the value of every node whose bounding box
+** overlaps "aabb". The proxies may not be sorted between queries,
+** so we can't exit early and need to check every one of them.
+*/
+void aabbSweepQueryAABB(
+	aabbSweep *const restrict sweep, const colliderAABB *const restrict aabb,
+	void (*const callback)(void *const restrict value, void *args), void *args
+){
+
+	const aabbSweepProxy *proxy = sweep->proxies;
+	const aabbSweepProxy *const lastProxy = &proxy[sweep->numProxies];
+
+	for(; proxy < lastProxy; ++proxy){
+		if(colliderAABBCollidingAABB(aabb, &proxy->node->aabb)){
+			(*callback)(proxy->node->data.leaf.value, args);
+		}
+	}
+}
+
+
+/*
+** Call "callback" on the value of every node whose bounding box is hit
+** by a ray starting at "origin" before it has travelled "maxDistance".
+** Like "aabbTreeQueryRay", the callback returns the new maximum distance,
+** and a negative distance stops the query.
+*/
+void aabbSweepQueryRay(
+	aabbSweep *const restrict sweep, const vec3 *const restrict origin, const vec3 *const restrict invDir, float maxDistance,
+	float (*const callback)(void *const restrict value, const float maxDistance, void *args), void *args
+){
+
+	const aabbSweepProxy *proxy = sweep->proxies;
+	const aabbSweepProxy *const lastProxy = &proxy[sweep->numProxies];
+
+	for(; proxy < lastProxy; ++proxy){
+		if(colliderAABBCollidingRay(&proxy->node->aabb, origin, invDir, maxDistance)){
+			maxDistance = (*callback)(proxy->node->data.leaf.value, maxDistance, args);
+			if(maxDistance < 0.f){
+				return;
+			}
+		}
+	}
+}
+
+
+// Free the proxy array. The nodes should be removed first.
+void aabbSweepDelete(aabbSweep *const restrict sweep){
+	if(sweep->proxies != NULL){
+		memoryManagerGlobalFree(sweep->proxies);
+	}
+}
+
+
+insertionSortDefine(AABBSweepProxies, aabbSweepProxy, compareProxy)
\ No newline at end of file
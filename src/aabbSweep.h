@@ -0,0 +1,73 @@
+#ifndef aabbSweep_h
+#define aabbSweep_h
+
+
+#include <stddef.h>
+
+#include "settingsPhysics.h"
+
+#include "colliderAABB.h"
+#include "aabbTree.h"
+
+#include "sortInsertion.h"
+
+
+/*
+** Sweep-and-prune proxies store their node's extent along the sweep
+** axis, so sorting and sweeping don't have to touch the nodes.
+*/
+typedef struct aabbSweepProxy {
+	float min;
+	float max;
+	aabbNode *node;
+} aabbSweepProxy;
+
+/*
+** A sort-based alternative to the dynamic AABB tree. Nodes are kept
+** in an array sorted by the lower bounds of their bounding boxes on
+** the x-axis. Objects move very little between updates, so the array
+** stays almost sorted and insertion sort can restore it cheaply.
+**
+** The nodes are the same leaf nodes used by the tree, so anything
+** that only uses the leaves can work with either broadphase.
+*/
+typedef struct aabbSweep {
+	aabbSweepProxy *proxies;
+	size_t numProxies;
+	size_t capacity;
+	// Linked list of leaf nodes.
+	aabbNode *leaves;
+} aabbSweep;
+
+
+void aabbSweepInit(aabbSweep *const restrict sweep);
+
+aabbNode *aabbSweepInsertNode(
+	aabbSweep *const restrict sweep, const colliderAABB *const restrict aabb,
+	void *const restrict value, aabbNode *(*const allocate)()
+);
+void aabbSweepUpdateNode(aabbSweep *const restrict sweep, aabbNode *const restrict node);
+void aabbSweepRemoveNode(
+	aabbSweep *const restrict sweep, aabbNode *const restrict node, void (*const deallocate)(aabbNode *node, void *args), void *args
+);
+
+void aabbSweepTraverse(aabbSweep *const restrict sweep, void (*const callback)(aabbNode *node, void *args), void *args);
+void aabbSweepQueryCollisions(
+	aabbSweep *const restrict sweep,
+	void (*const callback)(void *const restrict d1, void *const restrict d2, void *args), void *args
+);
+void aabbSweepQueryAABB(
+	aabbSweep *const restrict sweep, const colliderAABB *const restrict aabb,
+	void (*const callback)(void *const restrict value, void *args), void *args
+);
+void aabbSweepQueryRay(
+	aabbSweep *const restrict sweep, const vec3 *const restrict origin, const vec3 *const restrict invDir, float maxDistance,
+	float (*const callback)(void *const restrict value, const float maxDistance, void *args), void *args
+);
+
+void aabbSweepDelete(aabbSweep *const restrict sweep);
+
+insertionSortDeclare(AABBSweepProxies, aabbSweepProxy)
+
+
+#endif
\ No newline at end of file
@@ -7,6 +7,28 @@
 #define AABBTREE_QUERY_STACK_SIZE 256
 
 
+#ifdef AABBTREE_RAY_PACKET_SIMD
+#include <xmmintrin.h>
+#endif
+
+/*
+** Rays in a packet are stored in structure-of-arrays form,
+** so a node's slab tests can be done for every ray at once.
+*/
+typedef struct aabbTreeRayPacket {
+	#ifdef AABBTREE_RAY_PACKET_SIMD
+	__m128 origin[3];
+	__m128 invDir[3];
+	#else
+	vec3 origin[AABBTREE_RAY_PACKET_WIDTH];
+	vec3 invDir[AABBTREE_RAY_PACKET_WIDTH];
+	#endif
+	// Rays that have stopped, as well as any unused
+	// lanes, are given a negative maximum distance.
+	float maxDistance[AABBTREE_RAY_PACKET_WIDTH];
+} aabbTreeRayPacket;
+
+
 /*
 ** Based off Randy Gaul's dynamic AABB tree implementation:
 **     https://github.com/RandyGaul/qu3e/blob/master/src/broadphase/q3DynamicAABBTree.cpp
@@ -19,10 +41,21 @@ static void balanceHierarchy(aabbTree *const restrict tree, aabbNode *const rest
 static void insertLeaf(aabbTree *const restrict tree, aabbNode *const restrict node, aabbNode *const restrict parent);
 static void removeLeaf(aabbTree *const restrict tree, aabbNode *const restrict node);
 
+static void initRayPacket(
+	aabbTreeRayPacket *const restrict packet, const vec3 *const restrict origins,
+	const vec3 *const restrict invDirs, const float *const restrict maxDistances, const size_t numRays
+);
+static unsigned int rayPacketHits(const aabbTreeRayPacket *const restrict packet, const colliderAABB *const restrict aabb);
+static void queryRayPacket(
+	aabbTree *const restrict tree, aabbTreeRayPacket *const restrict packet, const size_t firstRay,
+	float (*const callback)(void *const restrict value, const size_t ray, const float maxDistance, void *args), void *args
+);
+
 
 void aabbTreeInit(aabbTree *const restrict tree){
 	tree->root = NULL;
 	tree->leaves = NULL;
+	tree->numLeaves = 0;
 }
 
 
@@ -42,6 +75,7 @@ aabbNode *aabbTreeInsertNode(
 	node->data.leaf.next = tree->leaves;
 	node->height = AABBNODE_HEIGHT_LEAF;
 	tree->leaves = node;
+	++tree->numLeaves;
 
 	if(tree->root != NULL){
 		aabbNode *const parent = (*allocate)();
@@ -91,6 +125,7 @@ void aabbTreeRemoveNode(
 	}else{
 		tree->root = NULL;
 	}
+	--tree->numLeaves;
 
 	(*deallocate)(node, args);
 }
@@ -227,6 +262,193 @@ void aabbTreeQueryCollisionsStack(
 	} while(i);
 }
 
+/*
+** Call "callback" on every pair of leaves whose bounding boxes overlap.
+** Rather than querying the tree once for each leaf, which finds every
+** pair twice, we descend through pairs of nodes at the same time, like
+** Bullet's "collideTT". The pair of a node with itself is split into
+** its children's pairs, so leaves are never paired with themselves
+** and every overlapping pair is reported exactly once.
+**
+** Each pair we pop pushes at most three more and we descend one level
+** at a time, so the stack never needs more than four entries for every
+** level of the tree. The query stack is more than enough for this.
+*/
+void aabbTreeQueryPairs(
+	aabbTree *const restrict tree,
+	void (*const callback)(aabbNode *const nodeA, aabbNode *const nodeB, void *args), void *args
+){
+
+	aabbNode *stackA[AABBTREE_QUERY_STACK_SIZE];
+	aabbNode *stackB[AABBTREE_QUERY_STACK_SIZE];
+	size_t i = 1;
+
+	if(tree->root == NULL){
+		return;
+	}
+	stackA[0] = tree->root;
+	stackB[0] = tree->root;
+
+	do {
+		aabbNode *nodeA;
+		aabbNode *nodeB;
+
+		--i;
+		nodeA = stackA[i];
+		nodeB = stackB[i];
+
+		// A branch's leaves might overlap each other,
+		// so check both of its subtrees and their pair.
+		if(nodeA == nodeB){
+			if(!aabbNodeIsLeaf(nodeA)){
+				aabbNode *const left = nodeA->data.children.left;
+				aabbNode *const right = nodeA->data.children.right;
+
+				stackA[i] = left;
+				stackB[i] = left;
+				++i;
+				stackA[i] = right;
+				stackB[i] = right;
+				++i;
+				stackA[i] = left;
+				stackB[i] = right;
+				++i;
+			}
+		}else if(colliderAABBCollidingAABB(&nodeA->aabb, &nodeB->aabb)){
+			if(aabbNodeIsLeaf(nodeA)){
+				if(aabbNodeIsLeaf(nodeB)){
+					(*callback)(nodeA, nodeB, args);
+
+				// Only node B has children, so descend into them.
+				}else{
+					stackA[i] = nodeA;
+					stackB[i] = nodeB->data.children.left;
+					++i;
+					stackA[i] = nodeA;
+					stackB[i] = nodeB->data.children.right;
+					++i;
+				}
+
+			// Otherwise, descend into the taller of the two nodes.
+			// This keeps the pairs we check roughly the same size.
+			}else if(aabbNodeIsLeaf(nodeB) || nodeA->height >= nodeB->height){
+				stackA[i] = nodeA->data.children.left;
+				stackB[i] = nodeB;
+				++i;
+				stackA[i] = nodeA->data.children.right;
+				stackB[i] = nodeB;
+				++i;
+			}else{
+				stackA[i] = nodeA;
+				stackB[i] = nodeB->data.children.left;
+				++i;
+				stackA[i] = nodeA;
+				stackB[i] = nodeB->data.children.right;
+				++i;
+			}
+		}
+	} while(i);
+}
+
+// Call "callback" on the value of every leaf whose bounding box overlaps "aabb".
+void aabbTreeQueryAABB(
+	aabbTree *const restrict tree, const colliderAABB *const restrict aabb,
+	void (*const callback)(void *const restrict value, void *args), void *args
+){
+
+	aabbNode *stack[AABBTREE_QUERY_STACK_SIZE];
+	size_t i = 1;
+
+	if(tree->root == NULL){
+		return;
+	}
+	stack[0] = tree->root;
+
+	do {
+		aabbNode *curNode = stack[--i];
+
+		if(colliderAABBCollidingAABB(aabb, &curNode->aabb)){
+			if(aabbNodeIsLeaf(curNode)){
+				(*callback)(curNode->data.leaf.value, args);
+			}else{
+				stack[i] = curNode->data.children.left;
+				++i;
+				stack[i] = curNode->data.children.right;
+				++i;
+			}
+		}
+	} while(i);
+}
+
+/*
+** Call "callback" on the value of every leaf whose bounding box is hit
+** by a ray starting at "origin" before it has travelled "maxDistance".
+** The callback returns the new maximum distance, so queries for the
+** closest hit can stop visiting nodes that are farther away. If the
+** callback returns a negative distance, the query stops immediately.
+*/
+void aabbTreeQueryRay(
+	aabbTree *const restrict tree, const vec3 *const restrict origin, const vec3 *const restrict invDir, float maxDistance,
+	float (*const callback)(void *const restrict value, const float maxDistance, void *args), void *args
+){
+
+	aabbNode *stack[AABBTREE_QUERY_STACK_SIZE];
+	size_t i = 1;
+
+	if(tree->root == NULL){
+		return;
+	}
+	stack[0] = tree->root;
+
+	do {
+		aabbNode *curNode = stack[--i];
+
+		if(colliderAABBCollidingRay(&curNode->aabb, origin, invDir, maxDistance)){
+			if(aabbNodeIsLeaf(curNode)){
+				maxDistance = (*callback)(curNode->data.leaf.value, maxDistance, args);
+				if(maxDistance < 0.f){
+					return;
+				}
+			}else{
+				stack[i] = curNode->data.children.left;
+				++i;
+				stack[i] = curNode->data.children.right;
+				++i;
+			}
+		}
+	} while(i);
+}
+
+/*
+** Traverse the tree for a batch of rays, calling "callback" whenever
+** a ray hits a leaf. The callback is given the ray's index in the
+** batch, and it returns the ray's new maximum distance, which should
+** be negative if the ray should stop.
+**
+** Rays are traversed in packets of "AABBTREE_RAY_PACKET_WIDTH", so
+** this works best when neighbouring rays travel in similar directions.
+** The tree isn't modified, so separate parts of a large batch may be
+** queried on separate threads.
+*/
+void aabbTreeQueryRayBatch(
+	aabbTree *const restrict tree, const vec3 *const restrict origins, const vec3 *const restrict invDirs,
+	const float *const restrict maxDistances, const size_t numRays,
+	float (*const callback)(void *const restrict value, const size_t ray, const float maxDistance, void *args), void *args
+){
+
+	size_t i;
+
+	if(tree->root == NULL){
+		return;
+	}
+
+	for(i = 0; i < numRays; i += AABBTREE_RAY_PACKET_WIDTH){
+		aabbTreeRayPacket packet;
+		initRayPacket(&packet, &origins[i], &invDirs[i], &maxDistances[i], numRays - i);
+		queryRayPacket(tree, &packet, i, callback, args);
+	}
+}
+
 /*
 ** Traverse the tree in order and return first node
 ** following "prevNode" that may be colliding with "aabb".
@@ -578,4 +800,126 @@ static void removeLeaf(aabbTree *const restrict tree, aabbNode *const restrict n
 		tree->root = sibling;
 		sibling->parent = NULL;
 	}
+}
+
+
+/*
+** Fill a packet with up to "AABBTREE_RAY_PACKET_WIDTH" rays.
+** Unused lanes copy the first ray, but they never hit anything.
+*/
+static void initRayPacket(
+	aabbTreeRayPacket *const restrict packet, const vec3 *const restrict origins,
+	const vec3 *const restrict invDirs, const float *const restrict maxDistances, const size_t numRays
+){
+
+	#ifdef AABBTREE_RAY_PACKET_SIMD
+	float origin[3][AABBTREE_RAY_PACKET_WIDTH];
+	float invDir[3][AABBTREE_RAY_PACKET_WIDTH];
+	#endif
+	size_t i;
+
+	for(i = 0; i < AABBTREE_RAY_PACKET_WIDTH; ++i){
+		const size_t ray = (i < numRays) ? i : 0;
+
+		#ifdef AABBTREE_RAY_PACKET_SIMD
+		origin[0][i] = origins[ray].x;
+		origin[1][i] = origins[ray].y;
+		origin[2][i] = origins[ray].z;
+		invDir[0][i] = invDirs[ray].x;
+		invDir[1][i] = invDirs[ray].y;
+		invDir[2][i] = invDirs[ray].z;
+		#else
+		packet->origin[i] = origins[ray];
+		packet->invDir[i] = invDirs[ray];
+		#endif
+		packet->maxDistance[i] = (i < numRays) ? maxDistances[ray] : -1.f;
+	}
+
+	#ifdef AABBTREE_RAY_PACKET_SIMD
+	for(i = 0; i < 3; ++i){
+		packet->origin[i] = _mm_loadu_ps(origin[i]);
+		packet->invDir[i] = _mm_loadu_ps(invDir[i]);
+	}
+	#endif
+}
+
+/*
+** Return a mask with the i'th bit set if the
+** packet's i'th ray hits the bounding box.
+*/
+static unsigned int rayPacketHits(const aabbTreeRayPacket *const restrict packet, const colliderAABB *const restrict aabb){
+	#ifdef AABBTREE_RAY_PACKET_SIMD
+	const float *const min = (const float *)&aabb->min;
+	const float *const max = (const float *)&aabb->max;
+	__m128 tNear = _mm_setzero_ps();
+	__m128 tFar = _mm_loadu_ps(packet->maxDistance);
+	size_t i;
+
+	for(i = 0; i < 3; ++i){
+		const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(min[i]), packet->origin[i]), packet->invDir[i]);
+		const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(max[i]), packet->origin[i]), packet->invDir[i]);
+		tNear = _mm_max_ps(tNear, _mm_min_ps(t1, t2));
+		tFar = _mm_min_ps(tFar, _mm_max_ps(t1, t2));
+	}
+
+	return(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+	#else
+	unsigned int hits = 0;
+	size_t i;
+
+	for(i = 0; i < AABBTREE_RAY_PACKET_WIDTH; ++i){
+		if(colliderAABBCollidingRay(aabb, &packet->origin[i], &packet->invDir[i], packet->maxDistance[i])){
+			hits |= 1 << i;
+		}
+	}
+
+	return(hits);
+	#endif
+}
+
+/*
+** Traverse the tree for every ray in the packet at once. We only
+** descend into nodes that are hit by at least one of the rays, and
+** stop early if all of the rays have stopped.
+*/
+static void queryRayPacket(
+	aabbTree *const restrict tree, aabbTreeRayPacket *const restrict packet, const size_t firstRay,
+	float (*const callback)(void *const restrict value, const size_t ray, const float maxDistance, void *args), void *args
+){
+
+	aabbNode *stack[AABBTREE_QUERY_STACK_SIZE];
+	size_t i = 1;
+
+	stack[0] = tree->root;
+
+	do {
+		aabbNode *curNode = stack[--i];
+		const unsigned int hits = rayPacketHits(packet, &curNode->aabb);
+
+		if(hits){
+			if(aabbNodeIsLeaf(curNode)){
+				return_t active = 0;
+				size_t j;
+
+				for(j = 0; j < AABBTREE_RAY_PACKET_WIDTH; ++j){
+					if(hits & (1 << j)){
+						packet->maxDistance[j] = (*callback)(
+							curNode->data.leaf.value, firstRay + j, packet->maxDistance[j], args
+						);
+					}
+					if(packet->maxDistance[j] >= 0.f){
+						active = 1;
+					}
+				}
+				if(!active){
+					return;
+				}
+			}else{
+				stack[i] = curNode->data.children.left;
+				++i;
+				stack[i] = curNode->data.children.right;
+				++i;
+			}
+		}
+	} while(i);
 }
\ No newline at end of file
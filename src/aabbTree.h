@@ -9,6 +9,15 @@
 #include "colliderAABB.h"
 
 
+// Ray packets are tested against each node using SSE,
+// which every x86-64 processor has.
+#if defined(AABBTREE_RAY_PACKET_SIMD) && !(defined(__SSE__) || defined(_M_X64))
+	#undef AABBTREE_RAY_PACKET_SIMD
+#endif
+
+// Number of rays traversed together by batched ray queries.
+#define AABBTREE_RAY_PACKET_WIDTH 4
+
 #define AABBNODE_HEIGHT_LEAF        0
 #define AABBNODE_HEIGHT_LAST_BRANCH 1
 
@@ -27,6 +36,11 @@ typedef struct aabbNodeLeaf {
 	// Pointer to the next
 	// leaf node in the list.
 	aabbNode *next;
+	// Broadphases that store their leaves in
+	// arrays keep the leaf's index here. Pair
+	// caches store the index of the leaf's
+	// first pair here instead.
+	size_t index;
 } aabbNodeLeaf;
 
 
@@ -48,6 +62,7 @@ typedef struct aabbTree {
 	aabbNode *root;
 	// Linked list of leaf nodes.
 	aabbNode *leaves;
+	size_t numLeaves;
 } aabbTree;
 
 
@@ -71,6 +86,23 @@ void aabbTreeQueryCollisionsStack(
 	aabbTree *const restrict tree, const aabbNode *const node,
 	void (*const callback)(void *const restrict d1, void *const restrict d2, void *args), void *args
 );
+void aabbTreeQueryPairs(
+	aabbTree *const restrict tree,
+	void (*const callback)(aabbNode *const nodeA, aabbNode *const nodeB, void *args), void *args
+);
+void aabbTreeQueryAABB(
+	aabbTree *const restrict tree, const colliderAABB *const restrict aabb,
+	void (*const callback)(void *const restrict value, void *args), void *args
+);
+void aabbTreeQueryRay(
+	aabbTree *const restrict tree, const vec3 *const restrict origin, const vec3 *const restrict invDir, float maxDistance,
+	float (*const callback)(void *const restrict value, const float maxDistance, void *args), void *args
+);
+void aabbTreeQueryRayBatch(
+	aabbTree *const restrict tree, const vec3 *const restrict origins, const vec3 *const restrict invDirs,
+	const float *const restrict maxDistances, const size_t numRays,
+	float (*const callback)(void *const restrict value, const size_t ray, const float maxDistance, void *args), void *args
+);
 aabbNode *aabbTreeFindNextNode(
 	aabbTree *const restrict tree, const colliderAABB *const restrict aabb, const aabbNode *const restrict prevNode
 );
@@ -59,6 +59,65 @@ void colliderUpdate(
 	}
 }
 
+/*
+** Return whether "colliderSupport" can describe a collider. Only
+** these types can be used with GJK, such as for shape casts and
+** continuous collision detection.
+*/
+return_t colliderHasSupport(const collider *const restrict c){
+	switch(c->type){
+		case 0:
+		case COLLIDER_TYPE_SPHERE:
+		case COLLIDER_TYPE_CAPSULE:
+			return(1);
+		break;
+		default:
+			return(0);
+	}
+}
+
+// Find the point on a collider farthest in the direction "dir".
+void colliderSupport(const void *const restrict c, const vec3 *const restrict dir, vec3 *const restrict out){
+	switch(((collider *)c)->type){
+		case 0:
+			*out = *colliderHullSupport(&((collider *)c)->data.hull, dir);
+		break;
+		case COLLIDER_TYPE_SPHERE:
+			colliderSphereSupport(&((collider *)c)->data.sphere, dir, out);
+		break;
+		case COLLIDER_TYPE_CAPSULE:
+			colliderCapsuleSupport(&((collider *)c)->data.capsule, dir, out);
+		break;
+		default:
+			vec3InitZero(out);
+	}
+}
+
+/*
+** Find where a ray starting at "origin" and travelling in the unit
+** direction "dir" first hits a collider, if it does so before it
+** has travelled "maxDistance". Colliders must have been updated.
+*/
+return_t colliderRaycast(
+	const collider *const restrict c, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+){
+
+	switch(c->type){
+		case 0:
+			return(colliderHullRaycast(&c->data.hull, origin, dir, maxDistance, distance, normal));
+		break;
+		case COLLIDER_TYPE_SPHERE:
+			return(colliderSphereRaycast(&c->data.sphere, origin, dir, maxDistance, distance, normal));
+		break;
+		case COLLIDER_TYPE_CAPSULE:
+			return(colliderCapsuleRaycast(&c->data.capsule, origin, dir, maxDistance, distance, normal));
+		break;
+		default:
+			return(0);
+	}
+}
+
 
 void colliderDeleteInstance(collider *const restrict c){
 	switch(c->type){
@@ -33,6 +33,10 @@ typedef struct collider {
 	// to store any type of collider.
 	union {
 		colliderHull hull;
+		// Spheres and capsules can't be loaded yet,
+		// but they can be used for scene queries.
+		colliderSphere sphere;
+		colliderCapsule capsule;
 	} data;
 	// Stores which type of
 	// collider this object is.
@@ -57,6 +61,12 @@ void colliderUpdate(
 	const collider *const restrict cBase, const vec3 *const restrict baseCentroid,
 	const transform *const restrict trans, colliderAABB *const restrict aabb
 );
+return_t colliderHasSupport(const collider *const restrict c);
+void colliderSupport(const void *const restrict c, const vec3 *const restrict dir, vec3 *const restrict out);
+return_t colliderRaycast(
+	const collider *const restrict c, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+);
 
 void colliderDeleteInstance(collider *const restrict c);
 void colliderDelete(collider *const restrict c);
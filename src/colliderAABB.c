@@ -1,6 +1,23 @@
 #include "colliderAABB.h"
 
 
+#include <math.h>
+#include <float.h>
+
+#include "utilMath.h"
+
+
+// Ray direction components are clamped to this before being inverted.
+#define COLLIDER_AABB_RAY_EPSILON 1e-18f
+
+
+// Forward-declare any helper functions!
+static void raySlab(
+	const float min, const float max, const float origin, const float invDir,
+	float *const restrict tNear, float *const restrict tFar
+);
+
+
 void colliderAABBUpdate(
 	colliderAABB *const restrict aabb,
 	const colliderAABB *const restrict base,
@@ -230,4 +247,107 @@ return_t colliderAABBCollidingAABB(
 		aabbA->min.y <= aabbB->max.y && aabbA->max.y >= aabbB->min.y &&
 		aabbA->min.z <= aabbB->max.z && aabbA->max.z >= aabbB->min.z
 	);
+}
+
+
+/*
+** Invert a ray's direction for the slab tests. Components that are
+** almost zero are replaced by a huge value rather than infinity, as
+** "-ffast-math" lets the compiler assume that infinities never occur.
+*/
+void colliderAABBInvertRay(const vec3 *const restrict dir, vec3 *const restrict invDir){
+	invDir->x = (fabsf(dir->x) > COLLIDER_AABB_RAY_EPSILON) ? 1.f/dir->x : copySign(1.f/COLLIDER_AABB_RAY_EPSILON, dir->x);
+	invDir->y = (fabsf(dir->y) > COLLIDER_AABB_RAY_EPSILON) ? 1.f/dir->y : copySign(1.f/COLLIDER_AABB_RAY_EPSILON, dir->y);
+	invDir->z = (fabsf(dir->z) > COLLIDER_AABB_RAY_EPSILON) ? 1.f/dir->z : copySign(1.f/COLLIDER_AABB_RAY_EPSILON, dir->z);
+}
+
+/*
+** Return whether a ray starting at "origin" hits an axis-aligned
+** bounding box before travelling "maxDistance". This is used
+** by broadphase traversals, so it takes the inverted direction
+** and doesn't bother working out where the ray hits.
+*/
+return_t colliderAABBCollidingRay(
+	const colliderAABB *const restrict aabb, const vec3 *const restrict origin,
+	const vec3 *const restrict invDir, const float maxDistance
+){
+
+	float tNear = 0.f;
+	float tFar = maxDistance;
+
+	raySlab(aabb->min.x, aabb->max.x, origin->x, invDir->x, &tNear, &tFar);
+	raySlab(aabb->min.y, aabb->max.y, origin->y, invDir->y, &tNear, &tFar);
+	raySlab(aabb->min.z, aabb->max.z, origin->z, invDir->z, &tNear, &tFar);
+
+	return(tNear <= tFar);
+}
+
+/*
+** Find where a ray starting at "origin" and travelling in the
+** unit direction "dir" first hits an axis-aligned bounding box.
+** If the ray starts inside the box, it hits immediately and the
+** normal points back along the ray.
+*/
+return_t colliderAABBRaycast(
+	const colliderAABB *const restrict aabb, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+){
+
+	vec3 invDir;
+	vec3 tNear;
+	float tFar = maxDistance;
+
+	colliderAABBInvertRay(dir, &invDir);
+	tNear.x = tNear.y = tNear.z = -FLT_MAX;
+	raySlab(aabb->min.x, aabb->max.x, origin->x, invDir.x, &tNear.x, &tFar);
+	raySlab(aabb->min.y, aabb->max.y, origin->y, invDir.y, &tNear.y, &tFar);
+	raySlab(aabb->min.z, aabb->max.z, origin->z, invDir.z, &tNear.z, &tFar);
+	if(tFar < 0.f){
+		return(0);
+	}
+
+	// The ray enters the box through the last slab it enters.
+	vec3InitZero(normal);
+	if(tNear.x >= tNear.y && tNear.x >= tNear.z){
+		*distance = tNear.x;
+		normal->x = -copySign(1.f, dir->x);
+	}else if(tNear.y >= tNear.z){
+		*distance = tNear.y;
+		normal->y = -copySign(1.f, dir->y);
+	}else{
+		*distance = tNear.z;
+		normal->z = -copySign(1.f, dir->z);
+	}
+
+	if(*distance > tFar){
+		return(0);
+	}
+	if(*distance < 0.f){
+		*distance = 0.f;
+		vec3NegateOut(dir, normal);
+	}
+
+	return(1);
+}
+
+
+/*
+** Clip the interval "[tNear, tFar]" to the part of a ray
+** that lies between the planes of one of a box's slabs.
+*/
+static void raySlab(
+	const float min, const float max, const float origin, const float invDir,
+	float *const restrict tNear, float *const restrict tFar
+){
+
+	const float t1 = (min - origin) * invDir;
+	const float t2 = (max - origin) * invDir;
+
+	if(t1 < t2){
+		*tNear = floatMaxFast(*tNear, t1);
+		*tFar  = floatMinFast(*tFar, t2);
+	}else{
+		*tNear = floatMaxFast(*tNear, t2);
+		*tFar  = floatMinFast(*tFar, t1);
+	}
 }
\ No newline at end of file
@@ -61,5 +61,15 @@ return_t colliderAABBCollidingAABB(
 	const colliderAABB *const restrict aabbB
 );
 
+void colliderAABBInvertRay(const vec3 *const restrict dir, vec3 *const restrict invDir);
+return_t colliderAABBCollidingRay(
+	const colliderAABB *const restrict aabb, const vec3 *const restrict origin,
+	const vec3 *const restrict invDir, const float maxDistance
+);
+return_t colliderAABBRaycast(
+	const colliderAABB *const restrict aabb, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+);
+
 
 #endif
\ No newline at end of file
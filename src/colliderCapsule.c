@@ -1,4 +1,108 @@
 #include "colliderCapsule.h"
 
 
-// 
\ No newline at end of file
+#include <math.h>
+
+#include "utilMath.h"
+
+#include "colliderSphere.h"
+
+
+// Return the point on a capsule farthest in the direction "dir".
+void colliderCapsuleSupport(
+	const colliderCapsule *const restrict capsule,
+	const vec3 *const restrict dir, vec3 *const restrict out
+){
+
+	const float magnitudeSquared = vec3MagnitudeSquaredVec3(dir);
+	const vec3 *const endpoint = (vec3DotVec3(&capsule->start, dir) >= vec3DotVec3(&capsule->end, dir)) ? &capsule->start : &capsule->end;
+
+	if(magnitudeSquared > 0.f){
+		vec3FmaOut(capsule->radius * invSqrt(magnitudeSquared), dir, endpoint, out);
+	}else{
+		*out = *endpoint;
+	}
+}
+
+/*
+** Let the capsule's segment run from a to b, so its axis is
+** d = b - a, and let the ray start at p with unit direction v.
+** The ray hits the capsule's cylindrical body when the distance
+** from p + tv to the axis is r, which gives the quadratic
+**     (d.d - (d.v)^2)t^2 + 2(d.d (v.m) - (d.m)(d.v))t
+**         + d.d (m.m - r^2) - (d.m)^2 = 0,
+** where m = p - a. The hit is only on the body if its projection
+** onto the axis, y = d.m + t(d.v), is between 0 and d.d, and as
+** the hemispherical caps are inside the infinite cylinder, such
+** a hit must be the first one. Otherwise, the ray can only hit
+** one of the caps, which we test as spheres.
+*/
+return_t colliderCapsuleRaycast(
+	const colliderCapsule *const restrict capsule, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+){
+
+	vec3 axis;
+	vec3 offset;
+	float axisAxis;
+	float axisDir;
+	float axisOffset;
+	const float radiusSquared = capsule->radius*capsule->radius;
+	float a;
+
+	vec3SubtractVec3Out(&capsule->end, &capsule->start, &axis);
+	vec3SubtractVec3Out(origin, &capsule->start, &offset);
+	axisAxis   = vec3DotVec3(&axis, &axis);
+	axisDir    = vec3DotVec3(&axis, dir);
+	axisOffset = vec3DotVec3(&axis, &offset);
+
+	// If the ray starts inside the capsule, it hits immediately.
+	{
+		const float s = (axisAxis > 0.f) ? floatClamp(axisOffset / axisAxis, 0.f, 1.f) : 0.f;
+		vec3 closest;
+		vec3FmaOut(-s, &axis, &offset, &closest);
+		if(vec3MagnitudeSquaredVec3(&closest) <= radiusSquared){
+			*distance = 0.f;
+			vec3NegateOut(dir, normal);
+			return(1);
+		}
+	}
+
+	// Rays that are parallel to the axis can only hit the caps.
+	a = axisAxis - axisDir*axisDir;
+	if(a > MATH_NORMALIZE_EPSILON * axisAxis){
+		const float b = axisAxis*vec3DotVec3(&offset, dir) - axisOffset*axisDir;
+		const float c = axisAxis*(vec3MagnitudeSquaredVec3(&offset) - radiusSquared) - axisOffset*axisOffset;
+		const float discriminant = b*b - a*c;
+
+		if(discriminant >= 0.f){
+			const float t = (-b - sqrtf(discriminant)) / a;
+			const float y = axisOffset + t*axisDir;
+
+			if(y > 0.f && y < axisAxis){
+				if(t < 0.f || t > maxDistance){
+					return(0);
+				}
+
+				// The normal points away from the closest point on the axis.
+				*distance = t;
+				vec3FmaP2(t, dir, &offset);
+				vec3FmaP2(-y / axisAxis, &axis, &offset);
+				vec3MultiplySOut(&offset, 1.f/capsule->radius, normal);
+				return(1);
+			}
+		}
+	}
+
+	// Otherwise, take the closer of the two caps' hits.
+	{
+		colliderSphere cap;
+		return_t hit;
+
+		cap.pos = capsule->start;
+		cap.radius = capsule->radius;
+		hit = colliderSphereRaycast(&cap, origin, dir, maxDistance, distance, normal);
+		cap.pos = capsule->end;
+		return(colliderSphereRaycast(&cap, origin, dir, hit ? *distance : maxDistance, distance, normal) || hit);
+	}
+}
\ No newline at end of file
@@ -2,7 +2,28 @@
 #define colliderCapsule_h
 
 
-//
+#include "vec3.h"
+
+#include "utilTypes.h"
+
+
+// A capsule is the set of points within
+// "radius" of the segment from "start" to "end".
+typedef struct colliderCapsule {
+	vec3 start;
+	vec3 end;
+	float radius;
+} colliderCapsule;
+
+
+void colliderCapsuleSupport(
+	const colliderCapsule *const restrict capsule,
+	const vec3 *const restrict dir, vec3 *const restrict out
+);
+return_t colliderCapsuleRaycast(
+	const colliderCapsule *const restrict capsule, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,600 @@
+#include "colliderGJK.h"
+
+
+#include <math.h>
+#include <string.h>
+
+#include "utilMath.h"
+
+
+#define COLLIDER_GJK_TOLERANCE_SQUARED (COLLIDER_GJK_TOLERANCE*COLLIDER_GJK_TOLERANCE)
+
+// The initial tetrahedron has four vertices, and each iteration of
+// EPA adds one more. A closed triangle mesh with "n" vertices has
+// "2n - 4" faces, and each face we remove has three edges.
+#define COLLIDER_GJK_EPA_MAX_VERTICES (COLLIDER_GJK_EPA_MAX_ITERATIONS + 4)
+#define COLLIDER_GJK_EPA_MAX_FACES    (2*COLLIDER_GJK_EPA_MAX_VERTICES - 4)
+#define COLLIDER_GJK_EPA_MAX_EDGES    (3*COLLIDER_GJK_EPA_MAX_FACES)
+
+
+// Triangle on the boundary of the EPA polytope. The
+// normal always points away from the polytope, and
+// "distance" is the face's distance from the origin.
+typedef struct epaFace {
+	vec3 normal;
+	float distance;
+	byte_t vertices[3];
+} epaFace;
+
+
+// Forward-declare any helper functions!
+static void minkowskiSupport(
+	const void *const restrict cA, const vec3 *const restrict offsetA,
+	const void *const restrict cB, const colliderSupportFunc support,
+	const vec3 *const restrict dir, vec3 *const restrict out
+);
+static void closestPointSegment(
+	const vec3 *const restrict a, const vec3 *const restrict b,
+	colliderGJKSimplex *const restrict simplex, vec3 *const restrict v
+);
+static void closestPointTriangle(
+	const vec3 *const restrict a, const vec3 *const restrict b, const vec3 *const restrict c,
+	colliderGJKSimplex *const restrict simplex, vec3 *const restrict v
+);
+static return_t originOutsidePlane(
+	const vec3 *const restrict a, const vec3 *const restrict b,
+	const vec3 *const restrict c, const vec3 *const restrict d
+);
+static return_t closestPointTetrahedron(colliderGJKSimplex *const restrict simplex, vec3 *const restrict v);
+static return_t closestPointSimplex(colliderGJKSimplex *const restrict simplex, vec3 *const restrict v);
+static return_t epaFaceInit(
+	epaFace *const restrict face, const vec3 *const restrict vertices,
+	const byte_t a, const byte_t b, const byte_t c
+);
+static void epaAddEdge(byte_t (*const edges)[2], size_t *const restrict numEdges, const byte_t a, const byte_t b);
+
+
+/*
+** Return the distance between two colliders using the Gilbert-Johnson-Keerthi
+** algorithm. Collider A is translated by "offsetA", which lets us move it
+** without having to update its vertices, unless it is NULL. If the colliders
+** are separated, "normal" is set to the direction from collider B to A.
+**
+** If the colliders are intersecting, we return zero and "normal" is unset.
+** In this case, "simplex" can be passed to "colliderGJKPenetration".
+*/
+float colliderGJKDistance(
+	const void *const restrict cA, const vec3 *const restrict offsetA,
+	const void *const restrict cB, const colliderSupportFunc support,
+	colliderGJKSimplex *const restrict simplex, vec3 *const restrict normal
+){
+
+	vec3 v;
+	float distanceSquared;
+	float distance;
+	unsigned int i;
+
+	// Start with an arbitrary point on the Minkowski difference.
+	vec3InitSet(&v, 1.f, 0.f, 0.f);
+	minkowskiSupport(cA, offsetA, cB, support, &v, &simplex->vertices[0]);
+	simplex->numVertices = 1;
+	v = simplex->vertices[0];
+
+	for(i = 0; i < COLLIDER_GJK_MAX_ITERATIONS; ++i){
+		const vec3 prevV = v;
+		vec3 dir;
+		vec3 w;
+		byte_t j;
+
+		distanceSquared = vec3MagnitudeSquaredVec3(&v);
+		// If the origin is on the simplex, the colliders are touching.
+		if(distanceSquared <= COLLIDER_GJK_TOLERANCE_SQUARED){
+			return(0.f);
+		}
+
+		// Find the point on the Minkowski difference farthest towards the origin.
+		vec3NegateOut(&v, &dir);
+		minkowskiSupport(cA, offsetA, cB, support, &dir, &w);
+		// If this point doesn't get us any closer to the
+		// origin, "v" is the closest point we can find.
+		if(distanceSquared - vec3DotVec3(&v, &w) <= COLLIDER_GJK_TOLERANCE * distanceSquared){
+			break;
+		}
+		// The same goes for points that are already in the simplex.
+		// Rounding can make the test above miss these when we're
+		// very close to the origin, which would make us cycle.
+		for(j = 0; j < simplex->numVertices; ++j){
+			const vec3 *const vertex = &simplex->vertices[j];
+			if(vertex->x == w.x && vertex->y == w.y && vertex->z == w.z){
+				break;
+			}
+		}
+		if(j < simplex->numVertices){
+			break;
+		}
+
+		simplex->vertices[simplex->numVertices] = w;
+		++simplex->numVertices;
+		// If the simplex contains the origin, the colliders are intersecting.
+		if(!closestPointSimplex(simplex, &v)){
+			return(0.f);
+		}
+		// Every iteration should bring us closer to the origin.
+		// If it didn't, the last point is the best we can do.
+		if(vec3MagnitudeSquaredVec3(&v) >= distanceSquared){
+			v = prevV;
+			break;
+		}
+	}
+
+	distance = sqrtf(vec3MagnitudeSquaredVec3(&v));
+	vec3MultiplySOut(&v, 1.f/distance, normal);
+	return(distance);
+}
+
+/*
+** Find the penetration depth of two intersecting colliders using the
+** Expanding Polytope Algorithm. We start with the tetrahedron that
+** GJK found enclosing the origin and keep pushing out whichever face
+** of the polytope is closest to the origin until it reaches the
+** boundary of the Minkowski difference.
+**
+** On success, "normal" is the direction collider A must be moved in
+** to separate the colliders and "depth" is how far it must be moved.
+** If GJK didn't give us a tetrahedron or the polytope degenerates, we
+** return zero and the caller should fall back to some other method.
+*/
+return_t colliderGJKPenetration(
+	const void *const restrict cA, const vec3 *const restrict offsetA,
+	const void *const restrict cB, const colliderSupportFunc support,
+	const colliderGJKSimplex *const restrict simplex,
+	vec3 *const restrict normal, float *const restrict depth
+){
+
+	// Each face of the tetrahedron, followed by the vertex opposite it.
+	static const byte_t tetrahedronFaces[4][4] = {
+		{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}
+	};
+	vec3 vertices[COLLIDER_GJK_EPA_MAX_VERTICES];
+	epaFace faces[COLLIDER_GJK_EPA_MAX_FACES];
+	byte_t edges[COLLIDER_GJK_EPA_MAX_EDGES][2];
+	size_t numVertices;
+	size_t numFaces = 0;
+	const epaFace *closestFace = NULL;
+	unsigned int i;
+
+	if(simplex->numVertices < 4){
+		return(0);
+	}
+
+	memcpy(vertices, simplex->vertices, sizeof(simplex->vertices));
+	numVertices = 4;
+	// Build the tetrahedron's faces, making sure their normals
+	// point away from the vertex opposite them.
+	for(i = 0; i < 4; ++i){
+		const byte_t *const f = tetrahedronFaces[i];
+		vec3 offset;
+
+		if(!epaFaceInit(&faces[numFaces], vertices, f[0], f[1], f[2])){
+			return(0);
+		}
+		vec3SubtractVec3Out(&vertices[f[3]], &vertices[f[0]], &offset);
+		if(vec3DotVec3(&faces[numFaces].normal, &offset) > 0.f){
+			epaFaceInit(&faces[numFaces], vertices, f[0], f[2], f[1]);
+		}
+		++numFaces;
+	}
+
+	for(i = 0; i < COLLIDER_GJK_EPA_MAX_ITERATIONS; ++i){
+		const epaFace *curFace = faces;
+		const epaFace *const lastFace = &faces[numFaces];
+		size_t numEdges = 0;
+		size_t j;
+		vec3 w;
+
+		// Find the face closest to the origin.
+		closestFace = curFace;
+		for(++curFace; curFace < lastFace; ++curFace){
+			if(curFace->distance < closestFace->distance){
+				closestFace = curFace;
+			}
+		}
+
+		// If we can't push the face out any further, it's on
+		// the boundary of the Minkowski difference and we're done.
+		minkowskiSupport(cA, offsetA, cB, support, &closestFace->normal, &w);
+		if(vec3DotVec3(&w, &closestFace->normal) - closestFace->distance <= COLLIDER_GJK_EPA_TOLERANCE){
+			break;
+		}
+		vertices[numVertices] = w;
+
+		// Remove every face that can see the new vertex,
+		// keeping track of the hole's boundary edges.
+		for(j = 0; j < numFaces;){
+			epaFace *const face = &faces[j];
+			vec3 offset;
+
+			vec3SubtractVec3Out(&w, &vertices[face->vertices[0]], &offset);
+			if(vec3DotVec3(&face->normal, &offset) > 0.f){
+				epaAddEdge(edges, &numEdges, face->vertices[0], face->vertices[1]);
+				epaAddEdge(edges, &numEdges, face->vertices[1], face->vertices[2]);
+				epaAddEdge(edges, &numEdges, face->vertices[2], face->vertices[0]);
+				--numFaces;
+				*face = faces[numFaces];
+			}else{
+				++j;
+			}
+		}
+
+		// Patch the hole using the new vertex. The boundary edges keep
+		// the winding of the faces they came from, so the new faces
+		// will also have outward-facing normals.
+		if(numFaces + numEdges > COLLIDER_GJK_EPA_MAX_FACES){
+			return(0);
+		}
+		for(j = 0; j < numEdges; ++j){
+			if(!epaFaceInit(&faces[numFaces], vertices, edges[j][0], edges[j][1], numVertices)){
+				return(0);
+			}
+			++numFaces;
+		}
+		++numVertices;
+		closestFace = NULL;
+	}
+
+	// If we ran out of iterations, the closest
+	// face is still a decent approximation.
+	if(closestFace == NULL){
+		const epaFace *curFace = faces;
+		const epaFace *const lastFace = &faces[numFaces];
+
+		closestFace = curFace;
+		for(++curFace; curFace < lastFace; ++curFace){
+			if(curFace->distance < closestFace->distance){
+				closestFace = curFace;
+			}
+		}
+	}
+
+	// The face's normal points from collider B's side
+	// of the Minkowski difference to collider A's.
+	vec3NegateOut(&closestFace->normal, normal);
+	*depth = closestFace->distance;
+	return(1);
+}
+
+/*
+** Find the time of impact between collider A, translated by "offsetA"
+** and moving by "displacement", and a stationary collider B using
+** conservative advancement. As neither collider rotates, the distance
+** along the separating normal is a safe lower bound on how far collider
+** A can move before they touch.
+**
+** If collider A gets within "targetSeparation" of collider B before the
+** end of its motion, we return the fraction of the motion at which this
+** happens in "toi" and the normal at that time. Colliders that start out
+** closer than this are left for the discrete narrowphase to handle.
+*/
+return_t colliderGJKTimeOfImpact(
+	const void *const restrict cA, const vec3 *const restrict offsetA, const vec3 *const restrict displacement,
+	const void *const restrict cB, const colliderSupportFunc support, const float targetSeparation,
+	float *const restrict toi, vec3 *const restrict normal
+){
+
+	colliderGJKSimplex simplex;
+	vec3 offset = *offsetA;
+	float time = 0.f;
+	unsigned int i;
+
+	for(i = 0; i < COLLIDER_GJK_TOI_MAX_ITERATIONS; ++i){
+		const float distance = colliderGJKDistance(cA, &offset, cB, support, &simplex, normal);
+		float approachSpeed;
+
+		if(distance - targetSeparation <= COLLIDER_GJK_TOI_TOLERANCE){
+			// The colliders were already close at the start of the motion.
+			if(i == 0){
+				return(0);
+			}
+			break;
+		}
+
+		// The normal points towards collider A, so collider
+		// A is approaching B if it's moving against it.
+		approachSpeed = -vec3DotVec3(displacement, normal);
+		if(approachSpeed <= 0.f){
+			return(0);
+		}
+		time += (distance - targetSeparation) / approachSpeed;
+		if(time >= 1.f){
+			return(0);
+		}
+		vec3FmaOut(time, displacement, offsetA, &offset);
+	}
+
+	*toi = time;
+	return(1);
+}
+
+
+// Return the point on the Minkowski difference "A - B" farthest in the direction "dir".
+static void minkowskiSupport(
+	const void *const restrict cA, const vec3 *const restrict offsetA,
+	const void *const restrict cB, const colliderSupportFunc support,
+	const vec3 *const restrict dir, vec3 *const restrict out
+){
+
+	vec3 negDir;
+	vec3 supportB;
+
+	support(cA, dir, out);
+	if(offsetA != NULL){
+		vec3AddVec3(out, offsetA);
+	}
+	vec3NegateOut(dir, &negDir);
+	support(cB, &negDir, &supportB);
+	vec3SubtractVec3P1(out, &supportB);
+}
+
+/*
+** Find the point on the segment "ab" closest to the origin
+** and store the smallest part of the segment containing it.
+*/
+static void closestPointSegment(
+	const vec3 *const restrict a, const vec3 *const restrict b,
+	colliderGJKSimplex *const restrict simplex, vec3 *const restrict v
+){
+
+	vec3 ab;
+	float t;
+
+	vec3SubtractVec3Out(b, a, &ab);
+	t = -vec3DotVec3(a, &ab);
+	if(t <= 0.f){
+		*v = *a;
+		simplex->vertices[0] = *a;
+		simplex->numVertices = 1;
+	}else{
+		const float denom = vec3MagnitudeSquaredVec3(&ab);
+		if(t >= denom){
+			*v = *b;
+			simplex->vertices[0] = *b;
+			simplex->numVertices = 1;
+		}else{
+			vec3FmaOut(t/denom, &ab, a, v);
+			simplex->vertices[0] = *a;
+			simplex->vertices[1] = *b;
+			simplex->numVertices = 2;
+		}
+	}
+}
+
+/*
+** Find the point on the triangle "abc" closest to the origin by checking which
+** of its Voronoi regions contains the origin. This is based on the method
+** given in Christer Ericson's "Real-Time Collision Detection", section 5.1.5.
+*/
+static void closestPointTriangle(
+	const vec3 *const restrict a, const vec3 *const restrict b, const vec3 *const restrict c,
+	colliderGJKSimplex *const restrict simplex, vec3 *const restrict v
+){
+
+	vec3 ab;
+	vec3 ac;
+	float d1, d2, d3, d4, d5, d6;
+	float va, vb, vc;
+
+	vec3SubtractVec3Out(b, a, &ab);
+	vec3SubtractVec3Out(c, a, &ac);
+
+	// Vertex region A.
+	d1 = -vec3DotVec3(&ab, a);
+	d2 = -vec3DotVec3(&ac, a);
+	if(d1 <= 0.f && d2 <= 0.f){
+		*v = *a;
+		simplex->vertices[0] = *a;
+		simplex->numVertices = 1;
+		return;
+	}
+
+	// Vertex region B.
+	d3 = -vec3DotVec3(&ab, b);
+	d4 = -vec3DotVec3(&ac, b);
+	if(d3 >= 0.f && d4 <= d3){
+		*v = *b;
+		simplex->vertices[0] = *b;
+		simplex->numVertices = 1;
+		return;
+	}
+
+	// Edge region AB.
+	vc = d1*d4 - d3*d2;
+	if(vc <= 0.f && d1 >= 0.f && d3 <= 0.f){
+		vec3FmaOut(d1/(d1 - d3), &ab, a, v);
+		simplex->vertices[0] = *a;
+		simplex->vertices[1] = *b;
+		simplex->numVertices = 2;
+		return;
+	}
+
+	// Vertex region C.
+	d5 = -vec3DotVec3(&ab, c);
+	d6 = -vec3DotVec3(&ac, c);
+	if(d6 >= 0.f && d5 <= d6){
+		*v = *c;
+		simplex->vertices[0] = *c;
+		simplex->numVertices = 1;
+		return;
+	}
+
+	// Edge region AC.
+	vb = d5*d2 - d1*d6;
+	if(vb <= 0.f && d2 >= 0.f && d6 <= 0.f){
+		vec3FmaOut(d2/(d2 - d6), &ac, a, v);
+		simplex->vertices[0] = *a;
+		simplex->vertices[1] = *c;
+		simplex->numVertices = 2;
+		return;
+	}
+
+	// Edge region BC.
+	va = d3*d6 - d5*d4;
+	if(va <= 0.f && d4 >= d3 && d5 >= d6){
+		vec3 bc;
+		vec3SubtractVec3Out(c, b, &bc);
+		vec3FmaOut((d4 - d3)/((d4 - d3) + (d5 - d6)), &bc, b, v);
+		simplex->vertices[0] = *b;
+		simplex->vertices[1] = *c;
+		simplex->numVertices = 2;
+		return;
+	}
+
+	// Face region.
+	{
+		const float denom = 1.f/(va + vb + vc);
+		*v = *a;
+		vec3FmaP2(vb*denom, &ab, v);
+		vec3FmaP2(vc*denom, &ac, v);
+		simplex->vertices[0] = *a;
+		simplex->vertices[1] = *b;
+		simplex->vertices[2] = *c;
+		simplex->numVertices = 3;
+	}
+}
+
+// Return whether the origin and "d" are on opposite sides of the plane "abc".
+static return_t originOutsidePlane(
+	const vec3 *const restrict a, const vec3 *const restrict b,
+	const vec3 *const restrict c, const vec3 *const restrict d
+){
+
+	vec3 ab;
+	vec3 ac;
+	vec3 ad;
+	vec3 n;
+	float signD;
+
+	vec3SubtractVec3Out(b, a, &ab);
+	vec3SubtractVec3Out(c, a, &ac);
+	vec3SubtractVec3Out(d, a, &ad);
+	vec3CrossVec3Out(&ab, &ac, &n);
+	signD = vec3DotVec3(&ad, &n);
+
+	// If the tetrahedron is degenerate, treat the origin as outside.
+	if(signD*signD <= COLLIDER_GJK_TOLERANCE_SQUARED*COLLIDER_GJK_TOLERANCE_SQUARED){
+		return(1);
+	}
+	return(-vec3DotVec3(a, &n) * signD < 0.f);
+}
+
+/*
+** Find the point on the tetrahedron closest to the origin. This is
+** the closest point on whichever of the faces the origin lies outside
+** of. If it's not outside of any of them, the origin is enclosed.
+*/
+static return_t closestPointTetrahedron(colliderGJKSimplex *const restrict simplex, vec3 *const restrict v){
+	// Each face of the tetrahedron, followed by the vertex opposite it.
+	static const byte_t faces[4][4] = {
+		{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}
+	};
+	const colliderGJKSimplex tetrahedron = *simplex;
+	float bestDistance = INFINITY;
+	unsigned int i;
+
+	for(i = 0; i < 4; ++i){
+		const vec3 *const a = &tetrahedron.vertices[faces[i][0]];
+		const vec3 *const b = &tetrahedron.vertices[faces[i][1]];
+		const vec3 *const c = &tetrahedron.vertices[faces[i][2]];
+
+		if(originOutsidePlane(a, b, c, &tetrahedron.vertices[faces[i][3]])){
+			colliderGJKSimplex faceSimplex;
+			vec3 faceV;
+			float faceDistance;
+
+			closestPointTriangle(a, b, c, &faceSimplex, &faceV);
+			faceDistance = vec3MagnitudeSquaredVec3(&faceV);
+			if(faceDistance < bestDistance){
+				bestDistance = faceDistance;
+				*simplex = faceSimplex;
+				*v = faceV;
+			}
+		}
+	}
+
+	return(bestDistance != INFINITY);
+}
+
+/*
+** Find the point on the simplex closest to the origin and
+** remove any vertices that aren't needed to represent it.
+** If the simplex encloses the origin, we return zero.
+*/
+static return_t closestPointSimplex(colliderGJKSimplex *const restrict simplex, vec3 *const restrict v){
+	const colliderGJKSimplex old = *simplex;
+
+	switch(simplex->numVertices){
+		case 2:
+			closestPointSegment(&old.vertices[0], &old.vertices[1], simplex, v);
+		break;
+		case 3:
+			closestPointTriangle(&old.vertices[0], &old.vertices[1], &old.vertices[2], simplex, v);
+		break;
+		case 4:
+			return(closestPointTetrahedron(simplex, v));
+		break;
+		default:
+			*v = simplex->vertices[0];
+	}
+
+	return(1);
+}
+
+/*
+** Initialise the EPA face "abc". If the face is too
+** small to have a well-defined normal, we return zero.
+*/
+static return_t epaFaceInit(
+	epaFace *const restrict face, const vec3 *const restrict vertices,
+	const byte_t a, const byte_t b, const byte_t c
+){
+
+	vec3 ab;
+	vec3 ac;
+	float magnitudeSquared;
+
+	vec3SubtractVec3Out(&vertices[b], &vertices[a], &ab);
+	vec3SubtractVec3Out(&vertices[c], &vertices[a], &ac);
+	vec3CrossVec3Out(&ab, &ac, &face->normal);
+	magnitudeSquared = vec3MagnitudeSquaredVec3(&face->normal);
+	if(magnitudeSquared <= COLLIDER_GJK_TOLERANCE_SQUARED*COLLIDER_GJK_TOLERANCE_SQUARED){
+		return(0);
+	}
+
+	vec3MultiplyS(&face->normal, invSqrt(magnitudeSquared));
+	face->distance = vec3DotVec3(&face->normal, &vertices[a]);
+	face->vertices[0] = a;
+	face->vertices[1] = b;
+	face->vertices[2] = c;
+	return(1);
+}
+
+/*
+** Add the edge "ab" to the boundary of the hole we're cutting
+** in the polytope. If its twin "ba" is already there, the edge
+** is shared by two removed faces and isn't on the boundary.
+*/
+static void epaAddEdge(byte_t (*const edges)[2], size_t *const restrict numEdges, const byte_t a, const byte_t b){
+	size_t i;
+
+	for(i = 0; i < *numEdges; ++i){
+		if(edges[i][0] == b && edges[i][1] == a){
+			--*numEdges;
+			edges[i][0] = edges[*numEdges][0];
+			edges[i][1] = edges[*numEdges][1];
+			return;
+		}
+	}
+
+	edges[*numEdges][0] = a;
+	edges[*numEdges][1] = b;
+	++*numEdges;
+}
\ No newline at end of file
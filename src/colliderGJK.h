@@ -0,0 +1,73 @@
+#ifndef colliderGJK_h
+#define colliderGJK_h
+
+
+#include "settingsPhysics.h"
+
+#include "utilTypes.h"
+#include "vec3.h"
+
+
+#ifndef COLLIDER_GJK_MAX_ITERATIONS
+	#define COLLIDER_GJK_MAX_ITERATIONS 32
+#endif
+// GJK terminates when the distance improves by less than this fraction.
+#ifndef COLLIDER_GJK_TOLERANCE
+	#define COLLIDER_GJK_TOLERANCE 0.0001f
+#endif
+
+#ifndef COLLIDER_GJK_TOI_MAX_ITERATIONS
+	#define COLLIDER_GJK_TOI_MAX_ITERATIONS 20
+#endif
+// Conservative advancement stops once the colliders
+// are within this distance of the target separation.
+#ifndef COLLIDER_GJK_TOI_TOLERANCE
+	#define COLLIDER_GJK_TOI_TOLERANCE 0.001f
+#endif
+
+// EPA adds at most one vertex to the polytope per iteration.
+#ifndef COLLIDER_GJK_EPA_MAX_ITERATIONS
+	#define COLLIDER_GJK_EPA_MAX_ITERATIONS 64
+#endif
+// EPA terminates when the depth improves by less than this.
+#ifndef COLLIDER_GJK_EPA_TOLERANCE
+	#define COLLIDER_GJK_EPA_TOLERANCE 0.0001f
+#endif
+
+
+// Finds the point on a collider farthest in the direction "dir".
+typedef void (*colliderSupportFunc)(
+	const void *const restrict c,
+	const vec3 *const restrict dir,
+	vec3 *const restrict out
+);
+
+/*
+** Stores the vertices of the GJK simplex. The vertices are
+** points on the Minkowski difference of the two colliders.
+*/
+typedef struct colliderGJKSimplex {
+	vec3 vertices[4];
+	byte_t numVertices;
+} colliderGJKSimplex;
+
+
+float colliderGJKDistance(
+	const void *const restrict cA, const vec3 *const restrict offsetA,
+	const void *const restrict cB, const colliderSupportFunc support,
+	colliderGJKSimplex *const restrict simplex, vec3 *const restrict normal
+);
+return_t colliderGJKPenetration(
+	const void *const restrict cA, const vec3 *const restrict offsetA,
+	const void *const restrict cB, const colliderSupportFunc support,
+	const colliderGJKSimplex *const restrict simplex,
+	vec3 *const restrict normal, float *const restrict depth
+);
+return_t colliderGJKTimeOfImpact(
+	const void *const restrict cA, const vec3 *const restrict offsetA, const vec3 *const restrict displacement,
+	const void *const restrict cB, const colliderSupportFunc support, const float targetSeparation,
+	float *const restrict toi, vec3 *const restrict normal
+);
+
+
+#endif
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "memoryManager.h"
 
 #include "colliderAABB.h"
+#include "colliderGJK.h"
 #include "physicsCollider.h"
 
 #include "contact.h"
@@ -27,6 +28,9 @@
 #define COLLISION_PARALLEL_THRESHOLD_SQUARED COLLISION_PARALLEL_THRESHOLD*COLLISION_PARALLEL_THRESHOLD
 #define COLLISION_TOLERANCE_COEFFICIENT      0.95f
 #define COLLISION_TOLERANCE_TERM             0.025f
+// When using GJK, we only look for an edge pair if the best face's
+// separation is at least this far from the penetration depth.
+#define COLLISION_GJK_FACE_TOLERANCE         0.001f
 
 #define CLIPPING_INORDER 0
 // We can use byte offsets or a conditional check to swap our keys around.
@@ -59,6 +63,13 @@
 #endif
 
 
+// Faces with at most this many edges are clipped using a buffer
+// on the stack, rather than one from the global memory manager.
+// This avoids touching the allocator during the narrowphase,
+// which may be running on several threads at the same time.
+#define CLIPPING_STACK_FACE_EDGES 16
+
+
 // These must be at least 1!
 #define BASE_VERTEX_CAPACITY 1
 #define BASE_FACE_CAPACITY   1
@@ -103,6 +114,13 @@ typedef struct vertexProject {
 	float dist;
 } vertexProject;
 
+// GJK is given one of these for each hull, so that every
+// support point can be found by hill climbing from the last.
+typedef struct hullSupportCache {
+	const colliderHull *hull;
+	colliderVertexIndex vertex;
+} hullSupportCache;
+
 
 // Forward-declare any helper functions!
 #warning "Ideally, this macro shouldn't exist. We should check if weights were specified, then call the correct functions."
@@ -128,10 +146,22 @@ static void generateInertia(
 );
 #endif
 
+static void generateClimbData(colliderHull *const restrict hull);
+static const vec3 *supportScan(const colliderHull *const restrict hull, const vec3 *const restrict dir);
+static const vec3 *supportClimb(
+	const colliderHull *const restrict hull,
+	const vec3 *const restrict dir, colliderVertexIndex best
+);
+
 static void hullFaceDataInit(hullFaceData *const restrict faceData);
 static void hullEdgeDataInit(hullEdgeData *const restrict edgeData);
 static void collisionDataInit(collisionData *const restrict cd);
 
+static float faceDistance(
+	const colliderHull *const restrict hullA,
+	const colliderHull *const restrict hullB,
+	const colliderFaceIndex face
+);
 static return_t faceSeparation(
 	const colliderHull *const restrict hullA,
 	const colliderHull *const restrict hullB,
@@ -142,6 +172,11 @@ static return_t edgeSeparation(
 	const colliderHull *const restrict hullB,
 	contactSeparation *const restrict cs
 );
+static float edgeDistance(
+	const colliderHull *const restrict hullA,
+	const colliderHull *const restrict hullB,
+	const contactSeparation *const restrict cs
+);
 
 static void clipManifoldSHC(
 	const colliderHull *const restrict hullA, const colliderHull *const restrict hullB,
@@ -169,6 +204,20 @@ static return_t noSeparatingEdge(
 	hullEdgeData *const restrict edgeData, contactSeparation *const restrict separation
 );
 
+static void hullSupport(
+	const void *const restrict cache,
+	const vec3 *const restrict dir,
+	vec3 *const restrict out
+);
+static void findSeparatingFace(
+	const colliderHull *const restrict hullA, const colliderHull *const restrict hullB,
+	const vec3 *const restrict normal, contactSeparation *const restrict separation
+);
+static void findCollisionFeatures(
+	const hullSupportCache *const restrict cacheA, const hullSupportCache *const restrict cacheB,
+	const vec3 *const restrict normal, const float depth, collisionData *const restrict cd
+);
+
 static colliderFaceIndex findIncidentFace(
 	const colliderHull *const restrict hull,
 	const vec3 *const restrict refNormal
@@ -186,6 +235,7 @@ static void clipFaceContact(
 	const colliderHull *const restrict hullB,
 	const colliderFaceIndex refIndex,
 	const unsigned int swapped,
+	const float maxSeparation,
 	contactManifold *const restrict cm
 );
 static void clipEdgeContact(
@@ -538,6 +588,19 @@ return_t colliderHullLoad(
 	#endif
 
 	tempHull.centroid = *centroid;
+	// SAT's edge checks get very slow for hulls with lots of
+	// faces, so we use GJK for these unless told otherwise.
+	if(tempHull.numFaces >= COLLIDER_HULL_GJK_FACE_THRESHOLD){
+		tempHull.narrowphase = COLLIDER_HULL_NARROWPHASE_GJK;
+	}else{
+		tempHull.narrowphase = COLLIDER_HULL_NARROWPHASE_SAT;
+	}
+
+
+	// Larger hulls find their support points by hill climbing.
+	if(tempHull.numVertices >= COLLIDER_HULL_CLIMB_VERTEX_THRESHOLD){
+		generateClimbData(&tempHull);
+	}
 
 
 	// We'll never be adding to these arrays, so we
@@ -667,23 +730,101 @@ const vec3 *colliderHullSupport(
 	const vec3 *const restrict dir
 ){
 
-	const vec3 *bestVertex = hull->vertices;
-	float bestDistance = vec3DotVec3(bestVertex, dir);
+	return(colliderHullSupportFrom(hull, dir, valueInvalid(colliderVertexIndex)));
+}
 
-	const vec3 *curVertex = &bestVertex[1];
-	const vec3 *const lastVertex = &bestVertex[hull->numVertices];
+/*
+** This is the same as "colliderHullSupport", but if the hull is large
+** enough to hill climb, we start from the vertex "start". This should
+** be a support point from a previous query in a similar direction. If
+** "start" is invalid, we start from the best of the hull's seeds.
+*/
+const vec3 *colliderHullSupportFrom(
+	const colliderHull *const restrict hull,
+	const vec3 *const restrict dir, const colliderVertexIndex start
+){
 
-	for(; curVertex < lastVertex; ++curVertex){
-		const float curDistance = vec3DotVec3(curVertex, dir);
-		// If the current vertex is farther in the direction
-		// of "dir" than our current best, store it instead.
-		if(curDistance > bestDistance){
-			bestVertex = curVertex;
-			bestDistance = curDistance;
+	if(hull->adjacency == NULL){
+		return(supportScan(hull, dir));
+	}
+
+	if(valueIsInvalid(start, colliderVertexIndex)){
+		colliderVertexIndex best = hull->climbSeeds[0];
+		float bestDistance = vec3DotVec3(&hull->vertices[best], dir);
+		size_t i;
+
+		for(i = 1; i < COLLIDER_HULL_NUM_CLIMB_SEEDS; ++i){
+			const float curDistance = vec3DotVec3(&hull->vertices[hull->climbSeeds[i]], dir);
+			if(curDistance > bestDistance){
+				best = hull->climbSeeds[i];
+				bestDistance = curDistance;
+			}
 		}
+
+		return(supportClimb(hull, dir, best));
 	}
 
-	return(bestVertex);
+	return(supportClimb(hull, dir, start));
+}
+
+/*
+** Find where a ray first hits a hull by clipping it against the plane
+** of each face. The ray enters the hull through the last face whose
+** plane it crosses from the outside, and leaves through the first
+** face whose plane it crosses from the inside. If the ray starts
+** inside the hull, it hits immediately and the normal points back
+** along the ray.
+*/
+return_t colliderHullRaycast(
+	const colliderHull *const restrict hull, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+){
+
+	const vec3 *curNormal = hull->normals;
+	const vec3 *enterNormal = NULL;
+	float tEnter = 0.f;
+	float tExit = maxDistance;
+	colliderFaceIndex i;
+
+	for(i = 0; i < hull->numFaces; ++i){
+		// The origin's distance behind the face's plane.
+		const float behind = planePointDistVec3Alt(
+			curNormal, origin, &hull->vertices[hull->edges[hull->faces[i]].startVertexIndex]
+		);
+		const float speed = vec3DotVec3(curNormal, dir);
+
+		// If the ray is parallel to the face and in front
+		// of it, it can never get inside the hull.
+		if(speed == 0.f){
+			if(behind < 0.f){
+				return(0);
+			}
+		}else{
+			const float t = behind / speed;
+			if(speed < 0.f){
+				if(t > tEnter){
+					tEnter = t;
+					enterNormal = curNormal;
+				}
+			}else if(t < tExit){
+				tExit = t;
+			}
+			if(tEnter > tExit){
+				return(0);
+			}
+		}
+
+		++curNormal;
+	}
+
+	*distance = tEnter;
+	if(enterNormal != NULL){
+		*normal = *enterNormal;
+	}else{
+		vec3NegateOut(dir, normal);
+	}
+
+	return(1);
 }
 
 
@@ -705,6 +846,9 @@ return_t colliderHullSeparated(
 				(colliderHull *)hullB, (colliderHull *)hullA, cs
 			));
 		break;
+		case COLLIDER_HULL_SEPARATION_NONE:
+			return(0);
+		break;
 		default:
 			return(edgeSeparation(
 				(colliderHull *)hullA, (colliderHull *)hullB, cs
@@ -712,6 +856,24 @@ return_t colliderHullSeparated(
 	}
 }
 
+/*
+** Return whether or not two hulls are colliding, using
+** whichever narrowphase test the hulls have asked for.
+*/
+return_t colliderHullColliding(
+	const void *const restrict hullA, const void *const restrict hullB,
+	contactSeparation *const restrict separation, contactManifold *const restrict cm
+){
+
+	if(
+		((colliderHull *)hullA)->narrowphase == COLLIDER_HULL_NARROWPHASE_GJK ||
+		((colliderHull *)hullB)->narrowphase == COLLIDER_HULL_NARROWPHASE_GJK
+	){
+		return(colliderHullCollidingGJK(hullA, hullB, separation, cm));
+	}
+	return(colliderHullCollidingSAT(hullA, hullB, separation, cm));
+}
+
 /*
 ** Return whether or not two hulls are colliding using
 ** the Separating Axis Theorem. Special thanks to Dirk
@@ -746,6 +908,104 @@ return_t colliderHullCollidingSAT(
 	return(0);
 }
 
+/*
+** Return whether or not two hulls are colliding using the
+** Gilbert-Johnson-Keerthi algorithm, and find the penetration
+** depth using EPA. Rather than checking every face and edge
+** pair like SAT does, this only ever looks at the vertices
+** and faces near the axis of minimum penetration, which is
+** much faster for hulls with many faces.
+**
+** We use the normal from EPA to find the features SAT would
+** have found, so the contact manifold is clipped in the same
+** way. If GJK or EPA can't give us an answer, we fall back
+** to SAT. This should only happen when the hulls are just
+** touching or their Minkowski difference is degenerate.
+*/
+return_t colliderHullCollidingGJK(
+	const void *const restrict hullA, const void *const restrict hullB,
+	contactSeparation *const restrict separation, contactManifold *const restrict cm
+){
+
+	hullSupportCache cacheA = {.hull = hullA, .vertex = valueInvalid(colliderVertexIndex)};
+	hullSupportCache cacheB = {.hull = hullB, .vertex = valueInvalid(colliderVertexIndex)};
+	colliderGJKSimplex simplex;
+	vec3 normal;
+	float depth;
+
+	// If the hulls are separated, try to find a face that separates
+	// them so the next update can check the separation quickly.
+	if(colliderGJKDistance(&cacheA, NULL, &cacheB, &hullSupport, &simplex, &normal) > 0.f){
+		if(separation != NULL){
+			findSeparatingFace((colliderHull *)hullA, (colliderHull *)hullB, &normal, separation);
+		}
+
+		return(0);
+	}
+
+	if(!colliderGJKPenetration(&cacheA, NULL, &cacheB, &hullSupport, &simplex, &normal, &depth)){
+		return(colliderHullCollidingSAT(hullA, hullB, separation, cm));
+	}
+
+	if(cm != NULL){
+		collisionData cd;
+		collisionDataInit(&cd);
+
+		// EPA's normal points from hull B to hull A,
+		// but contact normals should point the other way.
+		vec3Negate(&normal);
+		findCollisionFeatures(&cacheA, &cacheB, &normal, depth, &cd);
+		clipManifoldSHC((colliderHull *)hullA, (colliderHull *)hullB, &cd, cm);
+	}
+
+	return(1);
+}
+
+/*
+** Given the features that separate two hulls, return whether
+** the hulls are within "margin" of each other along them. If
+** they are, we clip the features to create a manifold of
+** speculative contact points, whose separations are positive.
+** These let the solver stop the hulls from penetrating before
+** they actually touch, rather than pushing them apart after.
+*/
+return_t colliderHullNearby(
+	const void *const restrict hullA, const void *const restrict hullB,
+	const contactSeparation *const restrict cs, const float margin, contactManifold *const restrict cm
+){
+
+	hullEdgeData edgeData;
+
+	switch(cs->type){
+		case COLLIDER_HULL_SEPARATION_FACE_A:
+			if(faceDistance((colliderHull *)hullA, (colliderHull *)hullB, cs->featureA) > margin){
+				return(0);
+			}
+			clipFaceContact((colliderHull *)hullA, (colliderHull *)hullB, cs->featureA, CLIPPING_INORDER, margin, cm);
+		break;
+		case COLLIDER_HULL_SEPARATION_FACE_B:
+			if(faceDistance((colliderHull *)hullB, (colliderHull *)hullA, cs->featureA) > margin){
+				return(0);
+			}
+			clipFaceContact((colliderHull *)hullB, (colliderHull *)hullA, cs->featureA, CLIPPING_SWAPPED, margin, cm);
+		break;
+		case COLLIDER_HULL_SEPARATION_NONE:
+			return(0);
+		break;
+		default:
+			edgeData.edgeA = cs->featureA;
+			edgeData.edgeB = cs->featureB;
+			edgeData.separation = edgeDistance((colliderHull *)hullA, (colliderHull *)hullB, cs);
+			// Parallel edges have a separation of negative infinity.
+			if(edgeData.separation < 0.f || edgeData.separation > margin){
+				return(0);
+			}
+			clipEdgeContact((colliderHull *)hullA, (colliderHull *)hullB, &edgeData, cm);
+	}
+
+	return(cm->numContacts > 0);
+}
+
 
 void colliderHullDeleteInstance(colliderHull *const restrict hull){
 	if(hull->vertices != NULL){
@@ -769,6 +1029,9 @@ void colliderHullDelete(colliderHull *const restrict hull){
 	if(hull->faces != NULL){
 		memoryManagerGlobalFree(hull->faces);
 	}
+	if(hull->adjacencyOffsets != NULL){
+		memoryManagerGlobalFree(hull->adjacencyOffsets);
+	}
 }
 
 
@@ -933,6 +1196,128 @@ static void generateInertia(
 }
 #endif
 
+/*
+** Find the neighbours of each of the hull's vertices, which we
+** walk over when hill climbing. Twin edges are stored together,
+** so every edge adds each of its vertices to the other's list.
+** We also find the seeds that hill climbing may start from.
+*/
+static void generateClimbData(colliderHull *const restrict hull){
+	const colliderHullEdge *curEdge = hull->edges;
+	const colliderHullEdge *const lastEdge = &curEdge[hull->numEdges];
+	const vec3 *const vertices = hull->vertices;
+	uint_least32_t *offsets;
+	colliderVertexIndex *seeds = hull->climbSeeds;
+	colliderVertexIndex i;
+
+	// The offsets and neighbours are ordered by
+	// alignment, so we can store them in one block.
+	offsets = memoryManagerGlobalAlloc(
+		(hull->numVertices + 1) * sizeof(*offsets) + 2 * hull->numEdges * sizeof(*hull->adjacency)
+	);
+	if(offsets == NULL){
+		/** MALLOC FAILED **/
+	}
+	hull->adjacencyOffsets = offsets;
+	hull->adjacency = (colliderVertexIndex *)&offsets[hull->numVertices + 1];
+
+	// Count each vertex's neighbours in the offset after its
+	// own, so adding up the counts gives us each list's start.
+	memset(offsets, 0, (hull->numVertices + 1) * sizeof(*offsets));
+	for(; curEdge < lastEdge; ++curEdge){
+		++offsets[curEdge->startVertexIndex + 1];
+		++offsets[curEdge->endVertexIndex + 1];
+	}
+	for(i = 0; i < hull->numVertices; ++i){
+		offsets[i + 1] += offsets[i];
+	}
+
+	// Filling a vertex's list moves its offset to the start of
+	// the next vertex's, so we need to shift them back after.
+	for(curEdge = hull->edges; curEdge < lastEdge; ++curEdge){
+		hull->adjacency[offsets[curEdge->startVertexIndex]++] = curEdge->endVertexIndex;
+		hull->adjacency[offsets[curEdge->endVertexIndex]++] = curEdge->startVertexIndex;
+	}
+	for(i = hull->numVertices; i > 0; --i){
+		offsets[i] = offsets[i - 1];
+	}
+	offsets[0] = 0;
+
+
+	memset(seeds, 0, sizeof(hull->climbSeeds));
+	for(i = 1; i < hull->numVertices; ++i){
+		if(vertices[i].x > vertices[seeds[0]].x){
+			seeds[0] = i;
+		}else if(vertices[i].x < vertices[seeds[1]].x){
+			seeds[1] = i;
+		}
+		if(vertices[i].y > vertices[seeds[2]].y){
+			seeds[2] = i;
+		}else if(vertices[i].y < vertices[seeds[3]].y){
+			seeds[3] = i;
+		}
+		if(vertices[i].z > vertices[seeds[4]].z){
+			seeds[4] = i;
+		}else if(vertices[i].z < vertices[seeds[5]].z){
+			seeds[5] = i;
+		}
+	}
+}
+
+/*
+** Find the support point by checking every vertex. This is
+** faster than hill climbing for hulls with few vertices.
+*/
+static const vec3 *supportScan(const colliderHull *const restrict hull, const vec3 *const restrict dir){
+	const vec3 *const vertices = hull->vertices;
+	colliderVertexIndex best = 0;
+	float bestDistance = vec3DotVec3(vertices, dir);
+	colliderVertexIndex i;
+
+	for(i = 1; i < hull->numVertices; ++i){
+		const float curDistance = vec3DotVec3(&vertices[i], dir);
+		// If the current vertex is farther in the direction
+		// of "dir" than our current best, store it instead.
+		if(curDistance > bestDistance){
+			best = i;
+			bestDistance = curDistance;
+		}
+	}
+
+	return(&vertices[best]);
+}
+
+/*
+** Find the support point by walking from "best" to whichever of its
+** neighbours is farthest in the direction "dir", until none of them
+** are any farther. Hulls are convex, so this must be the support point.
+*/
+static const vec3 *supportClimb(
+	const colliderHull *const restrict hull,
+	const vec3 *const restrict dir, colliderVertexIndex best
+){
+
+	const vec3 *const vertices = hull->vertices;
+	float bestDistance = vec3DotVec3(&vertices[best], dir);
+
+	for(;;){
+		const colliderVertexIndex *curNeighbour = &hull->adjacency[hull->adjacencyOffsets[best]];
+		const colliderVertexIndex *const lastNeighbour = &hull->adjacency[hull->adjacencyOffsets[best + 1]];
+		const colliderVertexIndex prevBest = best;
+
+		for(; curNeighbour < lastNeighbour; ++curNeighbour){
+			const float curDistance = vec3DotVec3(&vertices[*curNeighbour], dir);
+			if(curDistance > bestDistance){
+				best = *curNeighbour;
+				bestDistance = curDistance;
+			}
+		}
+		if(best == prevBest){
+			return(&vertices[best]);
+		}
+	}
+}
+
 
 static void hullFaceDataInit(hullFaceData *const restrict faceData){
 	faceData->index = COLLIDER_HULL_INVALID_FEATURE;
@@ -956,14 +1341,18 @@ static void collisionDataInit(collisionData *const restrict cd){
 }
 
 
-// Return whether a face separation between two convex hulls still exists.
-static return_t faceSeparation(
+/*
+** Return the distance between a face on "hullA" and the
+** point on "hullB" farthest behind it. This is negative
+** if the hulls are overlapping along the face's normal.
+*/
+static float faceDistance(
 	const colliderHull *const restrict hullA,
 	const colliderHull *const restrict hullB,
-	contactSeparation *const restrict cs
+	const colliderFaceIndex face
 ){
 
-	const vec3 *const normal = &hullA->normals[cs->featureA];
+	const vec3 *const normal = &hullA->normals[face];
 	const vec3 invNormal = {
 		.x = -normal->x,
 		.y = -normal->y,
@@ -973,12 +1362,22 @@ static return_t faceSeparation(
 	return(
 		planePointDistVec3Alt(
 			normal,
-			&hullA->vertices[hullA->edges[hullA->faces[cs->featureA]].startVertexIndex],
+			&hullA->vertices[hullA->edges[hullA->faces[face]].startVertexIndex],
 			colliderHullSupport(hullB, &invNormal)
-		) > 0.f
+		)
 	);
 }
 
+// Return whether a face separation between two convex hulls still exists.
+static return_t faceSeparation(
+	const colliderHull *const restrict hullA,
+	const colliderHull *const restrict hullB,
+	contactSeparation *const restrict cs
+){
+
+	return(faceDistance(hullA, hullB, cs->featureA) > 0.f);
+}
+
 // Return whether an edge separation between two convex hulls still exists.
 static return_t edgeSeparation(
 	const colliderHull *const restrict hullA,
@@ -1005,6 +1404,26 @@ static return_t edgeSeparation(
 	);
 }
 
+// Return the distance between the two edges of an edge separation.
+static float edgeDistance(
+	const colliderHull *const restrict hullA,
+	const colliderHull *const restrict hullB,
+	const contactSeparation *const restrict cs
+){
+
+	const colliderHullEdge *const edgeA = &hullA->edges[cs->featureA];
+	const vec3 *const startVertexA = &hullA->vertices[edgeA->startVertexIndex];
+	vec3 invEdgeA;
+	const colliderHullEdge *const edgeB = &hullB->edges[cs->featureB];
+	const vec3 *const startVertexB = &hullB->vertices[edgeB->startVertexIndex];
+	vec3 invEdgeB;
+
+	vec3SubtractVec3Out(startVertexA, &hullA->vertices[edgeA->endVertexIndex], &invEdgeA);
+	vec3SubtractVec3Out(startVertexB, &hullB->vertices[edgeB->endVertexIndex], &invEdgeB);
+
+	return(edgeDistSquared(startVertexA, &invEdgeA, startVertexB, &invEdgeB, &hullA->centroid));
+}
+
 
 /*
 ** Using the collision information generated from the
@@ -1032,7 +1451,7 @@ static void clipManifoldSHC(
 		// using faces from hull A as the reference face.
 		if(COLLISION_TOLERANCE_COEFFICIENT * cd->faceB.separation > cd->faceA.separation + COLLISION_TOLERANCE_TERM){
 			// Use hull B for the reference face.
-			clipFaceContact(hullB, hullA, cd->faceB.index, CLIPPING_SWAPPED, cm);
+			clipFaceContact(hullB, hullA, cd->faceB.index, CLIPPING_SWAPPED, 0.f, cm);
 
 			// There's a rare chance that clipping will produce no contact points.
 			// In that case, we can either clip using the other hull for the
@@ -1042,7 +1461,7 @@ static void clipManifoldSHC(
 					clipEdgeContact(hullA, hullB, &cd->edgeData, cm);
 				}else{
 					// Use hull A for the reference face.
-					clipFaceContact(hullA, hullB, cd->faceA.index, CLIPPING_INORDER, cm);
+					clipFaceContact(hullA, hullB, cd->faceA.index, CLIPPING_INORDER, 0.f, cm);
 
 					// If there are still no contact points, just treat it as an edge
 					// contact. This will ensure we have at least one contact point.
@@ -1053,7 +1472,7 @@ static void clipManifoldSHC(
 			}
 		}else{
 			// Use hull A for the reference face.
-			clipFaceContact(hullA, hullB, cd->faceA.index, CLIPPING_INORDER, cm);
+			clipFaceContact(hullA, hullB, cd->faceA.index, CLIPPING_INORDER, 0.f, cm);
 
 			// There's a rare chance that clipping will produce no contact points.
 			// In that case, we can either clip using the other hull for the
@@ -1063,7 +1482,7 @@ static void clipManifoldSHC(
 					clipEdgeContact(hullA, hullB, &cd->edgeData, cm);
 				}else{
 					// Use hull B for the reference face.
-					clipFaceContact(hullB, hullA, cd->faceB.index, CLIPPING_SWAPPED, cm);
+					clipFaceContact(hullB, hullA, cd->faceB.index, CLIPPING_SWAPPED, 0.f, cm);
 
 					// If there are still no contact points, just treat it as an edge
 					// contact. This will ensure we have at least one contact point.
@@ -1201,6 +1620,9 @@ static return_t noSeparatingFace(
 		if(curDistance > 0.f){
 			if(separation != NULL){
 				separation->featureA = i;
+				// Face separations don't use the second feature, but we
+				// clear it so separations can be compared byte for byte.
+				separation->featureB = 0;
 				separation->type = type;
 			}
 
@@ -1289,6 +1711,129 @@ static return_t noSeparatingEdge(
 }
 
 
+/*
+** Wrapper around "colliderHullSupportFrom" that GJK can call.
+** GJK only sees the caches as constant, but they belong to
+** the caller, so we're free to update the starting vertex.
+*/
+static void hullSupport(
+	const void *const restrict cache,
+	const vec3 *const restrict dir,
+	vec3 *const restrict out
+){
+
+	hullSupportCache *const c = (hullSupportCache *)cache;
+	const vec3 *const support = colliderHullSupportFrom(c->hull, dir, c->vertex);
+
+	c->vertex = support - c->hull->vertices;
+	*out = *support;
+}
+
+/*
+** GJK gives us the direction from "hullB" to "hullA" along
+** which they are separated. This is usually very close to
+** the normal of a face on one of the hulls, so we check the
+** faces most closely aligned with it. If neither of them
+** separates the hulls, the separation must be on an edge pair
+** and the hulls will need to be fully checked next update.
+*/
+static void findSeparatingFace(
+	const colliderHull *const restrict hullA, const colliderHull *const restrict hullB,
+	const vec3 *const restrict normal, contactSeparation *const restrict separation
+){
+
+	vec3 invNormal;
+
+	// Only edge separations use the second feature.
+	separation->featureB = 0;
+
+	// Hull A's face should point away from the separating normal.
+	separation->featureA = findIncidentFace(hullA, normal);
+	if(faceDistance(hullA, hullB, separation->featureA) > 0.f){
+		separation->type = COLLIDER_HULL_SEPARATION_FACE_A;
+		return;
+	}
+
+	vec3NegateOut(normal, &invNormal);
+	separation->featureA = findIncidentFace(hullB, &invNormal);
+	if(faceDistance(hullB, hullA, separation->featureA) > 0.f){
+		separation->type = COLLIDER_HULL_SEPARATION_FACE_B;
+		return;
+	}
+
+	separation->type = COLLIDER_HULL_SEPARATION_NONE;
+}
+
+/*
+** Using the normal of minimum penetration found by EPA, which points
+** from "hullA" to "hullB", find the features that SAT would have
+** found. These are the faces on each hull most closely aligned with
+** the normal and, if neither of them realises the penetration depth,
+** the pair of edges around the support points whose cross product
+** is closest to the normal.
+*/
+static void findCollisionFeatures(
+	const hullSupportCache *const restrict cacheA, const hullSupportCache *const restrict cacheB,
+	const vec3 *const restrict normal, const float depth, collisionData *const restrict cd
+){
+
+	const colliderHull *const hullA = cacheA->hull;
+	const colliderHull *const hullB = cacheB->hull;
+	vec3 invNormal;
+
+	vec3NegateOut(normal, &invNormal);
+	cd->faceA.index = findIncidentFace(hullA, &invNormal);
+	cd->faceA.separation = faceDistance(hullA, hullB, cd->faceA.index);
+	cd->faceB.index = findIncidentFace(hullB, normal);
+	cd->faceB.separation = faceDistance(hullB, hullA, cd->faceB.index);
+
+	// The axis of minimum penetration must be a face on the Minkowski
+	// difference, so if it isn't one of the hulls' faces, it must be
+	// formed by an edge on each hull. These edges must be incident to
+	// the hulls' support points in the direction of the normal.
+	if(floatMax(cd->faceA.separation, cd->faceB.separation) < -depth - COLLISION_GJK_FACE_TOLERANCE){
+		// EPA's last support points should be very close to these.
+		const colliderVertexIndex supportA = colliderHullSupportFrom(hullA, normal, cacheA->vertex) - hullA->vertices;
+		const colliderVertexIndex supportB = colliderHullSupportFrom(hullB, &invNormal, cacheB->vertex) - hullB->vertices;
+		const colliderHullEdge *edgeA = hullA->edges;
+		colliderEdgeIndex a;
+
+		for(a = 0; a < hullA->numEdges; ++edgeA, ++a){
+			if(edgeA->startVertexIndex == supportA || edgeA->endVertexIndex == supportA){
+				const colliderHullEdge *edgeB = hullB->edges;
+				const vec3 *const startVertexA = &hullA->vertices[edgeA->startVertexIndex];
+				vec3 invEdgeA;
+				colliderEdgeIndex b;
+
+				vec3SubtractVec3Out(startVertexA, &hullA->vertices[edgeA->endVertexIndex], &invEdgeA);
+
+				for(b = 0; b < hullB->numEdges; ++edgeB, ++b){
+					if(edgeB->startVertexIndex == supportB || edgeB->endVertexIndex == supportB){
+						const vec3 *const startVertexB = &hullB->vertices[edgeB->startVertexIndex];
+						vec3 invEdgeB;
+
+						vec3SubtractVec3Out(startVertexB, &hullB->vertices[edgeB->endVertexIndex], &invEdgeB);
+
+						if(isMinkowskiFace(
+							&hullA->normals[edgeA->faceIndex], &hullA->normals[edgeA->twinFaceIndex], &invEdgeA,
+							&hullB->normals[edgeB->faceIndex], &hullB->normals[edgeB->twinFaceIndex], &invEdgeB
+						)){
+
+							const float curDistance = edgeDistSquared(startVertexA, &invEdgeA, startVertexB, &invEdgeB, &hullA->centroid);
+							if(curDistance > cd->edgeData.separation){
+								cd->edgeData.edgeA = a;
+								cd->edgeData.edgeB = b;
+								cd->edgeData.separation = curDistance;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+
 /*
 ** Using the normal of the reference face on one object,
 ** find the incident face on another. The incident face
@@ -1438,12 +1983,15 @@ static void reduceContacts(
 ** faces adjacent to the reference face using the Sutherland-Hodgman
 ** clipping algorithm. The reference face is always assumed to be on
 ** "hullA" and the incident face is always assumed to be on "hullB".
+** Only points at most "maxSeparation" in front of the reference
+** face are kept, which is 0 unless we're building speculative contacts.
 */
 static void clipFaceContact(
 	const colliderHull *const restrict hullA,
 	const colliderHull *const restrict hullB,
 	const colliderFaceIndex refIndex,
 	const unsigned int swapped,
+	const float maxSeparation,
 	contactManifold *const restrict cm
 ){
 
@@ -1453,7 +2001,9 @@ static void clipFaceContact(
 	// to store twice the maximum number of edges that a face has, as
 	// each edge can intersect two faces at most. This means that, in
 	// practice, we are really storing four times the number of edges.
-	vertexClip *const vertices = memoryManagerGlobalAlloc(2 * hullB->maxFaceEdges * sizeof(*vertices) * 2);
+	vertexClip stackVertices[2 * CLIPPING_STACK_FACE_EDGES * 2];
+	vertexClip *const vertices = (hullB->maxFaceEdges <= CLIPPING_STACK_FACE_EDGES) ?
+		stackVertices : memoryManagerGlobalAlloc(2 * hullB->maxFaceEdges * sizeof(*vertices) * 2);
 	if(vertices == NULL){
 		/** MALLOC FAILED **/
 	}
@@ -1710,7 +2260,7 @@ static void clipFaceContact(
 		// vertex and the reference face to ensure
 		// that it is within the clipping region.
 		curDist = planePointDistVec3(&clipPlane, &curVertex->v);
-		if(curDist <= 0.f){
+		if(curDist <= maxSeparation){
 			*loopVertex = *curVertex;
 			++loopVertex;
 			// Project the vertex onto the reference
@@ -1746,7 +2296,9 @@ static void clipFaceContact(
 	}
 
 
-	memoryManagerGlobalFree(vertices);
+	if(vertices != stackVertices){
+		memoryManagerGlobalFree(vertices);
+	}
 }
 
 /*
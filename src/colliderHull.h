@@ -16,6 +16,13 @@
 #define COLLIDER_HULL_SEPARATION_FACE_A 0
 #define COLLIDER_HULL_SEPARATION_FACE_B 1
 #define COLLIDER_HULL_SEPARATION_EDGE   2
+// The GJK path found that the hulls were separated,
+// but not which feature separates them. The pair
+// needs to be completely rechecked on every update.
+#define COLLIDER_HULL_SEPARATION_NONE   3
+
+#define COLLIDER_HULL_NARROWPHASE_SAT 0
+#define COLLIDER_HULL_NARROWPHASE_GJK 1
 
 #define COLLIDER_HULL_INVALID_FEATURE -1
 
@@ -24,6 +31,23 @@
 	#define COLLIDER_HULL_DEFAULT_VERTEX_WEIGHT 1.f
 #endif
 
+// Hulls with at least this many faces use GJK
+// and EPA for collision, rather than SAT, by default.
+#ifndef COLLIDER_HULL_GJK_FACE_THRESHOLD
+	#define COLLIDER_HULL_GJK_FACE_THRESHOLD 16
+#endif
+
+// Hulls with at least this many vertices find their support
+// points by hill climbing over their vertices' neighbours,
+// rather than by checking every vertex.
+#ifndef COLLIDER_HULL_CLIMB_VERTEX_THRESHOLD
+	#define COLLIDER_HULL_CLIMB_VERTEX_THRESHOLD 64
+#endif
+
+// Hill climbing starts from one of the vertices that are
+// farthest along each of the hull's local axes.
+#define COLLIDER_HULL_NUM_CLIMB_SEEDS 6
+
 
 typedef uint_least16_t colliderVertexIndex;
 typedef uint_least16_t colliderEdgeIndex;
@@ -58,9 +82,14 @@ typedef struct colliderHull {
 	// reallocated for each instance.
 	vec3 *vertices;
 	vec3 *normals;
-	// These two don't.
+	// These don't.
 	colliderHullFace *faces;
 	colliderHullEdge *edges;
+	// The neighbours of vertex "i" are stored in "adjacency",
+	// from "adjacencyOffsets[i]" up to "adjacencyOffsets[i + 1]".
+	// These are NULL if the hull is too small to hill climb.
+	uint_least32_t *adjacencyOffsets;
+	colliderVertexIndex *adjacency;
 
 	// We don't need to store the number of
 	// normals since we can use "numFaces".
@@ -73,10 +102,16 @@ typedef struct colliderHull {
 	// two vertices when we're clipping. This value is
 	// used for preallocation during collision detection.
 	colliderFaceIndex maxFaceEdges;
+	// Which narrowphase test to use for this hull. If
+	// either hull in a pair prefers GJK, it will be used.
+	byte_t narrowphase;
 
 	// Hulls are the only colliders that
 	// need their centroids for collision.
 	vec3 centroid;
+	// Hill climbing without a starting vertex begins from
+	// whichever of these is farthest in the search direction.
+	colliderVertexIndex climbSeeds[COLLIDER_HULL_NUM_CLIMB_SEEDS];
 } colliderHull;
 
 
@@ -106,16 +141,36 @@ const vec3 *colliderHullSupport(
 	const colliderHull *const restrict hull,
 	const vec3 *const restrict dir
 );
+const vec3 *colliderHullSupportFrom(
+	const colliderHull *const restrict hull,
+	const vec3 *const restrict dir, const colliderVertexIndex start
+);
+return_t colliderHullRaycast(
+	const colliderHull *const restrict hull, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+);
 
 return_t colliderHullSeparated(
 	const void *const restrict hullA,
 	const void *const restrict hullB,
 	contactSeparation *const restrict cs
 );
+return_t colliderHullColliding(
+	const void *const restrict hullA, const void *const restrict hullB,
+	contactSeparation *const restrict separation, contactManifold *const restrict cm
+);
 return_t colliderHullCollidingSAT(
 	const void *const restrict hullA, const void *const restrict hullB,
 	contactSeparation *const restrict separation, contactManifold *const restrict cm
 );
+return_t colliderHullCollidingGJK(
+	const void *const restrict hullA, const void *const restrict hullB,
+	contactSeparation *const restrict separation, contactManifold *const restrict cm
+);
+return_t colliderHullNearby(
+	const void *const restrict hullA, const void *const restrict hullB,
+	const contactSeparation *const restrict cs, const float margin, contactManifold *const restrict cm
+);
 
 void colliderHullDeleteInstance(colliderHull *const restrict hull);
 void colliderHullDelete(colliderHull *const restrict hull);
@@ -1,11 +1,33 @@
 #include "colliderSphere.h"
 
 
+#include <math.h>
+
+#include "utilMath.h"
+
+
+// Return the point on a sphere farthest in the direction "dir".
+void colliderSphereSupport(
+	const colliderSphere *const restrict sphere,
+	const vec3 *const restrict dir, vec3 *const restrict out
+){
+
+	const float magnitudeSquared = vec3MagnitudeSquaredVec3(dir);
+
+	if(magnitudeSquared > 0.f){
+		vec3FmaOut(sphere->radius * invSqrt(magnitudeSquared), dir, &sphere->pos, out);
+	}else{
+		*out = sphere->pos;
+	}
+}
+
+
+
 /*
 ** Let S be the sphere of radius r centred at c and R
 ** the ray starting at p and travelling in direction v.
 ** That is, we have
-**     S = {x in R^3 : ||x - c|| = 1},
+**     S = {x in R^3 : ||x - c|| = r},
 **     R = {p + tv : t >= 0}.
 ** Note that if R intersects S, then it must intersect
 ** at the boundary at least once at and at most twice.
@@ -17,8 +39,47 @@
 ** If the input to the square root is negative, R does
 ** not intersect S. If it's positive, we still need to
 ** check whether t >= 0, as otherwise it intersects S
-** behind p.
+** behind p. If p is inside S, we say that the ray
+** hits immediately, and the normal points back along it.
 */
-return_t colliderSphereRaycast(){
-	return(0);
+return_t colliderSphereRaycast(
+	const colliderSphere *const restrict sphere, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+){
+
+	vec3 offset;
+	float offsetDot;
+	float c;
+	float discriminant;
+	float t;
+
+	vec3SubtractVec3Out(origin, &sphere->pos, &offset);
+	c = vec3MagnitudeSquaredVec3(&offset) - sphere->radius*sphere->radius;
+	if(c <= 0.f){
+		*distance = 0.f;
+		vec3NegateOut(dir, normal);
+		return(1);
+	}
+
+	// If the ray starts outside the sphere and is
+	// pointing away from it, it can't intersect.
+	offsetDot = vec3DotVec3(&offset, dir);
+	if(offsetDot > 0.f){
+		return(0);
+	}
+	discriminant = offsetDot*offsetDot - c;
+	if(discriminant < 0.f){
+		return(0);
+	}
+
+	t = -offsetDot - sqrtf(discriminant);
+	if(t > maxDistance){
+		return(0);
+	}
+
+	// The normal is the direction from the centre to the hit point.
+	*distance = t;
+	vec3FmaP2(t, dir, &offset);
+	vec3MultiplySOut(&offset, 1.f/sphere->radius, normal);
+	return(1);
 }
\ No newline at end of file
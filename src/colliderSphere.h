@@ -13,7 +13,14 @@ typedef struct colliderSphere {
 } colliderSphere;
 
 
-return_t colliderSphereRaycast();
+void colliderSphereSupport(
+	const colliderSphere *const restrict sphere,
+	const vec3 *const restrict dir, vec3 *const restrict out
+);
+return_t colliderSphereRaycast(
+	const colliderSphere *const restrict sphere, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, float *const restrict distance, vec3 *const restrict normal
+);
 
 
 #endif
\ No newline at end of file
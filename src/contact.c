@@ -20,7 +20,20 @@ return_t (*contactCollisionTable[COLLIDER_NUM_TYPES][COLLIDER_NUM_TYPES])(
 	contactManifold *const restrict cm
 ) = {
 	{
-		colliderHullCollidingSAT
+		colliderHullColliding
+	}
+};
+
+// Jump table for building speculative contacts independent of collider types.
+return_t (*contactNearbyTable[COLLIDER_NUM_TYPES][COLLIDER_NUM_TYPES])(
+	const void *const restrict cA,
+	const void *const restrict cB,
+	const contactSeparation *const restrict cs,
+	const float margin,
+	contactManifold *const restrict cm
+) = {
+	{
+		colliderHullNearby
 	}
 };
 
@@ -70,4 +83,17 @@ return_t collidersAreColliding(
 ){
 
 	return(contactCollisionTable[cA->type][cB->type]((void *)(&cA->data), (void *)(&cB->data), cs, cm));
+}
+
+/*
+** If two separated colliders are within "margin" of each other,
+** build a manifold of speculative contacts from the features that
+** separate them. Note that "cs" must be a valid separation.
+*/
+return_t collidersAreNearby(
+	const collider *const restrict cA, const collider *const restrict cB,
+	const contactSeparation *const restrict cs, const float margin, contactManifold *const restrict cm
+){
+
+	return(contactNearbyTable[cA->type][cB->type]((void *)(&cA->data), (void *)(&cB->data), cs, margin, cm));
 }
\ No newline at end of file
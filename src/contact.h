@@ -53,8 +53,8 @@ typedef struct contactPoint {
 
 	vec3 normal;
 
-	// Separation between the colliders.
-	// Note that this is a negative quantity.
+	// Separation between the colliders. This is
+	// negative unless the contact is speculative.
 	float separation;
 	// Used to uniquely identify the contact point.
 	contactKey key;
@@ -82,6 +82,10 @@ return_t collidersAreColliding(
 	const collider *const restrict cA, const collider *const restrict cB,
 	contactSeparation *const restrict cs, contactManifold *const restrict cm
 );
+return_t collidersAreNearby(
+	const collider *const restrict cA, const collider *const restrict cB,
+	const contactSeparation *const restrict cs, const float margin, contactManifold *const restrict cm
+);
 
 
 extern return_t (*contactSeparationTable[COLLIDER_NUM_TYPES][COLLIDER_NUM_TYPES])(
@@ -95,6 +99,13 @@ extern return_t (*contactCollisionTable[COLLIDER_NUM_TYPES][COLLIDER_NUM_TYPES])
 	contactSeparation *const restrict cs,
 	contactManifold *const restrict cm
 );
+extern return_t (*contactNearbyTable[COLLIDER_NUM_TYPES][COLLIDER_NUM_TYPES])(
+	const void *const restrict cA,
+	const void *const restrict cB,
+	const contactSeparation *const restrict cs,
+	const float margin,
+	contactManifold *const restrict cm
+);
 
 
 #endif
\ No newline at end of file
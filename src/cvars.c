@@ -12,6 +12,10 @@ return_t cv_prg_running = 1;
 int cv_mouse_dx;
 int cv_mouse_dy;
 
+#ifdef PHYSISLAND_PROFILE
+const physicsProfiler *cv_phys_profiler = NULL;
+#endif
+
 
 // Forward-declare any helper functions!
 #ifdef C_MOUSEMOVE_FAST
@@ -43,6 +47,15 @@ void c_mousemove(commandSystem *const restrict cmdSys, const size_t argc, const
 	}
 }
 
+#ifdef PHYSISLAND_PROFILE
+// Print the timings and counters of the last physics step.
+void c_physprofile(commandSystem *const restrict cmdSys, const size_t argc, const char **const restrict argv){
+	if(cv_phys_profiler != NULL){
+		physProfilerPrint(cv_phys_profiler);
+	}
+}
+#endif
+
 
 #ifdef C_MOUSEMOVE_FAST
 /*
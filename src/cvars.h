@@ -2,7 +2,12 @@
 #define cvars_h
 
 
+#include "settingsPhysics.h"
+
 #include "command.h"
+#ifdef PHYSISLAND_PROFILE
+#include "physicsProfiler.h"
+#endif
 #include "utilTypes.h"
 
 
@@ -14,6 +19,10 @@ void c_exit(commandSystem *const restrict cmdSys, const size_t argc, const char
 
 void c_mousemove(commandSystem *const restrict cmdSys, const size_t argc, const char **const restrict argv);
 
+#ifdef PHYSISLAND_PROFILE
+void c_physprofile(commandSystem *const restrict cmdSys, const size_t argc, const char **const restrict argv);
+#endif
+
 
 // The program will stop if this is set to 0.
 extern return_t cv_prg_running;
@@ -25,5 +34,11 @@ extern return_t cv_prg_running;
 extern int cv_mouse_dx;
 extern int cv_mouse_dy;
 
+#ifdef PHYSISLAND_PROFILE
+// Profiler printed by the "physprofile" command.
+// This is usually the main physics island's.
+extern const physicsProfiler *cv_phys_profiler;
+#endif
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "memoryArena.h"
+
+
+#include <string.h>
+#include <stdatomic.h>
+
+#include "memoryManager.h"
+
+
+// Each thread has its own arena, which is created the first
+// time the thread uses it. Threads find out that a new frame
+// has started by checking the global frame number when they
+// allocate memory, so no thread ever touches another's arena.
+typedef struct memoryThreadArena {
+	memoryArena arena;
+	void *memory;
+	// The global frame number when we last started a frame.
+	size_t frame;
+	// We can't start a new frame while there are markers
+	// that haven't been rolled back, as it could free
+	// memory that is still being used by their owners.
+	size_t numScopes;
+	byte_t initialised;
+} memoryThreadArena;
+
+
+// Forward-declare any helper functions!
+static void freeOverflow(void *block, const void *const last);
+static memoryArena *threadArenaSync();
+
+
+static atomic_size_t globalFrame;
+static _Thread_local memoryThreadArena threadArena;
+
+
+/*
+** Split "memory" between the arena's two stacks. If "memory"
+** is NULL, every block will be allocated by the memory manager.
+*/
+void *memArenaInit(memoryArena *const restrict arena, void *const restrict memory, const size_t memorySize){
+	const size_t frameSize = (memory != NULL) ? ((memorySize/2) & MEMORY_DATA_MASK) : 0;
+
+	memStackInit(&arena->frames[0], memory, frameSize);
+	memStackInit(&arena->frames[1], memoryAddPointer(memory, frameSize), frameSize);
+	arena->overflow[0] = NULL;
+	arena->overflow[1] = NULL;
+	arena->frame = 0;
+
+	return(memory);
+}
+
+
+void *memArenaAlloc(memoryArena *const restrict arena, const size_t blockSize){
+	const size_t current = arena->frame & 1;
+	void *newBlock = memStackAlloc(&arena->frames[current], blockSize);
+
+	// If the current frame's stack is full, allocate the block using
+	// the memory manager and add it to the list of overflowing blocks.
+	if(newBlock == NULL && blockSize > 0){
+		void **const overflowBlock = memoryManagerGlobalAlloc(MEMARENA_OVERFLOW_HEADER_SIZE + blockSize);
+		if(overflowBlock == NULL){
+			/** MALLOC FAILED **/
+			return(NULL);
+		}
+
+		*overflowBlock = arena->overflow[current];
+		arena->overflow[current] = overflowBlock;
+		newBlock = memoryAddPointer(overflowBlock, MEMARENA_OVERFLOW_HEADER_SIZE);
+	}
+
+	return(newBlock);
+}
+
+
+// Return a marker that can be used to free every block allocated after it.
+memArenaMarker memArenaGetMarker(const memoryArena *const restrict arena){
+	const size_t current = arena->frame & 1;
+	const memArenaMarker marker = {
+		.top = memStackGetMarker(&arena->frames[current]),
+		.overflow = arena->overflow[current],
+		.frame = arena->frame
+	};
+
+	return(marker);
+}
+
+/*
+** Free every block allocated since "marker" was created. If
+** the frame has changed since then, we do nothing, as those
+** blocks will be freed at the end of the next frame anyway.
+*/
+void memArenaRollback(memoryArena *const restrict arena, const memArenaMarker *const restrict marker){
+	if(marker->frame == arena->frame){
+		const size_t current = arena->frame & 1;
+
+		memStackFreeTo(&arena->frames[current], marker->top);
+		freeOverflow(arena->overflow[current], marker->overflow);
+		arena->overflow[current] = marker->overflow;
+	}
+}
+
+/*
+** Start a new frame, freeing everything that was allocated
+** during the frame before the one that has just finished.
+*/
+void memArenaNextFrame(memoryArena *const restrict arena){
+	const size_t next = (++arena->frame) & 1;
+
+	memStackClear(&arena->frames[next]);
+	freeOverflow(arena->overflow[next], NULL);
+	arena->overflow[next] = NULL;
+}
+
+// Free any overflowing blocks. The arena's memory belongs to the caller.
+void memArenaDelete(memoryArena *const restrict arena){
+	freeOverflow(arena->overflow[0], NULL);
+	arena->overflow[0] = NULL;
+	freeOverflow(arena->overflow[1], NULL);
+	arena->overflow[1] = NULL;
+}
+
+
+/*
+** Start a new frame for every thread's arena. This should be
+** called once at the start of each update and each render.
+*/
+void memArenaGlobalNextFrame(){
+	atomic_fetch_add_explicit(&globalFrame, 1, memory_order_relaxed);
+}
+
+
+// Allocate a block of scratch memory using the calling thread's arena.
+void *memArenaThreadAlloc(const size_t blockSize){
+	return(memArenaAlloc(threadArenaSync(), blockSize));
+}
+
+// Every marker returned by this must be rolled back!
+memArenaMarker memArenaThreadGetMarker(){
+	const memArenaMarker marker = memArenaGetMarker(threadArenaSync());
+	++threadArena.numScopes;
+
+	return(marker);
+}
+
+void memArenaThreadRollback(const memArenaMarker *const restrict marker){
+	memArenaRollback(&threadArena.arena, marker);
+	--threadArena.numScopes;
+}
+
+// Threads should call this before they exit, as their arenas would leak otherwise.
+void memArenaThreadDelete(){
+	if(threadArena.initialised){
+		memArenaDelete(&threadArena.arena);
+		if(threadArena.memory != NULL){
+			memoryManagerGlobalFree(threadArena.memory);
+		}
+		memset(&threadArena, 0, sizeof(threadArena));
+	}
+}
+
+
+// Free a list of overflowing blocks, stopping when we reach "last".
+static void freeOverflow(void *block, const void *const last){
+	while(block != last){
+		void *const next = *((void **)block);
+		memoryManagerGlobalFree(block);
+		block = next;
+	}
+}
+
+/*
+** Return the calling thread's arena, creating it if it
+** doesn't exist. If the global frame number has changed,
+** we also start a new frame. We only ever move forward by
+** one frame though, so anything allocated during the last
+** frame this thread saw is still valid until the next one.
+*/
+static memoryArena *threadArenaSync(){
+	const size_t frame = atomic_load_explicit(&globalFrame, memory_order_relaxed);
+
+	if(!threadArena.initialised){
+		const size_t memorySize = memArenaMemoryForSize(MEMARENA_THREAD_FRAME_SIZE);
+		threadArena.memory = memoryManagerGlobalAlloc(memorySize);
+		memArenaInit(&threadArena.arena, threadArena.memory, memorySize);
+		threadArena.frame = frame;
+		threadArena.initialised = 1;
+	}else if(threadArena.frame != frame && threadArena.numScopes == 0){
+		memArenaNextFrame(&threadArena.arena);
+		threadArena.frame = frame;
+	}
+
+	return(&threadArena.arena);
+}
\ No newline at end of file
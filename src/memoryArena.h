@@ -0,0 +1,75 @@
+#ifndef memoryArena_h
+#define memoryArena_h
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "settingsMemory.h"
+#include "utilMemory.h"
+#include "memoryStack.h"
+
+#include "utilTypes.h"
+
+
+// This is the size of each of the two buffers in a thread's arena.
+#ifndef MEMARENA_THREAD_FRAME_SIZE
+	#define MEMARENA_THREAD_FRAME_SIZE (512 * MEMORY_KIBIBYTE)
+#endif
+
+#define MEMARENA_OVERFLOW_HEADER_SIZE ((uintptr_t)memoryAlign(sizeof(void *)))
+
+// Return the amount of memory required for an
+// arena with two buffers of "size" bytes each.
+#define memArenaMemoryForSize(size) (2 * (size_t)memoryAlign(size))
+
+
+// Overflow block diagram:
+// [next][       data       ]
+
+/* A frame arena is a pair of stacks used for scratch memory */
+/* that only needs to last for a frame. Rather than freeing  */
+/* blocks individually, everything allocated during a frame  */
+/* is released at once when the frame after it ends. This    */
+/* means memory allocated during an update is still valid    */
+/* during the following render, and vice versa.              */
+/*                                                           */
+/* Markers allow memory to be released sooner. Rolling back  */
+/* to a marker frees every block allocated since it was got. */
+/* If a stack fills up, we fall back to the global memory    */
+/* manager and free the overflowing blocks with the rest.    */
+
+
+typedef struct memoryArena {
+	memoryStack frames[2];
+	// Blocks that didn't fit on each frame's stack.
+	void *overflow[2];
+	// The current stack is "frames[frame & 1]".
+	size_t frame;
+} memoryArena;
+
+typedef struct memArenaMarker {
+	void *top;
+	void *overflow;
+	size_t frame;
+} memArenaMarker;
+
+
+void *memArenaInit(memoryArena *const restrict arena, void *const restrict memory, const size_t memorySize);
+
+void *memArenaAlloc(memoryArena *const restrict arena, const size_t blockSize);
+
+memArenaMarker memArenaGetMarker(const memoryArena *const restrict arena);
+void memArenaRollback(memoryArena *const restrict arena, const memArenaMarker *const restrict marker);
+void memArenaNextFrame(memoryArena *const restrict arena);
+void memArenaDelete(memoryArena *const restrict arena);
+
+void memArenaGlobalNextFrame();
+
+void *memArenaThreadAlloc(const size_t blockSize);
+memArenaMarker memArenaThreadGetMarker();
+void memArenaThreadRollback(const memArenaMarker *const restrict marker);
+void memArenaThreadDelete();
+
+
+#endif
\ No newline at end of file
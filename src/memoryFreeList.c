@@ -4,25 +4,17 @@
 #include "utilTypes.h"
 
 
+// Forward-declare any helper functions!
+static void *initRegion(const size_t blockSize, memoryRegion *const restrict region);
+static void clearRegions(const size_t blockSize, memoryRegion *region);
+
+
 /*
 ** Initialise every block in a region, setting the
 ** flag to invalid and the next pointer to NULL.
 */
 void memFreeListInitRegion(memoryFreeList *const restrict freeList, memoryRegion *const restrict region){
-	const size_t blockSize = freeList->blockSize;
-	void *currentBlock = region->start;
-	void *nextBlock = memFreeListBlockGetNextBlock(currentBlock, blockSize);
-
-	// Set the next pointer for each block!
-	while(nextBlock < (void *)region){
-		memFreeListBlockFreeGetNext(currentBlock) = nextBlock;
-
-		currentBlock = nextBlock;
-		nextBlock = memFreeListBlockGetNextBlock(currentBlock, blockSize);
-	}
-
-	// Set the next pointer for the last block!
-	memFreeListBlockFreeGetNext(currentBlock) = NULL;
+	initRegion(freeList->blockSize, region);
 }
 
 void *memFreeListInit(memoryFreeList *const restrict freeList, void *const restrict memory, const size_t memorySize, const size_t blockSize){
@@ -82,6 +74,178 @@ void memFreeListClear(memoryFreeList *const restrict freeList){
 	freeList->usedBlocks = 0;
 	#endif
 
+	clearRegions(blockSize, region);
+}
+
+
+#ifdef MEMORYREGION_EXTEND_ALLOCATORS
+void *memFreeListExtend(memoryFreeList *const restrict freeList, void *const restrict memory, const size_t memorySize){
+	if(memory != NULL){
+		memoryRegion *const newRegion = memoryGetRegionFromSize(memory, memorySize);
+		// Add the new region to the end of the list!
+		memoryRegionAppend(&freeList->region, newRegion, memory);
+		// Set up its memory!
+		memFreeListInitRegion(freeList, newRegion);
+
+		freeList->nextFreeBlock = memory;
+	}
+
+	return(memory);
+}
+#endif
+
+
+void *memFreeListConcurrentInit(memoryFreeListConcurrent *const restrict freeList, void *const restrict memory, const size_t memorySize, const size_t blockSize){
+	// Make sure the user isn't being difficult.
+	if(memory != NULL){
+		memoryRegion *region;
+
+		freeList->blockSize = memFreeListGetBlockSize(blockSize);
+
+		region = memoryGetRegionFromSize(memory, memorySize);
+		region->start = memory;
+		region->next = NULL;
+		initRegion(freeList->blockSize, region);
+
+		memoryFreeStackInit(&freeList->nextFreeBlock, memory);
+		#ifdef MEMFREELIST_COUNT_USED_BLOCKS
+		atomic_init(&freeList->usedBlocks, 0);
+		#endif
+		freeList->generation = memoryMagazineNewGeneration();
+		freeList->region = region;
+	}
+
+	return(memory);
+}
+
+
+// This is safe to call from multiple threads at once.
+void *memFreeListConcurrentAlloc(memoryFreeListConcurrent *const restrict freeList){
+	void *const newBlock = memoryFreeStackPop(&freeList->nextFreeBlock);
+
+	#ifdef MEMFREELIST_COUNT_USED_BLOCKS
+	if(newBlock != NULL){
+		atomic_fetch_add_explicit(&freeList->usedBlocks, 1, memory_order_relaxed);
+	}
+	#endif
+
+	return(newBlock);
+}
+
+/*
+** Allocate a block using the calling thread's magazine,
+** only touching the shared free list if it's empty.
+*/
+void *memFreeListMagazineAlloc(memoryFreeListConcurrent *const restrict freeList, memoryMagazine *const restrict magazine){
+	void *const newBlock = memoryMagazineAlloc(magazine, freeList->generation);
+	if(newBlock != NULL){
+		return(newBlock);
+	}
+
+	return(memFreeListConcurrentAlloc(freeList));
+}
+
+
+// This is safe to call from multiple threads at once.
+void memFreeListConcurrentFree(memoryFreeListConcurrent *const restrict freeList, void *const restrict data){
+	memoryFreeStackPush(&freeList->nextFreeBlock, data, data);
+	#ifdef MEMFREELIST_COUNT_USED_BLOCKS
+	atomic_fetch_sub_explicit(&freeList->usedBlocks, 1, memory_order_relaxed);
+	#endif
+}
+
+/*
+** Free a block into the calling thread's magazine. If the
+** magazine is full, we return half of it to the list first.
+*/
+void memFreeListMagazineFree(memoryFreeListConcurrent *const restrict freeList, memoryMagazine *const restrict magazine, void *const restrict data){
+	#ifdef MEMFREELIST_COUNT_USED_BLOCKS
+	atomic_fetch_sub_explicit(
+		&freeList->usedBlocks,
+		memoryMagazineFree(magazine, &freeList->nextFreeBlock, freeList->generation, data),
+		memory_order_relaxed
+	);
+	#else
+	memoryMagazineFree(magazine, &freeList->nextFreeBlock, freeList->generation, data);
+	#endif
+}
+
+/*
+** Return every block in the calling thread's magazine to the list.
+** Threads should do this before they exit, as otherwise the blocks
+** can't be allocated again until the list is cleared.
+*/
+void memFreeListMagazineFlush(memoryFreeListConcurrent *const restrict freeList, memoryMagazine *const restrict magazine){
+	#ifdef MEMFREELIST_COUNT_USED_BLOCKS
+	atomic_fetch_sub_explicit(
+		&freeList->usedBlocks,
+		memoryMagazineFlush(magazine, &freeList->nextFreeBlock, freeList->generation),
+		memory_order_relaxed
+	);
+	#else
+	memoryMagazineFlush(magazine, &freeList->nextFreeBlock, freeList->generation);
+	#endif
+}
+
+/*
+** Clear every memory region in the allocator. This is not
+** thread-safe, but it empties every thread's magazine.
+*/
+void memFreeListConcurrentClear(memoryFreeListConcurrent *const restrict freeList){
+	memoryFreeStackInit(&freeList->nextFreeBlock, freeList->region->start);
+	#ifdef MEMFREELIST_COUNT_USED_BLOCKS
+	atomic_store_explicit(&freeList->usedBlocks, 0, memory_order_relaxed);
+	#endif
+	freeList->generation = memoryMagazineNewGeneration();
+
+	clearRegions(freeList->blockSize, freeList->region);
+}
+
+
+#ifdef MEMORYREGION_EXTEND_ALLOCATORS
+/*
+** Append a new memory region to the end of our allocator's region list!
+** Other threads may allocate and free blocks while this is happening,
+** but only one thread should be extending the list at any given time.
+*/
+void *memFreeListConcurrentExtend(memoryFreeListConcurrent *const restrict freeList, void *const restrict memory, const size_t memorySize){
+	if(memory != NULL){
+		memoryRegion *const newRegion = memoryGetRegionFromSize(memory, memorySize);
+		// Add the new region to the end of the list!
+		memoryRegionAppend(&freeList->region, newRegion, memory);
+		// Set up its memory and add it to the free list!
+		memoryFreeStackPush(&freeList->nextFreeBlock, memory, initRegion(freeList->blockSize, newRegion));
+	}
+
+	return(memory);
+}
+#endif
+
+
+/*
+** Initialise every block in a region, setting the next
+** pointer of the last block to NULL. We return the last block.
+*/
+static void *initRegion(const size_t blockSize, memoryRegion *const restrict region){
+	void *currentBlock = region->start;
+	void *nextBlock = memFreeListBlockGetNextBlock(currentBlock, blockSize);
+
+	// Set the next pointer for each block!
+	while(nextBlock < (void *)region){
+		memFreeListBlockFreeGetNext(currentBlock) = nextBlock;
+
+		currentBlock = nextBlock;
+		nextBlock = memFreeListBlockGetNextBlock(currentBlock, blockSize);
+	}
+
+	// Set the next pointer for the last block!
+	memFreeListBlockFreeGetNext(currentBlock) = NULL;
+
+	return(currentBlock);
+}
+
+// Set the next pointer of every block in a sequence of memory regions.
+static void clearRegions(const size_t blockSize, memoryRegion *region){
 	// Loop through every region in the allocator.
 	for(;;){
 		memoryRegion *const nextRegion = region->next;
@@ -105,21 +269,4 @@ void memFreeListClear(memoryFreeList *const restrict freeList){
 		}
 		region = nextRegion;
 	}
-}
-
-
-#ifdef MEMORYREGION_EXTEND_ALLOCATORS
-void *memFreeListExtend(memoryFreeList *const restrict freeList, void *const restrict memory, const size_t memorySize){
-	if(memory != NULL){
-		memoryRegion *const newRegion = memoryGetRegionFromSize(memory, memorySize);
-		// Add the new region to the end of the list!
-		memoryRegionAppend(&freeList->region, newRegion, memory);
-		// Set up its memory!
-		memFreeListInitRegion(freeList, newRegion);
-
-		freeList->nextFreeBlock = memory;
-	}
-
-	return(memory);
-}
-#endif
\ No newline at end of file
+}
\ No newline at end of file
@@ -90,6 +90,23 @@ typedef struct memoryFreeList {
 	memoryRegion *region;
 } memoryFreeList;
 
+// Concurrent free lists work like concurrent pools.
+// Any number of threads may allocate and free blocks
+// at once, but only one thread may extend the list.
+typedef struct memoryFreeListConcurrent {
+	size_t blockSize;
+	// Points to the next pointer of a free block.
+	memoryFreeStack nextFreeBlock;
+	#ifdef MEMFREELIST_COUNT_USED_BLOCKS
+	// Blocks in threads' magazines are counted as used.
+	atomic_size_t usedBlocks;
+	#endif
+	// This changes whenever the list is initialised or cleared.
+	size_t generation;
+
+	memoryRegion *region;
+} memoryFreeListConcurrent;
+
 
 void memFreeListInitRegion(memoryFreeList *const restrict freeList, memoryRegion *const restrict region);
 void *memFreeListInit(memoryFreeList *const restrict freeList, void *const restrict memory, const size_t memorySize, const size_t blockSize);
@@ -103,5 +120,19 @@ void memFreeListClear(memoryFreeList *const restrict freeList);
 void *memFreeListExtend(memoryFreeList *const restrict freeList, void *memory, const size_t memorySize);
 #endif
 
+void *memFreeListConcurrentInit(memoryFreeListConcurrent *const restrict freeList, void *const restrict memory, const size_t memorySize, const size_t blockSize);
+
+void *memFreeListConcurrentAlloc(memoryFreeListConcurrent *const restrict freeList);
+void *memFreeListMagazineAlloc(memoryFreeListConcurrent *const restrict freeList, memoryMagazine *const restrict magazine);
+
+void memFreeListConcurrentFree(memoryFreeListConcurrent *const restrict freeList, void *const restrict data);
+void memFreeListMagazineFree(memoryFreeListConcurrent *const restrict freeList, memoryMagazine *const restrict magazine, void *const restrict data);
+void memFreeListMagazineFlush(memoryFreeListConcurrent *const restrict freeList, memoryMagazine *const restrict magazine);
+void memFreeListConcurrentClear(memoryFreeListConcurrent *const restrict freeList);
+
+#ifdef MEMORYREGION_EXTEND_ALLOCATORS
+void *memFreeListConcurrentExtend(memoryFreeListConcurrent *const restrict freeList, void *const restrict memory, const size_t memorySize);
+#endif
+
 
 #endif
\ No newline at end of file
@@ -1,41 +1,180 @@
 #include "memoryManager.h"
 
 
+// Both of the allocators we can use for the
+// memory managers have the same interface.
+#ifdef MEMORY_MANAGER_USE_TLSF
+	#define managerMemoryForSize(size)                 memTLSFMemoryForSize(size)
+	#define managerInit(memMngr, memory, memorySize)   memTLSFInit(memMngr, memory, memorySize)
+	#define managerAlloc(memMngr, blockSize)           memTLSFAlloc(memMngr, blockSize)
+	#define managerResize(memMngr, block, blockSize)   memTLSFResize(memMngr, block, blockSize)
+	#define managerRealloc(memMngr, block, blockSize)  memTLSFRealloc(memMngr, block, blockSize)
+	#define managerExtend(memMngr, memory, memorySize) memTLSFExtend(memMngr, memory, memorySize)
+	#define managerFree(memMngr, block)                memTLSFFree(memMngr, block)
+	#define managerBlockGetSize(block)                 memTLSFBlockGetSize(block)
+#else
+	#define managerMemoryForSize(size)                 memTreeMemoryForSize(size)
+	#define managerInit(memMngr, memory, memorySize)   memTreeInit(memMngr, memory, memorySize)
+	#define managerAlloc(memMngr, blockSize)           memTreeAlloc(memMngr, blockSize)
+	#define managerResize(memMngr, block, blockSize)   memTreeResize(memMngr, block, blockSize)
+	#define managerRealloc(memMngr, block, blockSize)  memTreeRealloc(memMngr, block, blockSize)
+	#define managerExtend(memMngr, memory, memorySize) memTreeExtend(memMngr, memory, memorySize)
+	#define managerFree(memMngr, block)                memTreeFree(memMngr, block)
+	#define managerBlockGetSize(block)                 memTreeBlockGetSize(block)
+#endif
+
+
 #ifdef MEMORY_USE_GLOBAL_MANAGER
 memoryManager g_memManager;
+#ifdef MEMORY_GLOBAL_MANAGER_THREAD_SAFE
+// Every call to the global memory manager that
+// can't be handled by a thread's cache takes this lock.
+threadMutex g_memManagerLock;
+
+#define memoryManagerGlobalLock()   threadMutexLock(&g_memManagerLock)
+#define memoryManagerGlobalUnlock() threadMutexUnlock(&g_memManagerLock)
+#else
+#define memoryManagerGlobalLock()
+#define memoryManagerGlobalUnlock()
+#endif
+#ifdef MEMORY_GLOBAL_MANAGER_TRACE
+#include <stdio.h>
+
+/*
+** Each line of the trace file is one operation, where "a" is
+** an allocation, "r" is a resize, "z" is a reallocation and
+** "f" is a free. Addresses are written as decimal integers:
+**
+** a <size> <result>
+** r <block> <size> <result>
+** z <block> <size> <result>
+** f <block>
+*/
+static FILE *traceFile = NULL;
+
+#define memoryManagerGlobalTrace(...) if(traceFile != NULL){ fprintf(traceFile, __VA_ARGS__); }
+#else
+#define memoryManagerGlobalTrace(...)
+#endif
+#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+#define MEMORY_THREAD_CACHE_NUM_CLASSES (MEMORY_THREAD_CACHE_MAX_SIZE/MEMORY_THREAD_CACHE_CLASS_SIZE)
+
+// Return the size class that an allocation of "size" bytes should use.
+#define threadCacheAllocClass(size) (((size) - 1)/MEMORY_THREAD_CACHE_CLASS_SIZE)
+// Return the largest size class that a block with "size" usable bytes can be used for.
+#define threadCacheBlockClass(size) ((size)/MEMORY_THREAD_CACHE_CLASS_SIZE - 1)
+// Return the number of bytes that blocks in a size class should have.
+#define threadCacheClassSize(sizeClass) (((sizeClass) + 1)*MEMORY_THREAD_CACHE_CLASS_SIZE)
+
+/*
+** Each thread keeps a list of free small blocks for every size
+** class. These blocks are still active as far as the global
+** memory manager is concerned, so threads can allocate and free
+** them without taking its lock. When a list is empty or becomes
+** too long, we move a whole batch of blocks at once.
+*/
+typedef struct memoryThreadCache {
+	// Cached blocks are linked through their first word.
+	void *blocks[MEMORY_THREAD_CACHE_NUM_CLASSES];
+	size_t numBlocks[MEMORY_THREAD_CACHE_NUM_CLASSES];
+} memoryThreadCache;
+
+static _Thread_local memoryThreadCache threadCache;
+
+
+// Forward-declare any helper functions!
+static void *threadCacheAlloc(const size_t blockSize);
+static void threadCacheFree(void *const restrict block);
+static void *threadCacheRefill(const size_t sizeClass);
+static void threadCacheReturn(const size_t sizeClass, size_t numBlocks);
+#endif
 
 
 // Allocate memory for the global memory manager.
 #warning "Check if memoryAlloc failed in here instead of the allocators."
 return_t memoryManagerGlobalInit(const size_t heapSize){
-	const size_t regionSize = memTreeMemoryForSize(heapSize);
+	const size_t regionSize = memoryRegionGetAllocSize(managerMemoryForSize(heapSize));
 
-	return(memTreeInit(&g_memManager, memoryAlloc(regionSize), regionSize) != NULL);
+	#ifdef MEMORY_GLOBAL_MANAGER_THREAD_SAFE
+	threadMutexInit(&g_memManagerLock);
+	#endif
+	#ifdef MEMORY_GLOBAL_MANAGER_TRACE
+	traceFile = fopen(MEMORY_GLOBAL_MANAGER_TRACE_FILE, "w");
+	#endif
+
+	return(managerInit(&g_memManager, memoryRegionAlloc(regionSize), regionSize) != NULL);
 }
 
 
 void *memoryManagerGlobalAlloc(const size_t blockSize){
-	return(memTreeAlloc(&g_memManager, blockSize));
+	void *block;
+
+	#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+	// Small blocks can usually be taken from this thread's cache.
+	if(blockSize > 0 && blockSize <= MEMORY_THREAD_CACHE_MAX_SIZE){
+		block = threadCacheAlloc(blockSize);
+		memoryManagerGlobalTrace("a "PRINTF_SIZE_T" "PRINTF_SIZE_T"\n", blockSize, (uintptr_t)block);
+		return(block);
+	}
+	#endif
+
+	memoryManagerGlobalLock();
+	block = managerAlloc(&g_memManager, blockSize);
+	memoryManagerGlobalTrace("a "PRINTF_SIZE_T" "PRINTF_SIZE_T"\n", blockSize, (uintptr_t)block);
+	memoryManagerGlobalUnlock();
+
+	return(block);
 }
 
 void *memoryManagerGlobalResize(void *const restrict block, const size_t blockSize){
-	return(memTreeResize(&g_memManager, block, blockSize));
+	void *newBlock;
+
+	memoryManagerGlobalLock();
+	newBlock = managerResize(&g_memManager, block, blockSize);
+	memoryManagerGlobalTrace("r "PRINTF_SIZE_T" "PRINTF_SIZE_T" "PRINTF_SIZE_T"\n", (uintptr_t)block, blockSize, (uintptr_t)newBlock);
+	memoryManagerGlobalUnlock();
+
+	return(newBlock);
 }
 
 void *memoryManagerGlobalRealloc(void *const restrict block, const size_t blockSize){
-	return(memTreeRealloc(&g_memManager, block, blockSize));
+	void *newBlock;
+
+	memoryManagerGlobalLock();
+	newBlock = managerRealloc(&g_memManager, block, blockSize);
+	memoryManagerGlobalTrace("z "PRINTF_SIZE_T" "PRINTF_SIZE_T" "PRINTF_SIZE_T"\n", (uintptr_t)block, blockSize, (uintptr_t)newBlock);
+	memoryManagerGlobalUnlock();
+
+	return(newBlock);
 }
 
 #if defined(MEMORYREGION_EXTEND_ALLOCATORS) && defined(MEMORYREGION_EXTEND_MANAGERS)
 void *memoryManagerGlobalExtend(const size_t heapSize){
-	const size_t regionSize = memTreeMemoryForSize(heapSize);
+	const size_t regionSize = memoryRegionGetAllocSize(managerMemoryForSize(heapSize));
+	void *block;
+
+	memoryManagerGlobalLock();
+	block = managerExtend(&g_memManager, memoryRegionAlloc(regionSize), regionSize);
+	memoryManagerGlobalUnlock();
 
-	return(memTreeExtend(&g_memManager, memoryAlloc(regionSize), regionSize));
+	return(block);
 }
 #endif
 
 void memoryManagerGlobalFree(void *const restrict block){
-	memTreeFree(&g_memManager, block);
+	#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+	// Small blocks are kept in this thread's cache.
+	if(managerBlockGetSize(block) <= MEMORY_THREAD_CACHE_MAX_SIZE){
+		memoryManagerGlobalTrace("f "PRINTF_SIZE_T"\n", (uintptr_t)block);
+		threadCacheFree(block);
+		return;
+	}
+	#endif
+
+	memoryManagerGlobalLock();
+	managerFree(&g_memManager, block);
+	memoryManagerGlobalTrace("f "PRINTF_SIZE_T"\n", (uintptr_t)block);
+	memoryManagerGlobalUnlock();
 }
 
 
@@ -53,44 +192,157 @@ void memoryManagerGlobalDeleteRegions(memoryRegion *region){
 	}
 }
 
+#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+/*
+** Give every block in the calling thread's cache back to the
+** global memory manager. Threads that use the global manager
+** should call this before they exit, or their blocks will leak.
+*/
+void memoryManagerGlobalFlushCache(){
+	size_t i;
+	for(i = 0; i < MEMORY_THREAD_CACHE_NUM_CLASSES; ++i){
+		if(threadCache.numBlocks[i] > 0){
+			threadCacheReturn(i, threadCache.numBlocks[i]);
+		}
+	}
+}
+#endif
+
 // Free memory used by the global memory manager.
 void memoryManagerGlobalDelete(){
 	memoryDeleteRegions(g_memManager.region);
+	#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+	// The calling thread's cache points into the
+	// memory we just freed, so we need to reset it.
+	memset(&threadCache, 0, sizeof(threadCache));
+	#endif
+
+	#ifdef MEMORY_GLOBAL_MANAGER_TRACE
+	if(traceFile != NULL){
+		fclose(traceFile);
+		traceFile = NULL;
+	}
+	#endif
+
+	#ifdef MEMORY_GLOBAL_MANAGER_THREAD_SAFE
+	threadMutexDelete(&g_memManagerLock);
+	#endif
+}
+
+
+#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+// Take a block from the calling thread's cache, refilling it if it's empty.
+static void *threadCacheAlloc(const size_t blockSize){
+	const size_t sizeClass = threadCacheAllocClass(blockSize);
+	void *block = threadCache.blocks[sizeClass];
+
+	if(block == NULL){
+		block = threadCacheRefill(sizeClass);
+		if(block == NULL){
+			return(NULL);
+		}
+	}
+	threadCache.blocks[sizeClass] = *((void **)block);
+	--threadCache.numBlocks[sizeClass];
+
+	return(block);
+}
+
+/*
+** Add a block to the calling thread's cache. If the list for
+** its size class becomes too long, give a batch back to the
+** global memory manager. Blocks might be larger than their
+** size class if the allocator couldn't split them, but this
+** is fine, as we only ever use blocks for smaller classes.
+*/
+static void threadCacheFree(void *const restrict block){
+	const size_t sizeClass = threadCacheBlockClass(managerBlockGetSize(block));
+
+	*((void **)block) = threadCache.blocks[sizeClass];
+	threadCache.blocks[sizeClass] = block;
+	++threadCache.numBlocks[sizeClass];
+	if(threadCache.numBlocks[sizeClass] > MEMORY_THREAD_CACHE_MAX_BLOCKS){
+		threadCacheReturn(sizeClass, MEMORY_THREAD_CACHE_BATCH_SIZE);
+	}
+}
+
+/*
+** Allocate a batch of blocks for a size class while only taking
+** the global memory manager's lock once. If the heap is almost
+** full, we might not get the whole batch. We return the first
+** block in the new list, or NULL if we couldn't get any blocks.
+*/
+static void *threadCacheRefill(const size_t sizeClass){
+	const size_t blockSize = threadCacheClassSize(sizeClass);
+	void *blocks = NULL;
+	size_t i;
+
+	memoryManagerGlobalLock();
+	for(i = 0; i < MEMORY_THREAD_CACHE_BATCH_SIZE; ++i){
+		void *const block = managerAlloc(&g_memManager, blockSize);
+		if(block == NULL){
+			break;
+		}
+		*((void **)block) = blocks;
+		blocks = block;
+	}
+	memoryManagerGlobalUnlock();
+
+	threadCache.blocks[sizeClass] = blocks;
+	threadCache.numBlocks[sizeClass] = i;
+
+	return(blocks);
+}
+
+// Free the first "numBlocks" blocks in a size class's list while only taking the lock once.
+static void threadCacheReturn(const size_t sizeClass, size_t numBlocks){
+	void *block = threadCache.blocks[sizeClass];
+
+	threadCache.numBlocks[sizeClass] -= numBlocks;
+	memoryManagerGlobalLock();
+	for(; numBlocks > 0; --numBlocks){
+		void *const next = *((void **)block);
+		managerFree(&g_memManager, block);
+		block = next;
+	}
+	memoryManagerGlobalUnlock();
+	threadCache.blocks[sizeClass] = block;
 }
 #endif
+#endif
 
 
 #ifdef MEMORY_USE_MODULE_MANAGER
 // Allocate memory for the memory manager.
 return_t memoryManagerInit(memoryManager *const restrict memMngr, const size_t heapSize){
-	const size_t regionSize = memTreeMemoryForSize(heapSize);
+	const size_t regionSize = memoryRegionGetAllocSize(managerMemoryForSize(heapSize));
 
-	return(memTreeInit(memMngr, memoryAlloc(regionSize), regionSize) != NULL);
+	return(managerInit(memMngr, memoryRegionAlloc(regionSize), regionSize) != NULL);
 }
 
 
 void *memoryManagerAlloc(memoryManager *const restrict memMngr, const size_t blockSize){
-	return(memTreeAlloc(memMngr, blockSize));
+	return(managerAlloc(memMngr, blockSize));
 }
 
 void *memoryManagerResize(memoryManager *const restrict memMngr, void *const restrict block, const size_t blockSize){
-	return(memTreeResize(memMngr, block, blockSize));
+	return(managerResize(memMngr, block, blockSize));
 }
 
 void *memoryManagerRealloc(memoryManager *const restrict memMngr, void *const restrict block, const size_t blockSize){
-	return(memTreeRealloc(memMngr, block, blockSize));
+	return(managerRealloc(memMngr, block, blockSize));
 }
 
 #if defined(MEMORYREGION_EXTEND_ALLOCATORS) && defined(MEMORYREGION_EXTEND_MANAGERS)
 void *memoryManagerExtend(memoryManager *const restrict memMngr, const size_t heapSize){
-	const size_t regionSize = memTreeMemoryForSize(heapSize);
+	const size_t regionSize = memoryRegionGetAllocSize(managerMemoryForSize(heapSize));
 
-	return(memTreeExtend(memMngr, memoryAlloc(regionSize), regionSize));
+	return(managerExtend(memMngr, memoryRegionAlloc(regionSize), regionSize));
 }
 #endif
 
 void memoryManagerFree(memoryManager *const restrict memMngr, void *const restrict block){
-	memTreeFree(memMngr, block);
+	managerFree(memMngr, block);
 }
 
 
@@ -5,16 +5,66 @@
 #include "utilMemory.h"
 #include "settingsMemory.h"
 
+#ifdef MEMORY_MANAGER_USE_TLSF
+#include "memoryTLSF.h"
+#else
 #include "memoryTree.h"
+#endif
+
+#ifdef MEMORY_GLOBAL_MANAGER_THREAD_SAFE
+#include "thread.h"
+#endif
 
 
 #ifndef MEMORY_HEAPSIZE
 	#define MEMORY_HEAPSIZE (64 * MEMORY_MEBIBYTE)
 #endif
+#ifndef MEMORY_GLOBAL_MANAGER_TRACE_FILE
+	#define MEMORY_GLOBAL_MANAGER_TRACE_FILE "memoryTrace.txt"
+#endif
+
+// The thread caches need the global memory manager's lock.
+#ifndef MEMORY_GLOBAL_MANAGER_THREAD_SAFE
+	#undef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+#endif
+// Blocks no larger than this are handled by the thread caches.
+#ifndef MEMORY_THREAD_CACHE_MAX_SIZE
+	#define MEMORY_THREAD_CACHE_MAX_SIZE 256
+#endif
+// The difference in size between consecutive size classes.
+#ifndef MEMORY_THREAD_CACHE_CLASS_SIZE
+	#define MEMORY_THREAD_CACHE_CLASS_SIZE 16
+#endif
+// The number of blocks moved to or from the global
+// memory manager when a cache's list is refilled or
+// returned. Larger batches take the lock less often.
+#ifndef MEMORY_THREAD_CACHE_BATCH_SIZE
+	#define MEMORY_THREAD_CACHE_BATCH_SIZE 32
+#endif
+// When a thread's list for a size class becomes longer
+// than this, it will give a batch of its blocks back.
+#ifndef MEMORY_THREAD_CACHE_MAX_BLOCKS
+	#define MEMORY_THREAD_CACHE_MAX_BLOCKS (4 * MEMORY_THREAD_CACHE_BATCH_SIZE)
+#endif
+
 
+#ifdef MEMORY_MANAGER_USE_TLSF
+typedef memoryTLSF memoryManager;
 
+#ifdef MEMTLSF_DEBUG
+	#define memoryManagerPrintAllSizes(memMngr) memTLSFPrintAllSizes(memMngr)
+#endif
+#else
 typedef memoryTree memoryManager;
 
+#ifdef MEMTREE_DEBUG
+	#define memoryManagerPrintAllSizes(memMngr) memTreePrintAllSizes(memMngr)
+#endif
+#endif
+#ifndef memoryManagerPrintAllSizes
+	#define memoryManagerPrintAllSizes(memMngr)
+#endif
+
 
 // This will define a memory manager with global scope
 // and functions that are "more optimised" for it.
@@ -31,11 +81,17 @@ void *memoryManagerGlobalExtend(const size_t memorySize);
 #endif
 void memoryManagerGlobalFree(void *const restrict block);
 
+#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+void memoryManagerGlobalFlushCache();
+#endif
 void memoryManagerGlobalDeleteRegions(memoryRegion *region);
 void memoryManagerGlobalDelete();
 
 
 extern memoryManager g_memManager;
+#ifdef MEMORY_GLOBAL_MANAGER_THREAD_SAFE
+extern threadMutex g_memManagerLock;
+#endif
 #endif
 
 // This will define memory manager functions
@@ -12,31 +12,17 @@
 #define memPoolBlockUsedDataGetFlag(block) memPoolBlockDataGetFlag(block)
 
 
+// Forward-declare any helper functions!
+static void *initRegion(const size_t blockSize, memoryRegion *const restrict region);
+static void clearRegions(const size_t blockSize, memoryRegion *region);
+
+
 /*
 ** Initialise every block in a region, setting the flag
 ** to invalid and the last block's next pointer to NULL.
 */
 void memPoolInitRegion(memoryPool *const restrict pool, memoryRegion *const restrict region){
-	const size_t blockSize = pool->blockSize;
-	void *currentBlock = region->start;
-	void *nextBlock = memPoolBlockGetNextBlock(currentBlock, blockSize);
-
-	// Set the flag and next pointer for each block!
-	while(nextBlock < (void *)region){
-		//*memPoolBlockFreeNextGetFlag(currentBlock) = MEMPOOL_FLAG_INVALID;
-		//memPoolBlockFreeGetNext(currentBlock) = nextBlock;
-		memPoolBlockGetFlag(currentBlock) = MEMPOOL_FLAG_INVALID;
-		*memPoolBlockFreeFlagGetNext(currentBlock) = (void *)memPoolBlockFreeFlagGetNext(nextBlock);
-
-		currentBlock = nextBlock;
-		nextBlock = memPoolBlockGetNextBlock(currentBlock, blockSize);
-	}
-
-	// Set the flag and next pointer for the last block!
-	//*memPoolBlockFreeNextGetFlag(currentBlock) = MEMPOOL_FLAG_INVALID;
-	//memPoolBlockFreeGetNext(currentBlock) = NULL;
-	memPoolBlockGetFlag(currentBlock) = MEMPOOL_FLAG_INVALID;
-	*memPoolBlockFreeFlagGetNext(currentBlock) = NULL;
+	initRegion(pool->blockSize, region);
 }
 
 void *memPoolInit(memoryPool *const restrict pool, void *const restrict memory, const size_t memorySize, const size_t blockSize){
@@ -105,6 +91,200 @@ void memPoolClear(memoryPool *const restrict pool){
 	pool->usedBlocks = 0;
 	#endif
 
+	clearRegions(blockSize, region);
+}
+
+
+#ifdef MEMORYREGION_EXTEND_ALLOCATORS
+// Append a new memory region to the end of our allocator's region list!
+void *memPoolExtend(memoryPool *const restrict pool, void *const restrict memory, const size_t memorySize){
+	if(memory != NULL){
+		memoryRegion *const newRegion = memoryGetRegionFromSize(memory, memorySize);
+		// Add the new region to the end of the list!
+		memoryRegionAppend(&pool->region, newRegion, memory);
+		//newRegion->start = memPoolBlockFreeFlagGetNext(memory);
+		// Set up its memory!
+		memPoolInitRegion(pool, newRegion);
+
+		pool->nextFreeBlock = (void *)memPoolBlockFreeFlagGetNext(memory);
+	}
+
+	return(memory);
+}
+#endif
+
+
+void *memPoolConcurrentInit(memoryPoolConcurrent *const restrict pool, void *const restrict memory, const size_t memorySize, const size_t blockSize){
+	// Make sure the user isn't being difficult.
+	if(memory != NULL){
+		memoryRegion *region;
+
+		pool->blockSize = memPoolGetBlockSize(blockSize);
+
+		region = memoryGetRegionFromSize(memory, memorySize);
+		region->start = memory;
+		region->next = NULL;
+		initRegion(pool->blockSize, region);
+
+		memoryFreeStackInit(&pool->nextFreeBlock, memPoolBlockFreeFlagGetNext(memory));
+		#ifdef MEMPOOL_COUNT_USED_BLOCKS
+		atomic_init(&pool->usedBlocks, 0);
+		#endif
+		pool->generation = memoryMagazineNewGeneration();
+		pool->region = region;
+	}
+
+	return(memory);
+}
+
+
+// This is safe to call from multiple threads at once.
+void *memPoolConcurrentAlloc(memoryPoolConcurrent *const restrict pool){
+	void *const newBlock = memoryFreeStackPop(&pool->nextFreeBlock);
+
+	// Make sure the pool isn't full.
+	if(newBlock != NULL){
+		#ifdef MEMPOOL_COUNT_USED_BLOCKS
+		atomic_fetch_add_explicit(&pool->usedBlocks, 1, memory_order_relaxed);
+		#endif
+		// Set its active flag.
+		*memPoolBlockUsedDataGetFlag(newBlock) = MEMPOOL_FLAG_ACTIVE;
+	}
+
+	return(newBlock);
+}
+
+/*
+** Allocate a block using the calling thread's magazine,
+** only touching the shared free list if it's empty.
+*/
+void *memPoolMagazineAlloc(memoryPoolConcurrent *const restrict pool, memoryMagazine *const restrict magazine){
+	void *const newBlock = memoryMagazineAlloc(magazine, pool->generation);
+	if(newBlock != NULL){
+		*memPoolBlockUsedDataGetFlag(newBlock) = MEMPOOL_FLAG_ACTIVE;
+		return(newBlock);
+	}
+
+	return(memPoolConcurrentAlloc(pool));
+}
+
+
+// This is safe to call from multiple threads at once.
+void memPoolConcurrentFree(memoryPoolConcurrent *const restrict pool, void *const restrict data){
+	*memPoolBlockFreeNextGetFlag(data) = MEMPOOL_FLAG_INACTIVE;
+	memoryFreeStackPush(&pool->nextFreeBlock, data, data);
+	#ifdef MEMPOOL_COUNT_USED_BLOCKS
+	atomic_fetch_sub_explicit(&pool->usedBlocks, 1, memory_order_relaxed);
+	#endif
+}
+
+/*
+** Free a block into the calling thread's magazine. If the
+** magazine is full, we return half of it to the pool first.
+*/
+void memPoolMagazineFree(memoryPoolConcurrent *const restrict pool, memoryMagazine *const restrict magazine, void *const restrict data){
+	*memPoolBlockFreeNextGetFlag(data) = MEMPOOL_FLAG_INACTIVE;
+	#ifdef MEMPOOL_COUNT_USED_BLOCKS
+	atomic_fetch_sub_explicit(
+		&pool->usedBlocks,
+		memoryMagazineFree(magazine, &pool->nextFreeBlock, pool->generation, data),
+		memory_order_relaxed
+	);
+	#else
+	memoryMagazineFree(magazine, &pool->nextFreeBlock, pool->generation, data);
+	#endif
+}
+
+/*
+** Return every block in the calling thread's magazine to the pool.
+** Threads should do this before they exit, as otherwise the blocks
+** can't be allocated again until the pool is cleared.
+*/
+void memPoolMagazineFlush(memoryPoolConcurrent *const restrict pool, memoryMagazine *const restrict magazine){
+	#ifdef MEMPOOL_COUNT_USED_BLOCKS
+	atomic_fetch_sub_explicit(
+		&pool->usedBlocks,
+		memoryMagazineFlush(magazine, &pool->nextFreeBlock, pool->generation),
+		memory_order_relaxed
+	);
+	#else
+	memoryMagazineFlush(magazine, &pool->nextFreeBlock, pool->generation);
+	#endif
+}
+
+/*
+** Clear every memory region in the allocator. This is not
+** thread-safe, but it empties every thread's magazine.
+*/
+void memPoolConcurrentClear(memoryPoolConcurrent *const restrict pool){
+	memoryFreeStackInit(&pool->nextFreeBlock, memPoolBlockFreeFlagGetNext(pool->region->start));
+	#ifdef MEMPOOL_COUNT_USED_BLOCKS
+	atomic_store_explicit(&pool->usedBlocks, 0, memory_order_relaxed);
+	#endif
+	pool->generation = memoryMagazineNewGeneration();
+
+	clearRegions(pool->blockSize, pool->region);
+}
+
+
+#ifdef MEMORYREGION_EXTEND_ALLOCATORS
+/*
+** Append a new memory region to the end of our allocator's region list!
+** Other threads may allocate and free blocks while this is happening,
+** but only one thread should be extending the pool at any given time.
+*/
+void *memPoolConcurrentExtend(memoryPoolConcurrent *const restrict pool, void *const restrict memory, const size_t memorySize){
+	if(memory != NULL){
+		memoryRegion *const newRegion = memoryGetRegionFromSize(memory, memorySize);
+		// Add the new region to the end of the list!
+		memoryRegionAppend(&pool->region, newRegion, memory);
+		// Set up its memory and add it to the free list. Other
+		// threads may have freed blocks since the pool filled up,
+		// so we need to link the new blocks to the front of the list.
+		memoryFreeStackPush(
+			&pool->nextFreeBlock, memPoolBlockFreeFlagGetNext(memory),
+			initRegion(pool->blockSize, newRegion)
+		);
+	}
+
+	return(memory);
+}
+#endif
+
+/*
+** Initialise every block in a region, setting the flag
+** to invalid and the last block's next pointer to NULL.
+** We return the data segment of the region's last block.
+*/
+static void *initRegion(const size_t blockSize, memoryRegion *const restrict region){
+	void *currentBlock = region->start;
+	void *nextBlock = memPoolBlockGetNextBlock(currentBlock, blockSize);
+
+	// Set the flag and next pointer for each block!
+	while(nextBlock < (void *)region){
+		//*memPoolBlockFreeNextGetFlag(currentBlock) = MEMPOOL_FLAG_INVALID;
+		//memPoolBlockFreeGetNext(currentBlock) = nextBlock;
+		memPoolBlockGetFlag(currentBlock) = MEMPOOL_FLAG_INVALID;
+		*memPoolBlockFreeFlagGetNext(currentBlock) = (void *)memPoolBlockFreeFlagGetNext(nextBlock);
+
+		currentBlock = nextBlock;
+		nextBlock = memPoolBlockGetNextBlock(currentBlock, blockSize);
+	}
+
+	// Set the flag and next pointer for the last block!
+	//*memPoolBlockFreeNextGetFlag(currentBlock) = MEMPOOL_FLAG_INVALID;
+	//memPoolBlockFreeGetNext(currentBlock) = NULL;
+	memPoolBlockGetFlag(currentBlock) = MEMPOOL_FLAG_INVALID;
+	*memPoolBlockFreeFlagGetNext(currentBlock) = NULL;
+
+	return(memPoolBlockFreeFlagGetNext(currentBlock));
+}
+
+/*
+** Reset the flags and next pointers of every
+** block in a sequence of memory regions.
+*/
+static void clearRegions(const size_t blockSize, memoryRegion *region){
 	// Loop through every region in the allocator.
 	for(;;){
 		memoryRegion *const nextRegion = region->next;
@@ -140,23 +320,4 @@ void memPoolClear(memoryPool *const restrict pool){
 		}
 		region = nextRegion;
 	}
-}
-
-
-#ifdef MEMORYREGION_EXTEND_ALLOCATORS
-// Append a new memory region to the end of our allocator's region list!
-void *memPoolExtend(memoryPool *const restrict pool, void *const restrict memory, const size_t memorySize){
-	if(memory != NULL){
-		memoryRegion *const newRegion = memoryGetRegionFromSize(memory, memorySize);
-		// Add the new region to the end of the list!
-		memoryRegionAppend(&pool->region, newRegion, memory);
-		//newRegion->start = memPoolBlockFreeFlagGetNext(memory);
-		// Set up its memory!
-		memPoolInitRegion(pool, newRegion);
-
-		pool->nextFreeBlock = (void *)memPoolBlockFreeFlagGetNext(memory);
-	}
-
-	return(memory);
-}
-#endif
\ No newline at end of file
+}
\ No newline at end of file
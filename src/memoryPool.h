@@ -169,6 +169,24 @@ typedef struct memoryPool {
 	memoryRegion *region;
 } memoryPool;
 
+// Concurrent pools use the same block layout, but their free list is
+// a lock-free stack, so any number of threads may allocate and free
+// blocks at once. Initialising and clearing the pool are not thread-
+// safe, and only one thread may extend the pool at any given time.
+typedef struct memoryPoolConcurrent {
+	size_t blockSize;
+	// Points to the data segment of the first free block.
+	memoryFreeStack nextFreeBlock;
+	#ifdef MEMPOOL_COUNT_USED_BLOCKS
+	// Blocks in threads' magazines are counted as used.
+	atomic_size_t usedBlocks;
+	#endif
+	// This changes whenever the pool is initialised or cleared.
+	size_t generation;
+
+	memoryRegion *region;
+} memoryPoolConcurrent;
+
 
 void memPoolInitRegion(memoryPool *const restrict pool, memoryRegion *const restrict region);
 void *memPoolInit(memoryPool *const restrict pool, void *const restrict memory, const size_t memorySize, const size_t blockSize);
@@ -182,5 +200,19 @@ void memPoolClear(memoryPool *const restrict pool);
 void *memPoolExtend(memoryPool *const restrict pool, void *const restrict memory, const size_t memorySize);
 #endif
 
+void *memPoolConcurrentInit(memoryPoolConcurrent *const restrict pool, void *const restrict memory, const size_t memorySize, const size_t blockSize);
+
+void *memPoolConcurrentAlloc(memoryPoolConcurrent *const restrict pool);
+void *memPoolMagazineAlloc(memoryPoolConcurrent *const restrict pool, memoryMagazine *const restrict magazine);
+
+void memPoolConcurrentFree(memoryPoolConcurrent *const restrict pool, void *const restrict data);
+void memPoolMagazineFree(memoryPoolConcurrent *const restrict pool, memoryMagazine *const restrict magazine, void *const restrict data);
+void memPoolMagazineFlush(memoryPoolConcurrent *const restrict pool, memoryMagazine *const restrict magazine);
+void memPoolConcurrentClear(memoryPoolConcurrent *const restrict pool);
+
+#ifdef MEMORYREGION_EXTEND_ALLOCATORS
+void *memPoolConcurrentExtend(memoryPoolConcurrent *const restrict pool, void *const restrict memory, const size_t memorySize);
+#endif
+
 
 #endif
\ No newline at end of file
@@ -24,6 +24,7 @@ void *memStackInit(memoryStack *const restrict stack, void *const restrict memor
 // Allocate a new block at the top of the stack!
 void *memStackAlloc(memoryStack *const restrict stack, const size_t blockSize){
 	void *const newBlock = stack->top;
+	size_t alignedBlockSize;
 	size_t actualBlockSize;
 
 	// Check for 0 byte allocations.
@@ -31,10 +32,12 @@ void *memStackAlloc(memoryStack *const restrict stack, const size_t blockSize){
 		return(NULL);
 	}
 
-	actualBlockSize = blockSize + MEMSTACK_BLOCK_FOOTER_SIZE;
+	// Make sure that the footer and the next block are aligned.
+	alignedBlockSize = (size_t)memoryAlign(blockSize);
+	actualBlockSize = alignedBlockSize + MEMSTACK_BLOCK_FOOTER_SIZE;
 	if(stack->size >= actualBlockSize){
 		// Store this block's size in its footer.
-		*memStackBlockGetNextBlockFooter(newBlock, blockSize) = blockSize;
+		*memStackBlockGetNextBlockFooter(newBlock, alignedBlockSize) = alignedBlockSize;
 
 		// Advance the stack's top pointer and update its size.
 		stack->top = memoryAddPointer(newBlock, actualBlockSize);
@@ -54,7 +57,22 @@ void memStackFreeLast(memoryStack *const restrict stack){
 	size_t *const lastBlockFooter = memStackBlockGetPrevBlockFooter(stack->top);
 	const size_t lastBlockSize = *lastBlockFooter;
 
-	// Move the top of the stack back and update its size.
-	stack->top = lastBlockFooter - lastBlockSize;
+	// Move the top of the stack back and update its size. The
+	// footer is a size_t pointer, so we can't subtract directly.
+	stack->top = memorySubPointer(lastBlockFooter, lastBlockSize);
 	stack->size += lastBlockSize + MEMSTACK_BLOCK_FOOTER_SIZE;
+}
+
+/*
+** Free every block allocated since "marker" was
+** returned by "memStackGetMarker" at once.
+*/
+void memStackFreeTo(memoryStack *const restrict stack, void *const restrict marker){
+	stack->size += (uintptr_t)stack->top - (uintptr_t)marker;
+	stack->top = marker;
+}
+
+// Free every block in the stack.
+void memStackClear(memoryStack *const restrict stack){
+	memStackFreeTo(stack, stack->bottom);
 }
\ No newline at end of file
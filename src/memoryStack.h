@@ -10,6 +10,8 @@
 
 // This is a nice abstraction for when we need to free a stack.
 #define memStackMemory(stack) ((stack)->bottom)
+// Every block above this point can be freed at once using "memStackFreeTo".
+#define memStackGetMarker(stack) ((stack)->top)
 
 
 // Example stack diagram:
@@ -30,6 +32,8 @@ void *memStackInit(memoryStack *const restrict stack, void *const restrict memor
 
 void *memStackAlloc(memoryStack *const restrict stack, const size_t blockSize);
 void memStackFreeLast(memoryStack *const restrict stack);
+void memStackFreeTo(memoryStack *const restrict stack, void *const restrict marker);
+void memStackClear(memoryStack *const restrict stack);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,630 @@
+#include "memoryTLSF.h"
+
+
+#ifdef MEMTLSF_DEBUG
+#include <stdio.h>
+#endif
+
+#include "utilTypes.h"
+
+
+#define MEMTLSF_FLAG_INACTIVE 0x00
+#define MEMTLSF_FLAG_ACTIVE   0x01
+#define MEMTLSF_FLAG_FIRST    0x02
+#define MEMTLSF_FLAG_LAST     0x04
+#define MEMTLSF_FLAG_ONLY     0x06
+
+// Get the next block's header from the current one's.
+#define blockGetNext(block, size) ((memTLSFBlockHeader *)memoryAddPointer(block, size))
+// Get the previous block's header from the current one's.
+#define blockGetPrev(block, size) ((memTLSFBlockHeader *)memorySubPointer(block, size))
+// Return the user's data, or the free list node if the block is inactive.
+#define blockGetData(block) memoryAddPointer(block, MEMTLSF_BLOCK_HEADER_SIZE)
+// Return a block's header from the user's data or its free list node.
+#define dataGetBlock(data) ((memTLSFBlockHeader *)memorySubPointer(data, MEMTLSF_BLOCK_HEADER_SIZE))
+
+// We'll need to remove the flags from the
+// size if we want to get its real value.
+#define blockGetSize(info) (((uintptr_t)(info)) & MEMORY_DATA_MASK)
+// The flags are stored in the three
+// least significant bits of the size.
+#define blockGetFlags(info) (((uintptr_t)(info)) & MEMORY_FLAG_MASK)
+// Set the size of a block without changing its flags.
+#define blockSetSize(info, size) ((size) | blockGetFlags(info))
+
+// Get the flag specified by "flag" from the block's information.
+#define blockGetFlag(info, flag) (((uintptr_t)(info)) & (flag))
+// Get whether or not this block is active.
+#define blockIsActive(info) blockGetFlag(info, MEMTLSF_FLAG_ACTIVE)
+// Get whether or not this block is the first.
+#define blockIsFirst(info) blockGetFlag(info, MEMTLSF_FLAG_FIRST)
+// Get whether or not this block is the last.
+#define blockIsLast(info) blockGetFlag(info, MEMTLSF_FLAG_LAST)
+
+// Write the flag specified by "flag" to the block's information.
+#define blockSetFlag(info, flag) ((info) | (flag))
+// Set the value of a block's active flag.
+#define blockMakeActive(info) blockSetFlag(info, MEMTLSF_FLAG_ACTIVE)
+// Set the value of a block's "last" flag.
+#define blockMakeLast(info) blockSetFlag(info, MEMTLSF_FLAG_LAST)
+// Remove the flag specified by "flag" from the block's information.
+#define blockRemoveFlag(info, flag) (((uintptr_t)(info)) & (~(flag)))
+// Remove the active flag from a block's information.
+#define blockRemoveActive(info) blockRemoveFlag(info, MEMTLSF_FLAG_ACTIVE)
+// Remove the "last" flag from a block's information.
+#define blockRemoveLast(info) blockRemoveFlag(info, MEMTLSF_FLAG_LAST)
+
+
+// Forward-declare any helper functions!
+static memTLSFBlockHeader *initRegion(void *const restrict memory, const size_t memorySize);
+static void clearLists(memoryTLSF *const restrict tlsf);
+
+static void splitBlock(memoryTLSF *const restrict tlsf, memTLSFBlockHeader *const restrict block, const size_t newSize);
+static size_t growBlock(memoryTLSF *const restrict tlsf, memTLSFBlockHeader *const restrict block, const size_t newSize);
+
+static void insertFreeBlock(memoryTLSF *const restrict tlsf, memTLSFBlockHeader *const restrict block);
+static void removeFreeBlock(memoryTLSF *const restrict tlsf, memTLSFBlockHeader *const restrict block);
+static void removeFreeNode(memoryTLSF *const restrict tlsf, memTLSFFreeNode *const restrict node, const size_t fl, const size_t sl);
+static memTLSFFreeNode *findFreeNode(const memoryTLSF *const restrict tlsf, size_t *const restrict fl, size_t *const restrict sl);
+
+static void mappingInsert(const size_t size, size_t *const restrict fl, size_t *const restrict sl);
+static void mappingSearch(size_t size, size_t *const restrict fl, size_t *const restrict sl);
+static unsigned int findFirstSet(const uint_least32_t bits);
+static unsigned int findLastSet(const size_t bits);
+
+
+void *memTLSFInit(memoryTLSF *const restrict tlsf, void *const restrict memory, const size_t memorySize){
+	// Make sure the user isn't being difficult.
+	if(memory != NULL){
+		const size_t regionSize = memoryGetRegionSize(memorySize);
+
+		// Set up the allocator's memory region footer.
+		tlsf->region = memoryGetRegionFromSize(memory, memorySize);
+		tlsf->region->start = memory;
+		tlsf->region->next = NULL;
+
+		// Create a free block to occupy all of the allocated memory.
+		clearLists(tlsf);
+		insertFreeBlock(tlsf, initRegion(memory, regionSize));
+	}
+
+	return(memory);
+}
+
+
+void *memTLSFAlloc(memoryTLSF *const restrict tlsf, const size_t blockSize){
+	size_t fullSize;
+	size_t fl;
+	size_t sl;
+	memTLSFFreeNode *node;
+
+	// Check for 0 byte allocations.
+	if(blockSize == 0){
+		return(NULL);
+	}
+
+	// Make sure the new block's size is neither too small nor misaligned.
+	fullSize = memTLSFGetBlockSize(blockSize) + MEMTLSF_BLOCK_HEADER_SIZE;
+	// Find the first non-empty size class whose
+	// blocks are all large enough for our data.
+	mappingSearch(fullSize, &fl, &sl);
+	node = findFreeNode(tlsf, &fl, &sl);
+
+	if(node != NULL){
+		memTLSFBlockHeader *const block = dataGetBlock(node);
+
+		// The largest size class has no upper bound, so
+		// its blocks aren't guaranteed to be large enough.
+		if(block->size < fullSize){
+			return(NULL);
+		}
+
+		removeFreeNode(tlsf, node, fl, sl);
+		block->prevSize = blockMakeActive(block->prevSize);
+		// Provided the leftover memory is large enough,
+		// create a new empty block after the current one.
+		splitBlock(tlsf, block, fullSize);
+	}
+
+	// The free list node is where the user's data starts, so we can
+	// just return it. If there were no free blocks, this is NULL.
+	return(node);
+}
+
+/*
+** Assuming "block" is not NULL, it will be resized to "blockSize".
+** Note that unlike realloc, this function will always resize the
+** block. Unlike memoryTree, we never merge with the block to the
+** left, so the user's data only has to be copied if we need to
+** allocate a new block. If that fails, the old block is untouched.
+*/
+void *memTLSFResize(memoryTLSF *const restrict tlsf, void *const restrict block, const size_t blockSize){
+	memTLSFBlockHeader *const oldBlock = dataGetBlock(block);
+	const size_t fullSize = memTLSFGetBlockSize(blockSize) + MEMTLSF_BLOCK_HEADER_SIZE;
+	const size_t oldSize = oldBlock->size;
+	void *newBlock;
+
+	// If the block is large enough, we can shrink it in place.
+	if(fullSize <= oldSize){
+		splitBlock(tlsf, oldBlock, fullSize);
+		return(block);
+	}
+	// Otherwise, try to take memory from the block to its right.
+	if(growBlock(tlsf, oldBlock, fullSize) >= fullSize){
+		return(block);
+	}
+
+	// If the block is still too small, we'll need to move the user's data.
+	newBlock = memTLSFAlloc(tlsf, blockSize);
+	if(newBlock != NULL){
+		memcpy(newBlock, block, oldSize - MEMTLSF_BLOCK_HEADER_SIZE);
+		memTLSFFree(tlsf, block);
+	}
+
+	return(newBlock);
+}
+
+/*
+** Reallocate a block to one with the size specified by "blockSize".
+** If the block is already large enough, we exit early. If no block
+** was specified, we allocate a new one.
+*/
+void *memTLSFRealloc(memoryTLSF *const restrict tlsf, void *const restrict block, const size_t blockSize){
+	if(block != NULL){
+		memTLSFBlockHeader *const oldBlock = dataGetBlock(block);
+		const size_t fullSize = memTLSFGetBlockSize(blockSize) + MEMTLSF_BLOCK_HEADER_SIZE;
+		const size_t oldSize = oldBlock->size;
+		void *newBlock;
+
+		// If the block is already big enough, we can exit early.
+		if(fullSize <= oldSize){
+			return(block);
+		}
+		// Otherwise, try to take memory from the block to its right.
+		if(growBlock(tlsf, oldBlock, fullSize) >= fullSize){
+			return(block);
+		}
+
+		// If the block is still too small, we'll need to move the user's data.
+		newBlock = memTLSFAlloc(tlsf, blockSize);
+		if(newBlock != NULL){
+			memcpy(newBlock, block, oldSize - MEMTLSF_BLOCK_HEADER_SIZE);
+			memTLSFFree(tlsf, block);
+		}
+
+		return(newBlock);
+	}
+
+	// If we're performing a realloc on a NULL
+	// pointer, just allocate a new block.
+	return(memTLSFAlloc(tlsf, blockSize));
+}
+
+
+void memTLSFFree(memoryTLSF *const restrict tlsf, void *const restrict block){
+	memTLSFBlockHeader *newBlock = dataGetBlock(block);
+	size_t newSize = newBlock->size;
+
+	// If this block is not the first, we might be able to merge left.
+	if(!blockIsFirst(newBlock->prevSize)){
+		memTLSFBlockHeader *const leftBlock = blockGetPrev(newBlock, blockGetSize(newBlock->prevSize));
+		// We can only merge it if the block to its left is free.
+		if(!blockIsActive(leftBlock->prevSize)){
+			// Remove the left block from its free list,
+			// as it's outdated. We'll add it back later.
+			removeFreeBlock(tlsf, leftBlock);
+
+			// Make sure we preserve the free block's "last" flag.
+			leftBlock->prevSize |= blockIsLast(newBlock->prevSize);
+			// We're merging the two blocks, so add their sizes.
+			newSize += leftBlock->size;
+			// The free block no longer exists as it has been merged,
+			// so our pointer should now point to the left block.
+			newBlock = leftBlock;
+		}
+	}
+	// If this block is not the last, we might be able to merge right.
+	if(!blockIsLast(newBlock->prevSize)){
+		memTLSFBlockHeader *const rightBlock = blockGetNext(newBlock, newSize);
+		// We can only merge it if the block to its right is free.
+		if(!blockIsActive(rightBlock->prevSize)){
+			// Remove the right block from its free
+			// list, as it no longer exists.
+			removeFreeBlock(tlsf, rightBlock);
+			// We're merging the two blocks, so add their sizes.
+			newSize += rightBlock->size;
+
+			// If there is a block after this one,
+			// update its previous size property.
+			if(!blockIsLast(rightBlock->prevSize)){
+				memTLSFBlockHeader *const nextBlock = blockGetNext(newBlock, newSize);
+				nextBlock->prevSize = blockSetSize(nextBlock->prevSize, newSize);
+
+			// Otherwise, make sure we preserve
+			// the right block's "last" flag.
+			}else{
+				newBlock->prevSize = blockMakeLast(newBlock->prevSize);
+			}
+
+		// Otherwise, update the block's previous size property.
+		}else{
+			rightBlock->prevSize = blockSetSize(rightBlock->prevSize, newSize);
+		}
+	}
+
+
+	// Make sure we make the free block
+	// inactive and update its size.
+	newBlock->prevSize = blockRemoveActive(newBlock->prevSize);
+	newBlock->size = newSize;
+	// Now that we've finished any coalescence,
+	// we can add our block to its free list!
+	insertFreeBlock(tlsf, newBlock);
+}
+
+// Free every block in every memory region used by the allocator.
+void memTLSFClear(memoryTLSF *const restrict tlsf){
+	memoryRegion *region = tlsf->region;
+
+	clearLists(tlsf);
+	// Create a free block to occupy all of each region's memory.
+	while(region != NULL){
+		const size_t regionSize = (size_t)((byte_t *)region - (byte_t *)region->start);
+		insertFreeBlock(tlsf, initRegion(region->start, regionSize));
+		region = region->next;
+	}
+}
+
+
+#ifdef MEMORYREGION_EXTEND_ALLOCATORS
+void *memTLSFExtend(memoryTLSF *const restrict tlsf, void *const restrict memory, const size_t memorySize){
+	if(memory != NULL){
+		const size_t regionSize = memoryGetRegionSize(memorySize);
+		memoryRegion *const newRegion = memoryGetRegionFromSize(memory, memorySize);
+
+		// Add the new region to the end of the list!
+		memoryRegionAppend(&tlsf->region, newRegion, memory);
+		// Create a free block to occupy all of the allocated memory.
+		insertFreeBlock(tlsf, initRegion(memory, regionSize));
+	}
+
+	return(memory);
+}
+#endif
+
+
+#ifdef MEMTLSF_DEBUG
+void memTLSFPrintAllSizes(memoryTLSF *const restrict tlsf){
+	memoryRegion *region = tlsf->region;
+	size_t regionNum = 0;
+
+	puts("MEMTLSF_DEBUG: All Blocks\n"
+	     "~~~~~~~~~~~~~~~~~~~~~~~~~");
+
+	// Loop through all of the memory regions that this allocator uses.
+	do {
+		memTLSFBlockHeader *block = (memTLSFBlockHeader *)(region->start);
+
+		// Print some details about the region.
+		printf(
+			"Region Number: "PRINTF_SIZE_T", Address: "PRINTF_SIZE_T", Start: "PRINTF_SIZE_T", Next: "PRINTF_SIZE_T"\n"
+			"-------------------------\n",
+			regionNum, (uintptr_t)region, (uintptr_t)(region->start), (uintptr_t)(region->next)
+		);
+
+		// Loop through all of the blocks in this region.
+		for(;;){
+			// If the block is active, we just print its size and flags.
+			if(blockIsActive(block->prevSize)){
+				printf(
+					"Used Address: "PRINTF_SIZE_T", Size: "PRINTF_SIZE_T", PrevSize: "PRINTF_SIZE_T", Flags: "PRINTF_SIZE_T"\n\n",
+					(uintptr_t)blockGetData(block),
+					block->size - MEMTLSF_BLOCK_HEADER_SIZE,
+					blockIsFirst(block->prevSize) ? 0 : (blockGetSize(block->prevSize) - MEMTLSF_BLOCK_HEADER_SIZE),
+					blockGetFlags(block->prevSize)
+				);
+
+			// Otherwise, we can print its free list data too!
+			}else{
+				const memTLSFFreeNode *const node = blockGetData(block);
+				printf(
+					"Free Address: "PRINTF_SIZE_T", Size: "PRINTF_SIZE_T", PrevSize: "PRINTF_SIZE_T", Flags: "PRINTF_SIZE_T",\n"
+					"Next: "PRINTF_SIZE_T", Prev: "PRINTF_SIZE_T"\n\n",
+					(uintptr_t)node, block->size - MEMTLSF_BLOCK_HEADER_SIZE,
+					blockIsFirst(block->prevSize) ? 0 : (blockGetSize(block->prevSize) - MEMTLSF_BLOCK_HEADER_SIZE), blockGetFlags(block->prevSize),
+					(uintptr_t)(node->next), (uintptr_t)(node->prev)
+				);
+			}
+
+			// If this block is the last, we've finished!
+			if(blockIsLast(block->prevSize)){
+				break;
+			}
+			// Otherwise, move to the next block!
+			block = blockGetNext(block, block->size);
+		}
+
+		// Now that we're done, move to the next region!
+		region = region->next;
+		++regionNum;
+	} while(region != NULL);
+}
+
+void memTLSFPrintFreeSizes(memoryTLSF *const restrict tlsf){
+	size_t fl;
+	size_t sl;
+
+	puts("MEMTLSF_DEBUG: Free Blocks\n"
+	     "~~~~~~~~~~~~~~~~~~~~~~~~~~");
+
+	for(fl = 0; fl < MEMTLSF_FL_INDEX_COUNT; ++fl){
+		for(sl = 0; sl < MEMTLSF_SL_INDEX_COUNT; ++sl){
+			const memTLSFFreeNode *node = tlsf->blocks[fl][sl];
+			if(node != NULL){
+				printf("Size Class: "PRINTF_SIZE_T", "PRINTF_SIZE_T"\n", fl, sl);
+				// Sizes include the block's header, so
+				// we need to remove that when we print it.
+				for(; node != NULL; node = node->next){
+					const memTLSFBlockHeader *const block = dataGetBlock(node);
+					printf(
+						"Free Address: "PRINTF_SIZE_T", Size: "PRINTF_SIZE_T", Flags: "PRINTF_SIZE_T",\n"
+						"Next: "PRINTF_SIZE_T", Prev: "PRINTF_SIZE_T"\n\n",
+						(uintptr_t)node, block->size - MEMTLSF_BLOCK_HEADER_SIZE, blockGetFlags(block->prevSize),
+						(uintptr_t)(node->next), (uintptr_t)(node->prev)
+					);
+				}
+			}
+		}
+	}
+}
+#endif
+
+
+// Create a single block that takes up all of the memory in the region.
+static memTLSFBlockHeader *initRegion(void *const restrict memory, const size_t memorySize){
+	((memTLSFBlockHeader *)memory)->prevSize = MEMTLSF_FLAG_ONLY;
+	((memTLSFBlockHeader *)memory)->size = memorySize;
+
+	return((memTLSFBlockHeader *)memory);
+}
+
+// Empty every free list.
+static void clearLists(memoryTLSF *const restrict tlsf){
+	tlsf->flBitmap = 0;
+	memset(tlsf->slBitmaps, 0, sizeof(tlsf->slBitmaps));
+	memset(tlsf->blocks, (uintptr_t)NULL, sizeof(tlsf->blocks));
+}
+
+
+/*
+** Shrink an active block to "newSize". If the leftover memory is
+** large enough, it becomes a new free block, which is merged with
+** the block after it if that block is also free.
+*/
+static void splitBlock(memoryTLSF *const restrict tlsf, memTLSFBlockHeader *const restrict block, const size_t newSize){
+	size_t sizeDiff = block->size - newSize;
+
+	// Make sure the difference in the current size and
+	// the ideal size is large enough for a new free block.
+	if(sizeDiff >= MEMTLSF_BLOCK_MIN_SIZE){
+		memTLSFBlockHeader *const freeBlock = blockGetNext(block, newSize);
+
+		// If the free block is the last, give
+		// it the used block's "last" flag.
+		if(blockIsLast(block->prevSize)){
+			block->prevSize = blockRemoveLast(block->prevSize);
+			freeBlock->prevSize = blockMakeLast(newSize);
+
+		// If this block isn't the last, we will have to
+		// set the previous size element of the next block.
+		}else{
+			memTLSFBlockHeader *nextBlock = blockGetNext(freeBlock, sizeDiff);
+
+			// We don't need to explicitly make the block inactive,
+			// since we would just be performing an OR with '0'.
+			freeBlock->prevSize = newSize;
+			// When a block is shrunk by resizing, the block after
+			// it might be free, in which case we should merge them.
+			if(!blockIsActive(nextBlock->prevSize)){
+				removeFreeBlock(tlsf, nextBlock);
+				sizeDiff += nextBlock->size;
+
+				if(blockIsLast(nextBlock->prevSize)){
+					freeBlock->prevSize = blockMakeLast(freeBlock->prevSize);
+				}else{
+					nextBlock = blockGetNext(freeBlock, sizeDiff);
+					nextBlock->prevSize = blockSetSize(nextBlock->prevSize, sizeDiff);
+				}
+			}else{
+				nextBlock->prevSize = blockSetSize(nextBlock->prevSize, sizeDiff);
+			}
+		}
+
+		// Set the size elements of the two blocks.
+		block->size = newSize;
+		freeBlock->size = sizeDiff;
+
+		// Add the new free block to its list!
+		insertFreeBlock(tlsf, freeBlock);
+	}
+}
+
+/*
+** Try to grow an active block to "newSize" by merging it with
+** the block to its right. The block is only modified if this
+** succeeds. Either way, we return the block's final size.
+*/
+static size_t growBlock(memoryTLSF *const restrict tlsf, memTLSFBlockHeader *const restrict block, const size_t newSize){
+	if(!blockIsLast(block->prevSize)){
+		memTLSFBlockHeader *const rightBlock = blockGetNext(block, block->size);
+		const size_t mergedSize = block->size + rightBlock->size;
+
+		if(!blockIsActive(rightBlock->prevSize) && mergedSize >= newSize){
+			removeFreeBlock(tlsf, rightBlock);
+
+			// If there is a block after this one,
+			// update its previous size property.
+			if(!blockIsLast(rightBlock->prevSize)){
+				memTLSFBlockHeader *const nextBlock = blockGetNext(block, mergedSize);
+				nextBlock->prevSize = blockSetSize(nextBlock->prevSize, mergedSize);
+
+			// Otherwise, make sure we preserve
+			// the right block's "last" flag.
+			}else{
+				block->prevSize = blockMakeLast(block->prevSize);
+			}
+			block->size = mergedSize;
+
+			// Give back whatever we don't need.
+			splitBlock(tlsf, block, newSize);
+		}
+	}
+
+	return(block->size);
+}
+
+
+// Add a free block to the front of its size class's list.
+static void insertFreeBlock(memoryTLSF *const restrict tlsf, memTLSFBlockHeader *const restrict block){
+	memTLSFFreeNode *const node = blockGetData(block);
+	memTLSFFreeNode *next;
+	size_t fl;
+	size_t sl;
+
+	mappingInsert(block->size, &fl, &sl);
+	next = tlsf->blocks[fl][sl];
+
+	node->next = next;
+	node->prev = NULL;
+	if(next != NULL){
+		next->prev = node;
+	}
+	tlsf->blocks[fl][sl] = node;
+
+	// Mark the size class as non-empty.
+	tlsf->flBitmap |= (uint_least32_t)1 << fl;
+	tlsf->slBitmaps[fl] |= (uint_least32_t)1 << sl;
+}
+
+// Remove a free block from its size class's list.
+static void removeFreeBlock(memoryTLSF *const restrict tlsf, memTLSFBlockHeader *const restrict block){
+	size_t fl;
+	size_t sl;
+
+	mappingInsert(block->size, &fl, &sl);
+	removeFreeNode(tlsf, blockGetData(block), fl, sl);
+}
+
+// Remove a node from the free list of the size class "fl" and "sl".
+static void removeFreeNode(memoryTLSF *const restrict tlsf, memTLSFFreeNode *const restrict node, const size_t fl, const size_t sl){
+	memTLSFFreeNode *const next = node->next;
+	memTLSFFreeNode *const prev = node->prev;
+
+	if(next != NULL){
+		next->prev = prev;
+	}
+	if(prev != NULL){
+		prev->next = next;
+
+	// If the node was the head of its list, we need
+	// to update it. If the list is now empty, we
+	// also have to clear the size class's bits.
+	}else{
+		tlsf->blocks[fl][sl] = next;
+		if(next == NULL){
+			tlsf->slBitmaps[fl] &= ~((uint_least32_t)1 << sl);
+			if(tlsf->slBitmaps[fl] == 0){
+				tlsf->flBitmap &= ~((uint_least32_t)1 << fl);
+			}
+		}
+	}
+}
+
+/*
+** Find the first free block in the smallest non-empty size class
+** that is at least as large as "fl" and "sl". This only requires
+** a couple of bit scans. The size class of the block we return
+** is written back to "fl" and "sl".
+*/
+static memTLSFFreeNode *findFreeNode(const memoryTLSF *const restrict tlsf, size_t *const restrict fl, size_t *const restrict sl){
+	// Check the second level lists of our first level class.
+	uint_least32_t slBitmap = tlsf->slBitmaps[*fl] & (~(uint_least32_t)0 << *sl);
+
+	// If they're all empty, we'll have to use a larger first level class.
+	if(slBitmap == 0){
+		const uint_least32_t flBitmap = tlsf->flBitmap & (~(uint_least32_t)0 << (*fl + 1));
+		if(flBitmap == 0){
+			return(NULL);
+		}
+
+		*fl = findFirstSet(flBitmap);
+		slBitmap = tlsf->slBitmaps[*fl];
+	}
+
+	*sl = findFirstSet(slBitmap);
+	return(tlsf->blocks[*fl][*sl]);
+}
+
+
+/*
+** Find the size class that a block of "size" bytes belongs to.
+** Small blocks are split linearly into the first level's lists,
+** and larger ones are split by their most significant bit, then
+** again linearly by the bits that follow it.
+*/
+static void mappingInsert(const size_t size, size_t *const restrict fl, size_t *const restrict sl){
+	if(size < MEMTLSF_SMALL_BLOCK_SIZE){
+		*fl = 0;
+		*sl = size >> MEMTLSF_ALIGNMENT_LOG2;
+	}else{
+		const unsigned int msb = findLastSet(size);
+
+		*fl = msb - (MEMTLSF_FL_INDEX_SHIFT - 1);
+		*sl = (size >> (msb - MEMTLSF_SL_INDEX_COUNT_LOG2)) ^ MEMTLSF_SL_INDEX_COUNT;
+		// Every block too large for the first level
+		// goes into the largest size class's list.
+		if(*fl >= MEMTLSF_FL_INDEX_COUNT){
+			*fl = MEMTLSF_FL_INDEX_COUNT - 1;
+			*sl = MEMTLSF_SL_INDEX_COUNT - 1;
+		}
+	}
+}
+
+/*
+** Find the smallest size class whose blocks are all at least
+** "size" bytes. We do this by rounding up to the next class,
+** so we never have to search through a list for a good fit.
+*/
+static void mappingSearch(size_t size, size_t *const restrict fl, size_t *const restrict sl){
+	if(size >= MEMTLSF_SMALL_BLOCK_SIZE){
+		size += ((size_t)1 << (findLastSet(size) - MEMTLSF_SL_INDEX_COUNT_LOG2)) - 1;
+	}
+	mappingInsert(size, fl, sl);
+}
+
+// Return the index of the least significant set bit. "bits" must be non-zero.
+static unsigned int findFirstSet(const uint_least32_t bits){
+	#ifdef __GNUC__
+	return(__builtin_ctzl((unsigned long)bits));
+	#else
+	unsigned int i = 0;
+	while(!(bits & ((uint_least32_t)1 << i))){
+		++i;
+	}
+	return(i);
+	#endif
+}
+
+// Return the index of the most significant set bit. "bits" must be non-zero.
+static unsigned int findLastSet(const size_t bits){
+	#ifdef __GNUC__
+	return(sizeof(unsigned long long)*8 - 1 - __builtin_clzll((unsigned long long)bits));
+	#else
+	unsigned int i = 0;
+	size_t shifted = bits;
+	while(shifted >>= 1){
+		++i;
+	}
+	return(i);
+	#endif
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef memoryTLSF_h
+#define memoryTLSF_h
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "settingsMemory.h"
+#include "utilMemory.h"
+
+
+// Each first level size class is split into this many
+// second level classes. This must be at most 5, as the
+// second level bitmaps are only guaranteed to have 32 bits.
+#ifndef MEMTLSF_SL_INDEX_COUNT_LOG2
+	#define MEMTLSF_SL_INDEX_COUNT_LOG2 4
+#endif
+// Blocks of at least 2^MEMTLSF_FL_INDEX_MAX bytes
+// all share the largest size class's free list.
+#ifndef MEMTLSF_FL_INDEX_MAX
+	#if UINTPTR_MAX == UINT32_MAX
+		#define MEMTLSF_FL_INDEX_MAX 30
+	#else
+		#define MEMTLSF_FL_INDEX_MAX 32
+	#endif
+#endif
+
+#define MEMTLSF_ALIGNMENT_LOG2 3
+#define MEMTLSF_SL_INDEX_COUNT (1 << MEMTLSF_SL_INDEX_COUNT_LOG2)
+// Blocks smaller than this are all put in the first
+// first level class, which is split into linear steps.
+#define MEMTLSF_FL_INDEX_SHIFT (MEMTLSF_SL_INDEX_COUNT_LOG2 + MEMTLSF_ALIGNMENT_LOG2)
+#define MEMTLSF_FL_INDEX_COUNT (MEMTLSF_FL_INDEX_MAX - MEMTLSF_FL_INDEX_SHIFT + 1)
+#define MEMTLSF_SMALL_BLOCK_SIZE (1 << MEMTLSF_FL_INDEX_SHIFT)
+
+#define MEMTLSF_BLOCK_HEADER_SIZE sizeof(memTLSFBlockHeader)
+#define MEMTLSF_BLOCK_MIN_BODY_SIZE ((uintptr_t)memoryAlign(sizeof(memTLSFFreeNode)))
+#define MEMTLSF_BLOCK_MIN_SIZE (MEMTLSF_BLOCK_HEADER_SIZE + MEMTLSF_BLOCK_MIN_BODY_SIZE)
+
+#define memTLSFRegionStart(region) (((memoryRegion *)(region))->start)
+
+// Return the minimum block size for an element of "size" bytes.
+#define memTLSFGetBlockSize(size) ((size_t)memoryAlign( \
+	((size) > MEMTLSF_BLOCK_MIN_BODY_SIZE) ? (size) : MEMTLSF_BLOCK_MIN_BODY_SIZE \
+))
+// Return the amount of memory required for a
+// TLSF allocator with "size" many usable bytes.
+#define memTLSFMemoryForSize(size) memoryGetRequiredSize(size)
+// Return the number of usable bytes in an active block.
+#define memTLSFBlockGetSize(block) \
+	(((memTLSFBlockHeader *)memorySubPointer(block, MEMTLSF_BLOCK_HEADER_SIZE))->size - MEMTLSF_BLOCK_HEADER_SIZE)
+
+
+// Block data usage diagrams:
+// Used:      [header][           data           ]
+// Free:      [header][node][        fill        ]
+// Header:    [prevSize][size]
+// Free Node: [next][prev]
+
+/* This is a two-level segregated fit allocator. Rather  */
+/* than searching a tree for the best fitting free block */
+/* like memoryTree, free blocks are sorted into lists by */
+/* their size. The first level splits sizes by powers of */
+/* two and the second level splits each of these ranges  */
+/* linearly. A pair of bitmaps tracks which lists have   */
+/* free blocks, so finding, inserting and removing free  */
+/* blocks only takes a few bit operations.               */
+/*                                                       */
+/* The blocks themselves are laid out exactly like those */
+/* of memoryTree, so the flags in "prevSize" work in the */
+/* same way and blocks are merged with their neighbours  */
+/* as soon as they're freed.                             */
+
+
+typedef struct memTLSFBlockHeader {
+	// Note that these sizes include the block's header.
+	// The "prevSize" element also includes flags in
+	// the last three bits specifying if it's active,
+	// if it's the first block in the allocator and
+	// if it's the last block in the allocator.
+	size_t prevSize;
+	size_t size;
+} memTLSFBlockHeader;
+
+// Free blocks of the same size class are kept in a doubly linked list.
+typedef struct memTLSFFreeNode memTLSFFreeNode;
+typedef struct memTLSFFreeNode {
+	memTLSFFreeNode *next;
+	memTLSFFreeNode *prev;
+} memTLSFFreeNode;
+
+
+typedef struct memoryTLSF {
+	// Bit "i" of the first level bitmap is set if any of
+	// the second level lists in "blocks[i]" are non-empty.
+	uint_least32_t flBitmap;
+	uint_least32_t slBitmaps[MEMTLSF_FL_INDEX_COUNT];
+	// The first free block in each size class.
+	memTLSFFreeNode *blocks[MEMTLSF_FL_INDEX_COUNT][MEMTLSF_SL_INDEX_COUNT];
+
+	// This is stored at the very end of the allocated memory,
+	// meaning it can be used as a pointer to the end. The
+	// structure contains a pointer to the start of the region
+	// as well as a pointer to the extension that follows it.
+	memoryRegion *region;
+} memoryTLSF;
+
+
+void *memTLSFInit(memoryTLSF *const restrict tlsf, void *const restrict memory, const size_t memorySize);
+
+void *memTLSFAlloc(memoryTLSF *const restrict tlsf, const size_t blockSize);
+void *memTLSFResize(memoryTLSF *const restrict tlsf, void *const restrict block, const size_t blockSize);
+void *memTLSFRealloc(memoryTLSF *const restrict tlsf, void *const restrict block, const size_t blockSize);
+
+void memTLSFFree(memoryTLSF *const restrict tlsf, void *const restrict block);
+void memTLSFClear(memoryTLSF *const restrict tlsf);
+
+#ifdef MEMORYREGION_EXTEND_ALLOCATORS
+void *memTLSFExtend(memoryTLSF *const restrict tlsf, void *const restrict memory, const size_t memorySize);
+#endif
+
+#ifdef MEMTLSF_DEBUG
+void memTLSFPrintAllSizes(memoryTLSF *const restrict tlsf);
+void memTLSFPrintFreeSizes(memoryTLSF *const restrict tlsf);
+#endif
+
+
+#endif
\ No newline at end of file
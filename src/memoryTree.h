@@ -21,6 +21,9 @@
 // Return the amount of memory required for a
 // memory tree with "size" many usable bytes.
 #define memTreeMemoryForSize(size) memoryGetRequiredSize(size)
+// Return the number of usable bytes in an active block.
+#define memTreeBlockGetSize(block) \
+	(((memTreeListNode *)memorySubPointer(block, MEMTREE_BLOCK_HEADER_SIZE))->size - MEMTREE_BLOCK_HEADER_SIZE)
 
 
 // Block data usage diagrams:
@@ -5,8 +5,8 @@
 
 
 // aabbNode
-moduleDefinePool(PhysicsAABBNode, aabbNode, g_aabbNodeManager, MODULE_AABBNODE_MANAGER_SIZE)
-moduleDefinePoolFree(PhysicsAABBNode, aabbNode, g_aabbNodeManager)
+moduleDefinePoolConcurrent(PhysicsAABBNode, aabbNode, g_aabbNodeManager, MODULE_AABBNODE_MANAGER_SIZE)
+moduleDefinePoolFreeConcurrent(PhysicsAABBNode, aabbNode, g_aabbNodeManager)
 // physicsContactPair
 moduleDefineDoubleList(
 	PhysicsContactPair, physicsContactPair,
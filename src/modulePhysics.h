@@ -58,8 +58,8 @@
 
 
 // aabbNode
-moduleDeclarePool(PhysicsAABBNode, aabbNode, g_aabbNodeManager)
-moduleDeclarePoolFree(PhysicsAABBNode, aabbNode)
+moduleDeclarePoolConcurrent(PhysicsAABBNode, aabbNode, g_aabbNodeManager)
+moduleDeclarePoolFreeConcurrent(PhysicsAABBNode, aabbNode)
 // physicsContactPair
 moduleDeclareDoubleList(PhysicsContactPair, physicsContactPair, g_physContactPairManager)
 moduleDeclareDoubleListFree(PhysicsContactPair, physicsContactPair)
@@ -2,6 +2,9 @@
 #define moduleShared_h
 
 
+#include "thread.h"
+
+
 /*
 ** These function macros allow us to declare
 ** prototypes for custom module functions.
@@ -17,6 +20,19 @@
 	void module##name##Clear();                            \
 	void module##name##Delete();
 
+// Concurrent pool allocators. Their allocation and
+// free functions may be called from any thread, and
+// each thread keeps a magazine of recently freed blocks.
+#define moduleDeclarePoolConcurrent(name, type, manager) \
+	return_t module##name##Init();                       \
+	type *module##name##Alloc();                         \
+	extern memoryPoolConcurrent manager;
+#define moduleDeclarePoolFreeConcurrent(name, type)        \
+	void module##name##Free(type *const restrict element); \
+	void module##name##Flush();                            \
+	void module##name##Clear();                            \
+	void module##name##Delete();
+
 // Single list allocators.
 #define moduleDeclareSingleList(name, type, manager)                                         \
 	return_t module##name##Init();                                                           \
@@ -49,6 +65,37 @@
 	void module##name##Clear();                                                         \
 	void module##name##Delete();
 
+/*
+** These declare thread-safe variants of the allocation and free
+** functions above. They only guard the module's allocator, so
+** the lists passed to them must not be shared between threads.
+*/
+
+// Pool allocators.
+#define moduleDeclarePoolSafe(name, type) \
+	type *module##name##AllocSafe();
+#define moduleDeclarePoolFreeSafe(name, type) \
+	void module##name##FreeSafe(type *const restrict element);
+
+// Single list allocators.
+#define moduleDeclareSingleListSafe(name, type)                                                  \
+	type *module##name##AllocSafe();                                                             \
+	type *module##name##PrependSafe(type **const restrict start);                                \
+	type *module##name##AppendSafe(type **const restrict start);                                 \
+	type *module##name##InsertAfterSafe(type **const restrict start, type *const restrict prev);
+#define moduleDeclareSingleListFreeSafe(name, type) \
+	void module##name##FreeSafe(type **const restrict start, type *const restrict element, type *const restrict prev);
+
+// Double list allocators.
+#define moduleDeclareDoubleListSafe(name, type)                                                   \
+	type *module##name##AllocSafe();                                                              \
+	type *module##name##PrependSafe(type **const restrict start);                                 \
+	type *module##name##AppendSafe(type **const restrict start);                                  \
+	type *module##name##InsertBeforeSafe(type **const restrict start, type *const restrict next); \
+	type *module##name##InsertAfterSafe(type **const restrict start, type *const restrict prev);
+#define moduleDeclareDoubleListFreeSafe(name, type) \
+	void module##name##FreeSafe(type **const restrict start, type *const restrict element);
+
 /*
 ** Assuming function prototypes have been created using
 ** the macros above, these macros provide the definitions.
@@ -132,6 +179,100 @@
 		memoryManagerGlobalDeleteRegions(manager.region);       \
 	}
 
+// Concurrent pool allocators. When the pool is full, only
+// one thread may extend it, so this is guarded by a lock.
+#ifndef MEMORYREGION_EXTEND_ALLOCATORS
+#define moduleDefinePoolConcurrent(name, type, manager, size)          \
+	memoryPoolConcurrent manager;                                      \
+	static _Thread_local memoryMagazine manager##Magazine;             \
+                                                                       \
+	return_t module##name##Init(){                                     \
+		return(                                                        \
+			memPoolConcurrentInit(                                     \
+				&manager,                                              \
+				memoryManagerGlobalAlloc(memoryGetRequiredSize(size)), \
+				memoryGetRequiredSize(size), sizeof(type)              \
+			) != NULL                                                  \
+		);                                                             \
+	}                                                                  \
+                                                                       \
+	type *module##name##Alloc(){                                       \
+		return(memPoolMagazineAlloc(&manager, &manager##Magazine));    \
+	}
+#else
+#define moduleDefinePoolConcurrent(name, type, manager, size)                \
+	memoryPoolConcurrent manager;                                            \
+	static _Thread_local memoryMagazine manager##Magazine;                   \
+	static threadSpinlock manager##Lock = THREAD_SPINLOCK_INIT;              \
+                                                                             \
+	return_t module##name##Init(){                                           \
+		return(                                                              \
+			memPoolConcurrentInit(                                           \
+				&manager,                                                    \
+				memoryManagerGlobalAlloc(memoryGetRequiredSize(size)),       \
+				memoryGetRequiredSize(size), sizeof(type)                    \
+			) != NULL                                                        \
+		);                                                                   \
+	}                                                                        \
+                                                                             \
+	type *module##name##Alloc(){                                             \
+		type *newBlock = memPoolMagazineAlloc(&manager, &manager##Magazine); \
+		if(newBlock == NULL){                                                \
+			threadSpinlockLock(&manager##Lock);                              \
+			/* Another thread may have extended the pool already. */         \
+			newBlock = memPoolConcurrentAlloc(&manager);                     \
+			if(newBlock == NULL && memPoolConcurrentExtend(                  \
+				&manager,                                                    \
+				memoryManagerGlobalAlloc(memoryGetRequiredSize(size)),       \
+				memoryGetRequiredSize(size)                                  \
+			)){                                                              \
+				newBlock = memPoolConcurrentAlloc(&manager);                 \
+			}                                                                \
+			threadSpinlockUnlock(&manager##Lock);                            \
+		}                                                                    \
+		return(newBlock);                                                    \
+	}
+#endif
+#define moduleDefinePoolFreeConcurrent(name, type, manager)         \
+	void module##name##Free(type *const restrict element){          \
+		memPoolMagazineFree(&manager, &manager##Magazine, element); \
+	}                                                               \
+                                                                    \
+	void module##name##Flush(){                                     \
+		memPoolMagazineFlush(&manager, &manager##Magazine);         \
+	}                                                               \
+                                                                    \
+	void module##name##Clear(){                                     \
+		memPoolConcurrentClear(&manager);                           \
+	}                                                               \
+                                                                    \
+	void module##name##Delete(){                                    \
+		memoryManagerGlobalDeleteRegions(manager.region);           \
+	}
+#define moduleDefinePoolFreeFlexibleConcurrent(name, type, manager, func) \
+	void module##name##Free(type *const restrict element){                \
+		func(element);                                                    \
+		memPoolMagazineFree(&manager, &manager##Magazine, element);       \
+	}                                                                     \
+                                                                          \
+	void module##name##Flush(){                                           \
+		memPoolMagazineFlush(&manager, &manager##Magazine);               \
+	}                                                                     \
+                                                                          \
+	void module##name##Clear(){                                           \
+		MEMPOOL_LOOP_BEGIN(manager, i, type)                              \
+			module##name##Free(i);                                        \
+		MEMPOOL_LOOP_END(manager, i)                                      \
+		memPoolConcurrentClear(&manager);                                 \
+	}                                                                     \
+                                                                          \
+	void module##name##Delete(){                                          \
+		MEMPOOL_LOOP_BEGIN(manager, i, type)                              \
+			module##name##Free(i);                                        \
+		MEMPOOL_LOOP_END(manager, i)                                      \
+		memoryManagerGlobalDeleteRegions(manager.region);                 \
+	}
+
 // Single list allocators.
 #ifndef MEMORYREGION_EXTEND_ALLOCATORS
 #define moduleDefineSingleList(name, type, manager, size)                                    \
@@ -470,5 +611,109 @@
 		memoryManagerGlobalDeleteRegions(manager.region);                               \
 	}
 
+/*
+** These define the thread-safe variants, which just call the
+** regular functions while holding the module's spinlock. The
+** "Safe" definition creates the lock, so it should come before
+** any of the "FreeSafe" definitions. If a module uses a custom
+** free function, it must not free elements from the same module.
+*/
+
+// Call "func" while holding the module's lock.
+#define moduleLockedCall(manager, result, func) \
+	threadSpinlockLock(&manager##Lock);         \
+	result = func;                              \
+	threadSpinlockUnlock(&manager##Lock);
+
+// Pool allocators.
+#define moduleDefinePoolSafe(name, type, manager)                         \
+	static threadSpinlock manager##Lock = THREAD_SPINLOCK_INIT;           \
+                                                                          \
+	type *module##name##AllocSafe(){                                      \
+		type *newBlock;                                                   \
+		moduleLockedCall(manager, newBlock, module##name##Alloc())        \
+		return(newBlock);                                                 \
+	}
+#define moduleDefinePoolFreeSafe(name, type, manager)          \
+	void module##name##FreeSafe(type *const restrict element){ \
+		threadSpinlockLock(&manager##Lock);                    \
+		module##name##Free(element);                           \
+		threadSpinlockUnlock(&manager##Lock);                  \
+	}
+
+// Single list allocators.
+#define moduleDefineSingleListSafe(name, type, manager)                                              \
+	static threadSpinlock manager##Lock = THREAD_SPINLOCK_INIT;                                      \
+                                                                                                     \
+	type *module##name##AllocSafe(){                                                                 \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##Alloc())                                   \
+		return(newBlock);                                                                            \
+	}                                                                                                \
+                                                                                                     \
+	type *module##name##PrependSafe(type **const restrict start){                                    \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##Prepend(start))                            \
+		return(newBlock);                                                                            \
+	}                                                                                                \
+                                                                                                     \
+	type *module##name##AppendSafe(type **const restrict start){                                     \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##Append(start))                             \
+		return(newBlock);                                                                            \
+	}                                                                                                \
+                                                                                                     \
+	type *module##name##InsertAfterSafe(type **const restrict start, type *const restrict prev){     \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##InsertAfter(start, prev))                  \
+		return(newBlock);                                                                            \
+	}
+#define moduleDefineSingleListFreeSafe(name, type, manager)                                                            \
+	void module##name##FreeSafe(type **const restrict start, type *const restrict element, type *const restrict prev){ \
+		threadSpinlockLock(&manager##Lock);                                                                            \
+		module##name##Free(start, element, prev);                                                                      \
+		threadSpinlockUnlock(&manager##Lock);                                                                          \
+	}
+
+// Double list allocators.
+#define moduleDefineDoubleListSafe(name, type, manager)                                              \
+	static threadSpinlock manager##Lock = THREAD_SPINLOCK_INIT;                                      \
+                                                                                                     \
+	type *module##name##AllocSafe(){                                                                 \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##Alloc())                                   \
+		return(newBlock);                                                                            \
+	}                                                                                                \
+                                                                                                     \
+	type *module##name##PrependSafe(type **const restrict start){                                    \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##Prepend(start))                            \
+		return(newBlock);                                                                            \
+	}                                                                                                \
+                                                                                                     \
+	type *module##name##AppendSafe(type **const restrict start){                                     \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##Append(start))                             \
+		return(newBlock);                                                                            \
+	}                                                                                                \
+                                                                                                     \
+	type *module##name##InsertBeforeSafe(type **const restrict start, type *const restrict next){    \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##InsertBefore(start, next))                 \
+		return(newBlock);                                                                            \
+	}                                                                                                \
+                                                                                                     \
+	type *module##name##InsertAfterSafe(type **const restrict start, type *const restrict prev){     \
+		type *newBlock;                                                                              \
+		moduleLockedCall(manager, newBlock, module##name##InsertAfter(start, prev))                  \
+		return(newBlock);                                                                            \
+	}
+#define moduleDefineDoubleListFreeSafe(name, type, manager)                                 \
+	void module##name##FreeSafe(type **const restrict start, type *const restrict element){ \
+		threadSpinlockLock(&manager##Lock);                                                 \
+		module##name##Free(start, element);                                                 \
+		threadSpinlockUnlock(&manager##Lock);                                               \
+	}
+
 
 #endif
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "particleSystemNodeContainer.h"
 
 #include "memoryManager.h"
+#include "memoryArena.h"
 #include "moduleParticle.h"
 
 
@@ -222,8 +223,10 @@ void particleSysNodePresort(
 		return_t sorted = 1;
 
 		// Particles are pretty big, so it's more efficient
-		// to first sort an array of smaller key-values.
-		keyValue *const keyValues = memoryManagerGlobalAlloc(
+		// to first sort an array of smaller key-values. We
+		// only need them until we return, so we use the arena.
+		const memArenaMarker marker = memArenaThreadGetMarker();
+		keyValue *const keyValues = memArenaThreadAlloc(
 			sizeof(*keyValues) * manager.numParticles
 		);
 		if(keyValues == NULL){
@@ -277,14 +280,13 @@ void particleSysNodePresort(
 					particleSubsysUpdateParentPointers(&curParticle->subsys);
 				}
 			}
-			memoryManagerGlobalFree(keyValues);
 			memoryManagerGlobalFree(node->manager.particles);
 
 			// Overwrite the original array of particles with the new sorted array.
 			node->manager.particles = sortedArray;
 		}
 
-		memoryManagerGlobalFree(keyValues);
+		memArenaThreadRollback(&marker);
 	}
 }
 
@@ -311,8 +313,9 @@ keyValue *const void particleSysNodeSort(
 	return_t sorted = 1;
 
 	// Particles are pretty big, so it's more efficient
-	// to first sort an array of smaller key-values.
-	keyValue *const keyValues = memoryManagerGlobalAlloc(
+	// to first sort an array of smaller key-values. The
+	// renderer only needs these for the current frame.
+	keyValue *const keyValues = memArenaThreadAlloc(
 		sizeof(*keyValues) * manager.numParticles
 	);
 	if(keyValues == NULL){
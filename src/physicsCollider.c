@@ -26,6 +26,7 @@ void physColliderInit(physicsCollider *const restrict pc, const colliderType typ
 
 	pc->owner = NULL;
 	pc->node = NULL;
+	pc->key = 0;
 
 	pc->contacts = NULL;
 	pc->separations = NULL;
@@ -48,6 +49,7 @@ void physColliderInstantiate(physicsCollider *const restrict pc, const physicsCo
 
 	pc->owner = owner;
 	pc->node = NULL;
+	pc->key = 0;
 
 	pc->contacts = NULL;
 	pc->separations = NULL;
@@ -74,9 +76,9 @@ void physColliderUpdate(physicsCollider *const restrict collider){
 */
 return_t physColliderPermitCollision(const physicsCollider *const colliderA, const physicsCollider *const colliderB){
 	// We only want to run the narrowphase on two colliders once,
-	// so we do it when "colliderA" has the greater address.
+	// so we do it when "colliderA" has the greater key.
 	return(
-		colliderA > colliderB && (
+		colliderA->key > colliderB->key && (
 			// Either collider A should be on a layer that
 			// collider B collides with or vice versa.
 			(colliderA->layer & colliderB->mask) |
@@ -91,9 +93,9 @@ return_t physColliderPermitCollision(const physicsCollider *const colliderA, con
 ** If such a contact could not be found, a NULL pointer is returned.
 **
 ** We don't need to loop through every contact, as our linked lists
-** are sorted according to the address of the second collider involved
-** in the collision. If we find a pair whose second collider's address
-** is greater than "colliderB", we can exit early.
+** are sorted according to the key of the second collider involved
+** in the collision. If we find a pair whose second collider's key
+** is greater than that of "colliderB", we can exit early.
 */
 physicsContactPair *physColliderFindContact(
 	const physicsCollider *const restrict colliderA, const physicsCollider *const restrict colliderB,
@@ -108,7 +110,7 @@ physicsContactPair *physColliderFindContact(
 	//
 	// That is, search for a matching contact or
 	// the first onethat "colliderA" doesn't own.
-	while(curPair != NULL && colliderB >= curPair->cB){
+	while(curPair != NULL && colliderB->key >= curPair->cB->key){
 		// If the pair we ended on involves our colliders, return it!
 		if(curPair->cB == colliderB){
 			*prev = prevPair;
@@ -130,9 +132,9 @@ physicsContactPair *physColliderFindContact(
 ** If such a separation could not be found, a NULL pointer is returned.
 **
 ** We don't need to loop through every separation, as our linked lists
-** are sorted according to the address of the second collider involved
-** in the collision. If we find a pair whose second collider's address
-** is greater than "colliderB", we can exit early.
+** are sorted according to the key of the second collider involved
+** in the collision. If we find a pair whose second collider's key
+** is greater than that of "colliderB", we can exit early.
 */
 physicsSeparationPair *physColliderFindSeparation(
 	const physicsCollider *const restrict colliderA, const physicsCollider *const restrict colliderB,
@@ -147,7 +149,7 @@ physicsSeparationPair *physColliderFindSeparation(
 	//
 	// That is, search for a matching separation or
 	// the first onethat "colliderA" doesn't own.
-	while(curPair != NULL && colliderB >= curPair->cB){
+	while(curPair != NULL && colliderB->key >= curPair->cB->key){
 		// If the pair we ended on involves our colliders, return it!
 		if(curPair->cB == colliderB){
 			*prev = prevPair;
@@ -164,6 +166,24 @@ physicsSeparationPair *physColliderFindSeparation(
 }
 
 
+/*
+** Mark all of a physics collider's contact and separation
+** pairs as active, so they survive the next island update.
+*/
+void physColliderRefreshPairs(physicsCollider *const restrict collider){
+	physicsContactPair *contact = collider->contacts;
+	physicsSeparationPair *separation = collider->separations;
+
+	while(contact != NULL){
+		physPairRefresh(contact);
+		contact = (collider == contact->cA) ? contact->nextA : contact->nextB;
+	}
+	while(separation != NULL){
+		physPairRefresh(separation);
+		separation = (collider == separation->cA) ? separation->nextA : separation->nextB;
+	}
+}
+
 /*
 ** Clear all of a physics collider's contact and separation pairs.
 ** Note that islands should control the constraints for colliders,
@@ -6,6 +6,7 @@
 
 #include "collider.h"
 #include "physicsContact.h"
+#include "physicsJoint.h"
 #include "aabbTree.h"
 
 #include "utilTypes.h"
@@ -32,6 +33,7 @@
 
 
 typedef uint_least16_t physicsColliderLayer;
+typedef uint_least32_t physColliderKey;
 
 typedef struct physicsRigidBody physicsRigidBody;
 typedef struct physicsCollider {
@@ -54,11 +56,16 @@ typedef struct physicsCollider {
 	// collider has been instantiated.
 	physicsRigidBody *owner;
 	aabbNode *node;
+	// Islands give each collider a unique key when it's inserted.
+	// Pairs are ordered using these rather than the colliders'
+	// addresses, so the simulation doesn't depend on where the
+	// colliders happen to have been allocated.
+	physColliderKey key;
 
 	// Colliders store doubly linked lists of active contacts and
 	// separations. These lists are mostly sorted according to the
-	// addresses of the second collider involved in the contact or
-	// separation. Check the explanation given in "physicsConstraintPair.h".
+	// keys of the second collider involved in the contact or
+	// separation. Check the explanation given in "physicsContact.h".
 	//
 	// Note that the list is actually allocated and managed by the
 	// island, this just stores a pointer to the collider's first joint.
@@ -87,6 +94,7 @@ physicsSeparationPair *physColliderFindSeparation(
 	const physicsCollider *const restrict colliderA, const physicsCollider *const restrict colliderB,
 	physicsSeparationPair **const restrict prev, physicsSeparationPair **const restrict next
 );
+void physColliderRefreshPairs(physicsCollider *const restrict collider);
 void physColliderClearPairs(physicsCollider *const restrict collider);
 
 void physColliderDeleteInstance(physicsCollider *const restrict collider);
@@ -11,6 +11,28 @@
 #include "physicsRigidBody.h"
 #include "physicsCollider.h"
 
+#include "memoryManager.h"
+
+
+#ifdef PHYSCONTACT_SOLVER_SIMD
+#include <xmmintrin.h>
+
+// A vector for each of a block's lanes.
+typedef struct vec3Lanes {
+	__m128 x;
+	__m128 y;
+	__m128 z;
+} vec3Lanes;
+
+// The solver bodies used by each of a block's lanes.
+typedef struct solverBodyLanes {
+	vec3Lanes linearVelocity;
+	vec3Lanes angularVelocity;
+	__m128 invMass;
+	__m128 invInertiaGlobal[3][3];
+} solverBodyLanes;
+#endif
+
 
 /*
 ** ----------------------------------------------------------------------
@@ -130,7 +152,7 @@ static void calculateInverseEffectiveMass(
 	const physicsManifold *const restrict pm, physicsContactPoint *const restrict contact,
 	const physicsRigidBody *const restrict bodyA, const physicsRigidBody *const restrict bodyB
 );
-#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 static void calculateBias(
 	const physicsManifold *const restrict pm, physicsContactPoint *const restrict contact,
 	const physicsRigidBody *const restrict bodyA, const physicsRigidBody *const restrict bodyB,
@@ -161,6 +183,37 @@ float solvePosition(
 );
 #endif
 
+#ifdef PHYSCONTACT_PACKED_SOLVER
+static physicsSolverBody *getSolverBody(physicsSolverBody *const restrict bodies, const size_t index, physicsSolverBody *const restrict staticBody);
+static void solverBodyRelativeVelocity(
+	const physicsSolverBody *const restrict bodyA, const physicsSolverBody *const restrict bodyB,
+	const vec3 *const restrict rA, const vec3 *const restrict rB, vec3 *const restrict out
+);
+static void solverBodyApplyImpulse(
+	physicsSolverBody *const restrict bodyA, physicsSolverBody *const restrict bodyB,
+	const vec3 *const restrict rA, const vec3 *const restrict rB, const vec3 *const restrict J
+);
+#endif
+#ifdef PHYSCONTACT_SOLVER_SIMD
+static void loadVec3Lanes(const float *const restrict v, vec3Lanes *const restrict out);
+static __m128 vec3LanesDot(const vec3Lanes *const restrict v1, const vec3Lanes *const restrict v2);
+static void vec3LanesCross(const vec3Lanes *const restrict v1, const vec3Lanes *const restrict v2, vec3Lanes *const restrict out);
+static void solverBodyLanesInertia(const solverBodyLanes *const restrict body, const vec3Lanes *const restrict v, vec3Lanes *const restrict out);
+static void gatherSolverBodyLanes(const physicsSolverBody *const restrict bodies, const size_t *const restrict indices, solverBodyLanes *const restrict out);
+static void scatterSolverBodyLanes(
+	const solverBodyLanes *const restrict body, const size_t *const restrict indices,
+	const size_t numLanes, physicsSolverBody *const restrict bodies
+);
+static void solverBodyLanesRelativeVelocity(
+	const solverBodyLanes *const restrict bodyA, const solverBodyLanes *const restrict bodyB,
+	const vec3Lanes *const restrict rA, const vec3Lanes *const restrict rB, vec3Lanes *const restrict out
+);
+static void solverBodyLanesApplyImpulse(
+	solverBodyLanes *const restrict bodyA, solverBodyLanes *const restrict bodyB,
+	const vec3Lanes *const restrict rA, const vec3Lanes *const restrict rB, const vec3Lanes *const restrict J
+);
+#endif
+
 
 // Build a physics manifold by expanding a contact manifold.
 void physManifoldInit(
@@ -216,7 +269,7 @@ void physManifoldInit(
 		// Find the average contact normal.
 		vec3AddVec3(&normal, &cmContact->normal);
 
-		#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+		#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 		pmContact->separation = cmContact->separation;
 		#endif
 		pmContact->key = cmContact->key;
@@ -285,6 +338,11 @@ void physManifoldPersist(
 
 	unsigned int persistentFlags[CONTACT_MAX_POINTS];
 	unsigned int *isPersistent = persistentFlags;
+	// Stores which slots still hold old points that haven't
+	// been matched. Slots past the old manifold's last point
+	// may hold keys left over from an earlier manifold.
+	unsigned int availableFlags[CONTACT_MAX_POINTS];
+	contactPointIndex i;
 
 	vec3 normal;
 	#ifdef PHYSCONTACT_USE_FRICTION_JOINT
@@ -298,13 +356,20 @@ void physManifoldPersist(
 	// Initialise our flags to 0. A value of 0
 	// means that a contact is not persistent.
 	memset(persistentFlags, 0, sizeof(persistentFlags));
+	for(i = 0; i < CONTACT_MAX_POINTS; ++i){
+		availableFlags[i] = (i < pm->numContacts);
+	}
 
 	do {
 		physicsContactPoint *pmSwap = pm->contacts;
 		do {
 			// We've found a matching key pair, so the point is persistent!
 			// This works since our contact keys have no padding.
-			if(memcmp(&pmSwap->key, &cmContact->key, sizeof(pmSwap->key)) == 0){
+			//
+			// Only slots holding unmatched old points are checked. Otherwise,
+			// a duplicated key or a key left in an unused slot could give a
+			// point the accumulators of an uninitialised one to warm start.
+			if(availableFlags[pmSwap - pm->contacts] && memcmp(&pmSwap->key, &cmContact->key, sizeof(pmSwap->key)) == 0){
 				// We want contacts in the old physics manifold to be moved
 				// to their new positions in the current manifold. This will
 				// make it easier to copy the keys for non-persistent points.
@@ -332,6 +397,9 @@ void physManifoldPersist(
 					#endif
 				}
 
+				// The swapped slot now holds whatever this one held.
+				availableFlags[pmSwap - pm->contacts] = availableFlags[pmContact - pm->contacts];
+				availableFlags[pmContact - pm->contacts] = 0;
 				*isPersistent = 1;
 				break;
 			}
@@ -392,7 +460,7 @@ void physManifoldPersist(
 		quatConjRotateVec3FastOut(bodyBRot, &curHalfway, &pmContact->rBlocal);
 		#endif
 
-		#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+		#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 		pmContact->separation = cmContact->separation;
 		#endif
 
@@ -432,13 +500,34 @@ void physManifoldPersist(
 	#endif
 }
 
+/*
+** Apply a manifold's accumulated impulses to its bodies again.
+** Persistent contacts are warm started when they're updated,
+** but when sub-stepping, the solver needs to warm start them
+** again at the start of each substep after the first.
+*/
+#ifdef PHYSCONTACT_WARM_START
+void physManifoldWarmStart(physicsManifold *const restrict pm, physicsRigidBody *const restrict bodyA, physicsRigidBody *const restrict bodyB){
+	physicsContactPoint *curContact = pm->contacts;
+	const physicsContactPoint *const lastContact = &curContact[pm->numContacts];
+
+	for(; curContact < lastContact; ++curContact){
+		warmStartContactPoint(pm, curContact, bodyA, bodyB);
+	}
+
+	#if defined(PHYSCONTACT_USE_FRICTION_JOINT) && defined(PHYSJOINTFRICTION_WARM_START)
+	physJointFrictionWarmStart(&pm->frictionJoint, bodyA, bodyB);
+	#endif
+}
+#endif
+
 
 /*
 ** Calculate any values required by collision resolution
 ** that are not expected to change between iterations.
 ** Such values include the effective mass and the bias.
 */
-#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 void physManifoldPresolve(
 	physicsManifold *const restrict pm, const physicsRigidBody *const restrict bodyA, const physicsRigidBody *const restrict bodyB, const float frequency
 ){
@@ -453,7 +542,7 @@ void physManifoldPresolve(
 
 	for(; curContact < lastContact; ++curContact){
 		calculateInverseEffectiveMass(pm, curContact, bodyA, bodyB);
-		#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+		#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 		calculateBias(pm, curContact, bodyA, bodyB, frequency);
 		#else
 		calculateBias(pm, curContact, bodyA, bodyB);
@@ -519,6 +608,429 @@ float physManifoldSolvePosition(const physicsManifold *const restrict pm, physic
 #endif
 
 
+#ifdef PHYSCONTACT_PACKED_SOLVER
+void physContactConstraintsInit(physicsContactConstraints *const restrict constraints){
+	memset(constraints, 0, sizeof(*constraints));
+}
+
+/*
+** Make sure the constraint arrays can store "numManifolds" manifolds
+** with "numPoints" contact points in total. The arrays are refilled
+** on every update, so we don't need to keep their old contents.
+*/
+void physContactConstraintsReserve(physicsContactConstraints *const restrict constraints, const size_t numManifolds, const size_t numPoints){
+	if(numManifolds > constraints->manifoldCapacity){
+		byte_t *memory;
+
+		if(constraints->bodyA != NULL){
+			memoryManagerGlobalFree(constraints->bodyA);
+		}
+		memory = memoryManagerGlobalAlloc(numManifolds * (
+			3*sizeof(size_t) + 3*sizeof(vec3) + sizeof(float) + sizeof(contactPointIndex)
+		));
+		if(memory == NULL){
+			/** MALLOC FAILED **/
+		}
+
+		// The arrays are ordered by alignment,
+		// so we can store them all in one block.
+		constraints->bodyA = (size_t *)memory;
+		constraints->bodyB = &constraints->bodyA[numManifolds];
+		constraints->pointOffset = &constraints->bodyB[numManifolds];
+		constraints->normal = (vec3 *)&constraints->pointOffset[numManifolds];
+		constraints->tangentA = &constraints->normal[numManifolds];
+		constraints->tangentB = &constraints->tangentA[numManifolds];
+		constraints->friction = (float *)&constraints->tangentB[numManifolds];
+		constraints->numPoints = (contactPointIndex *)&constraints->friction[numManifolds];
+		constraints->manifoldCapacity = numManifolds;
+	}
+
+	if(numPoints > constraints->pointCapacity){
+		byte_t *memory;
+
+		if(constraints->rA != NULL){
+			memoryManagerGlobalFree(constraints->rA);
+		}
+		memory = memoryManagerGlobalAlloc(numPoints * (2*sizeof(vec3) + 7*sizeof(float)));
+		if(memory == NULL){
+			/** MALLOC FAILED **/
+		}
+
+		constraints->rA = (vec3 *)memory;
+		constraints->rB = &constraints->rA[numPoints];
+		constraints->bias = (float *)&constraints->rB[numPoints];
+		constraints->normalImpulse = &constraints->bias[numPoints];
+		constraints->tangentImpulseA = &constraints->normalImpulse[numPoints];
+		constraints->tangentImpulseB = &constraints->tangentImpulseA[numPoints];
+		constraints->invNormalMass = &constraints->tangentImpulseB[numPoints];
+		constraints->invTangentMassA = &constraints->invNormalMass[numPoints];
+		constraints->invTangentMassB = &constraints->invTangentMassA[numPoints];
+		constraints->pointCapacity = numPoints;
+	}
+}
+
+/*
+** Copy a presolved physics manifold into the constraint arrays.
+** Its contact points are stored starting from "pointOffset",
+** and we return the offset to use for the next manifold.
+*/
+size_t physContactConstraintsPack(
+	const physicsContactConstraints *const restrict constraints, const size_t manifold, const size_t pointOffset,
+	const physicsManifold *const restrict pm, const size_t bodyA, const size_t bodyB
+){
+
+	const physicsContactPoint *curContact = pm->contacts;
+	const physicsContactPoint *const lastContact = &curContact[pm->numContacts];
+	size_t i = pointOffset;
+
+	constraints->bodyA[manifold] = bodyA;
+	constraints->bodyB[manifold] = bodyB;
+	constraints->pointOffset[manifold] = pointOffset;
+	constraints->normal[manifold] = physContactNormal(pm);
+	constraints->tangentA[manifold] = physContactTangent(pm, 0);
+	constraints->tangentB[manifold] = physContactTangent(pm, 1);
+	constraints->friction[manifold] = physContactFriction(pm);
+	constraints->numPoints[manifold] = pm->numContacts;
+
+	for(; curContact < lastContact; ++curContact){
+		constraints->rA[i] = curContact->rA;
+		constraints->rB[i] = curContact->rB;
+		constraints->bias[i] = curContact->bias;
+		constraints->normalImpulse[i] = curContact->normalImpulse;
+		constraints->tangentImpulseA[i] = curContact->tangentImpulse[0];
+		constraints->tangentImpulseB[i] = curContact->tangentImpulse[1];
+		constraints->invNormalMass[i] = curContact->invNormalMass;
+		constraints->invTangentMassA[i] = curContact->invTangentMass[0];
+		constraints->invTangentMassB[i] = curContact->invTangentMass[1];
+		++i;
+	}
+
+	return(i);
+}
+
+/*
+** This is the same as "physManifoldWarmStart", but it
+** uses the packed constraint arrays and solver bodies.
+*/
+void physContactConstraintsWarmStart(const physicsContactConstraints *const restrict constraints, const size_t manifold, physicsSolverBody *const restrict bodies){
+	physicsSolverBody staticBodyA;
+	physicsSolverBody staticBodyB;
+	physicsSolverBody *const bodyA = getSolverBody(bodies, constraints->bodyA[manifold], &staticBodyA);
+	physicsSolverBody *const bodyB = getSolverBody(bodies, constraints->bodyB[manifold], &staticBodyB);
+	size_t i = constraints->pointOffset[manifold];
+	const size_t lastPoint = i + constraints->numPoints[manifold];
+
+	for(; i < lastPoint; ++i){
+		vec3 impulse;
+
+		// Apply the total accumulated normal and frictional impulses.
+		vec3MultiplySOut(&constraints->normal[manifold], constraints->normalImpulse[i], &impulse);
+		vec3FmaP2(constraints->tangentImpulseA[i], &constraints->tangentA[manifold], &impulse);
+		vec3FmaP2(constraints->tangentImpulseB[i], &constraints->tangentB[manifold], &impulse);
+		solverBodyApplyImpulse(bodyA, bodyB, &constraints->rA[i], &constraints->rB[i], &impulse);
+	}
+}
+
+/*
+** This is the same as "physManifoldSolveVelocity", but it
+** uses the packed constraint arrays and solver bodies.
+*/
+void physContactConstraintsSolveVelocity(const physicsContactConstraints *const restrict constraints, const size_t manifold, physicsSolverBody *const restrict bodies){
+	physicsSolverBody staticBodyA;
+	physicsSolverBody staticBodyB;
+	physicsSolverBody *const bodyA = getSolverBody(bodies, constraints->bodyA[manifold], &staticBodyA);
+	physicsSolverBody *const bodyB = getSolverBody(bodies, constraints->bodyB[manifold], &staticBodyB);
+	const vec3 *const normal = &constraints->normal[manifold];
+	const vec3 *const tangentA = &constraints->tangentA[manifold];
+	const vec3 *const tangentB = &constraints->tangentB[manifold];
+	const float friction = constraints->friction[manifold];
+	size_t i = constraints->pointOffset[manifold];
+	const size_t lastPoint = i + constraints->numPoints[manifold];
+
+	for(; i < lastPoint; ++i){
+		const vec3 *const rA = &constraints->rA[i];
+		const vec3 *const rB = &constraints->rB[i];
+		const float maxFriction = friction * constraints->normalImpulse[i];
+		float lambda;
+		float oldImpulse;
+		vec3 contactVelocity;
+		vec3 impulse;
+
+
+		// Calculate the frictional impulse to apply.
+		solverBodyRelativeVelocity(bodyA, bodyB, rA, rB, &contactVelocity);
+
+		// -f < lambda < f
+		lambda = -vec3DotVec3(&contactVelocity, tangentA) * constraints->invTangentMassA[i];
+		oldImpulse = constraints->tangentImpulseA[i];
+		constraints->tangentImpulseA[i] = floatClamp(oldImpulse + lambda, -maxFriction, maxFriction);
+		vec3MultiplySOut(tangentA, constraints->tangentImpulseA[i] - oldImpulse, &impulse);
+
+		lambda = -vec3DotVec3(&contactVelocity, tangentB) * constraints->invTangentMassB[i];
+		oldImpulse = constraints->tangentImpulseB[i];
+		constraints->tangentImpulseB[i] = floatClamp(oldImpulse + lambda, -maxFriction, maxFriction);
+		vec3FmaP2(constraints->tangentImpulseB[i] - oldImpulse, tangentB, &impulse);
+
+		solverBodyApplyImpulse(bodyA, bodyB, rA, rB, &impulse);
+
+
+		// Calculate the correctional normal impulse to apply.
+		solverBodyRelativeVelocity(bodyA, bodyB, rA, rB, &contactVelocity);
+
+		// C' >= 0
+		lambda = -(vec3DotVec3(&contactVelocity, normal) + constraints->bias[i]) * constraints->invNormalMass[i];
+		oldImpulse = constraints->normalImpulse[i];
+		constraints->normalImpulse[i] = floatMax(oldImpulse + lambda, 0.f);
+		vec3MultiplySOut(normal, constraints->normalImpulse[i] - oldImpulse, &impulse);
+
+		solverBodyApplyImpulse(bodyA, bodyB, rA, rB, &impulse);
+	}
+}
+
+/*
+** Copy a manifold's accumulated impulses back
+** into its contact points for warm starting.
+*/
+void physContactConstraintsUnpack(const physicsContactConstraints *const restrict constraints, const size_t manifold, physicsManifold *const restrict pm){
+	physicsContactPoint *curContact = pm->contacts;
+	const physicsContactPoint *const lastContact = &curContact[pm->numContacts];
+	size_t i = constraints->pointOffset[manifold];
+
+	for(; curContact < lastContact; ++curContact){
+		curContact->normalImpulse = constraints->normalImpulse[i];
+		curContact->tangentImpulse[0] = constraints->tangentImpulseA[i];
+		curContact->tangentImpulse[1] = constraints->tangentImpulseB[i];
+		++i;
+	}
+}
+
+void physContactConstraintsDelete(physicsContactConstraints *const restrict constraints){
+	if(constraints->bodyA != NULL){
+		memoryManagerGlobalFree(constraints->bodyA);
+	}
+	if(constraints->rA != NULL){
+		memoryManagerGlobalFree(constraints->rA);
+	}
+}
+#endif
+
+#ifdef PHYSCONTACT_SOLVER_SIMD
+/*
+** Interleave up to "PHYSCONTACT_SOLVER_SIMD_WIDTH" packed manifolds into
+** a block. The caller must make sure that they don't share any bodies.
+*/
+void physContactBlockPack(
+	physicsContactBlock *const restrict block, const physicsContactConstraints *const restrict constraints,
+	const size_t firstManifold, const size_t numManifolds
+){
+
+	size_t lane;
+
+	// Unused lanes and points should never apply any impulses.
+	memset(block, 0, sizeof(*block));
+	block->numLanes = numManifolds;
+
+	for(lane = 0; lane < PHYSCONTACT_SOLVER_SIMD_WIDTH; ++lane){
+		// Unused lanes just reuse the first lane's bodies.
+		const size_t manifold = firstManifold + ((lane < numManifolds) ? lane : 0);
+		size_t point;
+
+		block->manifold[lane] = manifold;
+		block->bodyA[lane] = constraints->bodyA[manifold];
+		block->bodyB[lane] = constraints->bodyB[manifold];
+		if(lane >= numManifolds){
+			continue;
+		}
+
+		block->normal[0][lane] = constraints->normal[manifold].x;
+		block->normal[1][lane] = constraints->normal[manifold].y;
+		block->normal[2][lane] = constraints->normal[manifold].z;
+		block->tangentA[0][lane] = constraints->tangentA[manifold].x;
+		block->tangentA[1][lane] = constraints->tangentA[manifold].y;
+		block->tangentA[2][lane] = constraints->tangentA[manifold].z;
+		block->tangentB[0][lane] = constraints->tangentB[manifold].x;
+		block->tangentB[1][lane] = constraints->tangentB[manifold].y;
+		block->tangentB[2][lane] = constraints->tangentB[manifold].z;
+		block->friction[lane] = constraints->friction[manifold];
+		if(constraints->numPoints[manifold] > block->numPoints){
+			block->numPoints = constraints->numPoints[manifold];
+		}
+
+		for(point = 0; point < constraints->numPoints[manifold]; ++point){
+			const size_t i = constraints->pointOffset[manifold] + point;
+
+			block->rA[point][0][lane] = constraints->rA[i].x;
+			block->rA[point][1][lane] = constraints->rA[i].y;
+			block->rA[point][2][lane] = constraints->rA[i].z;
+			block->rB[point][0][lane] = constraints->rB[i].x;
+			block->rB[point][1][lane] = constraints->rB[i].y;
+			block->rB[point][2][lane] = constraints->rB[i].z;
+			block->bias[point][lane] = constraints->bias[i];
+			block->normalImpulse[point][lane] = constraints->normalImpulse[i];
+			block->tangentImpulseA[point][lane] = constraints->tangentImpulseA[i];
+			block->tangentImpulseB[point][lane] = constraints->tangentImpulseB[i];
+			block->invNormalMass[point][lane] = constraints->invNormalMass[i];
+			block->invTangentMassA[point][lane] = constraints->invTangentMassA[i];
+			block->invTangentMassB[point][lane] = constraints->invTangentMassB[i];
+		}
+	}
+}
+
+/*
+** This is the same as "physContactConstraintsWarmStart",
+** but it warm starts every lane of the block at the same time.
+** Unused lanes have no impulses, so they don't change anything.
+*/
+void physContactBlockWarmStart(const physicsContactBlock *const restrict block, physicsSolverBody *const restrict bodies){
+	solverBodyLanes bodyA;
+	solverBodyLanes bodyB;
+	vec3Lanes normal;
+	vec3Lanes tangentA;
+	vec3Lanes tangentB;
+	contactPointIndex point;
+
+	gatherSolverBodyLanes(bodies, block->bodyA, &bodyA);
+	gatherSolverBodyLanes(bodies, block->bodyB, &bodyB);
+	loadVec3Lanes(block->normal[0], &normal);
+	loadVec3Lanes(block->tangentA[0], &tangentA);
+	loadVec3Lanes(block->tangentB[0], &tangentB);
+
+	for(point = 0; point < block->numPoints; ++point){
+		vec3Lanes rA;
+		vec3Lanes rB;
+		vec3Lanes impulse;
+		const __m128 normalImpulse = _mm_loadu_ps(block->normalImpulse[point]);
+		const __m128 tangentImpulseA = _mm_loadu_ps(block->tangentImpulseA[point]);
+		const __m128 tangentImpulseB = _mm_loadu_ps(block->tangentImpulseB[point]);
+
+		loadVec3Lanes(block->rA[point][0], &rA);
+		loadVec3Lanes(block->rB[point][0], &rB);
+
+		// Apply the total accumulated normal and frictional impulses.
+		impulse.x = _mm_mul_ps(normal.x, normalImpulse);
+		impulse.y = _mm_mul_ps(normal.y, normalImpulse);
+		impulse.z = _mm_mul_ps(normal.z, normalImpulse);
+		impulse.x = _mm_add_ps(impulse.x, _mm_mul_ps(tangentA.x, tangentImpulseA));
+		impulse.y = _mm_add_ps(impulse.y, _mm_mul_ps(tangentA.y, tangentImpulseA));
+		impulse.z = _mm_add_ps(impulse.z, _mm_mul_ps(tangentA.z, tangentImpulseA));
+		impulse.x = _mm_add_ps(impulse.x, _mm_mul_ps(tangentB.x, tangentImpulseB));
+		impulse.y = _mm_add_ps(impulse.y, _mm_mul_ps(tangentB.y, tangentImpulseB));
+		impulse.z = _mm_add_ps(impulse.z, _mm_mul_ps(tangentB.z, tangentImpulseB));
+		solverBodyLanesApplyImpulse(&bodyA, &bodyB, &rA, &rB, &impulse);
+	}
+
+	scatterSolverBodyLanes(&bodyA, block->bodyA, block->numLanes, bodies);
+	scatterSolverBodyLanes(&bodyB, block->bodyB, block->numLanes, bodies);
+}
+
+/*
+** This is the same as "physContactConstraintsSolveVelocity",
+** but it solves every lane of the block at the same time.
+*/
+void physContactBlockSolveVelocity(physicsContactBlock *const restrict block, physicsSolverBody *const restrict bodies){
+	solverBodyLanes bodyA;
+	solverBodyLanes bodyB;
+	vec3Lanes normal;
+	vec3Lanes tangentA;
+	vec3Lanes tangentB;
+	const __m128 friction = _mm_loadu_ps(block->friction);
+	const __m128 zero = _mm_setzero_ps();
+	contactPointIndex point;
+
+	gatherSolverBodyLanes(bodies, block->bodyA, &bodyA);
+	gatherSolverBodyLanes(bodies, block->bodyB, &bodyB);
+	loadVec3Lanes(block->normal[0], &normal);
+	loadVec3Lanes(block->tangentA[0], &tangentA);
+	loadVec3Lanes(block->tangentB[0], &tangentB);
+
+	for(point = 0; point < block->numPoints; ++point){
+		vec3Lanes rA;
+		vec3Lanes rB;
+		vec3Lanes contactVelocity;
+		vec3Lanes impulse;
+		const __m128 maxFriction = _mm_mul_ps(friction, _mm_loadu_ps(block->normalImpulse[point]));
+		__m128 oldImpulse;
+		__m128 newImpulse;
+		__m128 lambda;
+
+		loadVec3Lanes(block->rA[point][0], &rA);
+		loadVec3Lanes(block->rB[point][0], &rB);
+
+
+		// Calculate the frictional impulse to apply.
+		solverBodyLanesRelativeVelocity(&bodyA, &bodyB, &rA, &rB, &contactVelocity);
+
+		// -f < lambda < f
+		lambda = _mm_mul_ps(
+			_mm_sub_ps(zero, vec3LanesDot(&contactVelocity, &tangentA)),
+			_mm_loadu_ps(block->invTangentMassA[point])
+		);
+		oldImpulse = _mm_loadu_ps(block->tangentImpulseA[point]);
+		newImpulse = _mm_min_ps(_mm_max_ps(_mm_add_ps(oldImpulse, lambda), _mm_sub_ps(zero, maxFriction)), maxFriction);
+		_mm_storeu_ps(block->tangentImpulseA[point], newImpulse);
+		lambda = _mm_sub_ps(newImpulse, oldImpulse);
+		impulse.x = _mm_mul_ps(tangentA.x, lambda);
+		impulse.y = _mm_mul_ps(tangentA.y, lambda);
+		impulse.z = _mm_mul_ps(tangentA.z, lambda);
+
+		lambda = _mm_mul_ps(
+			_mm_sub_ps(zero, vec3LanesDot(&contactVelocity, &tangentB)),
+			_mm_loadu_ps(block->invTangentMassB[point])
+		);
+		oldImpulse = _mm_loadu_ps(block->tangentImpulseB[point]);
+		newImpulse = _mm_min_ps(_mm_max_ps(_mm_add_ps(oldImpulse, lambda), _mm_sub_ps(zero, maxFriction)), maxFriction);
+		_mm_storeu_ps(block->tangentImpulseB[point], newImpulse);
+		lambda = _mm_sub_ps(newImpulse, oldImpulse);
+		impulse.x = _mm_add_ps(impulse.x, _mm_mul_ps(tangentB.x, lambda));
+		impulse.y = _mm_add_ps(impulse.y, _mm_mul_ps(tangentB.y, lambda));
+		impulse.z = _mm_add_ps(impulse.z, _mm_mul_ps(tangentB.z, lambda));
+
+		solverBodyLanesApplyImpulse(&bodyA, &bodyB, &rA, &rB, &impulse);
+
+
+		// Calculate the correctional normal impulse to apply.
+		solverBodyLanesRelativeVelocity(&bodyA, &bodyB, &rA, &rB, &contactVelocity);
+
+		// C' >= 0
+		lambda = _mm_mul_ps(
+			_mm_sub_ps(zero, _mm_add_ps(vec3LanesDot(&contactVelocity, &normal), _mm_loadu_ps(block->bias[point]))),
+			_mm_loadu_ps(block->invNormalMass[point])
+		);
+		oldImpulse = _mm_loadu_ps(block->normalImpulse[point]);
+		newImpulse = _mm_max_ps(_mm_add_ps(oldImpulse, lambda), zero);
+		_mm_storeu_ps(block->normalImpulse[point], newImpulse);
+		lambda = _mm_sub_ps(newImpulse, oldImpulse);
+		impulse.x = _mm_mul_ps(normal.x, lambda);
+		impulse.y = _mm_mul_ps(normal.y, lambda);
+		impulse.z = _mm_mul_ps(normal.z, lambda);
+
+		solverBodyLanesApplyImpulse(&bodyA, &bodyB, &rA, &rB, &impulse);
+	}
+
+	scatterSolverBodyLanes(&bodyA, block->bodyA, block->numLanes, bodies);
+	scatterSolverBodyLanes(&bodyB, block->bodyB, block->numLanes, bodies);
+}
+
+// Copy a block's accumulated impulses back into the packed arrays.
+void physContactBlockUnpack(const physicsContactBlock *const restrict block, const physicsContactConstraints *const restrict constraints){
+	size_t lane;
+
+	for(lane = 0; lane < block->numLanes; ++lane){
+		const size_t manifold = block->manifold[lane];
+		size_t point;
+
+		for(point = 0; point < constraints->numPoints[manifold]; ++point){
+			const size_t i = constraints->pointOffset[manifold] + point;
+
+			constraints->normalImpulse[i] = block->normalImpulse[point][lane];
+			constraints->tangentImpulseA[i] = block->tangentImpulseA[point][lane];
+			constraints->tangentImpulseB[i] = block->tangentImpulseB[point][lane];
+		}
+	}
+}
+#endif
+
+
 // Initialise a contact pair from a manifold.
 void physContactPairInit(
 	physicsContactPair *const restrict pair,
@@ -839,7 +1351,7 @@ static void calculateInverseEffectiveMass(
 }
 
 // Calculate the contact's bias term.
-#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 static void calculateBias(
 	const physicsManifold *const restrict pm, physicsContactPoint *const restrict contact,
 	const physicsRigidBody *const restrict bodyA, const physicsRigidBody *const restrict bodyB,
@@ -864,6 +1376,20 @@ static void calculateBias(
 	// B = Baumgarte constant
 	// b_separation = B/dt * C(x)
 	contact->bias = (tempBias < 0.f) ? (PHYSCONTACT_BAUMGARTE_BIAS * frequency * tempBias) : 0.f;
+	#else
+	// If we're not using Baumgarte stabilisation, any
+	// penetration is fixed by the position solver instead.
+	contact->bias = 0.f;
+	#endif
+
+	#ifdef PHYSCONTACT_SPECULATIVE
+	// Speculative contacts aren't touching yet, so rather than
+	// pushing the bodies apart, we allow them to close the gap
+	// between them during this update, but no further.
+	// b_separation = C(x)/dt
+	if(contact->separation > 0.f){
+		contact->bias = contact->separation * frequency;
+	}
 	#endif
 
 
@@ -890,23 +1416,15 @@ static void calculateBias(
 	// Calculate the restitution bias term.
 	// b_restitution = e * (v_relative . n)
 	tempBias = vec3DotVec3(&contactVelocity, &physContactNormal(pm));
-	// Calculate the total bias.
-	if(tempBias < -PHYSCONTACT_RESTITUTION_THRESHOLD){
-	#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+	// Calculate the total bias. If the relative velocity is parallel
+	// to the normal, the bodies are moving away, so we ignore restitution.
+	// Speculative contacts should also only bounce if the bodies would
+	// otherwise touch during this update, which is always true for
+	// contacts that are already penetrating.
+	if(tempBias < -PHYSCONTACT_RESTITUTION_THRESHOLD && tempBias + contact->bias < 0.f){
 		// b = b_separation + b_restitution
-		//   = B/dt * C(x)  + e * (v_relative . n)
+		//   = b_separation + e * (v_relative . n)
 		contact->bias += pm->restitution * tempBias;
-	#else
-		// If we're not using Baumgarte stabilisation,
-		// we only have the restitution bias here.
-		// b = e * (v_relative . n)
-		contact->bias = pm->restitution * tempBias;
-
-	// If the relative velocity is parallel to the normal,
-	// the bodies are moving away, so ignore restitution.
-	}else{
-		contact->bias = 0.f;
-	#endif
 	}
 }
 
@@ -1083,4 +1601,203 @@ float solvePosition(
 
 	return(separation);
 }
+#endif
+
+
+#ifdef PHYSCONTACT_PACKED_SOLVER
+/*
+** Return the solver body with the given index. Bodies that
+** aren't simulated use "staticBody", which is zeroed so the
+** impulses applied to it don't affect anything else.
+*/
+static physicsSolverBody *getSolverBody(physicsSolverBody *const restrict bodies, const size_t index, physicsSolverBody *const restrict staticBody){
+	if(index == PHYSCONTACT_STATIC_SOLVER_BODY){
+		memset(staticBody, 0, sizeof(*staticBody));
+		return(staticBody);
+	}
+	return(&bodies[index]);
+}
+
+// Calculate the relative velocity between two solver bodies' contact points.
+static void solverBodyRelativeVelocity(
+	const physicsSolverBody *const restrict bodyA, const physicsSolverBody *const restrict bodyB,
+	const vec3 *const restrict rA, const vec3 *const restrict rB, vec3 *const restrict out
+){
+
+	vec3 velocityA;
+
+	// v_relative = (vB + wB X rB) - (vA + wA X rA)
+	vec3CrossVec3Out(&bodyA->angularVelocity, rA, &velocityA);
+	vec3AddVec3(&velocityA, &bodyA->linearVelocity);
+	vec3CrossVec3Out(&bodyB->angularVelocity, rB, out);
+	vec3AddVec3(out, &bodyB->linearVelocity);
+	vec3SubtractVec3P1(out, &velocityA);
+}
+
+// Subtract an impulse from body A and add it to body B.
+static void solverBodyApplyImpulse(
+	physicsSolverBody *const restrict bodyA, physicsSolverBody *const restrict bodyB,
+	const vec3 *const restrict rA, const vec3 *const restrict rB, const vec3 *const restrict J
+){
+
+	vec3 impulse;
+
+	vec3FmaP2(-bodyA->invMass, J, &bodyA->linearVelocity);
+	vec3CrossVec3Out(rA, J, &impulse);
+	mat3MultiplyVec3(&bodyA->invInertiaGlobal, &impulse);
+	vec3SubtractVec3P1(&bodyA->angularVelocity, &impulse);
+
+	vec3FmaP2(bodyB->invMass, J, &bodyB->linearVelocity);
+	vec3CrossVec3Out(rB, J, &impulse);
+	mat3MultiplyVec3(&bodyB->invInertiaGlobal, &impulse);
+	vec3AddVec3(&bodyB->angularVelocity, &impulse);
+}
+#endif
+
+#ifdef PHYSCONTACT_SOLVER_SIMD
+// Load a vector whose components are stored in consecutive arrays.
+static void loadVec3Lanes(const float *const restrict v, vec3Lanes *const restrict out){
+	out->x = _mm_loadu_ps(&v[0]);
+	out->y = _mm_loadu_ps(&v[PHYSCONTACT_SOLVER_SIMD_WIDTH]);
+	out->z = _mm_loadu_ps(&v[2*PHYSCONTACT_SOLVER_SIMD_WIDTH]);
+}
+
+static __m128 vec3LanesDot(const vec3Lanes *const restrict v1, const vec3Lanes *const restrict v2){
+	return(_mm_add_ps(_mm_add_ps(_mm_mul_ps(v1->x, v2->x), _mm_mul_ps(v1->y, v2->y)), _mm_mul_ps(v1->z, v2->z)));
+}
+
+static void vec3LanesCross(const vec3Lanes *const restrict v1, const vec3Lanes *const restrict v2, vec3Lanes *const restrict out){
+	out->x = _mm_sub_ps(_mm_mul_ps(v1->y, v2->z), _mm_mul_ps(v1->z, v2->y));
+	out->y = _mm_sub_ps(_mm_mul_ps(v1->z, v2->x), _mm_mul_ps(v1->x, v2->z));
+	out->z = _mm_sub_ps(_mm_mul_ps(v1->x, v2->y), _mm_mul_ps(v1->y, v2->x));
+}
+
+// Left-multiply a vector by the lanes' inverse inertia tensors.
+static void solverBodyLanesInertia(const solverBodyLanes *const restrict body, const vec3Lanes *const restrict v, vec3Lanes *const restrict out){
+	out->x = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(body->invInertiaGlobal[0][0], v->x), _mm_mul_ps(body->invInertiaGlobal[1][0], v->y)),
+		_mm_mul_ps(body->invInertiaGlobal[2][0], v->z)
+	);
+	out->y = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(body->invInertiaGlobal[0][1], v->x), _mm_mul_ps(body->invInertiaGlobal[1][1], v->y)),
+		_mm_mul_ps(body->invInertiaGlobal[2][1], v->z)
+	);
+	out->z = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(body->invInertiaGlobal[0][2], v->x), _mm_mul_ps(body->invInertiaGlobal[1][2], v->y)),
+		_mm_mul_ps(body->invInertiaGlobal[2][2], v->z)
+	);
+}
+
+// Transpose the solver bodies with the given indices into lanes.
+static void gatherSolverBodyLanes(const physicsSolverBody *const restrict bodies, const size_t *const restrict indices, solverBodyLanes *const restrict out){
+	float lanes[16][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	size_t lane;
+	size_t i;
+
+	// Bodies that aren't simulated are left as zero.
+	memset(lanes, 0, sizeof(lanes));
+	for(lane = 0; lane < PHYSCONTACT_SOLVER_SIMD_WIDTH; ++lane){
+		if(indices[lane] != PHYSCONTACT_STATIC_SOLVER_BODY){
+			const physicsSolverBody *const body = &bodies[indices[lane]];
+
+			lanes[0][lane] = body->linearVelocity.x;
+			lanes[1][lane] = body->linearVelocity.y;
+			lanes[2][lane] = body->linearVelocity.z;
+			lanes[3][lane] = body->angularVelocity.x;
+			lanes[4][lane] = body->angularVelocity.y;
+			lanes[5][lane] = body->angularVelocity.z;
+			lanes[6][lane] = body->invMass;
+			for(i = 0; i < 9; ++i){
+				lanes[7 + i][lane] = body->invInertiaGlobal.m[i / 3][i % 3];
+			}
+		}
+	}
+
+	out->linearVelocity.x = _mm_loadu_ps(lanes[0]);
+	out->linearVelocity.y = _mm_loadu_ps(lanes[1]);
+	out->linearVelocity.z = _mm_loadu_ps(lanes[2]);
+	out->angularVelocity.x = _mm_loadu_ps(lanes[3]);
+	out->angularVelocity.y = _mm_loadu_ps(lanes[4]);
+	out->angularVelocity.z = _mm_loadu_ps(lanes[5]);
+	out->invMass = _mm_loadu_ps(lanes[6]);
+	for(i = 0; i < 9; ++i){
+		out->invInertiaGlobal[i / 3][i % 3] = _mm_loadu_ps(lanes[7 + i]);
+	}
+}
+
+/*
+** Write the velocities of the first "numLanes" lanes back to their
+** solver bodies. Bodies that aren't simulated are never written to.
+*/
+static void scatterSolverBodyLanes(
+	const solverBodyLanes *const restrict body, const size_t *const restrict indices,
+	const size_t numLanes, physicsSolverBody *const restrict bodies
+){
+
+	float lanes[6][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	size_t lane;
+
+	_mm_storeu_ps(lanes[0], body->linearVelocity.x);
+	_mm_storeu_ps(lanes[1], body->linearVelocity.y);
+	_mm_storeu_ps(lanes[2], body->linearVelocity.z);
+	_mm_storeu_ps(lanes[3], body->angularVelocity.x);
+	_mm_storeu_ps(lanes[4], body->angularVelocity.y);
+	_mm_storeu_ps(lanes[5], body->angularVelocity.z);
+
+	for(lane = 0; lane < numLanes; ++lane){
+		if(indices[lane] != PHYSCONTACT_STATIC_SOLVER_BODY){
+			physicsSolverBody *const solverBody = &bodies[indices[lane]];
+
+			solverBody->linearVelocity.x = lanes[0][lane];
+			solverBody->linearVelocity.y = lanes[1][lane];
+			solverBody->linearVelocity.z = lanes[2][lane];
+			solverBody->angularVelocity.x = lanes[3][lane];
+			solverBody->angularVelocity.y = lanes[4][lane];
+			solverBody->angularVelocity.z = lanes[5][lane];
+		}
+	}
+}
+
+static void solverBodyLanesRelativeVelocity(
+	const solverBodyLanes *const restrict bodyA, const solverBodyLanes *const restrict bodyB,
+	const vec3Lanes *const restrict rA, const vec3Lanes *const restrict rB, vec3Lanes *const restrict out
+){
+
+	vec3Lanes velocityA;
+	vec3Lanes velocityB;
+
+	// v_relative = (vB + wB X rB) - (vA + wA X rA)
+	vec3LanesCross(&bodyA->angularVelocity, rA, &velocityA);
+	vec3LanesCross(&bodyB->angularVelocity, rB, &velocityB);
+	out->x = _mm_sub_ps(_mm_add_ps(velocityB.x, bodyB->linearVelocity.x), _mm_add_ps(velocityA.x, bodyA->linearVelocity.x));
+	out->y = _mm_sub_ps(_mm_add_ps(velocityB.y, bodyB->linearVelocity.y), _mm_add_ps(velocityA.y, bodyA->linearVelocity.y));
+	out->z = _mm_sub_ps(_mm_add_ps(velocityB.z, bodyB->linearVelocity.z), _mm_add_ps(velocityA.z, bodyA->linearVelocity.z));
+}
+
+static void solverBodyLanesApplyImpulse(
+	solverBodyLanes *const restrict bodyA, solverBodyLanes *const restrict bodyB,
+	const vec3Lanes *const restrict rA, const vec3Lanes *const restrict rB, const vec3Lanes *const restrict J
+){
+
+	vec3Lanes temp;
+	vec3Lanes impulse;
+
+	bodyA->linearVelocity.x = _mm_sub_ps(bodyA->linearVelocity.x, _mm_mul_ps(bodyA->invMass, J->x));
+	bodyA->linearVelocity.y = _mm_sub_ps(bodyA->linearVelocity.y, _mm_mul_ps(bodyA->invMass, J->y));
+	bodyA->linearVelocity.z = _mm_sub_ps(bodyA->linearVelocity.z, _mm_mul_ps(bodyA->invMass, J->z));
+	vec3LanesCross(rA, J, &temp);
+	solverBodyLanesInertia(bodyA, &temp, &impulse);
+	bodyA->angularVelocity.x = _mm_sub_ps(bodyA->angularVelocity.x, impulse.x);
+	bodyA->angularVelocity.y = _mm_sub_ps(bodyA->angularVelocity.y, impulse.y);
+	bodyA->angularVelocity.z = _mm_sub_ps(bodyA->angularVelocity.z, impulse.z);
+
+	bodyB->linearVelocity.x = _mm_add_ps(bodyB->linearVelocity.x, _mm_mul_ps(bodyB->invMass, J->x));
+	bodyB->linearVelocity.y = _mm_add_ps(bodyB->linearVelocity.y, _mm_mul_ps(bodyB->invMass, J->y));
+	bodyB->linearVelocity.z = _mm_add_ps(bodyB->linearVelocity.z, _mm_mul_ps(bodyB->invMass, J->z));
+	vec3LanesCross(rB, J, &temp);
+	solverBodyLanesInertia(bodyB, &temp, &impulse);
+	bodyB->angularVelocity.x = _mm_add_ps(bodyB->angularVelocity.x, impulse.x);
+	bodyB->angularVelocity.y = _mm_add_ps(bodyB->angularVelocity.y, impulse.y);
+	bodyB->angularVelocity.z = _mm_add_ps(bodyB->angularVelocity.z, impulse.z);
+}
 #endif
\ No newline at end of file
@@ -31,6 +31,24 @@
 	#define PHYSCONTACT_BAUMGARTE_BIAS 0.2f
 #endif
 
+#ifdef PHYSCONTACT_SPECULATIVE
+	// Colliders closer than this always get speculative contacts.
+	// The margin is grown by how far the colliders could approach
+	// each other during an update, up to the maximum distance.
+	#ifndef PHYSCONTACT_SPECULATIVE_DISTANCE
+		#define PHYSCONTACT_SPECULATIVE_DISTANCE (4.f * PHYSCONTACT_LINEAR_SLOP)
+	#endif
+	#ifndef PHYSCONTACT_SPECULATIVE_MAX_DISTANCE
+		#define PHYSCONTACT_SPECULATIVE_MAX_DISTANCE 0.2f
+	#endif
+#endif
+// Baumgarte stabilisation and speculative contacts both
+// need the separations of contact points and the update
+// frequency to calculate the velocity solver's bias.
+#if defined(PHYSCONTACT_STABILISER_BAUMGARTE) || defined(PHYSCONTACT_SPECULATIVE)
+	#define PHYSCONTACT_USE_SEPARATION_BIAS
+#endif
+
 #define PHYSCOLLISIONPAIR_ACTIVE 0
 
 #ifndef PHYSICS_SEPARATION_PAIR_MAX_INACTIVE_STEPS
@@ -40,6 +58,22 @@
 	#define PHYSICS_CONTACT_PAIR_MAX_INACTIVE_STEPS 1
 #endif
 
+// The packed solver stores the friction constraints in the
+// contact points, so it can't be used with friction joints.
+#ifdef PHYSCONTACT_USE_FRICTION_JOINT
+	#undef PHYSCONTACT_PACKED_SOLVER
+#endif
+// The SIMD solver works on the packed contacts, and
+// requires SSE, which every x86-64 processor has.
+#if defined(PHYSCONTACT_SOLVER_SIMD) && (!defined(PHYSCONTACT_PACKED_SOLVER) || !(defined(__SSE__) || defined(_M_X64)))
+	#undef PHYSCONTACT_SOLVER_SIMD
+#endif
+
+#ifdef PHYSCONTACT_SOLVER_SIMD
+	// Number of manifolds solved in lockstep.
+	#define PHYSCONTACT_SOLVER_SIMD_WIDTH 4
+#endif
+
 
 // Depending on whether or not we're using friciton joints, the place
 // we store normals and tangents changes. It's highly recommended that
@@ -75,9 +109,9 @@ typedef struct physicsContactPoint {
 	vec3 rBlocal;
 	#endif
 
-	#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
-	// Separation between the contact points.
-	// Note that this is a negative quantity.
+	#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
+	// Separation between the contact points. This is
+	// negative unless the contact is speculative.
 	float separation;
 	#endif
 	// Used to uniquely identify the contact point.
@@ -105,9 +139,6 @@ typedef struct physicsContactPoint {
 	#endif
 } physicsContactPoint;
 
-/** It would probably be best to do something similar to what Box2D      **/
-/** does with this structure, as ours is probably prone to cache misses. **/
-
 // A physics manifold is similar to a regular contact manifold,
 // but stores additional information required to solve contacts.
 typedef struct physicsManifold {
@@ -144,13 +175,103 @@ typedef struct physicsManifold {
 typedef struct physicsRigidBody physicsRigidBody;
 typedef struct physicsCollider physicsCollider;
 
+#ifdef PHYSCONTACT_PACKED_SOLVER
+// The parts of a rigid body that are
+// used by the contact velocity solver.
+typedef struct physicsSolverBody {
+	vec3 linearVelocity;
+	vec3 angularVelocity;
+	float invMass;
+	mat3 invInertiaGlobal;
+} physicsSolverBody;
+
+// Manifolds use this index for bodies that aren't simulated. These
+// have no velocity and infinite mass as far as the solver is concerned,
+// so each manifold solves against its own zeroed copy rather than one
+// that would have to be shared between threads.
+#define PHYSCONTACT_STATIC_SOLVER_BODY valueInvalid(size_t)
+
+/*
+** Physics manifolds are stored inside their contact pairs, which
+** are scattered throughout memory, and solving them requires us
+** to go through the colliders to reach the rigid bodies. This is
+** quite prone to cache misses, so similarly to Box2D, islands may
+** copy everything the velocity solver needs into these arrays.
+**
+** Bodies are referred to by their indices in an array of solver
+** bodies, or by "PHYSCONTACT_STATIC_SOLVER_BODY" if they aren't
+** simulated. Each manifold's contact points are stored contiguously,
+** starting from the manifold's point offset.
+*/
+typedef struct physicsContactConstraints {
+	// Manifold data.
+	size_t *bodyA;
+	size_t *bodyB;
+	size_t *pointOffset;
+	vec3 *normal;
+	vec3 *tangentA;
+	vec3 *tangentB;
+	float *friction;
+	contactPointIndex *numPoints;
+	size_t manifoldCapacity;
+
+	// Contact point data.
+	vec3 *rA;
+	vec3 *rB;
+	float *bias;
+	float *normalImpulse;
+	float *tangentImpulseA;
+	float *tangentImpulseB;
+	float *invNormalMass;
+	float *invTangentMassA;
+	float *invTangentMassB;
+	size_t pointCapacity;
+} physicsContactConstraints;
+#endif
+
+#ifdef PHYSCONTACT_SOLVER_SIMD
+/*
+** A block interleaves the data of several packed manifolds that don't
+** share any simulated bodies, so their contact points can be solved
+** in lockstep using SIMD instructions. The i'th point of every lane
+** is solved at the same time. Lanes with fewer points, as well as
+** unused lanes, have zero effective masses, so their impulses are
+** always zero.
+**
+** Vectors are stored as one array per component.
+*/
+typedef struct physicsContactBlock {
+	size_t manifold[PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	size_t bodyA[PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	size_t bodyB[PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float normal[3][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float tangentA[3][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float tangentB[3][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float friction[PHYSCONTACT_SOLVER_SIMD_WIDTH];
+
+	float rA[CONTACT_MAX_POINTS][3][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float rB[CONTACT_MAX_POINTS][3][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float bias[CONTACT_MAX_POINTS][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float normalImpulse[CONTACT_MAX_POINTS][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float tangentImpulseA[CONTACT_MAX_POINTS][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float tangentImpulseB[CONTACT_MAX_POINTS][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float invNormalMass[CONTACT_MAX_POINTS][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float invTangentMassA[CONTACT_MAX_POINTS][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+	float invTangentMassB[CONTACT_MAX_POINTS][PHYSCONTACT_SOLVER_SIMD_WIDTH];
+
+	// Largest number of points used by any lane.
+	contactPointIndex numPoints;
+	byte_t numLanes;
+} physicsContactBlock;
+#endif
+
 typedef uint_least8_t physPairTimestamp;
 
 /*
 ** These pairs are stored in a very particular way.
-**     1. The address of collider A must always be greater than the address of collider B.
+**     1. The key of collider A must always be greater than the key of collider B.
 **     2. Colliders store contacts they own before contacts they don't.
-**     3. Contacts owned by a particular collider are sorted by the address of collider B.
+**     3. Contacts owned by a particular collider are sorted by the key of collider B.
 **     4. Pairs are in general allocated by islands: colliders and rigid bodies just store pointers to particular elements.
 ** This makes lookups faster, though there is a slightly higher cost for creating pairs.
 */
@@ -202,7 +323,7 @@ void physManifoldPersist(
 	const physicsCollider *const restrict cA, const physicsCollider *const restrict cB
 );
 
-#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 void physManifoldPresolve(
 	physicsManifold *const restrict pm, const physicsRigidBody *const restrict bodyA, const physicsRigidBody *const restrict bodyB, const float frequency
 );
@@ -211,11 +332,36 @@ void physManifoldPresolve(
 	physicsManifold *const restrict pm, const physicsRigidBody *const restrict bodyA, const physicsRigidBody *const restrict bodyB
 );
 #endif
+#ifdef PHYSCONTACT_WARM_START
+void physManifoldWarmStart(physicsManifold *const restrict pm, physicsRigidBody *const restrict bodyA, physicsRigidBody *const restrict bodyB);
+#endif
 void physManifoldSolveVelocity(physicsManifold *const restrict pm, physicsRigidBody *const restrict bodyA, physicsRigidBody *const restrict bodyB);
 #ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
 float physManifoldSolvePosition(const physicsManifold *const restrict pm, physicsRigidBody *const restrict bodyA, physicsRigidBody *const restrict bodyB, float separation);
 #endif
 
+#ifdef PHYSCONTACT_PACKED_SOLVER
+void physContactConstraintsInit(physicsContactConstraints *const restrict constraints);
+void physContactConstraintsReserve(physicsContactConstraints *const restrict constraints, const size_t numManifolds, const size_t numPoints);
+size_t physContactConstraintsPack(
+	const physicsContactConstraints *const restrict constraints, const size_t manifold, const size_t pointOffset,
+	const physicsManifold *const restrict pm, const size_t bodyA, const size_t bodyB
+);
+void physContactConstraintsWarmStart(const physicsContactConstraints *const restrict constraints, const size_t manifold, physicsSolverBody *const restrict bodies);
+void physContactConstraintsSolveVelocity(const physicsContactConstraints *const restrict constraints, const size_t manifold, physicsSolverBody *const restrict bodies);
+void physContactConstraintsUnpack(const physicsContactConstraints *const restrict constraints, const size_t manifold, physicsManifold *const restrict pm);
+void physContactConstraintsDelete(physicsContactConstraints *const restrict constraints);
+#endif
+#ifdef PHYSCONTACT_SOLVER_SIMD
+void physContactBlockPack(
+	physicsContactBlock *const restrict block, const physicsContactConstraints *const restrict constraints,
+	const size_t firstManifold, const size_t numManifolds
+);
+void physContactBlockWarmStart(const physicsContactBlock *const restrict block, physicsSolverBody *const restrict bodies);
+void physContactBlockSolveVelocity(physicsContactBlock *const restrict block, physicsSolverBody *const restrict bodies);
+void physContactBlockUnpack(const physicsContactBlock *const restrict block, const physicsContactConstraints *const restrict constraints);
+#endif
+
 void physContactPairInit(
 	physicsContactPair *const restrict pair,
 	physicsCollider *const restrict cA, physicsCollider *const restrict cB,
@@ -1,13 +1,147 @@
 #include "physicsIsland.h"
 
 
+#include <string.h>
+
+#include "colliderGJK.h"
+#include "sortTimsort.h"
+
 #include "physicsContact.h"
 #include "physicsRigidBody.h"
 
 #include "modulePhysics.h"
+#include "memoryManager.h"
+#include "memoryArena.h"
+
+
+// When sub-stepping, each substep runs its own, smaller number of iterations.
+#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1
+	#define PHYSISLAND_VELOCITY_ITERATIONS PHYSICS_SUBSTEP_VELOCITY_SOLVER_NUM_ITERATIONS
+	#define PHYSISLAND_POSITION_ITERATIONS PHYSICS_SUBSTEP_POSITION_SOLVER_NUM_ITERATIONS
+#else
+	#define PHYSISLAND_VELOCITY_ITERATIONS PHYSICS_VELOCITY_SOLVER_NUM_ITERATIONS
+	#define PHYSISLAND_POSITION_ITERATIONS PHYSICS_POSITION_SOLVER_NUM_ITERATIONS
+#endif
+
+
+// Arguments passed to each of the narrowphase's jobs.
+typedef struct physicsNarrowphaseJobArgs {
+	physicsIsland *island;
+	#ifdef PHYSCONTACT_SPECULATIVE
+	// Used to scale the speculative margin of each pair.
+	float dt;
+	#endif
+} physicsNarrowphaseJobArgs;
+
+#ifdef PHYSISLAND_PARALLEL_SOLVER
+// Arguments passed to each of the parallel solver's jobs.
+typedef struct physicsSolverJobArgs {
+	physicsIsland *island;
+	const physicsConstraintColour *colour;
+	float dt;
+} physicsSolverJobArgs;
+#endif
+
+#ifdef PHYSISLAND_CONTINUOUS_COLLISION
+// Stores the earliest impact found while sweeping a collider.
+typedef struct physicsContinuousQuery {
+	physicsCollider *collider;
+	// How far the collider has already moved
+	// and how far it's trying to move now.
+	vec3 offset;
+	vec3 displacement;
+
+	physicsCollider *hit;
+	float toi;
+	vec3 normal;
+} physicsContinuousQuery;
+#endif
+
+// Stores the state of a raycast or shape cast.
+typedef struct physicsSceneQuery {
+	// For shape casts, the origin is unused and the
+	// bounding box is the shape's at the start.
+	vec3 origin;
+	vec3 dir;
+	vec3 invDir;
+	const collider *shape;
+	colliderAABB aabb;
+	float maxDistance;
+	physicsColliderLayer mask;
+	byte_t type;
+
+	// Closest and any-hit queries store their hit here,
+	// whereas queries for every hit call "callback".
+	physicsRaycastHit *hit;
+	void (*callback)(const physicsRaycastHit *const restrict hit, void *args);
+	void *args;
+	size_t numHits;
+} physicsSceneQuery;
+
+// Stores the state of an overlap query.
+typedef struct physicsOverlapQuery {
+	const colliderAABB *aabb;
+	// This is NULL if we only want to test the bounding box.
+	const collider *shape;
+	physicsColliderLayer mask;
+
+	void (*callback)(physicsCollider *const restrict collider, void *args);
+	void *args;
+	size_t numHits;
+} physicsOverlapQuery;
+
+// Stores the state of a batch of raycasts.
+typedef struct physicsRaycastBatch {
+	physicsIsland *island;
+	const vec3 *origins;
+	const vec3 *dirs;
+	const float *maxDistances;
+	size_t numRays;
+	physicsColliderLayer mask;
+	physicsRaycastHit *hits;
+} physicsRaycastBatch;
+
+// The part of a raycast batch handled by a single job.
+typedef struct physicsRaycastBatchJob {
+	const physicsRaycastBatch *batch;
+	size_t firstRay;
+	vec3 invDirs[PHYSISLAND_RAYCAST_BATCH_SIZE];
+} physicsRaycastBatchJob;
+
+// Every snapshot begins with the number of each type
+// of record it stores. The records follow in this order.
+typedef struct physicsIslandSnapshotHeader {
+	uint_least32_t numBodies;
+	uint_least32_t numColliders;
+	uint_least32_t numJoints;
+	uint_least32_t numContacts;
+	uint_least32_t numSeparations;
+	physColliderKey nextColliderKey;
+} physicsIslandSnapshotHeader;
+
+
+#ifdef PHYSISLAND_DETERMINISTIC
+// Candidates are sorted by the keys of their colliders.
+#define compareCandidate(c1, c2) (                                     \
+	((c1)->cA->key != (c2)->cA->key) ?                                 \
+	compareFloatFast((c1)->cA->key, (c2)->cA->key) :                   \
+	compareFloatFast((c1)->cB->key, (c2)->cB->key)                     \
+)
+#endif
 
 
 // Forward-declare any helper functions!
+static aabbNode *broadphaseLeaves(const physicsIsland *const restrict island);
+static void queryBroadphaseAABB(
+	physicsIsland *const restrict island, const colliderAABB *const restrict aabb,
+	void (*const callback)(void *const restrict value, void *args), void *args
+);
+static void queryBroadphaseRay(
+	physicsIsland *const restrict island, const vec3 *const restrict origin, const vec3 *const restrict invDir, const float maxDistance,
+	float (*const callback)(void *const restrict value, const float maxDistance, void *args), void *args
+);
+static void insertColliderNode(physicsIsland *const restrict island, physicsCollider *const restrict collider, const colliderAABB *const restrict aabb);
+static void moveColliderNode(physicsIsland *const restrict island, physicsCollider *const restrict collider);
 static void insertColliders(physicsIsland *const restrict island, physicsRigidBody *const restrict body);
 static void removeColliderNode(physicsIsland *const restrict island, physicsCollider *const restrict collider);
 static void removeColliders(physicsIsland *const restrict island, physicsRigidBody *const restrict body);
@@ -15,10 +149,23 @@ static void removeColliders(physicsIsland *const restrict island, physicsRigidBo
 static void insertJoint(physicsIsland *const restrict island, physicsJoint *const restrict joint);
 static void removeJoint(physicsIsland *const restrict island, physicsJoint *const restrict joint);
 
+#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+static return_t bodyIsActive(const physicsRigidBody *const restrict body);
+static void wakeJointBodies(physicsIsland *const restrict island);
+#endif
 static void updateRigidBodies(physicsIsland *const restrict island, const float dt);
 
-static void collisionCallback(void *const colliderA, void *const colliderB, void *const restrict island);
-#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+static physicsCandidatePair *addCandidate(physicsIsland *const restrict island, physicsCollider *const colliderA, physicsCollider *const colliderB);
+static void candidateCallback(void *const colliderA, void *const colliderB, void *const restrict island);
+static physicsSeparationPair *findCachedSeparation(const aabbPair *const restrict pair);
+static void reserveCandidates(physicsIsland *const restrict island, const size_t numCandidates);
+#ifdef PHYSCONTACT_SPECULATIVE
+static float speculativeMargin(const physicsCandidatePair *const restrict candidate, const float dt);
+#endif
+static void narrowphaseJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+static void mergeContact(physicsIsland *const restrict island, const physicsCandidatePair *const restrict candidate);
+static void mergeCandidate(physicsIsland *const restrict island, const physicsCandidatePair *const restrict candidate);
+#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 static void queryCollisions(physicsIsland *const restrict island, const float frequency);
 #else
 static void queryCollisions(physicsIsland *const restrict island);
@@ -26,23 +173,167 @@ static void queryCollisions(physicsIsland *const restrict island);
 
 static void freeNodeCallback(aabbNode *const restrict node, void *const restrict island);
 
-#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 static void updateColliderContacts(physicsIsland *const restrict island, physicsCollider *const restrict collider, const float frequency);
 #else
 static void updateColliderContacts(physicsIsland *const restrict island, physicsCollider *const restrict collider);
 #endif
 static void updateColliderSeparations(physicsIsland *const restrict island, physicsCollider *const restrict collider);
 
+static void reserveGraphArrays(
+	physicsIsland *const restrict island,
+	const size_t numBodies, const size_t numJoints, const size_t numContacts
+);
+static size_t findGraphRoot(size_t *const restrict parents, size_t i);
+static void mergeGraphs(size_t *const restrict parents, const physicsRigidBody *const bodyA, const physicsRigidBody *const bodyB);
+static size_t constraintGraphIndex(
+	const size_t *const restrict parents,
+	const physicsRigidBody *const bodyA, const physicsRigidBody *const bodyB
+);
+static void buildConstraintGraphs(physicsIsland *const restrict island);
+
+#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+static return_t constraintGraphIsAsleep(const physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph);
+static void updateConstraintGraphSleep(physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph, const float dt);
+#endif
+#ifdef PHYSCONTACT_PACKED_SOLVER
+static size_t solverBodyIndex(const physicsRigidBody *const restrict body);
+static void packGraphBodies(const physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph);
+static void unpackGraphBodies(const physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph);
+static void solveJointVelocityPacked(physicsSolverBody *const restrict bodies, physicsJoint *const restrict joint);
+#endif
+static void solveConstraintGraph(physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph, const float dt);
+#ifdef PHYSISLAND_PARALLEL_SOLVER
+static byte_t constraintColour(uint_least64_t *const restrict bodyColours, const physicsRigidBody *const bodyA, const physicsRigidBody *const bodyB);
+static void colourConstraints(physicsIsland *const restrict island);
+static void runColourJobs(physicsIsland *const restrict island, const size_t colour, const size_t numConstraints, threadPoolJob job, const float dt);
+static void presolveColourJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+static void warmStartColourJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1 && defined(PHYSCONTACT_WARM_START)
+static void warmStartContactColourJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+#endif
+static void velocityColourJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+#ifdef PHYSCONTACT_SOLVER_SIMD
+static void packContactBlocks(physicsIsland *const restrict island);
+#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1 && defined(PHYSCONTACT_WARM_START)
+static void warmStartContactBlockColourJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+#endif
+static void velocityColourBlockJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+#endif
+#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1
+static void integrateVelocityGraphJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+#endif
+static void integrateGraphJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
+static void positionColourJob(void *const args, const size_t jobIndex, const size_t threadIndex);
+#endif
+static void solveConstraintsParallel(physicsIsland *const restrict island, const float dt);
+#endif
 static void solveConstraints(physicsIsland *const restrict island, const float dt);
 
+#ifdef PHYSISLAND_CONTINUOUS_COLLISION
+static return_t bodyIsFast(const physicsRigidBody *const restrict body, const vec3 *const restrict displacement);
+static void continuousCallback(void *const restrict collider, void *const restrict query);
+static void sweepBody(physicsIsland *const restrict island, physicsRigidBody *const restrict body, const float dt);
+static void solveContinuous(physicsIsland *const restrict island, const float dt);
+#endif
+
+static float raycastCallback(void *const restrict collider, const float maxDistance, void *query);
+static void raycastBatchJob(void *const batch, const size_t jobIndex, const size_t threadIndex);
+static float raycastBatchCallback(void *const restrict collider, const size_t ray, const float maxDistance, void *job);
+static void shapeCastCallback(void *const restrict collider, void *query);
+static void overlapCallback(void *const restrict collider, void *query);
+static float reportHit(physicsSceneQuery *const restrict query, const physicsRaycastHit *const restrict hit, const float maxDistance);
+static void shapeBounds(const collider *const restrict shape, colliderAABB *const restrict aabb);
+
+static void snapshotWrite(physicsIslandSnapshot *const restrict snapshot, const void *const restrict data, const size_t size);
+static void snapshotRead(const byte_t **const restrict cursor, void *const restrict data, const size_t size);
+static void snapshotWriteBody(physicsIslandSnapshot *const restrict snapshot, const physicsRigidBody *const restrict body);
+static void snapshotReadBody(const byte_t **const restrict cursor, physicsRigidBody *const restrict body, uint_least32_t *const restrict sleepNext);
+static void snapshotWriteContact(physicsIslandSnapshot *const restrict snapshot, const physicsContactPair *const restrict contact);
+static return_t snapshotReadContact(const byte_t **const restrict cursor, physicsContactPair *const restrict contact);
+static void snapshotWriteContactPoint(physicsIslandSnapshot *const restrict snapshot, const physicsContactPoint *const restrict point);
+static void snapshotReadContactPoint(const byte_t **const restrict cursor, physicsContactPoint *const restrict point);
+static void snapshotWriteSeparation(physicsIslandSnapshot *const restrict snapshot, const physicsSeparationPair *const restrict separation);
+static void snapshotReadSeparation(const byte_t **const restrict cursor, physicsSeparationPair *const restrict separation);
+static size_t snapshotJointSize(const physicsJoint *const restrict joint);
+static return_t snapshotValidatePairs(
+	const physicsIsland *const restrict island, const byte_t *cursor,
+	const physicsIslandSnapshotHeader *const restrict header, physColliderKey *const restrict keys
+);
+static sort_t compareKeys(const void *const restrict k1, const void *const restrict k2);
+static return_t hasKey(const physColliderKey *const restrict keys, const size_t numKeys, const physColliderKey key);
+static sort_t compareColliderKeys(const void *const restrict c1, const void *const restrict c2);
+static physicsCollider *findColliderByKey(physicsCollider *const *const restrict colliders, const size_t numColliders, const physColliderKey key);
+
 
 void physIslandInit(physicsIsland *const restrict island){
 	aabbTreeInit(&island->tree);
+	aabbPairCacheInit(&island->pairCache);
+	aabbSweepInit(&island->sweep);
+	aabbArrayTreeInit(&island->arrayTree);
+	island->broadphase = PHYSISLAND_BROADPHASE_AABBTREE;
 
 	island->bodies = NULL;
 	island->contacts = NULL;
 	island->separations = NULL;
 	island->joints = NULL;
+
+	island->graphBodies = NULL;
+	island->graphJoints = NULL;
+	island->graphContacts = NULL;
+	island->graphs = NULL;
+	island->graphParents = NULL;
+	island->numGraphs = 0;
+	island->bodyCapacity = 0;
+	island->jointCapacity = 0;
+	island->contactCapacity = 0;
+
+	#ifdef PHYSCONTACT_PACKED_SOLVER
+	island->solverBodies = NULL;
+	physContactConstraintsInit(&island->contactConstraints);
+	#endif
+
+	island->candidates = NULL;
+	island->numCandidates = 0;
+	island->candidateCapacity = 0;
+
+	#ifdef PHYSISLAND_PARALLEL_SOLVER
+	island->colourJoints = NULL;
+	island->colourContacts = NULL;
+	island->jointColours = NULL;
+	island->contactColours = NULL;
+	island->bodyColours = NULL;
+	island->threadSeparations = NULL;
+	island->threadSolved = NULL;
+	island->threadCapacity = 0;
+	#ifdef PHYSCONTACT_SOLVER_SIMD
+	island->contactBlocks = NULL;
+	island->blockCapacity = 0;
+	#endif
+	#endif
+
+	island->workers = NULL;
+
+	island->nextColliderKey = 0;
+
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerInit(&island->profiler);
+	#endif
+}
+
+
+/*
+** Choose which broadphase the island should use. This
+** can only be done while the island has no colliders.
+*/
+return_t physIslandSetBroadphase(physicsIsland *const restrict island, const byte_t broadphase){
+	if(broadphaseLeaves(island) != NULL){
+		return(0);
+	}
+	island->broadphase = broadphase;
+
+	return(1);
 }
 
 
@@ -102,8 +393,17 @@ void physIslandRemoveRigidBody(physicsIsland *const restrict island, physicsRigi
 	physicsJoint *joint;
 	physicsCollider *collider;
 
-	physicsRigidBody *const nextBody = modulePhysicsRigidBodyNext(body);
-	physicsRigidBody *const prevBody = modulePhysicsRigidBodyPrev(body);
+	physicsRigidBody *nextBody;
+	physicsRigidBody *prevBody;
+
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	// Any bodies that fell asleep with this one
+	// shouldn't be left pointing to it afterwards.
+	physRigidBodyWake(body);
+	#endif
+
+	nextBody = modulePhysicsRigidBodyNext(body);
+	prevBody = modulePhysicsRigidBodyPrev(body);
 	// Fix up the next list element's pointers.
 	if(nextBody != NULL){
 		memDoubleListPrev(nextBody) = prevBody;
@@ -145,6 +445,10 @@ void physIslandRemoveRigidBodyList(physicsIsland *const restrict island, physics
 			physicsJoint *joint;
 			physicsCollider *collider;
 
+			#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+			physRigidBodyWake(lastBody);
+			#endif
+
 			joint = lastBody->joints;
 			// Remove any joints owned by this body from the island.
 			while(joint != NULL && joint->bodyA == lastBody){
@@ -187,27 +491,692 @@ void physIslandRemoveRigidBodyList(physicsIsland *const restrict island, physics
 
 
 void physIslandUpdate(physicsIsland *const restrict island, const float dt){
+	#ifdef PHYSISLAND_PROFILE
+	const timerVal stepStart = timerStart();
+	timerVal phaseStart = stepStart;
+
+	physProfilerBeginStep(&island->profiler);
+	#endif
+
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	// Joints attached to awake bodies should wake the other body.
+	wakeJointBodies(island);
+	#endif
 	// Update each of the island's rigid bodies and their colliders.
 	updateRigidBodies(island, dt);
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_BODIES, phaseStart);
+	#endif
 
 	// Check for any new contacts and separations between colliders.
 	// We also presolve any contact constraints in this function.
-	#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+	#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 	queryCollisions(island, 1.f/dt);
 	#else
 	queryCollisions(island);
 	#endif
 
+	// Split the island into independent constraint graphs.
+	#ifdef PHYSISLAND_PROFILE
+	phaseStart = timerStart();
+	#endif
+	buildConstraintGraphs(island);
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_GRAPHS, phaseStart);
+	#endif
 	solveConstraints(island, dt);
+
+	#ifdef PHYSISLAND_CONTINUOUS_COLLISION
+	// Stop any fast bodies from tunnelling through other colliders.
+	#ifdef PHYSISLAND_PROFILE
+	phaseStart = timerStart();
+	#endif
+	solveContinuous(island, dt);
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_CONTINUOUS, phaseStart);
+	#endif
+	#endif
+
+	// The array tree only adds moved leaves when it's queried. Doing
+	// it now means scene queries between updates won't modify the
+	// tree, so they can be run on several threads at once.
+	if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		aabbArrayTreeFlush(&island->arrayTree);
+	}
+
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_TOTAL, stepStart);
+	physProfilerEndStep(&island->profiler);
+	#endif
+}
+
+
+/*
+** Find the closest collider hit by a ray starting at "origin" and
+** travelling in the unit direction "dir" for at most "maxDistance".
+** Only colliders on one of the layers in "mask" are considered.
+*/
+return_t physIslandRaycast(
+	physicsIsland *const restrict island, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+){
+
+	physicsSceneQuery query;
+
+	query.origin = *origin;
+	query.dir = *dir;
+	colliderAABBInvertRay(dir, &query.invDir);
+	query.mask = mask;
+	query.type = PHYSISLAND_QUERY_CLOSEST;
+	query.hit = hit;
+	query.numHits = 0;
+	queryBroadphaseRay(island, origin, &query.invDir, maxDistance, &raycastCallback, &query);
+
+	return(query.numHits > 0);
+}
+
+/*
+** This is the same as "physIslandRaycast", but we stop at the first
+** hit we find, which may not be the closest. This is much faster for
+** queries that only need to know if something is in the way.
+*/
+return_t physIslandRaycastAny(
+	physicsIsland *const restrict island, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+){
+
+	physicsSceneQuery query;
+
+	query.origin = *origin;
+	query.dir = *dir;
+	colliderAABBInvertRay(dir, &query.invDir);
+	query.mask = mask;
+	query.type = PHYSISLAND_QUERY_ANY;
+	query.hit = hit;
+	query.numHits = 0;
+	queryBroadphaseRay(island, origin, &query.invDir, maxDistance, &raycastCallback, &query);
+
+	return(query.numHits > 0);
+}
+
+/*
+** Call "callback" for every collider hit by the ray, in no particular
+** order, and return the number of colliders that were hit.
+*/
+size_t physIslandRaycastAll(
+	physicsIsland *const restrict island, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask,
+	void (*const callback)(const physicsRaycastHit *const restrict hit, void *args), void *args
+){
+
+	physicsSceneQuery query;
+
+	query.origin = *origin;
+	query.dir = *dir;
+	colliderAABBInvertRay(dir, &query.invDir);
+	query.mask = mask;
+	query.type = PHYSISLAND_QUERY_ALL;
+	query.callback = callback;
+	query.args = args;
+	query.numHits = 0;
+	queryBroadphaseRay(island, origin, &query.invDir, maxDistance, &raycastCallback, &query);
+
+	return(query.numHits);
+}
+
+/*
+** Find the closest collider hit by each ray in a batch. The results
+** are stored in "hits", and rays that don't hit anything are given
+** a NULL collider. If the island has worker threads, the batch will
+** be split between them. We return the number of rays that hit.
+**
+** When the island uses the tree, rays are traversed in packets, so
+** neighbouring rays should travel in similar directions if possible.
+*/
+size_t physIslandRaycastBatch(
+	physicsIsland *const restrict island, const vec3 *const restrict origins, const vec3 *const restrict dirs,
+	const float *const restrict maxDistances, const size_t numRays, const physicsColliderLayer mask,
+	physicsRaycastHit *const restrict hits
+){
+
+	physicsRaycastBatch batch;
+	const size_t numJobs = (numRays + PHYSISLAND_RAYCAST_BATCH_SIZE - 1) / PHYSISLAND_RAYCAST_BATCH_SIZE;
+	size_t numHits = 0;
+	size_t i;
+
+	batch.island = island;
+	batch.origins = origins;
+	batch.dirs = dirs;
+	batch.maxDistances = maxDistances;
+	batch.numRays = numRays;
+	batch.mask = mask;
+	batch.hits = hits;
+
+	// Colliders added since the last update may still be waiting to
+	// be added to the array tree. Queries would add them otherwise,
+	// which isn't safe to do on several threads at once.
+	if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		aabbArrayTreeFlush(&island->arrayTree);
+	}
+	if(island->workers != NULL && numJobs > 1){
+		threadPoolRun(island->workers, &raycastBatchJob, &batch, numJobs);
+	}else{
+		for(i = 0; i < numJobs; ++i){
+			raycastBatchJob(&batch, i, 0);
+		}
+	}
+
+	for(i = 0; i < numRays; ++i){
+		if(hits[i].collider != NULL){
+			++numHits;
+		}
+	}
+
+	return(numHits);
+}
+
+/*
+** Find the first collider hit by a convex shape moving in the unit
+** direction "dir" for at most "maxDistance". The shape should be in
+** global space, and it is neither rotated nor affected by collisions.
+*/
+return_t physIslandShapeCast(
+	physicsIsland *const restrict island, const collider *const restrict shape, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+){
+
+	physicsSceneQuery query;
+	colliderAABB sweptAABB;
+	vec3 displacement;
+
+	query.dir = *dir;
+	query.shape = shape;
+	shapeBounds(shape, &query.aabb);
+	query.maxDistance = maxDistance;
+	query.mask = mask;
+	query.type = PHYSISLAND_QUERY_CLOSEST;
+	query.hit = hit;
+	query.numHits = 0;
+
+	vec3MultiplySOut(dir, maxDistance, &displacement);
+	colliderAABBExpandVec3(&query.aabb, &displacement, &sweptAABB);
+	queryBroadphaseAABB(island, &sweptAABB, &shapeCastCallback, &query);
+
+	return(query.numHits > 0);
+}
+
+// Sweep a sphere through the island and find the first collider it hits.
+return_t physIslandSphereCast(
+	physicsIsland *const restrict island, const colliderSphere *const restrict sphere, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+){
+
+	collider shape;
+
+	shape.data.sphere = *sphere;
+	shape.type = COLLIDER_TYPE_SPHERE;
+
+	return(physIslandShapeCast(island, &shape, dir, maxDistance, mask, hit));
+}
+
+// Sweep a capsule through the island and find the first collider it hits.
+return_t physIslandCapsuleCast(
+	physicsIsland *const restrict island, const colliderCapsule *const restrict capsule, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+){
+
+	collider shape;
+
+	shape.data.capsule = *capsule;
+	shape.type = COLLIDER_TYPE_CAPSULE;
+
+	return(physIslandShapeCast(island, &shape, dir, maxDistance, mask, hit));
+}
+
+/*
+** Call "callback" for every collider whose bounding box overlaps
+** "aabb" and return the number of colliders that were found.
+*/
+size_t physIslandQueryAABB(
+	physicsIsland *const restrict island, const colliderAABB *const restrict aabb, const physicsColliderLayer mask,
+	void (*const callback)(physicsCollider *const restrict collider, void *args), void *args
+){
+
+	physicsOverlapQuery query;
+
+	query.aabb = aabb;
+	query.shape = NULL;
+	query.mask = mask;
+	query.callback = callback;
+	query.args = args;
+	query.numHits = 0;
+	queryBroadphaseAABB(island, aabb, &overlapCallback, &query);
+
+	return(query.numHits);
+}
+
+/*
+** Call "callback" for every collider that intersects a convex shape
+** in global space and return the number of colliders that were found.
+*/
+size_t physIslandQueryShape(
+	physicsIsland *const restrict island, const collider *const restrict shape, const physicsColliderLayer mask,
+	void (*const callback)(physicsCollider *const restrict collider, void *args), void *args
+){
+
+	physicsOverlapQuery query;
+	colliderAABB aabb;
+
+	shapeBounds(shape, &aabb);
+	query.aabb = &aabb;
+	query.shape = shape;
+	query.mask = mask;
+	query.callback = callback;
+	query.args = args;
+	query.numHits = 0;
+	queryBroadphaseAABB(island, &aabb, &overlapCallback, &query);
+
+	return(query.numHits);
+}
+
+
+void physIslandSnapshotInit(physicsIslandSnapshot *const restrict snapshot){
+	snapshot->data = NULL;
+	snapshot->size = 0;
+	snapshot->capacity = 0;
+}
+
+/*
+** Write the island's current state to a snapshot, replacing whatever
+** it held before. This should only be done between updates. Bodies,
+** colliders and joints are written in the order of the island's lists,
+** and pairs refer to their colliders using their keys.
+*/
+void physIslandSnapshotSave(physicsIsland *const restrict island, physicsIslandSnapshot *const restrict snapshot){
+	physicsIslandSnapshotHeader header;
+	physicsRigidBody *body;
+	const physicsJoint *joint;
+	const physicsContactPair *contact;
+	const physicsSeparationPair *separation;
+
+	header.numBodies = 0;
+	header.numColliders = 0;
+	// Bodies that fell asleep together point to each other, so we
+	// need to number them before we can write any of them out.
+	// Body indices are only used during updates, so we borrow them.
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		const physicsCollider *collider = body->colliders;
+		body->islandIndex = header.numBodies;
+		++header.numBodies;
+		for(; collider != NULL; collider = modulePhysicsColliderNext(collider)){
+			++header.numColliders;
+		}
+	}
+	header.numJoints = 0;
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		++header.numJoints;
+	}
+	header.numContacts = 0;
+	for(contact = island->contacts; contact != NULL; contact = modulePhysicsContactPairNext(contact)){
+		++header.numContacts;
+	}
+	header.numSeparations = 0;
+	for(separation = island->separations; separation != NULL; separation = modulePhysicsSeparationPairNext(separation)){
+		++header.numSeparations;
+	}
+	header.nextColliderKey = island->nextColliderKey;
+
+	snapshot->size = 0;
+	snapshotWrite(snapshot, &header, sizeof(header));
+
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		const physicsCollider *collider = body->colliders;
+
+		snapshotWriteBody(snapshot, body);
+		// Colliders only need their keys and the bounding boxes of
+		// their nodes. Everything else is recomputed from the body.
+		for(; collider != NULL; collider = modulePhysicsColliderNext(collider)){
+			const byte_t hasNode = (collider->node != NULL);
+			snapshotWrite(snapshot, &collider->key, sizeof(collider->key));
+			snapshotWrite(snapshot, &hasNode, sizeof(hasNode));
+			if(hasNode){
+				snapshotWrite(snapshot, &collider->node->aabb, sizeof(collider->node->aabb));
+			}
+		}
+	}
+
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		snapshotWrite(snapshot, &joint->data, snapshotJointSize(joint));
+	}
+
+	for(contact = island->contacts; contact != NULL; contact = modulePhysicsContactPairNext(contact)){
+		snapshotWrite(snapshot, &contact->cA->key, sizeof(contact->cA->key));
+		snapshotWrite(snapshot, &contact->cB->key, sizeof(contact->cB->key));
+		snapshotWriteContact(snapshot, contact);
+	}
+	for(separation = island->separations; separation != NULL; separation = modulePhysicsSeparationPairNext(separation)){
+		snapshotWrite(snapshot, &separation->cA->key, sizeof(separation->cA->key));
+		snapshotWrite(snapshot, &separation->cB->key, sizeof(separation->cB->key));
+		snapshotWriteSeparation(snapshot, separation);
+	}
+}
+
+/*
+** Return the island to the state stored in a snapshot. The island must
+** have the same bodies, colliders and joints as when the snapshot was
+** taken. If their numbers don't match, or a pair refers to a collider
+** that isn't in the snapshot, this returns 0 and does nothing.
+**
+** The island's pairs are recreated in the order they were saved in, so
+** the island will be solved in exactly the same way as it was before.
+*/
+return_t physIslandSnapshotRestore(physicsIsland *const restrict island, const physicsIslandSnapshot *const restrict snapshot){
+	const byte_t *cursor = snapshot->data;
+	physicsIslandSnapshotHeader header;
+	memArenaMarker marker;
+	physicsRigidBody **bodies;
+	physicsCollider **colliders;
+	physColliderKey *keys;
+	physicsRigidBody *body;
+	physicsJoint *joint;
+	physicsContactPair *contact = NULL;
+	physicsSeparationPair *separation = NULL;
+	size_t numBodies = 0;
+	size_t numColliders = 0;
+	size_t numJoints = 0;
+	size_t i;
+
+	if(snapshot->size < sizeof(header)){
+		return(0);
+	}
+	snapshotRead(&cursor, &header, sizeof(header));
+
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		const physicsCollider *collider = body->colliders;
+		++numBodies;
+		for(; collider != NULL; collider = modulePhysicsColliderNext(collider)){
+			++numColliders;
+		}
+	}
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		++numJoints;
+	}
+	if(numBodies != header.numBodies || numColliders != header.numColliders || numJoints != header.numJoints){
+		return(0);
+	}
+
+	// These lookup tables are only needed until we return.
+	marker = memArenaThreadGetMarker();
+	bodies = memArenaThreadAlloc((numBodies + 1) * sizeof(*bodies));
+	if(bodies == NULL){
+		/** MALLOC FAILED **/
+	}
+	colliders = memArenaThreadAlloc((numColliders + 1) * sizeof(*colliders));
+	if(colliders == NULL){
+		/** MALLOC FAILED **/
+	}
+	keys = memArenaThreadAlloc((numColliders + 1) * sizeof(*keys));
+	if(keys == NULL){
+		/** MALLOC FAILED **/
+	}
+
+	// Make sure we can find every pair's colliders before we
+	// change anything, so a bad snapshot leaves the island alone.
+	if(!snapshotValidatePairs(island, cursor, &header, keys)){
+		memArenaThreadRollback(&marker);
+		return(0);
+	}
+
+	i = 0;
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		bodies[i] = body;
+		++i;
+	}
+
+	// The pairs are all recreated from the snapshot.
+	modulePhysicsContactPairFreeArray(&island->contacts);
+	modulePhysicsSeparationPairFreeArray(&island->separations);
+
+	numColliders = 0;
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		physicsCollider *collider = body->colliders;
+		uint_least32_t sleepNext;
+
+		snapshotReadBody(&cursor, body, &sleepNext);
+		#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+		body->sleepNext = (sleepNext < numBodies) ? bodies[sleepNext] : NULL;
+		#endif
+
+		for(; collider != NULL; collider = modulePhysicsColliderNext(collider)){
+			byte_t hasNode;
+			colliderAABB aabb;
+
+			snapshotRead(&cursor, &collider->key, sizeof(collider->key));
+			snapshotRead(&cursor, &hasNode, sizeof(hasNode));
+			// The body may have moved since the snapshot
+			// was taken, so its colliders need updating.
+			physColliderUpdate(collider);
+
+			// Make sure the collider's node exists if and only if it
+			// did when the snapshot was taken, and give it the same
+			// bounding box so the broadphase finds the same pairs.
+			if(hasNode){
+				snapshotRead(&cursor, &aabb, sizeof(aabb));
+				if(collider->node == NULL){
+					insertColliderNode(island, collider, &aabb);
+				}else{
+					collider->node->aabb = aabb;
+					moveColliderNode(island, collider);
+				}
+			}else{
+				removeColliderNode(island, collider);
+			}
+
+			colliders[numColliders] = collider;
+			++numColliders;
+		}
+	}
+	// Sort the colliders by key so we can find the pairs' colliders.
+	if(numColliders > 1){
+		timsort(colliders, numColliders, sizeof(*colliders), &compareColliderKeys);
+	}
+
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		snapshotRead(&cursor, &joint->data, snapshotJointSize(joint));
+	}
+
+	// Insert each pair after the previous one so
+	// the island's lists keep their original order.
+	for(i = 0; i < header.numContacts; ++i){
+		physicsCollider *cA;
+		physicsCollider *cB;
+		physColliderKey key;
+		physicsContactPair *prevPair;
+		physicsContactPair *nextPair;
+
+		snapshotRead(&cursor, &key, sizeof(key));
+		cA = findColliderByKey(colliders, numColliders, key);
+		snapshotRead(&cursor, &key, sizeof(key));
+		cB = findColliderByKey(colliders, numColliders, key);
+
+		contact = modulePhysicsContactPairInsertAfter(&island->contacts, contact);
+		if(contact == NULL){
+			/** MALLOC FAILED **/
+		}
+		physColliderFindContact(cA, cB, &prevPair, &nextPair);
+		physContactPairInit(contact, cA, cB, prevPair, nextPair);
+		snapshotReadContact(&cursor, contact);
+	}
+	for(i = 0; i < header.numSeparations; ++i){
+		physicsCollider *cA;
+		physicsCollider *cB;
+		physColliderKey key;
+		physicsSeparationPair *prevPair;
+		physicsSeparationPair *nextPair;
+
+		snapshotRead(&cursor, &key, sizeof(key));
+		cA = findColliderByKey(colliders, numColliders, key);
+		snapshotRead(&cursor, &key, sizeof(key));
+		cB = findColliderByKey(colliders, numColliders, key);
+
+		separation = modulePhysicsSeparationPairInsertAfter(&island->separations, separation);
+		if(separation == NULL){
+			/** MALLOC FAILED **/
+		}
+		physColliderFindSeparation(cA, cB, &prevPair, &nextPair);
+		physSeparationPairInit(separation, cA, cB, prevPair, nextPair);
+		snapshotReadSeparation(&cursor, separation);
+	}
+	// The cached pairs still refer to the separations we just freed.
+	if(island->broadphase == PHYSISLAND_BROADPHASE_AABBTREE){
+		for(i = 0; i < island->pairCache.numPairs; ++i){
+			island->pairCache.pairs[i].value = findCachedSeparation(&island->pairCache.pairs[i]);
+		}
+	}
+
+	island->nextColliderKey = header.nextColliderKey;
+
+	memArenaThreadRollback(&marker);
+
+	return(1);
+}
+
+// Return whether two snapshots store exactly the same state.
+return_t physIslandSnapshotEqual(const physicsIslandSnapshot *const restrict snapshotA, const physicsIslandSnapshot *const restrict snapshotB){
+	return(snapshotA->size == snapshotB->size && memcmp(snapshotA->data, snapshotB->data, snapshotA->size) == 0);
+}
+
+/*
+** Restore an island from a snapshot and update it "numSteps" times.
+** If "input" isn't NULL, it's called before each update so the
+** caller can apply the forces or impulses for that step again.
+** As long as the inputs and time steps are the same, the island
+** will finish in exactly the same state as it did the first time.
+*/
+return_t physIslandResimulate(
+	physicsIsland *const restrict island, const physicsIslandSnapshot *const restrict snapshot,
+	const size_t numSteps, const float dt,
+	void (*const input)(physicsIsland *const restrict island, const size_t step, void *args), void *args
+){
+
+	size_t i;
+
+	if(!physIslandSnapshotRestore(island, snapshot)){
+		return(0);
+	}
+	for(i = 0; i < numSteps; ++i){
+		if(input != NULL){
+			(*input)(island, i, args);
+		}
+		physIslandUpdate(island, dt);
+	}
+
+	return(1);
+}
+
+void physIslandSnapshotDelete(physicsIslandSnapshot *const restrict snapshot){
+	if(snapshot->data != NULL){
+		memoryManagerGlobalFree(snapshot->data);
+	}
 }
 
 
 // Free every node in a physics island's tree.
 void physIslandDelete(physicsIsland *const restrict island){
-	aabbTreeTraverse(&island->tree, &freeNodeCallback, island);
+	if(island->broadphase == PHYSISLAND_BROADPHASE_SWEEP){
+		aabbSweepTraverse(&island->sweep, &freeNodeCallback, island);
+	}else if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		aabbArrayTreeTraverse(&island->arrayTree, &freeNodeCallback, island);
+	}else{
+		// Every node is being removed, so there's
+		// no point removing their pairs one by one.
+		aabbPairCacheClear(&island->pairCache);
+		aabbTreeTraverse(&island->tree, &freeNodeCallback, island);
+	}
+	aabbPairCacheDelete(&island->pairCache);
+	aabbSweepDelete(&island->sweep);
+	aabbArrayTreeDelete(&island->arrayTree);
+
+	if(island->graphBodies != NULL){
+		memoryManagerGlobalFree(island->graphBodies);
+	}
+	if(island->graphJoints != NULL){
+		memoryManagerGlobalFree(island->graphJoints);
+	}
+	if(island->graphContacts != NULL){
+		memoryManagerGlobalFree(island->graphContacts);
+	}
+	if(island->graphs != NULL){
+		memoryManagerGlobalFree(island->graphs);
+	}
+	if(island->graphParents != NULL){
+		memoryManagerGlobalFree(island->graphParents);
+	}
+	#ifdef PHYSCONTACT_PACKED_SOLVER
+	if(island->solverBodies != NULL){
+		memoryManagerGlobalFree(island->solverBodies);
+	}
+	physContactConstraintsDelete(&island->contactConstraints);
+	#endif
+	if(island->candidates != NULL){
+		memoryManagerGlobalFree(island->candidates);
+	}
+
+	#ifdef PHYSISLAND_PARALLEL_SOLVER
+	if(island->colourJoints != NULL){
+		memoryManagerGlobalFree(island->colourJoints);
+	}
+	if(island->colourContacts != NULL){
+		memoryManagerGlobalFree(island->colourContacts);
+	}
+	if(island->jointColours != NULL){
+		memoryManagerGlobalFree(island->jointColours);
+	}
+	if(island->contactColours != NULL){
+		memoryManagerGlobalFree(island->contactColours);
+	}
+	if(island->bodyColours != NULL){
+		memoryManagerGlobalFree(island->bodyColours);
+	}
+	if(island->threadSeparations != NULL){
+		memoryManagerGlobalFree(island->threadSeparations);
+	}
+	if(island->threadSolved != NULL){
+		memoryManagerGlobalFree(island->threadSolved);
+	}
+	#ifdef PHYSCONTACT_SOLVER_SIMD
+	if(island->contactBlocks != NULL){
+		memoryManagerGlobalFree(island->contactBlocks);
+	}
+	#endif
+	#endif
 }
 
 
+// Add a collider to the island's broadphase using the bounding box "aabb".
+static void insertColliderNode(physicsIsland *const restrict island, physicsCollider *const restrict collider, const colliderAABB *const restrict aabb){
+	if(island->broadphase == PHYSISLAND_BROADPHASE_SWEEP){
+		collider->node = aabbSweepInsertNode(&island->sweep, aabb, (void *)collider, &modulePhysicsAABBNodeAlloc);
+	}else if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		collider->node = aabbArrayTreeInsertNode(&island->arrayTree, aabb, (void *)collider, &modulePhysicsAABBNodeAlloc);
+	}else{
+		collider->node = aabbTreeInsertNode(&island->tree, aabb, (void *)collider, &modulePhysicsAABBNodeAlloc);
+		aabbPairCacheInsertNode(&island->pairCache, collider->node);
+	}
+}
+
+// Tell the broadphase that a collider's node has a new bounding box.
+static void moveColliderNode(physicsIsland *const restrict island, physicsCollider *const restrict collider){
+	if(island->broadphase == PHYSISLAND_BROADPHASE_SWEEP){
+		aabbSweepUpdateNode(&island->sweep, collider->node);
+	}else if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		aabbArrayTreeUpdateNode(&island->arrayTree, collider->node);
+	}else{
+		aabbTreeUpdateNode(&island->tree, collider->node);
+		aabbPairCacheMoveNode(&island->pairCache, collider->node);
+	}
+}
+
 /*
 ** For every physics collider that is a part of
 ** this rigid body, we will need to update its
@@ -227,7 +1196,11 @@ static void insertColliders(physicsIsland *const restrict island, physicsRigidBo
 			#ifdef PHYSISLAND_AABBTREE_NODE_EXPAND_BY_VELOCITY
 			colliderAABBExpandVec3(&aabb, &curCollider->owner->linearVelocity, &aabb);
 			#endif
-			curCollider->node = aabbTreeInsertNode(&island->tree, &aabb, (void *)curCollider, &modulePhysicsAABBNodeAlloc);
+			// Keys are handed out in the order colliders are inserted,
+			// which only depends on the order of the island's bodies.
+			curCollider->key = island->nextColliderKey;
+			++island->nextColliderKey;
+			insertColliderNode(island, curCollider, &aabb);
 
 		// Otherwise, update its node!
 		}else if(!colliderAABBEnvelopsAABB(&curCollider->node->aabb, &curCollider->aabb)){
@@ -236,7 +1209,7 @@ static void insertColliders(physicsIsland *const restrict island, physicsRigidBo
 			#ifdef PHYSISLAND_AABBTREE_NODE_EXPAND_BY_VELOCITY
 			colliderAABBExpandVec3(&curCollider->node->aabb, &curCollider->owner->linearVelocity, &curCollider->node->aabb);
 			#endif
-			aabbTreeUpdateNode(&island->tree, curCollider->node);
+			moveColliderNode(island, curCollider);
 		}
 	}
 }
@@ -245,7 +1218,13 @@ static void insertColliders(physicsIsland *const restrict island, physicsRigidBo
 static void removeColliderNode(physicsIsland *const restrict island, physicsCollider *const restrict collider){
 	if(collider->node != NULL){
 		// The callback function will clear the collider's node pointer.
-		aabbTreeRemoveNode(&island->tree, collider->node, &freeNodeCallback, island);
+		if(island->broadphase == PHYSISLAND_BROADPHASE_SWEEP){
+			aabbSweepRemoveNode(&island->sweep, collider->node, &freeNodeCallback, island);
+		}else if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+			aabbArrayTreeRemoveNode(&island->arrayTree, collider->node, &freeNodeCallback, island);
+		}else{
+			aabbTreeRemoveNode(&island->tree, collider->node, &freeNodeCallback, island);
+		}
 	}
 }
 
@@ -287,14 +1266,56 @@ static void removeJoint(physicsIsland *const restrict island, physicsJoint *cons
 }
 
 
+#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+/*
+** Return whether a rigid body can generate new collision pairs.
+** This is true for bodies that are awake, as well as for bodies
+** that aren't simulated but have been moved since the last update.
+*/
+static return_t bodyIsActive(const physicsRigidBody *const restrict body){
+	if(physRigidBodyIsAsleep(body)){
+		return(0);
+	}
+	return(
+		flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE) ||
+		flagsContainsSubset(body->flags, PHYSRIGIDBODY_TRANSFORMED)
+	);
+}
+
+/*
+** If a joint connects an awake body to a sleeping one,
+** the sleeping body (and its neighbours) should wake up.
+*/
+static void wakeJointBodies(physicsIsland *const restrict island){
+	physicsJoint *joint = island->joints;
+	for(; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		if(bodyIsActive(joint->bodyA) || bodyIsActive(joint->bodyB)){
+			physRigidBodyWake(joint->bodyA);
+			physRigidBodyWake(joint->bodyB);
+		}
+	}
+}
+#endif
+
 /*
-** Updating a rigid body involves integrating its velocity.
+** Updating a rigid body involves integrating its velocity, unless
+** the solver is sub-stepping, in which case it does this instead.
 ** We also need to update their colliders and broadphase nodes.
 */
 static void updateRigidBodies(physicsIsland *const restrict island, const float dt){
 	physicsRigidBody *curBody = island->bodies;
 	for(; curBody != NULL; curBody = modulePhysicsRigidBodyNext(curBody)){
+		#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+		// Sleeping bodies haven't moved, so there's nothing to do.
+		if(physRigidBodyIsAsleep(curBody)){
+			continue;
+		}
+		#endif
+		#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1
+		physRigidBodyUpdateSubstepped(curBody);
+		#else
 		physRigidBodyUpdate(curBody, dt);
+		#endif
 
 		// If the rigid body allows collisions and has changed in the last update,
 		// we'll need to transform the colliders and re-add them to the island.
@@ -316,139 +1337,447 @@ static void updateRigidBodies(physicsIsland *const restrict island, const float
 }
 
 
-/*
-** If the bounding boxes of "colliderA" and "colliderB" intersect, check
-** for collision with the narrowphase and create a collision pair for them.
-*/
-static void collisionCallback(void *const colliderA, void *const colliderB, void *const restrict island){
-	// Make sure these colliders and rigid bodies are actually allowed to collide.
-	// We ensure that the address of collider A is greater than that of collider B.
-	if(
-		physColliderPermitCollision((physicsCollider *)colliderA, (physicsCollider *)colliderB) &&
-		physRigidBodyPermitCollision(((physicsCollider *)colliderA)->owner, ((physicsCollider *)colliderB)->owner)
-	){
-		// We should only run the narrowphase if the broadphase succeeds.
-		if(colliderAABBCollidingAABB(&((physicsCollider *)colliderA)->node->aabb, &((physicsCollider *)colliderB)->node->aabb)){
-			// Used when searching for an existing contact
-			// or separation or when creating a new one.
-			void *prevPair;
-			void *nextPair;
-			void *sharedPair;
-			// These variables store the results
-			// of our narrowphase collision check.
-			contactSeparation *separationPointer;
-			contactSeparation separation;
-			contactManifold manifold;
-
-
-			// Check if a separation involving our colliders exists.
-			sharedPair = physColliderFindSeparation(
-				(physicsCollider *)colliderA, (physicsCollider *)colliderB,
-				(physicsSeparationPair **)&prevPair, (physicsSeparationPair **)&nextPair
-			);
-			// If it does, we need to check if it is still valid.
-			if(sharedPair != NULL){
-				separationPointer = &(((physicsSeparationPair *)sharedPair)->separation);
-
-				// If the separation still exists, refresh it and return.
-				if(collidersAreSeparated(&(((physicsCollider *)colliderA)->global), &(((physicsCollider *)colliderB)->global), separationPointer)){
-					physPairRefresh((physicsSeparationPair *)sharedPair);
-					return;
-				}
+// Return the first leaf in the island's broadphase.
+static aabbNode *broadphaseLeaves(const physicsIsland *const restrict island){
+	if(island->broadphase == PHYSISLAND_BROADPHASE_SWEEP){
+		return(island->sweep.leaves);
+	}else if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		return(island->arrayTree.leaves);
+	}
+	return(island->tree.leaves);
+}
 
-			// Otherwise, direct our pointer to our new separation.
-			}else{
-				separationPointer = &separation;
-			}
+// Call "callback" on every collider whose node overlaps "aabb".
+static void queryBroadphaseAABB(
+	physicsIsland *const restrict island, const colliderAABB *const restrict aabb,
+	void (*const callback)(void *const restrict value, void *args), void *args
+){
 
+	if(island->broadphase == PHYSISLAND_BROADPHASE_SWEEP){
+		aabbSweepQueryAABB(&island->sweep, aabb, callback, args);
+	}else if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		aabbArrayTreeQueryAABB(&island->arrayTree, aabb, callback, args);
+	}else{
+		aabbTreeQueryAABB(&island->tree, aabb, callback, args);
+	}
+}
 
-			// Narrowphase collision check.
-			if(collidersAreColliding(&(((physicsCollider *)colliderA)->global), &(((physicsCollider *)colliderB)->global), separationPointer, &manifold)){
-				sharedPair = physColliderFindContact(
-					(physicsCollider *)colliderA, (physicsCollider *)colliderB,
-					(physicsContactPair **)&prevPair, (physicsContactPair **)&nextPair
-				);
-				// If a contact pair already exists, we need to refresh it
-				// and update the manifold components required for persistence.
-				if(sharedPair != NULL){
-					physManifoldPersist(&(((physicsContactPair *)sharedPair)->manifold), &manifold, colliderA, colliderB);
-					physPairRefresh((physicsContactPair *)sharedPair);
+// Call "callback" on every collider whose node is hit by the ray.
+static void queryBroadphaseRay(
+	physicsIsland *const restrict island, const vec3 *const restrict origin, const vec3 *const restrict invDir, const float maxDistance,
+	float (*const callback)(void *const restrict value, const float maxDistance, void *args), void *args
+){
 
-				// If this is a new contact, allocate a new pair.
-				}else{
-					sharedPair = modulePhysicsContactPairPrepend(&((physicsIsland *)island)->contacts);
-					if(sharedPair == NULL){
-						/** MALLOC FAILED **/
-					}
-
-					// Set up the new contact pair. This involves building a physics manifold
-					// from our contact manifold and setting up its linked lists components.
-					//
-					// Note that we're already guaranteed that the address of collider A
-					// is greater than that of collider B, so nothing weird can happen.
-					physManifoldInit(&((physicsContactPair *)sharedPair)->manifold, &manifold, (physicsCollider *)colliderA, (physicsCollider *)colliderB);
-					physContactPairInit(
-						(physicsContactPair *)sharedPair,
-						(physicsCollider *)colliderA, (physicsCollider *)colliderB,
-						(physicsContactPair *)prevPair, (physicsContactPair *)nextPair
-					);
-				}
+	if(island->broadphase == PHYSISLAND_BROADPHASE_SWEEP){
+		aabbSweepQueryRay(&island->sweep, origin, invDir, maxDistance, callback, args);
+	}else if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		aabbArrayTreeQueryRay(&island->arrayTree, origin, invDir, maxDistance, callback, args);
+	}else{
+		aabbTreeQueryRay(&island->tree, origin, invDir, maxDistance, callback, args);
+	}
+}
 
-			// Colliders are not penetrating, so we have a separation.
-			}else{
-				// If a separation pair containing these colliders
-				// already existed, we just have to refresh it.
-				if(sharedPair != NULL){
-					physPairRefresh((physicsSeparationPair *)sharedPair);
+/*
+** Add a candidate for a pair of colliders whose bounding boxes overlap,
+** unless they can't collide or can't have changed since the last update.
+** The candidate's separation pair and cached pair need to be set up by
+** the caller.
+*/
+static physicsCandidatePair *addCandidate(physicsIsland *const restrict island, physicsCollider *const colliderA, physicsCollider *const colliderB){
+	// The broadphases only report each overlapping pair once, so we need
+	// to make sure the collider with the greater key is passed in first.
+	physicsCollider *const cA = (colliderA->key > colliderB->key) ? colliderA : colliderB;
+	physicsCollider *const cB = (colliderA->key > colliderB->key) ? colliderB : colliderA;
+
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	// Pairs of inactive colliders can't have changed since the last update.
+	if(!bodyIsActive(cA->owner) && !bodyIsActive(cB->owner)){
+		return(NULL);
+	}
+	#endif
 
-				// Otherwise, we'll have to create one.
-				}else{
-					sharedPair = modulePhysicsSeparationPairPrepend(&((physicsIsland *)island)->separations);
-					if(sharedPair == NULL){
-						/** MALLOC FAILED **/
-					}
-
-					((physicsSeparationPair *)sharedPair)->separation = *separationPointer;
-					// Set up the new separation pair, including its lists.
-					physSeparationPairInit(
-						(physicsSeparationPair *)sharedPair,
-						(physicsCollider *)colliderA, (physicsCollider *)colliderB,
-						(physicsSeparationPair *)prevPair, (physicsSeparationPair *)nextPair
-					);
-				}
+	// Make sure these colliders and rigid bodies are actually allowed to collide.
+	if(physColliderPermitCollision(cA, cB) && physRigidBodyPermitCollision(cA->owner, cB->owner)){
+		physicsCandidatePair *candidate;
+
+		reserveCandidates(island, island->numCandidates + 1);
+		candidate = &island->candidates[island->numCandidates];
+		++island->numCandidates;
+
+		candidate->cA = cA;
+		candidate->cB = cB;
+
+		return(candidate);
+	}
+
+	return(NULL);
+}
+
+static void candidateCallback(void *const colliderA, void *const colliderB, void *const restrict island){
+	physicsCandidatePair *const candidate = addCandidate(island, colliderA, colliderB);
+	if(candidate != NULL){
+		physicsSeparationPair *prevPair;
+		physicsSeparationPair *nextPair;
+
+		// Check if a separation involving our colliders exists. If it
+		// does, the narrowphase can check whether it's still valid.
+		candidate->separationPair = physColliderFindSeparation(candidate->cA, candidate->cB, &prevPair, &nextPair);
+		if(candidate->separationPair != NULL){
+			candidate->separation = candidate->separationPair->separation;
+		}
+		candidate->cachedPair = NULL;
+	}
+}
+
+// Search for the separation pair between the colliders of a cached pair.
+static physicsSeparationPair *findCachedSeparation(const aabbPair *const restrict pair){
+	const physicsCollider *const colliderA = pair->a->data.leaf.value;
+	const physicsCollider *const colliderB = pair->b->data.leaf.value;
+	physicsSeparationPair *prevPair;
+	physicsSeparationPair *nextPair;
+
+	if(colliderA->key > colliderB->key){
+		return(physColliderFindSeparation(colliderA, colliderB, &prevPair, &nextPair));
+	}
+	return(physColliderFindSeparation(colliderB, colliderA, &prevPair, &nextPair));
+}
+
+// Make sure the island's candidate array can store "numCandidates" pairs.
+static void reserveCandidates(physicsIsland *const restrict island, const size_t numCandidates){
+	if(numCandidates > island->candidateCapacity){
+		const size_t newCapacity = (island->candidateCapacity > 0) ? 2*island->candidateCapacity : PHYSISLAND_NARROWPHASE_BATCH_SIZE;
+		island->candidates = memoryManagerGlobalRealloc(island->candidates, newCapacity * sizeof(*island->candidates));
+		if(island->candidates == NULL){
+			/** MALLOC FAILED **/
+		}
+		island->candidateCapacity = newCapacity;
+	}
+}
+
+#ifdef PHYSCONTACT_SPECULATIVE
+/*
+** Return how close a candidate's colliders need to be for us
+** to give them speculative contacts. This is grown by how far
+** they could approach each other during the update, so fast
+** bodies are caught earlier, but is capped so that bodies
+** don't snag on colliders that they're only passing by.
+*/
+static float speculativeMargin(const physicsCandidatePair *const restrict candidate, const float dt){
+	vec3 relativeVelocity;
+	vec3SubtractVec3Out(&candidate->cB->owner->linearVelocity, &candidate->cA->owner->linearVelocity, &relativeVelocity);
+	return(floatMin(
+		PHYSCONTACT_SPECULATIVE_DISTANCE + dt * vec3MagnitudeVec3(&relativeVelocity),
+		PHYSCONTACT_SPECULATIVE_MAX_DISTANCE
+	));
+}
+#endif
+
+/*
+** Run the narrowphase on a batch of candidate pairs. This doesn't touch
+** anything outside of the candidates themselves, so several batches
+** can be run on different threads. The results are stored in each
+** candidate and merged into the island's pairs later on.
+*/
+static void narrowphaseJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsNarrowphaseJobArgs *const jobArgs = (physicsNarrowphaseJobArgs *)args;
+	const size_t first = jobIndex * PHYSISLAND_NARROWPHASE_BATCH_SIZE;
+	const size_t last = first + PHYSISLAND_NARROWPHASE_BATCH_SIZE;
+	physicsCandidatePair *candidate = &jobArgs->island->candidates[first];
+	const physicsCandidatePair *const lastCandidate = &jobArgs->island->candidates[
+		(last < jobArgs->island->numCandidates) ? last : jobArgs->island->numCandidates
+	];
+
+	for(; candidate < lastCandidate; ++candidate){
+		// If the colliders were previously separated,
+		// check whether the separation is still valid.
+		if(
+			candidate->separationPair != NULL &&
+			collidersAreSeparated(&candidate->cA->global, &candidate->cB->global, &candidate->separation)
+		){
+			candidate->result = PHYSCANDIDATE_SEPARATED_CACHED;
+
+		// Narrowphase collision check.
+		}else if(collidersAreColliding(&candidate->cA->global, &candidate->cB->global, &candidate->separation, &candidate->manifold)){
+			candidate->result = PHYSCANDIDATE_COLLIDING;
+		}else{
+			candidate->result = PHYSCANDIDATE_SEPARATED;
+		}
+
+		#ifdef PHYSCONTACT_SPECULATIVE
+		// If the colliders are separated but close enough that they
+		// could touch during this update, we use the features that
+		// separate them to build a manifold of speculative contacts.
+		candidate->speculative = (candidate->result != PHYSCANDIDATE_COLLIDING) && collidersAreNearby(
+			&candidate->cA->global, &candidate->cB->global, &candidate->separation,
+			speculativeMargin(candidate, jobArgs->dt), &candidate->manifold
+		);
+		#endif
+	}
+}
+
+/*
+** Create or refresh the contact pair for a candidate whose
+** narrowphase check found a manifold of contact points.
+*/
+static void mergeContact(physicsIsland *const restrict island, const physicsCandidatePair *const restrict candidate){
+	// Used when searching for an existing
+	// contact or when creating a new one.
+	void *prevPair;
+	void *nextPair;
+	void *sharedPair;
+
+	sharedPair = physColliderFindContact(
+		candidate->cA, candidate->cB,
+		(physicsContactPair **)&prevPair, (physicsContactPair **)&nextPair
+	);
+	// If a contact pair already exists, we need to refresh it
+	// and update the manifold components required for persistence.
+	if(sharedPair != NULL){
+		physManifoldPersist(&(((physicsContactPair *)sharedPair)->manifold), &candidate->manifold, candidate->cA, candidate->cB);
+		physPairRefresh((physicsContactPair *)sharedPair);
+
+	// If this is a new contact, allocate a new pair.
+	}else{
+		sharedPair = modulePhysicsContactPairPrepend(&island->contacts);
+		if(sharedPair == NULL){
+			/** MALLOC FAILED **/
+		}
+
+		// Set up the new contact pair. This involves building a physics manifold
+		// from our contact manifold and setting up its linked lists components.
+		//
+		// Note that we're already guaranteed that the key of collider A
+		// is greater than that of collider B, so nothing weird can happen.
+		physManifoldInit(&((physicsContactPair *)sharedPair)->manifold, &candidate->manifold, candidate->cA, candidate->cB);
+		physContactPairInit(
+			(physicsContactPair *)sharedPair,
+			candidate->cA, candidate->cB,
+			(physicsContactPair *)prevPair, (physicsContactPair *)nextPair
+		);
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerCount(&island->profiler, PHYSPROFILER_COUNTER_CONTACTS_CREATED, 1);
+		#endif
+	}
+
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	// Touching a sleeping body should wake it up.
+	physRigidBodyWake(candidate->cA->owner);
+	physRigidBodyWake(candidate->cB->owner);
+	#endif
+}
+
+/*
+** Use the result of a candidate's narrowphase check
+** to create or refresh a contact or separation pair.
+*/
+static void mergeCandidate(physicsIsland *const restrict island, const physicsCandidatePair *const restrict candidate){
+	// Used when searching for an existing contact
+	// or separation or when creating a new one.
+	void *prevPair;
+	void *nextPair;
+	void *sharedPair;
+
+	// The narrowphase works on a copy of the separation,
+	// so we need to write it back to the original pair.
+	if(candidate->separationPair != NULL){
+		candidate->separationPair->separation = candidate->separation;
+	}
+
+	// If the separation still exists, refresh it and return.
+	if(candidate->result == PHYSCANDIDATE_SEPARATED_CACHED){
+		physPairRefresh(candidate->separationPair);
+
+	// The colliders are penetrating, so we have a contact.
+	}else if(candidate->result == PHYSCANDIDATE_COLLIDING){
+		mergeContact(island, candidate);
+
+	// Colliders are not penetrating, so we have a separation.
+	}else{
+		// If a separation pair containing these colliders
+		// already existed, we just have to refresh it.
+		if(candidate->separationPair != NULL){
+			physPairRefresh(candidate->separationPair);
+
+		// Otherwise, we'll have to create one. Earlier merges may
+		// have added pairs to these colliders' lists, so we need
+		// to search for the new pair's neighbours again.
+		}else{
+			physColliderFindSeparation(
+				candidate->cA, candidate->cB,
+				(physicsSeparationPair **)&prevPair, (physicsSeparationPair **)&nextPair
+			);
+			sharedPair = modulePhysicsSeparationPairPrepend(&island->separations);
+			if(sharedPair == NULL){
+				/** MALLOC FAILED **/
+			}
+
+			((physicsSeparationPair *)sharedPair)->separation = candidate->separation;
+			// Set up the new separation pair, including its lists.
+			physSeparationPairInit(
+				(physicsSeparationPair *)sharedPair,
+				candidate->cA, candidate->cB,
+				(physicsSeparationPair *)prevPair, (physicsSeparationPair *)nextPair
+			);
+			// Remember the pair so we don't have to search for it again.
+			if(candidate->cachedPair != NULL){
+				candidate->cachedPair->value = sharedPair;
 			}
+			#ifdef PHYSISLAND_PROFILE
+			physProfilerCount(&island->profiler, PHYSPROFILER_COUNTER_SEPARATIONS_CREATED, 1);
+			#endif
+		}
+
+		#ifdef PHYSCONTACT_SPECULATIVE
+		// If the colliders are close enough to touch by the end
+		// of the step, we keep the separation so it can still be
+		// cached, but also add a contact with the speculative points.
+		if(candidate->speculative){
+			mergeContact(island, candidate);
 		}
+		#endif
 	}
 }
 
 /*
 ** Check for collision between every collider in
 ** the island and update their collision pairs.
+**
+** This happens in three stages. The broadphase first
+** builds a flat array of candidate pairs, which are then
+** checked by the narrowphase, possibly on several threads.
+** Finally, the results are merged into the island's lists.
 */
-#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 static void queryCollisions(physicsIsland *const restrict island, const float frequency){
 #else
 static void queryCollisions(physicsIsland *const restrict island){
 #endif
 	physicsCollider *collider;
-	aabbNode *node = island->tree.leaves;
+	aabbNode *node;
+	aabbPair *pair;
+	const aabbPair *lastPair;
+	const physicsCandidatePair *candidate;
+	const physicsCandidatePair *lastCandidate;
+	size_t numBatches;
+	physicsNarrowphaseJobArgs args;
+	#ifdef PHYSISLAND_PROFILE
+	timerVal phaseStart = timerStart();
+	#endif
 
-	while(node != NULL){
-		// Update all of the current collider's separations and contacts.
-		aabbTreeQueryCollisionsStack(&island->tree, node, &collisionCallback, island);
+	// Find every pair of colliders whose bounding boxes overlap.
+	island->numCandidates = 0;
+	if(island->broadphase == PHYSISLAND_BROADPHASE_SWEEP){
+		aabbSweepQueryCollisions(&island->sweep, &candidateCallback, island);
+	}else if(island->broadphase == PHYSISLAND_BROADPHASE_ARRAYTREE){
+		aabbArrayTreeQueryCollisions(&island->arrayTree, &candidateCallback, island);
+	}else{
+		const aabbPair *firstAdded;
+
+		// Only nodes that have moved since the last
+		// update need to query the tree for new pairs.
+		aabbPairCacheUpdate(&island->pairCache, &island->tree);
+		pair = island->pairCache.pairs;
+		firstAdded = &pair[island->pairCache.firstAdded];
+		lastPair = &pair[island->pairCache.numPairs];
+		for(; pair < lastPair; ++pair){
+			physicsCandidatePair *newCandidate;
+
+			// Pairs that were already in the cache remember their
+			// separation pairs, so we only need to search for the
+			// separations of pairs that have just been added. We do
+			// this even if the pair is skipped so the cache stays
+			// in sync with the colliders' lists.
+			if(pair >= firstAdded){
+				pair->value = findCachedSeparation(pair);
+			}
+
+			newCandidate = addCandidate(island, pair->a->data.leaf.value, pair->b->data.leaf.value);
+			if(newCandidate != NULL){
+				newCandidate->separationPair = pair->value;
+				if(newCandidate->separationPair != NULL){
+					newCandidate->separation = newCandidate->separationPair->separation;
+				}
+				newCandidate->cachedPair = pair;
+			}
+		}
+	}
 
+	#ifdef PHYSISLAND_DETERMINISTIC
+	// The order candidates are found in depends on the broadphase's
+	// structure, which depends on its history. Merging a candidate
+	// can warm start its bodies, so we sort them to make sure the
+	// results only depend on the current state of the island.
+	if(island->numCandidates > 1){
+		timsortPhysicsCandidatePairs(island->candidates, island->numCandidates);
+	}
+	#endif
+
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_BROADPHASE, phaseStart);
+	physProfilerCount(&island->profiler, PHYSPROFILER_COUNTER_PAIRS_TESTED, island->numCandidates);
+	phaseStart = timerStart();
+	#endif
+
+	// Run the narrowphase on each of the candidates.
+	args.island = island;
+	#ifdef PHYSCONTACT_SPECULATIVE
+	args.dt = 1.f/frequency;
+	#endif
+	numBatches = (island->numCandidates + PHYSISLAND_NARROWPHASE_BATCH_SIZE - 1) / PHYSISLAND_NARROWPHASE_BATCH_SIZE;
+	if(island->workers != NULL){
+		threadPoolRun(island->workers, &narrowphaseJob, &args, numBatches);
+	}else{
+		size_t i;
+		for(i = 0; i < numBatches; ++i){
+			narrowphaseJob(&args, i, 0);
+		}
+	}
+
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_NARROWPHASE, phaseStart);
+	phaseStart = timerStart();
+	#endif
+
+	// Create or refresh the pairs for each candidate.
+	// Pairs are only ever updated by their first collider,
+	// so it doesn't matter that this is done in one go.
+	candidate = island->candidates;
+	lastCandidate = &candidate[island->numCandidates];
+	for(; candidate < lastCandidate; ++candidate){
+		#ifdef PHYSISLAND_PROFILE
+		// The narrowphase may have run on several threads,
+		// so its per-pair counts are only collected here.
+		physProfilerCountPair(&island->profiler, candidate->cA->global.type, candidate->cB->global.type);
+		if(candidate->result == PHYSCANDIDATE_SEPARATED_CACHED){
+			physProfilerCount(&island->profiler, PHYSPROFILER_COUNTER_SEPARATIONS_CACHED, 1);
+		}
+		#endif
+		mergeCandidate(island, candidate);
+	}
+
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_MERGE, phaseStart);
+	phaseStart = timerStart();
+	#endif
+
+	node = broadphaseLeaves(island);
+	while(node != NULL){
 		collider = (physicsCollider *)node->data.leaf.value;
 		node = node->data.leaf.next;
 
 		// Remove any separations and contacts that are now inactive.
 		// We also need to presolve any of the collider's contacts.
-		#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+		#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 		updateColliderContacts(island, collider, frequency);
 		#else
 		updateColliderContacts(island, collider);
 		#endif
 		updateColliderSeparations(island, collider);
 	}
+
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_PAIRS, phaseStart);
+	#endif
 }
 
 
@@ -461,7 +1790,6 @@ static void freeNodeCallback(aabbNode *const restrict node, void *const restrict
 		physicsCollider *collider = node->data.leaf.value;
 		physicsContactPair *contact = collider->contacts;
 		physicsSeparationPair *separation = collider->separations;
-		aabbNode *prevNode = ((physicsIsland *)island)->tree.leaves;
 
 		// Delete all of the collider's contact pairs.
 		while(contact != NULL){
@@ -479,20 +1807,26 @@ static void freeNodeCallback(aabbNode *const restrict node, void *const restrict
 		// Remove this node from the island's linked list.
 		// If we're removing the tree's root node, we will
 		// need to fix up the beginning of the linked list.
+		// The other broadphases unlink their own leaves,
+		// so this is only necessary when we're using the tree.
 		#warning "This is a bad way of doing it, and possibly not even necessary."
 		#warning "Check how Randy Gaul uses his dynamic AABB tree."
 		#warning "He constructs a list of leaf nodes as part of his island when he's adding colliders to the tree."
 		#warning "To deal with the discarded nodes when removing colliders from the tree, he uses a free list."
-		if(prevNode == node){
-			((physicsIsland *)island)->tree.leaves = node->data.leaf.next;
-
-		// Otherwise, find the leaf before our node
-		// and make it point to the one after it.
-		}else{
-			while(prevNode->data.leaf.next != node){
-				prevNode = prevNode->data.leaf.next;
+		if(((physicsIsland *)island)->broadphase == PHYSISLAND_BROADPHASE_AABBTREE){
+			aabbNode *prevNode = ((physicsIsland *)island)->tree.leaves;
+			aabbPairCacheRemoveNode(&((physicsIsland *)island)->pairCache, node);
+			if(prevNode == node){
+				((physicsIsland *)island)->tree.leaves = node->data.leaf.next;
+
+			// Otherwise, find the leaf before our node
+			// and make it point to the one after it.
+			}else{
+				while(prevNode->data.leaf.next != node){
+					prevNode = prevNode->data.leaf.next;
+				}
+				prevNode->data.leaf.next = node->data.leaf.next;
 			}
-			prevNode->data.leaf.next = node->data.leaf.next;
 		}
 		collider->node = NULL;
 	}
@@ -506,7 +1840,7 @@ static void freeNodeCallback(aabbNode *const restrict node, void *const restrict
 ** update the inactivity flags of contacts that are still active.
 ** This will also update the manifolds of active contact pairs.
 */
-#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 static void updateColliderContacts(physicsIsland *const restrict island, physicsCollider *const restrict collider, const float frequency){
 #else
 static void updateColliderContacts(physicsIsland *const restrict island, physicsCollider *const restrict collider){
@@ -516,15 +1850,27 @@ static void updateColliderContacts(physicsIsland *const restrict island, physics
 	while(curPair != NULL && curPair->cA == collider){
 		physicsContactPair *nextPair = curPair->nextA;
 
+		#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+		// Pairs between inactive bodies aren't checked, so we
+		// should leave them alone until one of them wakes up.
+		if(!bodyIsActive(curPair->cA->owner) && !bodyIsActive(curPair->cB->owner)){
+			curPair = nextPair;
+			continue;
+		}
+		#endif
+
 		// If the current contact has been
 		// inactive for too long, deallocate it.
 		if(physContactPairIsInactive(curPair)){
 			modulePhysicsContactPairFree(&island->contacts, curPair);
+			#ifdef PHYSISLAND_PROFILE
+			physProfilerCount(&island->profiler, PHYSPROFILER_COUNTER_CONTACTS_DESTROYED, 1);
+			#endif
 
 		// For contacts, we need to precalculate their impulses and
 		// bias terms as well as increment their inactivity flag.
 		}else{
-			#ifdef PHYSCONTACT_STABILISER_BAUMGARTE
+			#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
 			physManifoldPresolve(&curPair->manifold, curPair->cA->owner, curPair->cB->owner, frequency);
 			#else
 			physManifoldPresolve(&curPair->manifold, curPair->cA->owner, curPair->cB->owner);
@@ -546,10 +1892,27 @@ static void updateColliderSeparations(physicsIsland *const restrict island, phys
 	while(curPair != NULL && curPair->cA == collider){
 		physicsSeparationPair *nextPair = curPair->nextA;
 
+		#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+		if(!bodyIsActive(curPair->cA->owner) && !bodyIsActive(curPair->cB->owner)){
+			curPair = nextPair;
+			continue;
+		}
+		#endif
+
 		// If the current separation has been
 		// inactive for too long, deallocate it.
 		if(physSeparationPairIsInactive(curPair)){
+			// Make sure the pair cache forgets about it.
+			if(island->broadphase == PHYSISLAND_BROADPHASE_AABBTREE){
+				aabbPair *const cachedPair = aabbPairCacheFind(&island->pairCache, curPair->cA->node, curPair->cB->node);
+				if(cachedPair != NULL){
+					cachedPair->value = NULL;
+				}
+			}
 			modulePhysicsSeparationPairFree(&island->separations, curPair);
+			#ifdef PHYSISLAND_PROFILE
+			physProfilerCount(&island->profiler, PHYSPROFILER_COUNTER_SEPARATIONS_DESTROYED, 1);
+			#endif
 
 		// We only need to increment the inactivity flag for
 		// separations. On the next physics step, this will
@@ -563,6 +1926,267 @@ static void updateColliderSeparations(physicsIsland *const restrict island, phys
 }
 
 
+/*
+** Make sure the island's graph arrays are large
+** enough to store the number of elements given.
+*/
+static void reserveGraphArrays(
+	physicsIsland *const restrict island,
+	const size_t numBodies, const size_t numJoints, const size_t numContacts
+){
+
+	if(numBodies > island->bodyCapacity){
+		island->graphBodies = memoryManagerGlobalRealloc(island->graphBodies, numBodies * sizeof(*island->graphBodies));
+		if(island->graphBodies == NULL){
+			/** MALLOC FAILED **/
+		}
+		// There can never be more graphs than bodies.
+		island->graphs = memoryManagerGlobalRealloc(island->graphs, numBodies * sizeof(*island->graphs));
+		if(island->graphs == NULL){
+			/** MALLOC FAILED **/
+		}
+		island->graphParents = memoryManagerGlobalRealloc(island->graphParents, numBodies * sizeof(*island->graphParents));
+		if(island->graphParents == NULL){
+			/** MALLOC FAILED **/
+		}
+		#ifdef PHYSCONTACT_PACKED_SOLVER
+		island->solverBodies = memoryManagerGlobalRealloc(island->solverBodies, numBodies * sizeof(*island->solverBodies));
+		if(island->solverBodies == NULL){
+			/** MALLOC FAILED **/
+		}
+		#endif
+		#ifdef PHYSISLAND_PARALLEL_SOLVER
+		island->bodyColours = memoryManagerGlobalRealloc(island->bodyColours, numBodies * sizeof(*island->bodyColours));
+		if(island->bodyColours == NULL){
+			/** MALLOC FAILED **/
+		}
+		#endif
+		island->bodyCapacity = numBodies;
+	}
+	if(numJoints > island->jointCapacity){
+		island->graphJoints = memoryManagerGlobalRealloc(island->graphJoints, numJoints * sizeof(*island->graphJoints));
+		if(island->graphJoints == NULL){
+			/** MALLOC FAILED **/
+		}
+		#ifdef PHYSISLAND_PARALLEL_SOLVER
+		island->colourJoints = memoryManagerGlobalRealloc(island->colourJoints, numJoints * sizeof(*island->colourJoints));
+		if(island->colourJoints == NULL){
+			/** MALLOC FAILED **/
+		}
+		island->jointColours = memoryManagerGlobalRealloc(island->jointColours, numJoints * sizeof(*island->jointColours));
+		if(island->jointColours == NULL){
+			/** MALLOC FAILED **/
+		}
+		#endif
+		island->jointCapacity = numJoints;
+	}
+	if(numContacts > island->contactCapacity){
+		island->graphContacts = memoryManagerGlobalRealloc(island->graphContacts, numContacts * sizeof(*island->graphContacts));
+		if(island->graphContacts == NULL){
+			/** MALLOC FAILED **/
+		}
+		#ifdef PHYSISLAND_PARALLEL_SOLVER
+		island->colourContacts = memoryManagerGlobalRealloc(island->colourContacts, numContacts * sizeof(*island->colourContacts));
+		if(island->colourContacts == NULL){
+			/** MALLOC FAILED **/
+		}
+		island->contactColours = memoryManagerGlobalRealloc(island->contactColours, numContacts * sizeof(*island->contactColours));
+		if(island->contactColours == NULL){
+			/** MALLOC FAILED **/
+		}
+		#endif
+		#ifdef PHYSCONTACT_PACKED_SOLVER
+		// We don't know how many points each manifold has
+		// yet, so assume they're all using every point.
+		physContactConstraintsReserve(&island->contactConstraints, numContacts, numContacts * CONTACT_MAX_POINTS);
+		#endif
+		island->contactCapacity = numContacts;
+	}
+}
+
+/*
+** Find the root of the set containing element "i".
+** We use path halving to keep the trees shallow.
+*/
+static size_t findGraphRoot(size_t *const restrict parents, size_t i){
+	while(parents[i] != i){
+		parents[i] = parents[parents[i]];
+		i = parents[i];
+	}
+
+	return(i);
+}
+
+/*
+** Merge the sets containing two bodies. We always make the root
+** with the smaller index the parent, which guarantees that every
+** element's parent has an index no larger than its own.
+*/
+static void mergeGraphs(size_t *const restrict parents, const physicsRigidBody *const bodyA, const physicsRigidBody *const bodyB){
+	// Bodies that aren't simulated can't transfer impulses between
+	// the bodies they're touching, so they don't link any graphs.
+	if(
+		flagsContainsSubset(bodyA->flags, PHYSRIGIDBODY_SIMULATE) &&
+		flagsContainsSubset(bodyB->flags, PHYSRIGIDBODY_SIMULATE)
+	){
+		const size_t rootA = findGraphRoot(parents, bodyA->islandIndex);
+		const size_t rootB = findGraphRoot(parents, bodyB->islandIndex);
+
+		if(rootA < rootB){
+			parents[rootB] = rootA;
+		}else{
+			parents[rootA] = rootB;
+		}
+	}
+}
+
+/*
+** Return the graph that a constraint between two bodies belongs to.
+** If only one of the bodies is simulated, we use that body's graph.
+*/
+static size_t constraintGraphIndex(
+	const size_t *const restrict parents,
+	const physicsRigidBody *const bodyA, const physicsRigidBody *const bodyB
+){
+
+	if(flagsContainsSubset(bodyA->flags, PHYSRIGIDBODY_SIMULATE)){
+		return(parents[bodyA->islandIndex]);
+	}
+	return(parents[bodyB->islandIndex]);
+}
+
+/*
+** Split the island's rigid bodies into constraint graphs using
+** union-find over the contacts and joints that link them together.
+** Afterwards, the bodies, joints and contacts of each graph are
+** stored contiguously in the island's graph arrays, which lets
+** us solve each graph separately.
+*/
+static void buildConstraintGraphs(physicsIsland *const restrict island){
+	size_t numBodies = 0;
+	size_t numJoints = 0;
+	size_t numContacts = 0;
+	size_t numGraphs = 0;
+	size_t *parents;
+	physicsConstraintGraph *graph;
+	size_t i;
+
+	physicsRigidBody *body;
+	physicsJoint *joint;
+	physicsContactPair *contactPair;
+
+
+	// Give each body an index and count the island's constraints.
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		body->islandIndex = numBodies;
+		++numBodies;
+	}
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		++numJoints;
+	}
+	for(contactPair = island->contacts; contactPair != NULL; contactPair = modulePhysicsContactPairNext(contactPair)){
+		++numContacts;
+	}
+	reserveGraphArrays(island, numBodies, numJoints, numContacts);
+	parents = island->graphParents;
+
+
+	// Every body starts off in its own set.
+	for(i = 0; i < numBodies; ++i){
+		parents[i] = i;
+	}
+	// Merge the sets of any bodies that share a constraint.
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		mergeGraphs(parents, joint->bodyA, joint->bodyB);
+	}
+	for(contactPair = island->contacts; contactPair != NULL; contactPair = modulePhysicsContactPairNext(contactPair)){
+		mergeGraphs(parents, contactPair->cA->owner, contactPair->cB->owner);
+	}
+
+	// Replace each element's parent with the index of its graph.
+	// Because a parent's index is never larger than its child's,
+	// the parent will always have been replaced before the child.
+	for(i = 0; i < numBodies; ++i){
+		const size_t parent = parents[i];
+		if(parent == i){
+			graph = &island->graphs[numGraphs];
+			graph->numBodies = 0;
+			graph->numJoints = 0;
+			graph->numContacts = 0;
+			parents[i] = numGraphs;
+			++numGraphs;
+		}else{
+			parents[i] = parents[parent];
+		}
+	}
+	island->numGraphs = numGraphs;
+
+
+	// Count the number of elements in each graph.
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		++island->graphs[parents[body->islandIndex]].numBodies;
+	}
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		++island->graphs[constraintGraphIndex(parents, joint->bodyA, joint->bodyB)].numJoints;
+	}
+	for(contactPair = island->contacts; contactPair != NULL; contactPair = modulePhysicsContactPairNext(contactPair)){
+		++island->graphs[constraintGraphIndex(parents, contactPair->cA->owner, contactPair->cB->owner)].numContacts;
+	}
+
+	// Compute where each graph starts in the arrays. We reset
+	// the counts so they can be used to insert the elements.
+	numBodies = 0;
+	numJoints = 0;
+	numContacts = 0;
+	graph = island->graphs;
+	for(i = numGraphs; i > 0; --i){
+		graph->bodyOffset = numBodies;
+		numBodies += graph->numBodies;
+		graph->numBodies = 0;
+		graph->jointOffset = numJoints;
+		numJoints += graph->numJoints;
+		graph->numJoints = 0;
+		graph->contactOffset = numContacts;
+		numContacts += graph->numContacts;
+		graph->numContacts = 0;
+		++graph;
+	}
+
+	// Sort the elements into their graphs. This preserves the order
+	// of the island's lists, so the solver's behaviour is unchanged.
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		graph = &island->graphs[parents[body->islandIndex]];
+		island->graphBodies[graph->bodyOffset + graph->numBodies] = body;
+		++graph->numBodies;
+	}
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		graph = &island->graphs[constraintGraphIndex(parents, joint->bodyA, joint->bodyB)];
+		island->graphJoints[graph->jointOffset + graph->numJoints] = joint;
+		++graph->numJoints;
+	}
+	for(contactPair = island->contacts; contactPair != NULL; contactPair = modulePhysicsContactPairNext(contactPair)){
+		graph = &island->graphs[constraintGraphIndex(parents, contactPair->cA->owner, contactPair->cB->owner)];
+		island->graphContacts[graph->contactOffset + graph->numContacts] = contactPair;
+		++graph->numContacts;
+	}
+	// Now that we're done with the union-find parents,
+	// store the index of each body in the graph arrays.
+	for(i = 0; i < numBodies; ++i){
+		island->graphBodies[i]->islandIndex = i;
+	}
+
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	// Check which graphs are asleep. We need to do this before
+	// solving, as this might wake some of the graphs' bodies.
+	graph = island->graphs;
+	for(i = numGraphs; i > 0; --i){
+		graph->asleep = constraintGraphIsAsleep(island, graph);
+		++graph;
+	}
+	#endif
+}
+
+
 /*
 ** Solve the constraints, such as contacts and joints,
 ** for every system that is currently being simulated.
@@ -588,8 +2212,10 @@ static void updateColliderSeparations(physicsIsland *const restrict island, phys
 ** }
 **
 ** for all rigid bodies {
-**     integrate velocity;
-**     reset forces;
+**     if not sub-stepping {
+**         integrate velocity;
+**         reset forces;
+**     }
 **     update colliders;
 **     update bounding boxes;
 ** }
@@ -608,120 +2234,1805 @@ static void updateColliderSeparations(physicsIsland *const restrict island, phys
 **     }
 ** }
 **
+** buildConstraintGraphs(){
+**     union-find bodies over contacts and joints;
+** }
+**
 ** solveConstraints(){
-**     for all joints {
-**         presolve joint;
-**     }
+**     for all constraint graphs {
+**         for all substeps {
+**             if sub-stepping {
+**                 for all graph.rigidBodies {
+**                     integrate velocity;
+**                 }
+**             }
 **
-**     for all velocity solver iterations {
-**         for all joints {
-**             solve joint velocity constraints;
-**         }
+**             for all graph.joints {
+**                 presolve joint;
+**                 warm start joint;
+**             }
 **
-**         for all contacts {
-**             solve contact velocity constraints;
-**         }
-**     }
+**             if sub-stepping and not first substep {
+**                 for all graph.contacts {
+**                     warm start contact;
+**                 }
+**             }
 **
-**     for all rigid bodies {
-**         integrate position;
-**     }
+**             for all velocity solver iterations {
+**                 for all graph.joints {
+**                     solve joint velocity constraints;
+**                 }
+**
+**                 for all graph.contacts {
+**                     solve contact velocity constraints;
+**                 }
+**             }
 **
-**     for configuration solver iterations {
-**         for all joints {
-**             solve joint configuration constraints;
+**             for all graph.rigidBodies {
+**                 integrate position;
+**             }
+**
+**             for configuration solver iterations {
+**                 for all graph.joints {
+**                     solve joint configuration constraints;
+**                 }
+**
+**                 for all graph.contacts {
+**                     solve contact configuration constraints;
+**                 }
+**             }
 **         }
 **
-**         for all contacts {
-**             solve contact configuration constraints;
+**         if sub-stepping {
+**             for all graph.rigidBodies {
+**                 reset forces;
+**             }
 **         }
 **     }
 ** }
 */
 static void solveConstraints(physicsIsland *const restrict island, const float dt){
-	size_t i;
-	physicsRigidBody *body;
-	physicsJoint *joint;
-	physicsContactPair *contactPair;
-
+	const physicsConstraintGraph *graph = island->graphs;
+	const physicsConstraintGraph *const lastGraph = &graph[island->numGraphs];
+	#if defined(PHYSISLAND_PROFILE) && defined(PHYSRIGIDBODY_ALLOW_SLEEPING)
+	timerVal phaseStart;
+	#endif
 
-	// Presolve joints.
-	joint = island->joints;
-	while(joint != NULL){
-		physJointPresolve(joint, dt);
-		joint = modulePhysicsJointNext(joint);
+	#ifdef PHYSISLAND_PARALLEL_SOLVER
+	// Only bother with the parallel solver if we have enough
+	// constraints. Graphs are stored in order, so the last
+	// graph's ranges tell us how many constraints there are.
+	if(
+		island->workers != NULL && threadPoolNumThreads(island->workers) > 1 && island->numGraphs > 0 &&
+		(lastGraph - 1)->jointOffset + (lastGraph - 1)->numJoints +
+		(lastGraph - 1)->contactOffset + (lastGraph - 1)->numContacts >= PHYSISLAND_SOLVER_MIN_CONSTRAINTS
+	){
+		solveConstraintsParallel(island, dt);
+	}else
+	#endif
+	{
+		// Graphs don't share any bodies, so they can be solved separately.
+		for(; graph < lastGraph; ++graph){
+			#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+			if(graph->asleep){
+				continue;
+			}
+			#endif
+			solveConstraintGraph(island, graph, dt);
+		}
 	}
 
+	#if defined(PHYSISLAND_PROFILE) && !defined(PHYSRIGIDBODY_ALLOW_SLEEPING)
+	physProfilerCount(&island->profiler, PHYSPROFILER_COUNTER_GRAPHS_SOLVED, island->numGraphs);
+	#endif
 
-	// Iteratively solve joint and contact velocity constraints.
-	for(i = PHYSICS_VELOCITY_SOLVER_NUM_ITERATIONS; i > 0; --i){
-		// Solve joint velocity constraints.
-		joint = island->joints;
-		while(joint != NULL){
-			physJointSolveVelocity(joint);
-			joint = modulePhysicsJointNext(joint);
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	#ifdef PHYSISLAND_PROFILE
+	phaseStart = timerStart();
+	#endif
+	for(graph = island->graphs; graph < lastGraph; ++graph){
+		if(!graph->asleep){
+			updateConstraintGraphSleep(island, graph, dt);
+			#ifdef PHYSISLAND_PROFILE
+			physProfilerCount(&island->profiler, PHYSPROFILER_COUNTER_GRAPHS_SOLVED, 1);
+			#endif
 		}
-
-		// Solve contact velocity constraints.
-		contactPair = island->contacts;
-		while(contactPair != NULL){
-			physManifoldSolveVelocity(&contactPair->manifold, contactPair->cA->owner, contactPair->cB->owner);
-			contactPair = modulePhysicsContactPairNext(contactPair);
+	}
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_SLEEP, phaseStart);
+	#endif
+	#endif
+}
+
+#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+/*
+** Return whether every simulated body in a graph is asleep.
+** If the graph has any awake bodies, we wake the whole graph.
+*/
+static return_t constraintGraphIsAsleep(const physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph){
+	physicsRigidBody *const *const firstBody = &island->graphBodies[graph->bodyOffset];
+	physicsRigidBody *const *const lastBody = &firstBody[graph->numBodies];
+	physicsRigidBody *const *body;
+	return_t hasSleeping = 0;
+	return_t hasAwake = 0;
+
+	for(body = firstBody; body < lastBody; ++body){
+		if(physRigidBodyIsAsleep(*body)){
+			hasSleeping = 1;
+		}else if(flagsContainsSubset((*body)->flags, PHYSRIGIDBODY_SIMULATE)){
+			hasAwake = 1;
+		}
+	}
+
+	// This shouldn't really happen, as touching a sleeping body
+	// wakes it, but if it does, the whole graph needs to wake.
+	if(hasSleeping && hasAwake){
+		for(body = firstBody; body < lastBody; ++body){
+			physRigidBodyWake(*body);
 		}
+		return(0);
 	}
 
+	return(hasSleeping);
+}
+
+/*
+** Update the sleep timers of a graph's bodies. If every body in the
+** graph has been resting for long enough, the graph falls asleep.
+*/
+static void updateConstraintGraphSleep(physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph, const float dt){
+	physicsRigidBody *const *const firstBody = &island->graphBodies[graph->bodyOffset];
+	physicsRigidBody *const *const lastBody = &firstBody[graph->numBodies];
+	physicsRigidBody *const *body;
+	physicsRigidBody *firstSleeping = NULL;
+	physicsRigidBody *prevSleeping = NULL;
+	return_t canSleep = 1;
+
+	// A graph can only fall asleep if all of its bodies are resting.
+	for(body = firstBody; body < lastBody; ++body){
+		if(flagsContainsSubset((*body)->flags, PHYSRIGIDBODY_SIMULATE)){
+			if(physRigidBodyIsResting(*body)){
+				(*body)->sleepTime += dt;
+				if((*body)->sleepTime < PHYSISLAND_TIME_TO_SLEEP){
+					canSleep = 0;
+				}
+			}else{
+				(*body)->sleepTime = 0.f;
+				canSleep = 0;
+			}
+		}
+	}
+	if(!canSleep){
+		return;
+	}
 
-	// Integrate each physics object's position.
-	body = island->bodies;
-	while(body != NULL){
-		physRigidBodyIntegratePosition(body, dt);
-		body = modulePhysicsRigidBodyNext(body);
+	// Put the graph's bodies to sleep and link them together,
+	// so waking any of them will wake the rest of the graph.
+	for(body = firstBody; body < lastBody; ++body){
+		if(flagsContainsSubset((*body)->flags, PHYSRIGIDBODY_SIMULATE)){
+			physRigidBodySleep(*body);
+			// Sleeping bodies' colliders aren't updated until they wake
+			// up, so they should match where the solver left the body.
+			if(physRigidBodyIsCollidable(*body)){
+				insertColliders(island, *body);
+			}
+			if(prevSleeping != NULL){
+				prevSleeping->sleepNext = *body;
+			}else{
+				firstSleeping = *body;
+			}
+			prevSleeping = *body;
+		}
 	}
+	// Graphs without any simulated bodies never sleep.
+	if(prevSleeping != NULL){
+		prevSleeping->sleepNext = firstSleeping;
+	}
+}
+#endif
 
+#ifdef PHYSISLAND_PARALLEL_SOLVER
+/*
+** Choose the lowest colour that neither of a constraint's simulated
+** bodies is using yet and mark it as used. Bodies that aren't simulated
+** are never written to by the solver, as the rigid body impulse functions
+** ignore them and the packed solvers give them a zeroed solver body, so
+** they can be shared by any number of constraints of the same colour.
+*/
+static byte_t constraintColour(uint_least64_t *const restrict bodyColours, const physicsRigidBody *const bodyA, const physicsRigidBody *const bodyB){
+	const return_t simulateA = flagsContainsSubset(bodyA->flags, PHYSRIGIDBODY_SIMULATE);
+	const return_t simulateB = flagsContainsSubset(bodyB->flags, PHYSRIGIDBODY_SIMULATE);
+	uint_least64_t used = 0;
+	uint_least64_t bit = 1;
+	byte_t colour = 0;
+
+	if(simulateA){
+		used |= bodyColours[bodyA->islandIndex];
+	}
+	if(simulateB){
+		used |= bodyColours[bodyB->islandIndex];
+	}
 
-	#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
-	// Iteratively solve joint and contact configuration constraints.
-	for(i = PHYSICS_POSITION_SOLVER_NUM_ITERATIONS; i > 0; --i){
-		#ifdef PHYSJOINT_USE_POSITIONAL_CORRECTION
-		return_t solved = 1;
+	// Find the first colour that isn't used by either body.
+	while(used & bit){
+		++colour;
+		if(colour >= PHYSISLAND_SOLVER_NUM_COLOURS){
+			return(PHYSISLAND_SOLVER_OVERFLOW_COLOUR);
+		}
+		bit <<= 1;
+	}
+
+	if(simulateA){
+		bodyColours[bodyA->islandIndex] |= bit;
+	}
+	if(simulateB){
+		bodyColours[bodyB->islandIndex] |= bit;
+	}
+
+	return(colour);
+}
+
+/*
+** Greedily colour the joints and contacts of every awake graph,
+** then sort them by colour into the island's colour arrays.
+*/
+static void colourConstraints(physicsIsland *const restrict island){
+	const physicsConstraintGraph *graph = island->graphs;
+	const physicsConstraintGraph *const lastGraph = &graph[island->numGraphs];
+	physicsConstraintColour *colour;
+	size_t numJoints = 0;
+	size_t numContacts = 0;
+	size_t i;
+
+	// Clear the colours used by each body.
+	if(island->numGraphs > 0){
+		memset(island->bodyColours, 0, ((lastGraph - 1)->bodyOffset + (lastGraph - 1)->numBodies) * sizeof(*island->bodyColours));
+	}
+	for(colour = island->colours; colour <= &island->colours[PHYSISLAND_SOLVER_OVERFLOW_COLOUR]; ++colour){
+		colour->numJoints = 0;
+		colour->numContacts = 0;
+	}
+
+	// Colour each constraint and count the number of constraints of each colour.
+	for(; graph < lastGraph; ++graph){
+		#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+		if(graph->asleep){
+			continue;
+		}
 		#endif
-		#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
-		float separation = 0.f;
+		for(i = graph->jointOffset; i < graph->jointOffset + graph->numJoints; ++i){
+			const physicsJoint *const joint = island->graphJoints[i];
+			island->jointColours[i] = constraintColour(island->bodyColours, joint->bodyA, joint->bodyB);
+			++island->colours[island->jointColours[i]].numJoints;
+		}
+		for(i = graph->contactOffset; i < graph->contactOffset + graph->numContacts; ++i){
+			const physicsContactPair *const contactPair = island->graphContacts[i];
+			island->contactColours[i] = constraintColour(island->bodyColours, contactPair->cA->owner, contactPair->cB->owner);
+			++island->colours[island->contactColours[i]].numContacts;
+		}
+	}
+
+	// Compute where each colour starts in the arrays.
+	for(colour = island->colours; colour <= &island->colours[PHYSISLAND_SOLVER_OVERFLOW_COLOUR]; ++colour){
+		colour->jointOffset = numJoints;
+		numJoints += colour->numJoints;
+		colour->numJoints = 0;
+		colour->contactOffset = numContacts;
+		numContacts += colour->numContacts;
+		colour->numContacts = 0;
+	}
+
+	// Sort the constraints by colour.
+	for(graph = island->graphs; graph < lastGraph; ++graph){
+		#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+		if(graph->asleep){
+			continue;
+		}
 		#endif
+		for(i = graph->jointOffset; i < graph->jointOffset + graph->numJoints; ++i){
+			colour = &island->colours[island->jointColours[i]];
+			island->colourJoints[colour->jointOffset + colour->numJoints] = island->graphJoints[i];
+			++colour->numJoints;
+		}
+		for(i = graph->contactOffset; i < graph->contactOffset + graph->numContacts; ++i){
+			colour = &island->colours[island->contactColours[i]];
+			island->colourContacts[colour->contactOffset + colour->numContacts] = island->graphContacts[i];
+			++colour->numContacts;
+		}
+	}
+}
 
-		#ifdef PHYSJOINT_USE_POSITIONAL_CORRECTION
-		// Solve joint configuration constraints.
-		joint = island->joints;
-		while(joint != NULL){
-			solved &= physJointSolvePosition(joint);
-			joint = modulePhysicsJointNext(joint);
+/*
+** Run a job over every constraint of a single colour. The overflow
+** colour may have constraints that share bodies, so it's always
+** run on the calling thread.
+*/
+static void runColourJobs(physicsIsland *const restrict island, const size_t colour, const size_t numConstraints, threadPoolJob job, const float dt){
+	physicsSolverJobArgs args;
+	const size_t numJobs = (numConstraints + PHYSISLAND_SOLVER_BATCH_SIZE - 1) / PHYSISLAND_SOLVER_BATCH_SIZE;
+
+	args.island = island;
+	args.colour = &island->colours[colour];
+	args.dt = dt;
+
+	if(colour == PHYSISLAND_SOLVER_OVERFLOW_COLOUR){
+		size_t i;
+		for(i = 0; i < numJobs; ++i){
+			job(&args, i, 0);
 		}
+	}else if(numJobs > 0){
+		threadPoolRun(island->workers, job, &args, numJobs);
+	}
+}
+
+/*
+** Presolve a batch of a colour's joints.
+** Contacts are presolved when they're updated.
+*/
+static void presolveColourJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintColour *const colour = jobArgs->colour;
+	const size_t first = jobIndex * PHYSISLAND_SOLVER_BATCH_SIZE;
+	const size_t last = first + PHYSISLAND_SOLVER_BATCH_SIZE;
+	physicsJoint *const *joint = &jobArgs->island->colourJoints[colour->jointOffset + first];
+	physicsJoint *const *const lastJoint = &jobArgs->island->colourJoints[
+		colour->jointOffset + ((last < colour->numJoints) ? last : colour->numJoints)
+	];
+
+	for(; joint < lastJoint; ++joint){
+		physJointPresolve(*joint, jobArgs->dt);
+	}
+}
+
+// Warm start a batch of a colour's joints.
+static void warmStartColourJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintColour *const colour = jobArgs->colour;
+	const size_t first = jobIndex * PHYSISLAND_SOLVER_BATCH_SIZE;
+	const size_t last = first + PHYSISLAND_SOLVER_BATCH_SIZE;
+	physicsJoint *const *joint = &jobArgs->island->colourJoints[colour->jointOffset + first];
+	physicsJoint *const *const lastJoint = &jobArgs->island->colourJoints[
+		colour->jointOffset + ((last < colour->numJoints) ? last : colour->numJoints)
+	];
+
+	for(; joint < lastJoint; ++joint){
+		physJointWarmStart(*joint);
+	}
+}
+
+#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1 && defined(PHYSCONTACT_WARM_START)
+// Warm start a batch of a colour's contacts.
+static void warmStartContactColourJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintColour *const colour = jobArgs->colour;
+	size_t i = jobIndex * PHYSISLAND_SOLVER_BATCH_SIZE;
+	const size_t last = (i + PHYSISLAND_SOLVER_BATCH_SIZE < colour->numContacts) ? i + PHYSISLAND_SOLVER_BATCH_SIZE : colour->numContacts;
+
+	for(; i < last; ++i){
+		#ifdef PHYSCONTACT_PACKED_SOLVER
+		physContactConstraintsWarmStart(&jobArgs->island->contactConstraints, colour->contactOffset + i, jobArgs->island->solverBodies);
+		#else
+		physicsContactPair *const contactPair = jobArgs->island->colourContacts[colour->contactOffset + i];
+		physManifoldWarmStart(&contactPair->manifold, contactPair->cA->owner, contactPair->cB->owner);
 		#endif
+	}
+}
+#endif
 
-		#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
-		// Solve contact configuration constraints.
-		contactPair = island->contacts;
-		while(contactPair != NULL){
-			separation = physManifoldSolvePosition(&contactPair->manifold, contactPair->cA->owner, contactPair->cB->owner, separation);
-			contactPair = modulePhysicsContactPairNext(contactPair);
+/*
+** Solve the velocity constraints for a batch of a colour's
+** constraints. The joints come first, followed by the contacts.
+**
+** Note that bodies that aren't simulated may be shared by constraints
+** on different threads. This is fine, as the solver only ever reads
+** from them; see "constraintColour" for details.
+*/
+static void velocityColourJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintColour *const colour = jobArgs->colour;
+	const size_t numConstraints = colour->numJoints + colour->numContacts;
+	size_t i = jobIndex * PHYSISLAND_SOLVER_BATCH_SIZE;
+	const size_t last = (i + PHYSISLAND_SOLVER_BATCH_SIZE < numConstraints) ? i + PHYSISLAND_SOLVER_BATCH_SIZE : numConstraints;
+
+	for(; i < last; ++i){
+		#ifdef PHYSCONTACT_PACKED_SOLVER
+		if(i < colour->numJoints){
+			solveJointVelocityPacked(jobArgs->island->solverBodies, jobArgs->island->colourJoints[colour->jointOffset + i]);
+		}else{
+			physContactConstraintsSolveVelocity(
+				&jobArgs->island->contactConstraints, colour->contactOffset + i - colour->numJoints, jobArgs->island->solverBodies
+			);
+		}
+		#else
+		if(i < colour->numJoints){
+			physJointSolveVelocity(jobArgs->island->colourJoints[colour->jointOffset + i]);
+		}else{
+			physicsContactPair *const contactPair = jobArgs->island->colourContacts[colour->contactOffset + i - colour->numJoints];
+			physManifoldSolveVelocity(&contactPair->manifold, contactPair->cA->owner, contactPair->cB->owner);
 		}
 		#endif
+	}
+}
 
-		// Exit if the errors are small.
-		// if(solved && separation >= PHYSCONTACT_LINEAR_POSITIONAL_ERROR_THRESHOLD){
-		if(
+#ifdef PHYSCONTACT_SOLVER_SIMD
+/*
+** Interleave the packed contacts of each colour into blocks for
+** the SIMD solver. The overflow colour's contacts may share bodies,
+** so they're always solved one at a time by the scalar solver.
+*/
+static void packContactBlocks(physicsIsland *const restrict island){
+	physicsConstraintColour *colour = island->colours;
+	const physicsConstraintColour *const lastColour = &colour[PHYSISLAND_SOLVER_OVERFLOW_COLOUR];
+	size_t numBlocks = 0;
+
+	for(; colour < lastColour; ++colour){
+		colour->blockOffset = numBlocks;
+		colour->numBlocks = (colour->numContacts + PHYSCONTACT_SOLVER_SIMD_WIDTH - 1) / PHYSCONTACT_SOLVER_SIMD_WIDTH;
+		numBlocks += colour->numBlocks;
+	}
+	if(numBlocks > island->blockCapacity){
+		island->contactBlocks = memoryManagerGlobalRealloc(island->contactBlocks, numBlocks * sizeof(*island->contactBlocks));
+		if(island->contactBlocks == NULL){
+			/** MALLOC FAILED **/
+		}
+		island->blockCapacity = numBlocks;
+	}
+
+	for(colour = island->colours; colour < lastColour; ++colour){
+		physicsContactBlock *block = &island->contactBlocks[colour->blockOffset];
+		size_t i;
+
+		for(i = 0; i < colour->numContacts; i += PHYSCONTACT_SOLVER_SIMD_WIDTH){
+			const size_t numLeft = colour->numContacts - i;
+			physContactBlockPack(
+				block, &island->contactConstraints, colour->contactOffset + i,
+				(numLeft < PHYSCONTACT_SOLVER_SIMD_WIDTH) ? numLeft : PHYSCONTACT_SOLVER_SIMD_WIDTH
+			);
+			++block;
+		}
+	}
+}
+
+#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1 && defined(PHYSCONTACT_WARM_START)
+/*
+** This is the same as "warmStartContactColourJob", except
+** the contacts are warm started in blocks using SIMD.
+*/
+static void warmStartContactBlockColourJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintColour *const colour = jobArgs->colour;
+	size_t i = jobIndex * PHYSISLAND_SOLVER_BATCH_SIZE;
+	const size_t last = (i + PHYSISLAND_SOLVER_BATCH_SIZE < colour->numBlocks) ? i + PHYSISLAND_SOLVER_BATCH_SIZE : colour->numBlocks;
+
+	for(; i < last; ++i){
+		physContactBlockWarmStart(&jobArgs->island->contactBlocks[colour->blockOffset + i], jobArgs->island->solverBodies);
+	}
+}
+#endif
+
+/*
+** This is the same as "velocityColourJob", except
+** the contacts are solved in blocks using SIMD.
+*/
+static void velocityColourBlockJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintColour *const colour = jobArgs->colour;
+	const size_t numConstraints = colour->numJoints + colour->numBlocks;
+	size_t i = jobIndex * PHYSISLAND_SOLVER_BATCH_SIZE;
+	const size_t last = (i + PHYSISLAND_SOLVER_BATCH_SIZE < numConstraints) ? i + PHYSISLAND_SOLVER_BATCH_SIZE : numConstraints;
+
+	for(; i < last; ++i){
+		if(i < colour->numJoints){
+			solveJointVelocityPacked(jobArgs->island->solverBodies, jobArgs->island->colourJoints[colour->jointOffset + i]);
+		}else{
+			physContactBlockSolveVelocity(&jobArgs->island->contactBlocks[colour->blockOffset + i - colour->numJoints], jobArgs->island->solverBodies);
+		}
+	}
+}
+#endif
+
+#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1
+// Integrate the velocities of a single graph's bodies.
+static void integrateVelocityGraphJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintGraph *const graph = &jobArgs->island->graphs[jobIndex];
+	physicsRigidBody *const *body = &jobArgs->island->graphBodies[graph->bodyOffset];
+	physicsRigidBody *const *const lastBody = &body[graph->numBodies];
+
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	if(graph->asleep){
+		return;
+	}
+	#endif
+	for(; body < lastBody; ++body){
+		physRigidBodyIntegrateVelocity(*body, jobArgs->dt);
+	}
+}
+#endif
+
+// Integrate the positions of a single graph's bodies.
+static void integrateGraphJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintGraph *const graph = &jobArgs->island->graphs[jobIndex];
+	physicsRigidBody *const *body = &jobArgs->island->graphBodies[graph->bodyOffset];
+	physicsRigidBody *const *const lastBody = &body[graph->numBodies];
+
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	if(graph->asleep){
+		return;
+	}
+	#endif
+	for(; body < lastBody; ++body){
+		physRigidBodyIntegratePosition(*body, jobArgs->dt);
+	}
+}
+
+#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
+/*
+** Solve the configuration constraints for a batch of a colour's
+** constraints. Each thread keeps track of its own errors, which
+** are combined once every colour has been solved.
+*/
+static void positionColourJob(void *const args, const size_t jobIndex, const size_t threadIndex){
+	const physicsSolverJobArgs *const jobArgs = (physicsSolverJobArgs *)args;
+	const physicsConstraintColour *const colour = jobArgs->colour;
+	const size_t numConstraints = colour->numJoints + colour->numContacts;
+	size_t i = jobIndex * PHYSISLAND_SOLVER_BATCH_SIZE;
+	const size_t last = (i + PHYSISLAND_SOLVER_BATCH_SIZE < numConstraints) ? i + PHYSISLAND_SOLVER_BATCH_SIZE : numConstraints;
+
+	for(; i < last; ++i){
+		if(i < colour->numJoints){
 			#ifdef PHYSJOINT_USE_POSITIONAL_CORRECTION
-			solved
-				#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
-			&&
-				#endif
+			jobArgs->island->threadSolved[threadIndex] &= physJointSolvePosition(jobArgs->island->colourJoints[colour->jointOffset + i]);
 			#endif
+		}else{
 			#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
-			separation >= PHYSCONTACT_LINEAR_POSITIONAL_ERROR_THRESHOLD
+			physicsContactPair *const contactPair = jobArgs->island->colourContacts[colour->contactOffset + i - colour->numJoints];
+			jobArgs->island->threadSeparations[threadIndex] = physManifoldSolvePosition(
+				&contactPair->manifold, contactPair->cA->owner, contactPair->cB->owner,
+				jobArgs->island->threadSeparations[threadIndex]
+			);
+			#endif
+		}
+	}
+}
+#endif
+
+/*
+** Solve every awake graph's constraints using the island's thread pool.
+** We follow the same steps as the serial solver, but rather than solving
+** each graph in turn, we solve each colour in turn and split its
+** constraints across the pool's threads. Graphs can be integrated
+** independently, so each graph is given its own job for that step.
+*/
+static void solveConstraintsParallel(physicsIsland *const restrict island, const float dt){
+	const float substepDt = dt/PHYSICS_SOLVER_NUM_SUBSTEPS;
+	size_t substep;
+	size_t c;
+	size_t i;
+	#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
+	const size_t numThreads = threadPoolNumThreads(island->workers);
+	#endif
+	#ifdef PHYSISLAND_PROFILE
+	timerVal phaseStart = timerStart();
+	#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
+	size_t numPositionIterations = 0;
+	#endif
+	#endif
+
+	colourConstraints(island);
+
+
+	#ifdef PHYSCONTACT_PACKED_SOLVER
+	// Pack the contacts in colour order.
+	{
+		const size_t numContacts = island->colours[PHYSISLAND_SOLVER_OVERFLOW_COLOUR].contactOffset +
+		                           island->colours[PHYSISLAND_SOLVER_OVERFLOW_COLOUR].numContacts;
+		size_t pointOffset = 0;
+
+		for(i = 0; i < numContacts; ++i){
+			const physicsContactPair *const contactPair = island->colourContacts[i];
+			pointOffset = physContactConstraintsPack(
+				&island->contactConstraints, i, pointOffset, &contactPair->manifold,
+				solverBodyIndex(contactPair->cA->owner), solverBodyIndex(contactPair->cB->owner)
+			);
+		}
+	}
+	#endif
+	#ifdef PHYSCONTACT_SOLVER_SIMD
+	packContactBlocks(island);
+	#endif
+
+	#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
+	// Make sure every thread has somewhere to store its errors.
+	if(numThreads > island->threadCapacity){
+		island->threadSeparations = memoryManagerGlobalRealloc(island->threadSeparations, numThreads * sizeof(*island->threadSeparations));
+		if(island->threadSeparations == NULL){
+			/** MALLOC FAILED **/
+		}
+		island->threadSolved = memoryManagerGlobalRealloc(island->threadSolved, numThreads * sizeof(*island->threadSolved));
+		if(island->threadSolved == NULL){
+			/** MALLOC FAILED **/
+		}
+		island->threadCapacity = numThreads;
+	}
+	#endif
+
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerCountMax(
+		&island->profiler, PHYSPROFILER_COUNTER_VELOCITY_ITERATIONS,
+		PHYSICS_SOLVER_NUM_SUBSTEPS * PHYSISLAND_VELOCITY_ITERATIONS
+	);
+	#endif
+
+	for(substep = 0; substep < PHYSICS_SOLVER_NUM_SUBSTEPS; ++substep){
+		#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1
+		// Integrate each physics object's velocity.
+		{
+			physicsSolverJobArgs args;
+			args.island = island;
+			args.colour = NULL;
+			args.dt = substepDt;
+			threadPoolRun(island->workers, &integrateVelocityGraphJob, &args, island->numGraphs);
+		}
+		#endif
+
+		// Presolve and warm start joints.
+		for(c = 0; c <= PHYSISLAND_SOLVER_OVERFLOW_COLOUR; ++c){
+			runColourJobs(island, c, island->colours[c].numJoints, &presolveColourJob, substepDt);
+			runColourJobs(island, c, island->colours[c].numJoints, &warmStartColourJob, substepDt);
+		}
+
+
+		#ifdef PHYSCONTACT_PACKED_SOLVER
+		// Pack the awake bodies.
+		{
+			const physicsConstraintGraph *graph = island->graphs;
+			const physicsConstraintGraph *const lastGraph = &graph[island->numGraphs];
+
+			for(; graph < lastGraph; ++graph){
+				#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+				if(!graph->asleep)
+				#endif
+				{
+					packGraphBodies(island, graph);
+				}
+			}
+		}
+		#endif
+
+		#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1 && defined(PHYSCONTACT_WARM_START)
+		// Warm start contacts. They're warm started
+		// when they're updated, so skip the first substep.
+		if(substep > 0){
+			#ifdef PHYSCONTACT_SOLVER_SIMD
+			for(c = 0; c < PHYSISLAND_SOLVER_OVERFLOW_COLOUR; ++c){
+				runColourJobs(island, c, island->colours[c].numBlocks, &warmStartContactBlockColourJob, substepDt);
+			}
+			runColourJobs(island, c, island->colours[c].numContacts, &warmStartContactColourJob, substepDt);
+			#else
+			for(c = 0; c <= PHYSISLAND_SOLVER_OVERFLOW_COLOUR; ++c){
+				runColourJobs(island, c, island->colours[c].numContacts, &warmStartContactColourJob, substepDt);
+			}
+			#endif
+		}
+		#endif
+
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_PRESOLVE, phaseStart);
+		phaseStart = timerStart();
+		#endif
+
+		// Iteratively solve joint and contact velocity constraints.
+		for(i = PHYSISLAND_VELOCITY_ITERATIONS; i > 0; --i){
+			#ifdef PHYSCONTACT_SOLVER_SIMD
+			for(c = 0; c < PHYSISLAND_SOLVER_OVERFLOW_COLOUR; ++c){
+				runColourJobs(island, c, island->colours[c].numJoints + island->colours[c].numBlocks, &velocityColourBlockJob, substepDt);
+			}
+			runColourJobs(
+				island, PHYSISLAND_SOLVER_OVERFLOW_COLOUR,
+				island->colours[c].numJoints + island->colours[c].numContacts, &velocityColourJob, substepDt
+			);
+			#else
+			for(c = 0; c <= PHYSISLAND_SOLVER_OVERFLOW_COLOUR; ++c){
+				runColourJobs(island, c, island->colours[c].numJoints + island->colours[c].numContacts, &velocityColourJob, substepDt);
+			}
 			#endif
-		){
-			return;
+		}
+
+		#ifdef PHYSCONTACT_PACKED_SOLVER
+		// Write the results back to the bodies. The contacts'
+		// impulses stay packed until we've done every substep.
+		{
+			const physicsConstraintGraph *graph = island->graphs;
+			const physicsConstraintGraph *const lastGraph = &graph[island->numGraphs];
+
+			for(; graph < lastGraph; ++graph){
+				#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+				if(!graph->asleep)
+				#endif
+				{
+					unpackGraphBodies(island, graph);
+				}
+			}
+		}
+		#endif
+
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_VELOCITY, phaseStart);
+		phaseStart = timerStart();
+		#endif
+
+
+		// Integrate each physics object's position.
+		{
+			physicsSolverJobArgs args;
+			args.island = island;
+			args.colour = NULL;
+			args.dt = substepDt;
+			threadPoolRun(island->workers, &integrateGraphJob, &args, island->numGraphs);
+		}
+
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_INTEGRATE, phaseStart);
+		phaseStart = timerStart();
+		#endif
+
+
+		#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
+		// Iteratively solve joint and contact configuration constraints.
+		// Unlike the serial solver, we can only exit early once the
+		// errors of every graph are small.
+		for(i = PHYSISLAND_POSITION_ITERATIONS; i > 0; --i){
+			return_t solved = 1;
+			float separation = 0.f;
+			size_t t;
+
+			for(t = 0; t < numThreads; ++t){
+				island->threadSolved[t] = 1;
+				island->threadSeparations[t] = 0.f;
+			}
+			for(c = 0; c <= PHYSISLAND_SOLVER_OVERFLOW_COLOUR; ++c){
+				runColourJobs(island, c, island->colours[c].numJoints + island->colours[c].numContacts, &positionColourJob, substepDt);
+			}
+			for(t = 0; t < numThreads; ++t){
+				solved &= island->threadSolved[t];
+				if(island->threadSeparations[t] < separation){
+					separation = island->threadSeparations[t];
+				}
+			}
+
+			// Exit if the errors are small.
+			if(
+				#ifdef PHYSJOINT_USE_POSITIONAL_CORRECTION
+				solved
+					#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+				&&
+					#endif
+				#endif
+				#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+				separation >= PHYSCONTACT_LINEAR_POSITIONAL_ERROR_THRESHOLD
+				#endif
+			){
+				break;
+			}
+		}
+
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_POSITION, phaseStart);
+		numPositionIterations += PHYSISLAND_POSITION_ITERATIONS - i + (i > 0);
+		phaseStart = timerStart();
+		#endif
+		#endif
+	}
+
+	#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1
+	// Now that every substep has been integrated,
+	// we can reset the forces acting on the bodies.
+	{
+		const physicsConstraintGraph *graph = island->graphs;
+		const physicsConstraintGraph *const lastGraph = &graph[island->numGraphs];
+
+		for(; graph < lastGraph; ++graph){
+			#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+			if(!graph->asleep)
+			#endif
+			{
+				physicsRigidBody *const *body = &island->graphBodies[graph->bodyOffset];
+				physicsRigidBody *const *const lastBody = &body[graph->numBodies];
+
+				for(; body < lastBody; ++body){
+					physRigidBodyResetAccumulators(*body);
+				}
+			}
+		}
+	}
+	#endif
+
+	#ifdef PHYSCONTACT_SOLVER_SIMD
+	// Copy the blocks' impulses back into the packed arrays.
+	for(i = 0; i < island->colours[PHYSISLAND_SOLVER_OVERFLOW_COLOUR - 1].blockOffset + island->colours[PHYSISLAND_SOLVER_OVERFLOW_COLOUR - 1].numBlocks; ++i){
+		physContactBlockUnpack(&island->contactBlocks[i], &island->contactConstraints);
+	}
+	#endif
+
+	#ifdef PHYSCONTACT_PACKED_SOLVER
+	// Write the accumulated impulses back to the contacts.
+	{
+		const size_t numContacts = island->colours[PHYSISLAND_SOLVER_OVERFLOW_COLOUR].contactOffset +
+		                           island->colours[PHYSISLAND_SOLVER_OVERFLOW_COLOUR].numContacts;
+
+		for(i = 0; i < numContacts; ++i){
+			physContactConstraintsUnpack(&island->contactConstraints, i, &island->colourContacts[i]->manifold);
 		}
 	}
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_VELOCITY, phaseStart);
+	#endif
 	#endif
-}
\ No newline at end of file
+
+	#if defined(PHYSISLAND_PROFILE) && defined(PHYSCOLLIDER_USE_POSITIONAL_CORRECTION)
+	physProfilerCountMax(&island->profiler, PHYSPROFILER_COUNTER_POSITION_ITERATIONS, numPositionIterations);
+	#endif
+}
+#endif
+
+#ifdef PHYSCONTACT_PACKED_SOLVER
+/*
+** Bodies that aren't simulated may be touched by the constraints
+** of many graphs, and by constraints of the same colour. Their
+** velocities are always zero, so rather than sharing their solver
+** bodies between threads, the contacts use a zeroed copy instead.
+*/
+static size_t solverBodyIndex(const physicsRigidBody *const restrict body){
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE)){
+		return(body->islandIndex);
+	}
+	return(PHYSCONTACT_STATIC_SOLVER_BODY);
+}
+
+// Copy the velocities of a graph's bodies into the solver bodies.
+static void packGraphBodies(const physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph){
+	physicsRigidBody *const *body = &island->graphBodies[graph->bodyOffset];
+	physicsRigidBody *const *const lastBody = &body[graph->numBodies];
+
+	for(; body < lastBody; ++body){
+		physRigidBodyPackVelocity(*body, &island->solverBodies[(*body)->islandIndex]);
+	}
+}
+
+// Copy the solved velocities of a graph's bodies back into them.
+static void unpackGraphBodies(const physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph){
+	physicsRigidBody *const *body = &island->graphBodies[graph->bodyOffset];
+	physicsRigidBody *const *const lastBody = &body[graph->numBodies];
+
+	for(; body < lastBody; ++body){
+		physRigidBodyUnpackVelocity(*body, &island->solverBodies[(*body)->islandIndex]);
+	}
+}
+
+/*
+** Joints are solved using the rigid bodies themselves, so we need
+** to copy the packed velocities of their simulated bodies back and
+** forth. There are usually far fewer joints than contacts.
+*/
+static void solveJointVelocityPacked(physicsSolverBody *const restrict bodies, physicsJoint *const restrict joint){
+	const return_t simulateA = flagsContainsSubset(joint->bodyA->flags, PHYSRIGIDBODY_SIMULATE);
+	const return_t simulateB = flagsContainsSubset(joint->bodyB->flags, PHYSRIGIDBODY_SIMULATE);
+
+	if(simulateA){
+		physRigidBodyUnpackVelocity(joint->bodyA, &bodies[joint->bodyA->islandIndex]);
+	}
+	if(simulateB){
+		physRigidBodyUnpackVelocity(joint->bodyB, &bodies[joint->bodyB->islandIndex]);
+	}
+	physJointSolveVelocity(joint);
+	if(simulateA){
+		physRigidBodyPackVelocity(joint->bodyA, &bodies[joint->bodyA->islandIndex]);
+	}
+	if(simulateB){
+		physRigidBodyPackVelocity(joint->bodyB, &bodies[joint->bodyB->islandIndex]);
+	}
+}
+#endif
+
+/*
+** Solve the constraints of a single constraint graph. This is
+** the same process as described above, but it only touches
+** the bodies, joints and contacts that are in the graph.
+**
+** When sub-stepping, the bodies' velocities are integrated for
+** each substep, and the joints are presolved again using their
+** bodies' new configurations. The accumulated impulses are then
+** applied again to warm start each substep. Contacts are warm
+** started when they're updated, so we skip them on the first.
+*/
+static void solveConstraintGraph(physicsIsland *const restrict island, const physicsConstraintGraph *const restrict graph, const float dt){
+	const float substepDt = dt/PHYSICS_SOLVER_NUM_SUBSTEPS;
+	size_t substep;
+	size_t i;
+	#ifdef PHYSISLAND_PROFILE
+	timerVal phaseStart = timerStart();
+	#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
+	size_t numPositionIterations = 0;
+	#endif
+	#endif
+	physicsRigidBody *const *body;
+	physicsJoint *const *joint;
+	physicsContactPair *const *contactPair;
+
+	physicsRigidBody *const *const firstBody = &island->graphBodies[graph->bodyOffset];
+	physicsRigidBody *const *const lastBody = &firstBody[graph->numBodies];
+	physicsJoint *const *const firstJoint = &island->graphJoints[graph->jointOffset];
+	physicsJoint *const *const lastJoint = &firstJoint[graph->numJoints];
+	physicsContactPair *const *const firstContact = &island->graphContacts[graph->contactOffset];
+	physicsContactPair *const *const lastContact = &firstContact[graph->numContacts];
+
+
+	#ifdef PHYSCONTACT_PACKED_SOLVER
+	// Pack the graph's contacts for the velocity solver.
+	{
+		size_t pointOffset = 0;
+		for(contactPair = firstContact; contactPair < lastContact; ++contactPair){
+			pointOffset = physContactConstraintsPack(
+				&island->contactConstraints, contactPair - firstContact, pointOffset, &(*contactPair)->manifold,
+				solverBodyIndex((*contactPair)->cA->owner), solverBodyIndex((*contactPair)->cB->owner)
+			);
+		}
+	}
+	#endif
+
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerCountMax(
+		&island->profiler, PHYSPROFILER_COUNTER_VELOCITY_ITERATIONS,
+		PHYSICS_SOLVER_NUM_SUBSTEPS * PHYSISLAND_VELOCITY_ITERATIONS
+	);
+	#endif
+
+	for(substep = 0; substep < PHYSICS_SOLVER_NUM_SUBSTEPS; ++substep){
+		#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1
+		// Integrate each physics object's velocity.
+		for(body = firstBody; body < lastBody; ++body){
+			physRigidBodyIntegrateVelocity(*body, substepDt);
+		}
+		#endif
+
+		// Presolve and warm start joints.
+		for(joint = firstJoint; joint < lastJoint; ++joint){
+			physJointPresolve(*joint, substepDt);
+			physJointWarmStart(*joint);
+		}
+
+		#ifdef PHYSCONTACT_PACKED_SOLVER
+		// Pack the graph's bodies for the velocity solver.
+		packGraphBodies(island, graph);
+		#endif
+
+		#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1 && defined(PHYSCONTACT_WARM_START)
+		// Warm start contacts.
+		if(substep > 0){
+			#ifdef PHYSCONTACT_PACKED_SOLVER
+			for(i = 0; i < graph->numContacts; ++i){
+				physContactConstraintsWarmStart(&island->contactConstraints, i, island->solverBodies);
+			}
+			#else
+			for(contactPair = firstContact; contactPair < lastContact; ++contactPair){
+				physManifoldWarmStart(&(*contactPair)->manifold, (*contactPair)->cA->owner, (*contactPair)->cB->owner);
+			}
+			#endif
+		}
+		#endif
+
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_PRESOLVE, phaseStart);
+		phaseStart = timerStart();
+		#endif
+
+		// Iteratively solve joint and contact velocity constraints.
+		for(i = PHYSISLAND_VELOCITY_ITERATIONS; i > 0; --i){
+			#ifdef PHYSCONTACT_PACKED_SOLVER
+			size_t c;
+
+			// Solve joint velocity constraints.
+			for(joint = firstJoint; joint < lastJoint; ++joint){
+				solveJointVelocityPacked(island->solverBodies, *joint);
+			}
+
+			// Solve contact velocity constraints.
+			for(c = 0; c < graph->numContacts; ++c){
+				physContactConstraintsSolveVelocity(&island->contactConstraints, c, island->solverBodies);
+			}
+			#else
+			// Solve joint velocity constraints.
+			for(joint = firstJoint; joint < lastJoint; ++joint){
+				physJointSolveVelocity(*joint);
+			}
+
+			// Solve contact velocity constraints.
+			for(contactPair = firstContact; contactPair < lastContact; ++contactPair){
+				physManifoldSolveVelocity(&(*contactPair)->manifold, (*contactPair)->cA->owner, (*contactPair)->cB->owner);
+			}
+			#endif
+		}
+
+		#ifdef PHYSCONTACT_PACKED_SOLVER
+		// Write the results back to the bodies. The contacts'
+		// impulses stay packed until we've done every substep.
+		unpackGraphBodies(island, graph);
+		#endif
+
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_VELOCITY, phaseStart);
+		phaseStart = timerStart();
+		#endif
+
+
+		// Integrate each physics object's position.
+		for(body = firstBody; body < lastBody; ++body){
+			physRigidBodyIntegratePosition(*body, substepDt);
+		}
+
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_INTEGRATE, phaseStart);
+		phaseStart = timerStart();
+		#endif
+
+
+		#ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
+		// Iteratively solve joint and contact configuration constraints.
+		for(i = PHYSISLAND_POSITION_ITERATIONS; i > 0; --i){
+			#ifdef PHYSJOINT_USE_POSITIONAL_CORRECTION
+			return_t solved = 1;
+			#endif
+			#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+			float separation = 0.f;
+			#endif
+
+			#ifdef PHYSJOINT_USE_POSITIONAL_CORRECTION
+			// Solve joint configuration constraints.
+			for(joint = firstJoint; joint < lastJoint; ++joint){
+				solved &= physJointSolvePosition(*joint);
+			}
+			#endif
+
+			#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+			// Solve contact configuration constraints.
+			for(contactPair = firstContact; contactPair < lastContact; ++contactPair){
+				separation = physManifoldSolvePosition(&(*contactPair)->manifold, (*contactPair)->cA->owner, (*contactPair)->cB->owner, separation);
+			}
+			#endif
+
+			// Exit if the errors are small.
+			// if(solved && separation >= PHYSCONTACT_LINEAR_POSITIONAL_ERROR_THRESHOLD){
+			if(
+				#ifdef PHYSJOINT_USE_POSITIONAL_CORRECTION
+				solved
+					#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+				&&
+					#endif
+				#endif
+				#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+				separation >= PHYSCONTACT_LINEAR_POSITIONAL_ERROR_THRESHOLD
+				#endif
+			){
+				break;
+			}
+		}
+
+		#ifdef PHYSISLAND_PROFILE
+		physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_POSITION, phaseStart);
+		// If we exited early, "i" is one more than the number of iterations we skipped.
+		numPositionIterations += PHYSISLAND_POSITION_ITERATIONS - i + (i > 0);
+		phaseStart = timerStart();
+		#endif
+		#endif
+	}
+
+	#ifdef PHYSCONTACT_PACKED_SOLVER
+	// Write the accumulated impulses back to the contacts.
+	for(contactPair = firstContact; contactPair < lastContact; ++contactPair){
+		physContactConstraintsUnpack(&island->contactConstraints, contactPair - firstContact, &(*contactPair)->manifold);
+	}
+	#ifdef PHYSISLAND_PROFILE
+	physProfilerAddTime(&island->profiler, PHYSPROFILER_PHASE_VELOCITY, phaseStart);
+	#endif
+	#endif
+
+	#if PHYSICS_SOLVER_NUM_SUBSTEPS > 1
+	// Now that every substep has been integrated,
+	// we can reset the forces acting on the bodies.
+	for(body = firstBody; body < lastBody; ++body){
+		physRigidBodyResetAccumulators(*body);
+	}
+	#endif
+
+	#if defined(PHYSISLAND_PROFILE) && defined(PHYSCOLLIDER_USE_POSITIONAL_CORRECTION)
+	physProfilerCountMax(&island->profiler, PHYSPROFILER_COUNTER_POSITION_ITERATIONS, numPositionIterations);
+	#endif
+}
+
+
+#ifdef PHYSISLAND_CONTINUOUS_COLLISION
+/*
+** Return whether a body will move further than some fraction
+** of the width of its smallest collider during this update.
+*/
+static return_t bodyIsFast(const physicsRigidBody *const restrict body, const vec3 *const restrict displacement){
+	const float distanceSquared = vec3MagnitudeSquaredVec3(displacement);
+	const physicsCollider *collider = body->colliders;
+
+	for(; collider != NULL; collider = modulePhysicsColliderNext(collider)){
+		vec3 width;
+		float minWidth;
+
+		vec3SubtractVec3Out(&collider->aabb.max, &collider->aabb.min, &width);
+		minWidth = PHYSISLAND_CONTINUOUS_THRESHOLD * floatMin(width.x, floatMin(width.y, width.z));
+		if(distanceSquared > minWidth*minWidth){
+			return(1);
+		}
+	}
+
+	return(0);
+}
+
+/*
+** Find the time of impact between the query's collider
+** and "collider", and keep it if it's the earliest so far.
+*/
+static void continuousCallback(void *const restrict collider, void *const restrict query){
+	physicsCollider *const cA = ((physicsContinuousQuery *)query)->collider;
+	physicsCollider *const cB = (physicsCollider *)collider;
+	float toi;
+	vec3 normal;
+
+	// Colliders on the same body can't hit each other, and
+	// we should respect the usual collision filtering rules.
+	// We also can't sweep against colliders without support
+	// functions, so these are left to the discrete solver.
+	if(
+		cA->owner == cB->owner || !colliderHasSupport(&cB->global) ||
+		!((cA->key > cB->key) ? physColliderPermitCollision(cA, cB) : physColliderPermitCollision(cB, cA)) ||
+		!physRigidBodyPermitCollision(cA->owner, cB->owner)
+	){
+		return;
+	}
+
+	if(
+		colliderGJKTimeOfImpact(
+			&cA->global, &((physicsContinuousQuery *)query)->offset, &((physicsContinuousQuery *)query)->displacement,
+			&cB->global, &colliderSupport, PHYSISLAND_CONTINUOUS_TARGET_SEPARATION, &toi, &normal
+		) && (
+			toi < ((physicsContinuousQuery *)query)->toi ||
+			// Break ties using the colliders' keys, as the order
+			// we visit colliders in depends on the broadphase.
+			(
+				toi == ((physicsContinuousQuery *)query)->toi && ((physicsContinuousQuery *)query)->hit != NULL &&
+				cB->key < ((physicsContinuousQuery *)query)->hit->key
+			)
+		)
+	){
+		((physicsContinuousQuery *)query)->hit = cB;
+		((physicsContinuousQuery *)query)->toi = toi;
+		((physicsContinuousQuery *)query)->normal = normal;
+	}
+}
+
+/*
+** Sweep a fast body's colliders along the path it took during
+** this update and move it back to its first time of impact.
+**
+** Only the body's translation is swept, and everything else is
+** treated as stationary, so a fast spinning body can still clip
+** through thin colliders. Colliders without support functions
+** aren't swept at all. Rather than throwing away the rest of
+** the update after an impact, we let the body slide along the
+** surface it hit and sweep it again, which sub-steps only this
+** body. The velocity into the surface is removed, as it would
+** be by an inelastic contact; the discrete solver will create
+** the actual contact on the next update.
+*/
+static void sweepBody(physicsIsland *const restrict island, physicsRigidBody *const restrict body, const float dt){
+	physicsContinuousQuery query;
+	vec3 start;
+	unsigned int i;
+
+	// The body has already been moved by its full velocity,
+	// but its colliders are still where they started from.
+	vec3MultiplySOut(&body->linearVelocity, -dt, &start);
+	vec3AddVec3(&start, &body->centroid);
+	vec3InitZero(&query.offset);
+	vec3MultiplySOut(&body->linearVelocity, dt, &query.displacement);
+
+	for(i = 0; i < PHYSISLAND_CONTINUOUS_MAX_SUBSTEPS; ++i){
+		physicsCollider *collider = body->colliders;
+		float speed;
+
+		query.hit = NULL;
+		query.toi = 1.f;
+		for(; collider != NULL; collider = modulePhysicsColliderNext(collider)){
+			if(collider->node != NULL && colliderHasSupport(&collider->global)){
+				colliderAABB sweptAABB;
+
+				// Find everything the collider could pass through.
+				vec3AddVec3Out(&collider->aabb.min, &query.offset, &sweptAABB.min);
+				vec3AddVec3Out(&collider->aabb.max, &query.offset, &sweptAABB.max);
+				colliderAABBExpandVec3(&sweptAABB, &query.displacement, &sweptAABB);
+
+				query.collider = collider;
+				queryBroadphaseAABB(island, &sweptAABB, &continuousCallback, &query);
+			}
+		}
+
+		// Move the body as far as it can go.
+		vec3FmaP2(query.toi, &query.displacement, &query.offset);
+		if(query.hit == NULL){
+			break;
+		}
+
+		#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+		physRigidBodyWake(query.hit->owner);
+		#endif
+
+		// Slide along the surface for the rest of the update.
+		vec3MultiplyS(&query.displacement, 1.f - query.toi);
+		speed = vec3DotVec3(&query.displacement, &query.normal);
+		if(speed < 0.f){
+			vec3FmaP2(-speed, &query.normal, &query.displacement);
+		}
+		speed = vec3DotVec3(&body->linearVelocity, &query.normal);
+		if(speed < 0.f){
+			vec3FmaP2(-speed, &query.normal, &body->linearVelocity);
+		}
+	}
+
+	vec3AddVec3Out(&start, &query.offset, &body->centroid);
+}
+
+// Sweep any bodies that are moving fast enough to tunnel.
+static void solveContinuous(physicsIsland *const restrict island, const float dt){
+	physicsRigidBody *body = island->bodies;
+	for(; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		vec3 displacement;
+
+		#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+		if(physRigidBodyIsAsleep(body)){
+			continue;
+		}
+		#endif
+		if(
+			!flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_LINEAR) ||
+			!physRigidBodyIsCollidable(body)
+		){
+			continue;
+		}
+
+		vec3MultiplySOut(&body->linearVelocity, dt, &displacement);
+		if(bodyIsFast(body, &displacement)){
+			sweepBody(island, body, dt);
+		}
+	}
+}
+#endif
+
+
+/*
+** Test the ray against a collider found by the broadphase. We return
+** the new maximum distance for the traversal, which is negative if it
+** should stop.
+*/
+static float raycastCallback(void *const restrict collider, const float maxDistance, void *query){
+	physicsCollider *const c = (physicsCollider *)collider;
+	physicsSceneQuery *const q = (physicsSceneQuery *)query;
+	physicsRaycastHit hit;
+
+	// Nodes are padded, so check the collider's
+	// own bounding box before the real test.
+	if(
+		!(c->layer & q->mask) ||
+		!colliderAABBCollidingRay(&c->aabb, &q->origin, &q->invDir, maxDistance) ||
+		!colliderRaycast(&c->global, &q->origin, &q->dir, maxDistance, &hit.distance, &hit.normal)
+	){
+		return(maxDistance);
+	}
+
+	hit.collider = c;
+	vec3FmaOut(hit.distance, &q->dir, &q->origin, &hit.point);
+	return(reportHit(q, &hit, maxDistance));
+}
+
+/*
+** Cast a range of a batch's rays. The tree can traverse several
+** rays at once, but the other broadphases cast them one by one.
+*/
+static void raycastBatchJob(void *const batch, const size_t jobIndex, const size_t threadIndex){
+	const physicsRaycastBatch *const b = (physicsRaycastBatch *)batch;
+	const size_t first = jobIndex * PHYSISLAND_RAYCAST_BATCH_SIZE;
+	const size_t numRays = (b->numRays - first < PHYSISLAND_RAYCAST_BATCH_SIZE) ? b->numRays - first : PHYSISLAND_RAYCAST_BATCH_SIZE;
+	size_t i;
+
+	if(b->island->broadphase == PHYSISLAND_BROADPHASE_AABBTREE){
+		physicsRaycastBatchJob job;
+
+		job.batch = b;
+		job.firstRay = first;
+		for(i = 0; i < numRays; ++i){
+			b->hits[first + i].collider = NULL;
+			colliderAABBInvertRay(&b->dirs[first + i], &job.invDirs[i]);
+		}
+		aabbTreeQueryRayBatch(
+			&b->island->tree, &b->origins[first], job.invDirs,
+			&b->maxDistances[first], numRays, &raycastBatchCallback, &job
+		);
+	}else{
+		for(i = first; i < first + numRays; ++i){
+			if(!physIslandRaycast(b->island, &b->origins[i], &b->dirs[i], b->maxDistances[i], b->mask, &b->hits[i])){
+				b->hits[i].collider = NULL;
+			}
+		}
+	}
+}
+
+/*
+** This is the same as "raycastCallback", but the ray is one
+** of a batch's and we always keep the closest hit.
+*/
+static float raycastBatchCallback(void *const restrict collider, const size_t ray, const float maxDistance, void *job){
+	physicsCollider *const c = (physicsCollider *)collider;
+	const physicsRaycastBatchJob *const j = (physicsRaycastBatchJob *)job;
+	const physicsRaycastBatch *const b = j->batch;
+	const size_t i = j->firstRay + ray;
+	physicsRaycastHit *const hit = &b->hits[i];
+	float distance;
+	vec3 normal;
+
+	if(
+		!(c->layer & b->mask) ||
+		!colliderAABBCollidingRay(&c->aabb, &b->origins[i], &j->invDirs[ray], maxDistance) ||
+		!colliderRaycast(&c->global, &b->origins[i], &b->dirs[i], maxDistance, &distance, &normal)
+	){
+		return(maxDistance);
+	}
+
+	hit->collider = c;
+	vec3FmaOut(distance, &b->dirs[i], &b->origins[i], &hit->point);
+	hit->normal = normal;
+	hit->distance = distance;
+	return(distance);
+}
+
+/*
+** Sweep the query's shape against a collider found by the broadphase.
+** The broadphase can't shrink the swept bounding box as we find hits,
+** so we check the collider against the part of the sweep that's left.
+*/
+static void shapeCastCallback(void *const restrict collider, void *query){
+	physicsCollider *const c = (physicsCollider *)collider;
+	physicsSceneQuery *const q = (physicsSceneQuery *)query;
+	physicsRaycastHit hit;
+	colliderGJKSimplex simplex;
+	colliderAABB sweptAABB;
+	vec3 displacement;
+	vec3 support;
+
+	if(!(c->layer & q->mask)){
+		return;
+	}
+	vec3MultiplySOut(&q->dir, q->maxDistance, &displacement);
+	colliderAABBExpandVec3(&q->aabb, &displacement, &sweptAABB);
+	if(!colliderAABBCollidingAABB(&sweptAABB, &c->aabb)){
+		return;
+	}
+
+	// If the shape starts out inside the collider, it hits immediately.
+	if(colliderGJKDistance(q->shape, NULL, &c->global, &colliderSupport, &simplex, &hit.normal) <= 0.f){
+		hit.distance = 0.f;
+		vec3NegateOut(&q->dir, &hit.normal);
+	}else{
+		const vec3 offset = {.x = 0.f, .y = 0.f, .z = 0.f};
+		float toi;
+		if(!colliderGJKTimeOfImpact(q->shape, &offset, &displacement, &c->global, &colliderSupport, 0.f, &toi, &hit.normal)){
+			return;
+		}
+		hit.distance = toi * q->maxDistance;
+	}
+
+	// The point of contact is the shape's
+	// support point in the normal's direction.
+	hit.collider = c;
+	vec3NegateOut(&hit.normal, &displacement);
+	colliderSupport(q->shape, &displacement, &support);
+	vec3FmaOut(hit.distance, &q->dir, &support, &hit.point);
+	q->maxDistance = reportHit(q, &hit, q->maxDistance);
+}
+
+// Report a collider found by an overlap query if it intersects the shape.
+static void overlapCallback(void *const restrict collider, void *query){
+	physicsCollider *const c = (physicsCollider *)collider;
+	physicsOverlapQuery *const q = (physicsOverlapQuery *)query;
+
+	if(!(c->layer & q->mask) || !colliderAABBCollidingAABB(q->aabb, &c->aabb)){
+		return;
+	}
+	if(q->shape != NULL){
+		colliderGJKSimplex simplex;
+		vec3 normal;
+		if(colliderGJKDistance(q->shape, NULL, &c->global, &colliderSupport, &simplex, &normal) > 0.f){
+			return;
+		}
+	}
+
+	++q->numHits;
+	(*q->callback)(c, q->args);
+}
+
+/*
+** Record a hit according to the type of query,
+** and return the query's new maximum distance.
+*/
+static float reportHit(physicsSceneQuery *const restrict query, const physicsRaycastHit *const restrict hit, const float maxDistance){
+	++query->numHits;
+	switch(query->type){
+		case PHYSISLAND_QUERY_CLOSEST:
+			*query->hit = *hit;
+			return(hit->distance);
+		break;
+		case PHYSISLAND_QUERY_ANY:
+			*query->hit = *hit;
+			return(-1.f);
+		break;
+		default:
+			(*query->callback)(hit, query->args);
+			return(maxDistance);
+	}
+}
+
+// Find the bounding box of a convex shape using its support function.
+static void shapeBounds(const collider *const restrict shape, colliderAABB *const restrict aabb){
+	vec3 dir;
+	vec3 support;
+
+	vec3InitSet(&dir, 1.f, 0.f, 0.f);
+	colliderSupport(shape, &dir, &support);
+	aabb->max.x = support.x;
+	dir.x = -1.f;
+	colliderSupport(shape, &dir, &support);
+	aabb->min.x = support.x;
+
+	vec3InitSet(&dir, 0.f, 1.f, 0.f);
+	colliderSupport(shape, &dir, &support);
+	aabb->max.y = support.y;
+	dir.y = -1.f;
+	colliderSupport(shape, &dir, &support);
+	aabb->min.y = support.y;
+
+	vec3InitSet(&dir, 0.f, 0.f, 1.f);
+	colliderSupport(shape, &dir, &support);
+	aabb->max.z = support.z;
+	dir.z = -1.f;
+	colliderSupport(shape, &dir, &support);
+	aabb->min.z = support.z;
+}
+
+// Append "size" bytes of "data" to the end of a snapshot.
+static void snapshotWrite(physicsIslandSnapshot *const restrict snapshot, const void *const restrict data, const size_t size){
+	if(snapshot->size + size > snapshot->capacity){
+		size_t newCapacity = (snapshot->capacity > 0) ? 2*snapshot->capacity : PHYSISLAND_SNAPSHOT_MIN_CAPACITY;
+		while(newCapacity < snapshot->size + size){
+			newCapacity *= 2;
+		}
+		snapshot->data = memoryManagerGlobalRealloc(snapshot->data, newCapacity);
+		if(snapshot->data == NULL){
+			/** MALLOC FAILED **/
+		}
+		snapshot->capacity = newCapacity;
+	}
+	memcpy(&snapshot->data[snapshot->size], data, size);
+	snapshot->size += size;
+}
+
+// Read "size" bytes from a snapshot and advance the cursor.
+static void snapshotRead(const byte_t **const restrict cursor, void *const restrict data, const size_t size){
+	memcpy(data, *cursor, size);
+	*cursor += size;
+}
+
+// Write the parts of a rigid body that change as it's simulated.
+static void snapshotWriteBody(physicsIslandSnapshot *const restrict snapshot, const physicsRigidBody *const restrict body){
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	const uint_least32_t sleepNext = (body->sleepNext != NULL) ? body->sleepNext->islandIndex : valueInvalid(uint_least32_t);
+	#endif
+
+	snapshotWrite(snapshot, &body->state, sizeof(body->state));
+	snapshotWrite(snapshot, &body->centroid, sizeof(body->centroid));
+	snapshotWrite(snapshot, &body->invInertiaGlobal, sizeof(body->invInertiaGlobal));
+	snapshotWrite(snapshot, &body->linearVelocity, sizeof(body->linearVelocity));
+	snapshotWrite(snapshot, &body->angularVelocity, sizeof(body->angularVelocity));
+	snapshotWrite(snapshot, &body->netForce, sizeof(body->netForce));
+	snapshotWrite(snapshot, &body->netTorque, sizeof(body->netTorque));
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	snapshotWrite(snapshot, &body->sleepTime, sizeof(body->sleepTime));
+	snapshotWrite(snapshot, &sleepNext, sizeof(sleepNext));
+	#endif
+	snapshotWrite(snapshot, &body->flags, sizeof(body->flags));
+}
+
+/*
+** Read a rigid body written by "snapshotWriteBody". The index of
+** the next body that fell asleep with it is stored in "sleepNext",
+** as the caller needs to convert it back into a pointer.
+*/
+static void snapshotReadBody(const byte_t **const restrict cursor, physicsRigidBody *const restrict body, uint_least32_t *const restrict sleepNext){
+	snapshotRead(cursor, &body->state, sizeof(body->state));
+	snapshotRead(cursor, &body->centroid, sizeof(body->centroid));
+	snapshotRead(cursor, &body->invInertiaGlobal, sizeof(body->invInertiaGlobal));
+	snapshotRead(cursor, &body->linearVelocity, sizeof(body->linearVelocity));
+	snapshotRead(cursor, &body->angularVelocity, sizeof(body->angularVelocity));
+	snapshotRead(cursor, &body->netForce, sizeof(body->netForce));
+	snapshotRead(cursor, &body->netTorque, sizeof(body->netTorque));
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	snapshotRead(cursor, &body->sleepTime, sizeof(body->sleepTime));
+	snapshotRead(cursor, sleepNext, sizeof(*sleepNext));
+	#endif
+	snapshotRead(cursor, &body->flags, sizeof(body->flags));
+}
+
+/*
+** Write a contact pair's manifold. Depending on the settings, contact
+** points may contain padding, so they're written field by field.
+** Only the manifold's active contact points are written.
+*/
+static void snapshotWriteContact(physicsIslandSnapshot *const restrict snapshot, const physicsContactPair *const restrict contact){
+	const physicsManifold *const pm = &contact->manifold;
+	const physicsContactPoint *curPoint = pm->contacts;
+	const physicsContactPoint *const lastPoint = &curPoint[pm->numContacts];
+
+	snapshotWrite(snapshot, &contact->inactive, sizeof(contact->inactive));
+	snapshotWrite(snapshot, &pm->numContacts, sizeof(pm->numContacts));
+	for(; curPoint < lastPoint; ++curPoint){
+		snapshotWriteContactPoint(snapshot, curPoint);
+	}
+	#ifndef PHYSCONTACT_USE_FRICTION_JOINT
+	snapshotWrite(snapshot, &pm->normal, sizeof(pm->normal));
+	snapshotWrite(snapshot, pm->tangents, sizeof(pm->tangents));
+	snapshotWrite(snapshot, &pm->friction, sizeof(pm->friction));
+	#else
+	snapshotWrite(snapshot, &pm->frictionJoint, sizeof(pm->frictionJoint));
+	#endif
+	#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+	snapshotWrite(snapshot, &pm->normalLocal, sizeof(pm->normalLocal));
+	#endif
+	snapshotWrite(snapshot, &pm->restitution, sizeof(pm->restitution));
+}
+
+/*
+** Read a contact pair's manifold written by "snapshotWriteContact".
+** If it has too many contact points, we stop and return 0.
+*/
+static return_t snapshotReadContact(const byte_t **const restrict cursor, physicsContactPair *const restrict contact){
+	physicsManifold *const pm = &contact->manifold;
+	physicsContactPoint *curPoint = pm->contacts;
+	const physicsContactPoint *lastPoint;
+
+	snapshotRead(cursor, &contact->inactive, sizeof(contact->inactive));
+	snapshotRead(cursor, &pm->numContacts, sizeof(pm->numContacts));
+	if(pm->numContacts > CONTACT_MAX_POINTS){
+		return(0);
+	}
+	lastPoint = &curPoint[pm->numContacts];
+	for(; curPoint < lastPoint; ++curPoint){
+		snapshotReadContactPoint(cursor, curPoint);
+	}
+	#ifndef PHYSCONTACT_USE_FRICTION_JOINT
+	snapshotRead(cursor, &pm->normal, sizeof(pm->normal));
+	snapshotRead(cursor, pm->tangents, sizeof(pm->tangents));
+	snapshotRead(cursor, &pm->friction, sizeof(pm->friction));
+	#else
+	snapshotRead(cursor, &pm->frictionJoint, sizeof(pm->frictionJoint));
+	#endif
+	#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+	snapshotRead(cursor, &pm->normalLocal, sizeof(pm->normalLocal));
+	#endif
+	snapshotRead(cursor, &pm->restitution, sizeof(pm->restitution));
+
+	return(1);
+}
+
+// The key's members all have the same type, so it has no padding.
+static void snapshotWriteContactPoint(physicsIslandSnapshot *const restrict snapshot, const physicsContactPoint *const restrict point){
+	snapshotWrite(snapshot, &point->rA, sizeof(point->rA));
+	snapshotWrite(snapshot, &point->rB, sizeof(point->rB));
+	#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+	snapshotWrite(snapshot, &point->rAlocal, sizeof(point->rAlocal));
+	snapshotWrite(snapshot, &point->rBlocal, sizeof(point->rBlocal));
+	#endif
+	#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
+	snapshotWrite(snapshot, &point->separation, sizeof(point->separation));
+	#endif
+	snapshotWrite(snapshot, &point->key, sizeof(point->key));
+	snapshotWrite(snapshot, &point->bias, sizeof(point->bias));
+	snapshotWrite(snapshot, &point->normalImpulse, sizeof(point->normalImpulse));
+	#ifndef PHYSCONTACT_USE_FRICTION_JOINT
+	snapshotWrite(snapshot, point->tangentImpulse, sizeof(point->tangentImpulse));
+	#endif
+	snapshotWrite(snapshot, &point->invNormalMass, sizeof(point->invNormalMass));
+	#ifndef PHYSCONTACT_USE_FRICTION_JOINT
+	snapshotWrite(snapshot, point->invTangentMass, sizeof(point->invTangentMass));
+	#endif
+}
+
+static void snapshotReadContactPoint(const byte_t **const restrict cursor, physicsContactPoint *const restrict point){
+	snapshotRead(cursor, &point->rA, sizeof(point->rA));
+	snapshotRead(cursor, &point->rB, sizeof(point->rB));
+	#ifdef PHYSCONTACT_STABILISER_GAUSS_SEIDEL
+	snapshotRead(cursor, &point->rAlocal, sizeof(point->rAlocal));
+	snapshotRead(cursor, &point->rBlocal, sizeof(point->rBlocal));
+	#endif
+	#ifdef PHYSCONTACT_USE_SEPARATION_BIAS
+	snapshotRead(cursor, &point->separation, sizeof(point->separation));
+	#endif
+	snapshotRead(cursor, &point->key, sizeof(point->key));
+	snapshotRead(cursor, &point->bias, sizeof(point->bias));
+	snapshotRead(cursor, &point->normalImpulse, sizeof(point->normalImpulse));
+	#ifndef PHYSCONTACT_USE_FRICTION_JOINT
+	snapshotRead(cursor, point->tangentImpulse, sizeof(point->tangentImpulse));
+	#endif
+	snapshotRead(cursor, &point->invNormalMass, sizeof(point->invNormalMass));
+	#ifndef PHYSCONTACT_USE_FRICTION_JOINT
+	snapshotRead(cursor, point->invTangentMass, sizeof(point->invTangentMass));
+	#endif
+}
+
+// Separations end in padding, so they're written field by field.
+static void snapshotWriteSeparation(physicsIslandSnapshot *const restrict snapshot, const physicsSeparationPair *const restrict separation){
+	snapshotWrite(snapshot, &separation->inactive, sizeof(separation->inactive));
+	snapshotWrite(snapshot, &separation->separation.featureA, sizeof(separation->separation.featureA));
+	snapshotWrite(snapshot, &separation->separation.featureB, sizeof(separation->separation.featureB));
+	snapshotWrite(snapshot, &separation->separation.type, sizeof(separation->separation.type));
+}
+
+static void snapshotReadSeparation(const byte_t **const restrict cursor, physicsSeparationPair *const restrict separation){
+	snapshotRead(cursor, &separation->inactive, sizeof(separation->inactive));
+	snapshotRead(cursor, &separation->separation.featureA, sizeof(separation->separation.featureA));
+	snapshotRead(cursor, &separation->separation.featureB, sizeof(separation->separation.featureB));
+	snapshotRead(cursor, &separation->separation.type, sizeof(separation->separation.type));
+}
+
+/*
+** Joints are stored in a union, so the bytes past the end of
+** the active type are never written and may hold garbage.
+** We only save the active type to keep snapshots comparable.
+*/
+static size_t snapshotJointSize(const physicsJoint *const restrict joint){
+	switch(joint->type){
+		case PHYSJOINT_TYPE_DISTANCE:
+			return(sizeof(joint->data.distance));
+		case PHYSJOINT_TYPE_FIXED:
+			return(sizeof(joint->data.fixed));
+		case PHYSJOINT_TYPE_REVOLUTE:
+			return(sizeof(joint->data.revolute));
+		case PHYSJOINT_TYPE_PRISMATIC:
+			return(sizeof(joint->data.prismatic));
+		case PHYSJOINT_TYPE_SPHERE:
+			return(sizeof(joint->data.sphere));
+	}
+
+	return(sizeof(joint->data));
+}
+
+/*
+** Read through a snapshot without changing the island, checking that
+** every pair refers to colliders stored in the snapshot and that no
+** manifold has too many contact points. The colliders' keys are
+** stored in "keys", which must have room for all of them.
+*/
+static return_t snapshotValidatePairs(
+	const physicsIsland *const restrict island, const byte_t *cursor,
+	const physicsIslandSnapshotHeader *const restrict header, physColliderKey *const restrict keys
+){
+
+	const physicsRigidBody *body;
+	const physicsJoint *joint;
+	// Records we don't need are read into these.
+	physicsRigidBody scratchBody;
+	physicsContactPair scratchContact;
+	physicsSeparationPair scratchSeparation;
+	uint_least32_t sleepNext;
+	size_t numKeys = 0;
+	size_t i;
+
+	for(body = island->bodies; body != NULL; body = modulePhysicsRigidBodyNext(body)){
+		const physicsCollider *collider = body->colliders;
+
+		snapshotReadBody(&cursor, &scratchBody, &sleepNext);
+		for(; collider != NULL; collider = modulePhysicsColliderNext(collider)){
+			byte_t hasNode;
+
+			snapshotRead(&cursor, &keys[numKeys], sizeof(*keys));
+			++numKeys;
+			snapshotRead(&cursor, &hasNode, sizeof(hasNode));
+			if(hasNode){
+				cursor += sizeof(colliderAABB);
+			}
+		}
+	}
+	for(joint = island->joints; joint != NULL; joint = modulePhysicsJointNext(joint)){
+		cursor += snapshotJointSize(joint);
+	}
+	if(numKeys > 1){
+		timsort(keys, numKeys, sizeof(*keys), &compareKeys);
+	}
+
+	for(i = 0; i < header->numContacts; ++i){
+		physColliderKey keyA;
+		physColliderKey keyB;
+
+		snapshotRead(&cursor, &keyA, sizeof(keyA));
+		snapshotRead(&cursor, &keyB, sizeof(keyB));
+		if(!hasKey(keys, numKeys, keyA) || !hasKey(keys, numKeys, keyB) || !snapshotReadContact(&cursor, &scratchContact)){
+			return(0);
+		}
+	}
+	for(i = 0; i < header->numSeparations; ++i){
+		physColliderKey keyA;
+		physColliderKey keyB;
+
+		snapshotRead(&cursor, &keyA, sizeof(keyA));
+		snapshotRead(&cursor, &keyB, sizeof(keyB));
+		if(!hasKey(keys, numKeys, keyA) || !hasKey(keys, numKeys, keyB)){
+			return(0);
+		}
+		snapshotReadSeparation(&cursor, &scratchSeparation);
+	}
+
+	return(1);
+}
+
+// Compare two collider keys.
+static sort_t compareKeys(const void *const restrict k1, const void *const restrict k2){
+	return(compareFloatFast(*((const physColliderKey *)k1), *((const physColliderKey *)k2)));
+}
+
+// Binary search a sorted array of collider keys.
+static return_t hasKey(const physColliderKey *const restrict keys, const size_t numKeys, const physColliderKey key){
+	size_t first = 0;
+	size_t last = numKeys;
+
+	while(first < last){
+		const size_t middle = first + (last - first)/2;
+		if(keys[middle] < key){
+			first = middle + 1;
+		}else{
+			last = middle;
+		}
+	}
+
+	return(first < numKeys && keys[first] == key);
+}
+
+// Compare two pointers to colliders by their keys.
+static sort_t compareColliderKeys(const void *const restrict c1, const void *const restrict c2){
+	return(compareFloatFast((*((physicsCollider *const *)c1))->key, (*((physicsCollider *const *)c2))->key));
+}
+
+// Binary search an array of colliders sorted by key.
+static physicsCollider *findColliderByKey(physicsCollider *const *const restrict colliders, const size_t numColliders, const physColliderKey key){
+	size_t first = 0;
+	size_t last = numColliders;
+
+	while(first < last){
+		const size_t middle = first + (last - first)/2;
+		if(colliders[middle]->key < key){
+			first = middle + 1;
+		}else{
+			last = middle;
+		}
+	}
+
+	return((first < numColliders && colliders[first]->key == key) ? colliders[first] : NULL);
+}
+
+
+#ifdef PHYSISLAND_DETERMINISTIC
+insertionSortDefine(PhysicsCandidatePairs, physicsCandidatePair, compareCandidate)
+timsortDefine(PhysicsCandidatePairs, physicsCandidatePair, compareCandidate)
+#endif
\ No newline at end of file
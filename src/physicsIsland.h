@@ -5,6 +5,17 @@
 #include "settingsPhysics.h"
 
 #include "aabbTree.h"
+#include "aabbPairCache.h"
+#include "aabbSweep.h"
+#include "aabbArrayTree.h"
+#include "contact.h"
+#include "threadPool.h"
+#ifdef PHYSISLAND_DETERMINISTIC
+#include "sortTimsort.h"
+#endif
+#ifdef PHYSISLAND_PROFILE
+#include "physicsProfiler.h"
+#endif
 
 #include "physicsContact.h"
 #include "physicsCollider.h"
@@ -15,19 +26,192 @@
 	#define PHYSISLAND_AABBTREE_NODE_PADDING 0.2f
 #endif
 
+#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	// How long a graph's bodies must rest before it falls asleep.
+	#ifndef PHYSISLAND_TIME_TO_SLEEP
+		#define PHYSISLAND_TIME_TO_SLEEP 0.5f
+	#endif
+#endif
+
+#ifdef PHYSISLAND_PARALLEL_SOLVER
+	// Number of constraints handled by each solver job.
+	#ifndef PHYSISLAND_SOLVER_BATCH_SIZE
+		#define PHYSISLAND_SOLVER_BATCH_SIZE 32
+	#endif
+	// Islands with fewer constraints than this are solved serially.
+	#ifndef PHYSISLAND_SOLVER_MIN_CONSTRAINTS
+		#define PHYSISLAND_SOLVER_MIN_CONSTRAINTS 64
+	#endif
+#endif
+
+#ifdef PHYSISLAND_CONTINUOUS_COLLISION
+	// Bodies that move further than this fraction of their
+	// smallest collider's width in an update are swept.
+	#ifndef PHYSISLAND_CONTINUOUS_THRESHOLD
+		#define PHYSISLAND_CONTINUOUS_THRESHOLD 0.5f
+	#endif
+	// Maximum number of impacts handled for a body in an update.
+	#ifndef PHYSISLAND_CONTINUOUS_MAX_SUBSTEPS
+		#define PHYSISLAND_CONTINUOUS_MAX_SUBSTEPS 4
+	#endif
+	// How far away from a collider swept bodies should stop.
+	#ifndef PHYSISLAND_CONTINUOUS_TARGET_SEPARATION
+		#define PHYSISLAND_CONTINUOUS_TARGET_SEPARATION PHYSCONTACT_LINEAR_SLOP
+	#endif
+#endif
+
+// Number of rays handled by each job of a batched raycast.
+#ifndef PHYSISLAND_RAYCAST_BATCH_SIZE
+	#define PHYSISLAND_RAYCAST_BATCH_SIZE 64
+#endif
+
+// Initial size of a snapshot's buffer in bytes.
+#ifndef PHYSISLAND_SNAPSHOT_MIN_CAPACITY
+	#define PHYSISLAND_SNAPSHOT_MIN_CAPACITY 4096
+#endif
+
+// Number of candidate pairs handled by each narrowphase job.
+#ifndef PHYSISLAND_NARROWPHASE_BATCH_SIZE
+	#define PHYSISLAND_NARROWPHASE_BATCH_SIZE 16
+#endif
+
 #ifndef PHYSICS_VELOCITY_SOLVER_NUM_ITERATIONS
 	#define PHYSICS_VELOCITY_SOLVER_NUM_ITERATIONS 4
 #endif
 #ifndef PHYSICS_POSITION_SOLVER_NUM_ITERATIONS
 	#define PHYSICS_POSITION_SOLVER_NUM_ITERATIONS 4
 #endif
+// Number of substeps the solver splits each update into. Collisions
+// are only checked and contacts are only presolved once per update,
+// but each substep integrates the bodies' velocities, presolves and
+// warm starts the joints and warm starts the contacts again using the
+// smaller timestep. This helps stiff chains converge for far less than
+// running more iterations or more updates.
+#ifndef PHYSICS_SOLVER_NUM_SUBSTEPS
+	#define PHYSICS_SOLVER_NUM_SUBSTEPS 1
+#endif
+// When sub-stepping, each substep runs these many velocity and position
+// iterations instead of the full numbers above. Warm starting carries
+// the solution between substeps, so a single iteration is usually enough.
+#ifndef PHYSICS_SUBSTEP_VELOCITY_SOLVER_NUM_ITERATIONS
+	#define PHYSICS_SUBSTEP_VELOCITY_SOLVER_NUM_ITERATIONS 1
+#endif
+#ifndef PHYSICS_SUBSTEP_POSITION_SOLVER_NUM_ITERATIONS
+	#define PHYSICS_SUBSTEP_POSITION_SOLVER_NUM_ITERATIONS 1
+#endif
 
 
 #warning "We should investigate how Randy Gaul and Erin Catto handle physics islands."
 
 
+#define PHYSISLAND_BROADPHASE_AABBTREE  0
+#define PHYSISLAND_BROADPHASE_SWEEP     1
+#define PHYSISLAND_BROADPHASE_ARRAYTREE 2
+
+#define PHYSISLAND_QUERY_CLOSEST 0
+#define PHYSISLAND_QUERY_ANY     1
+#define PHYSISLAND_QUERY_ALL     2
+
+#define PHYSCANDIDATE_SEPARATED_CACHED 0
+#define PHYSCANDIDATE_COLLIDING        1
+#define PHYSCANDIDATE_SEPARATED        2
+
+
+// Pair of colliders whose bounding boxes are overlapping.
+typedef struct physicsCandidatePair {
+	physicsCollider *cA;
+	physicsCollider *cB;
+	// Separation pair from a previous update, if one exists.
+	physicsSeparationPair *separationPair;
+	// If the pair came from the tree's pair cache, this is the
+	// cached pair, which remembers the separation pair for us.
+	aabbPair *cachedPair;
+
+	// These store the results of the narrowphase.
+	contactSeparation separation;
+	contactManifold manifold;
+	byte_t result;
+	#ifdef PHYSCONTACT_SPECULATIVE
+	// Whether the colliders are separated but close enough
+	// that the manifold stores speculative contact points.
+	byte_t speculative;
+	#endif
+} physicsCandidatePair;
+
+#ifdef PHYSISLAND_DETERMINISTIC
+timsortDeclare(PhysicsCandidatePairs, physicsCandidatePair)
+#endif
+
+// Describes where a scene query hit a collider.
+typedef struct physicsRaycastHit {
+	physicsCollider *collider;
+	// For shape casts, this is the point on the
+	// shape that touches the collider when it stops.
+	vec3 point;
+	// The collider's surface normal at the hit point.
+	// If the query started inside the collider, this
+	// points back along the direction of the query.
+	vec3 normal;
+	float distance;
+} physicsRaycastHit;
+
+/*
+** A constraint graph is a group of rigid bodies that are connected,
+** either directly or indirectly, through contacts or joints. Bodies
+** in different graphs can't affect each other during a physics step,
+** so we're free to solve them separately and in parallel.
+**
+** Every graph occupies a contiguous range of the island's graph arrays.
+*/
+typedef struct physicsConstraintGraph {
+	size_t bodyOffset;
+	size_t numBodies;
+	size_t jointOffset;
+	size_t numJoints;
+	size_t contactOffset;
+	size_t numContacts;
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	return_t asleep;
+	#endif
+} physicsConstraintGraph;
+
+#ifdef PHYSISLAND_PARALLEL_SOLVER
+// Colours are stored as the bits of a 64-bit mask. Any constraints that
+// can't be given one of these colours go into an extra overflow colour,
+// which is always solved on a single thread.
+#define PHYSISLAND_SOLVER_NUM_COLOURS    64
+#define PHYSISLAND_SOLVER_OVERFLOW_COLOUR PHYSISLAND_SOLVER_NUM_COLOURS
+
+/*
+** No two constraints of the same colour share a simulated
+** body, so all of a colour's constraints can be solved at
+** the same time. Like graphs, colours occupy contiguous
+** ranges of the island's colour arrays.
+*/
+typedef struct physicsConstraintColour {
+	size_t jointOffset;
+	size_t numJoints;
+	size_t contactOffset;
+	size_t numContacts;
+	#ifdef PHYSCONTACT_SOLVER_SIMD
+	// A colour's contacts can't share bodies, so
+	// they can be interleaved into SIMD blocks.
+	size_t blockOffset;
+	size_t numBlocks;
+	#endif
+} physicsConstraintColour;
+#endif
+
 typedef struct physicsIsland {
+	// Only one of these is used, depending on the
+	// broadphase type. Islands use the tree by default.
 	aabbTree tree;
+	// Overlapping pairs of leaves in the tree, which
+	// are only updated for nodes that have moved.
+	aabbPairCache pairCache;
+	aabbSweep sweep;
+	aabbArrayTree arrayTree;
+	byte_t broadphase;
 
 	// We store doubly-linked lists of the resources that the island "owns".
 	// Colliders will store their own lists of contacts and separations, for
@@ -42,10 +226,90 @@ typedef struct physicsIsland {
 	physicsContactPair *contacts;
 	physicsSeparationPair *separations;
 	physicsJoint *joints;
+
+	// These arrays are rebuilt on every update by the island builder.
+	// Bodies, joints and contacts are sorted by the graph they belong
+	// to, but otherwise keep the order of the island's lists above.
+	physicsRigidBody **graphBodies;
+	physicsJoint **graphJoints;
+	physicsContactPair **graphContacts;
+	physicsConstraintGraph *graphs;
+	// Union-find parents, indexed by each body's "islandIndex".
+	size_t *graphParents;
+	size_t numGraphs;
+	size_t bodyCapacity;
+	size_t jointCapacity;
+	size_t contactCapacity;
+
+	#ifdef PHYSCONTACT_PACKED_SOLVER
+	// The velocity solver works on packed copies of the bodies and
+	// contacts. Solver bodies are indexed by each body's "islandIndex".
+	physicsSolverBody *solverBodies;
+	physicsContactConstraints contactConstraints;
+	#endif
+
+	// Candidate pairs found by the broadphase on the current update.
+	physicsCandidatePair *candidates;
+	size_t numCandidates;
+	size_t candidateCapacity;
+
+	#ifdef PHYSISLAND_PARALLEL_SOLVER
+	// Constraints of awake graphs, sorted by colour. We also store
+	// each constraint's colour, indexed in the same way as the
+	// graph arrays, and the colours used by each body.
+	physicsConstraintColour colours[PHYSISLAND_SOLVER_NUM_COLOURS + 1];
+	physicsJoint **colourJoints;
+	physicsContactPair **colourContacts;
+	byte_t *jointColours;
+	byte_t *contactColours;
+	uint_least64_t *bodyColours;
+	// Per-thread errors for the position solver.
+	float *threadSeparations;
+	return_t *threadSolved;
+	size_t threadCapacity;
+	#ifdef PHYSCONTACT_SOLVER_SIMD
+	physicsContactBlock *contactBlocks;
+	size_t blockCapacity;
+	#endif
+	#endif
+
+	// If this is not NULL, the narrowphase (and solver, if it's
+	// enabled) will be split across the pool's threads.
+	// Otherwise, they will be run serially.
+	threadPool *workers;
+
+	// Key given to the next collider inserted into the island.
+	physColliderKey nextColliderKey;
+
+	#ifdef PHYSISLAND_PROFILE
+	// Timings and counters for each update.
+	physicsProfiler profiler;
+	#endif
 } physicsIsland;
 
+/*
+** A snapshot stores everything an island needs to carry on from the
+** update it was taken after: the state of each rigid body, the bounds
+** of each collider's broadphase node, the joints' accumulated impulses
+** and every contact and separation pair. Pairs refer to their colliders
+** by key, so a snapshot can be restored into the same island after it
+** has been stepped forward, as long as no bodies, colliders or joints
+** have been added or removed in the meantime.
+**
+** Properties that the island never changes, such as masses and collision
+** filters, aren't stored. Pairs are written field by field rather than as
+** whole structures, so snapshots of the same state are identical byte for
+** byte and can be compared directly to detect desynchronisation.
+*/
+typedef struct physicsIslandSnapshot {
+	byte_t *data;
+	size_t size;
+	size_t capacity;
+} physicsIslandSnapshot;
+
 
 void physIslandInit(physicsIsland *const restrict island);
+return_t physIslandSetBroadphase(physicsIsland *const restrict island, const byte_t broadphase);
 
 void physIslandInsertRigidBody(physicsIsland *const restrict island, physicsRigidBody *const body);
 void physIslandInsertRigidBodyList(physicsIsland *const restrict island, physicsRigidBody *const bodies, size_t numBodies);
@@ -54,6 +318,56 @@ void physIslandRemoveRigidBodyList(physicsIsland *const restrict island, physics
 
 void physIslandUpdate(physicsIsland *const restrict island, const float dt);
 
+return_t physIslandRaycast(
+	physicsIsland *const restrict island, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+);
+return_t physIslandRaycastAny(
+	physicsIsland *const restrict island, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+);
+size_t physIslandRaycastAll(
+	physicsIsland *const restrict island, const vec3 *const restrict origin, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask,
+	void (*const callback)(const physicsRaycastHit *const restrict hit, void *args), void *args
+);
+size_t physIslandRaycastBatch(
+	physicsIsland *const restrict island, const vec3 *const restrict origins, const vec3 *const restrict dirs,
+	const float *const restrict maxDistances, const size_t numRays, const physicsColliderLayer mask,
+	physicsRaycastHit *const restrict hits
+);
+return_t physIslandShapeCast(
+	physicsIsland *const restrict island, const collider *const restrict shape, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+);
+return_t physIslandSphereCast(
+	physicsIsland *const restrict island, const colliderSphere *const restrict sphere, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+);
+return_t physIslandCapsuleCast(
+	physicsIsland *const restrict island, const colliderCapsule *const restrict capsule, const vec3 *const restrict dir,
+	const float maxDistance, const physicsColliderLayer mask, physicsRaycastHit *const restrict hit
+);
+size_t physIslandQueryAABB(
+	physicsIsland *const restrict island, const colliderAABB *const restrict aabb, const physicsColliderLayer mask,
+	void (*const callback)(physicsCollider *const restrict collider, void *args), void *args
+);
+size_t physIslandQueryShape(
+	physicsIsland *const restrict island, const collider *const restrict shape, const physicsColliderLayer mask,
+	void (*const callback)(physicsCollider *const restrict collider, void *args), void *args
+);
+
+void physIslandSnapshotInit(physicsIslandSnapshot *const restrict snapshot);
+void physIslandSnapshotSave(physicsIsland *const restrict island, physicsIslandSnapshot *const restrict snapshot);
+return_t physIslandSnapshotRestore(physicsIsland *const restrict island, const physicsIslandSnapshot *const restrict snapshot);
+return_t physIslandSnapshotEqual(const physicsIslandSnapshot *const restrict snapshotA, const physicsIslandSnapshot *const restrict snapshotB);
+return_t physIslandResimulate(
+	physicsIsland *const restrict island, const physicsIslandSnapshot *const restrict snapshot,
+	const size_t numSteps, const float dt,
+	void (*const input)(physicsIsland *const restrict island, const size_t step, void *args), void *args
+);
+void physIslandSnapshotDelete(physicsIslandSnapshot *const restrict snapshot);
+
 void physIslandDelete(physicsIsland *const restrict island);
 
 
@@ -82,6 +82,47 @@ void physJointPresolve(physicsJoint *const restrict joint, const float dt){
 	}
 }
 
+/*
+** Apply the impulses accumulated during the last update.
+** This is kept separate from presolving, as the solver may
+** presolve joints several times per update when sub-stepping.
+*/
+void physJointWarmStart(physicsJoint *const restrict joint){
+	switch(joint->type){
+		#ifdef PHYSJOINTDISTANCE_WARM_START
+		case PHYSJOINT_TYPE_DISTANCE:
+			physJointDistanceWarmStart(
+				&joint->data.distance, joint->bodyA, joint->bodyB
+			);
+		break;
+		#endif
+		#ifdef PHYSJOINTFIXED_WARM_START
+		case PHYSJOINT_TYPE_FIXED:
+			physJointFixedWarmStart(
+				&joint->data.fixed, joint->bodyA, joint->bodyB
+			);
+		break;
+		#endif
+		#ifdef PHYSJOINTPRISMATIC_WARM_START
+		case PHYSJOINT_TYPE_PRISMATIC:
+			physJointPrismaticWarmStart(
+				&joint->data.prismatic, joint->bodyA, joint->bodyB
+			);
+		break;
+		#endif
+		// The sphere joint resets its accumulated impulses
+		// here, so we need to call this even if it isn't
+		// being warm started.
+		case PHYSJOINT_TYPE_SPHERE:
+			physJointSphereWarmStart(
+				&joint->data.sphere, joint->bodyA, joint->bodyB
+			);
+		break;
+		default:
+		break;
+	}
+}
+
 void physJointSolveVelocity(physicsJoint *const restrict joint){
 	switch(joint->type){
 		case PHYSJOINT_TYPE_DISTANCE:
@@ -178,6 +178,7 @@ void physJointAdd(
 );
 
 void physJointPresolve(physicsJoint *const restrict joint, const float dt);
+void physJointWarmStart(physicsJoint *const restrict joint);
 void physJointSolveVelocity(physicsJoint *const restrict joint);
 #ifdef PHYSJOINT_USE_POSITIONAL_CORRECTION
 return_t physJointSolvePosition(const physicsJoint *const restrict joint);
@@ -173,9 +173,6 @@ void physJointDistancePresolve(
 	calculateBias((physicsJointDistance *)joint, dt);
 	// Now we can invert it.
 	joint->invEffectiveMass = 1.f/joint->invEffectiveMass;
-	#ifdef PHYSJOINTDISTANCE_WARM_START
-	physJointDistanceWarmStart(joint, bodyA, bodyB);
-	#endif
 }
 
 /*
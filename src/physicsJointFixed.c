@@ -323,12 +323,6 @@ void physJointFixedPresolve(
 		// it's much faster to invert it here when we're presolving.
 		mat3Invert(&joint->linearInvMass);
 	}
-
-
-	#ifdef PHYSJOINTFIXED_WARM_START
-	// Warm start the constraint if the old limit states match the new ones.
-	physJointFixedWarmStart(joint, bodyA, bodyB);
-	#endif
 }
 
 /*
@@ -258,9 +258,6 @@ void physJointPrismaticPresolve(
 
 	updateConstraintData(joint, bodyA, bodyB);
 	calculateEffectiveMass(joint, bodyA, bodyB);
-	#ifdef PHYSJOINTPRISMATIC_WARM_START
-	physJointPrismaticWarmStart(joint, bodyA, bodyB);
-	#endif
 }
 
 /*
@@ -1,6 +1,8 @@
 #include "physicsJointSphere.h"
 
 
+#include <string.h>
+
 #include "physicsRigidBody.h"
 
 #ifdef PHYSJOINTSPHERE_SWING_USE_ELLIPSE_NORMAL
@@ -267,12 +269,18 @@ void physJointSphereInit(
 	const float minZ, const float maxZ
 ){
 
+	// Some members are only set while a limit is active, and
+	// "limitStates" is followed by padding. Clearing everything
+	// keeps island snapshots of identical scenes byte-for-byte equal.
+	memset(joint, 0, sizeof(*joint));
+
 	joint->anchorA = *anchorA;
 	joint->anchorB = *anchorB;
 	joint->rotOffsetA = *rotOffsetA;
 	joint->rotOffsetB = *rotOffsetB;
 
 	joint->limitStates = PHYSJOINTSPHERE_LIMITS_FREE;
+	joint->warmStartLimitStates = PHYSJOINTSPHERE_LIMITS_FREE;
 
 	joint->restitution = restitution;
 
@@ -291,14 +299,39 @@ void physJointSphereInit(
 }
 
 
-#ifdef PHYSJOINTSPHERE_WARM_START
+/*
+** Reset any accumulated impulses that are no longer valid,
+** then apply the rest if we're warm starting. When we're
+** sub-stepping, this is called at the start of each substep.
+*/
 void physJointSphereWarmStart(
-	const physicsJointSphere *const restrict joint,
+	physicsJointSphere *const restrict joint,
 	physicsRigidBody *const restrict bodyA,
 	physicsRigidBody *const restrict bodyB
 ){
 
+	// Figure out which limits have been either enabled or disabled.
+	const flags8_t changedLimits = joint->warmStartLimitStates ^ joint->limitStates;
+	#ifdef PHYSJOINTSPHERE_WARM_START
 	vec3 angularImpulse;
+	#endif
+
+
+	// Reset the accumulated impulses if the limits have changed state.
+	if(flagsContainsSubset(changedLimits, PHYSJOINTSPHERE_LIMITS_SWING)){
+		joint->swingImpulse = 0.f;
+	}
+	if(flagsContainsSubset(changedLimits, PHYSJOINTSPHERE_LIMITS_TWIST)){
+		joint->twistImpulse = 0.f;
+	}
+	// Disable linear warmstarting while the swing constraint is violated.
+	// This is a little hacky, but seems to give much more accurate results.
+	if(flagsContainsSubset(joint->limitStates, PHYSJOINTSPHERE_LIMITS_SWING)){
+		vec3InitZero(&joint->linearImpulse);
+	}
+	joint->warmStartLimitStates = joint->limitStates;
+
+	#ifdef PHYSJOINTSPHERE_WARM_START
 	vec3InitZero(&angularImpulse);
 
 	// The angular impulse is the sum of the swing and twist impulses.
@@ -316,8 +349,8 @@ void physJointSphereWarmStart(
 	// Apply the accumulated impulses.
 	physRigidBodyApplyImpulseBoostInverse(bodyA, &joint->rA, &joint->linearImpulse, &angularImpulse);
 	physRigidBodyApplyImpulseBoost(bodyB, &joint->rB, &joint->linearImpulse, &angularImpulse);
+	#endif
 }
-#endif
 
 /*
 ** Calculate any values required by collision resolution
@@ -334,7 +367,6 @@ void physJointSpherePresolve(
 	#ifdef PHYSJOINTSPHERE_STABILISER_BAUMGARTE
 	const float frequency = 1.f/dt;
 	#endif
-	flags8_t changedLimits = joint->limitStates;
 
 
 	updateConstraintData(joint, bodyA, bodyB);
@@ -353,8 +385,6 @@ void physJointSpherePresolve(
 			&joint->swingAxis, &joint->swingBias,
 			&joint->twistAxis, &joint->twistBias
 		);
-		// Figure out which limits have been either enabled or disabled.
-		changedLimits ^= joint->limitStates;
 
 		calculateInverseAngularMass(
 			bodyA, bodyB,
@@ -432,24 +462,6 @@ void physJointSpherePresolve(
 		vec3InitZero(&joint->linearBias);
 		#endif
 	}
-
-
-	// Reset the accumulated impulses if the limits have changed state.
-	if(flagsContainsSubset(changedLimits, PHYSJOINTSPHERE_LIMITS_SWING)){
-		joint->swingImpulse = 0.f;
-	}
-	if(flagsContainsSubset(changedLimits, PHYSJOINTSPHERE_LIMITS_TWIST)){
-		joint->twistImpulse = 0.f;
-	}
-	// Disable linear warmstarting while the swing constraint is violated.
-	// This is a little hacky, but seems to give much more accurate results.
-	if(flagsContainsSubset(joint->limitStates, PHYSJOINTSPHERE_LIMITS_SWING)){
-		vec3InitZero(&joint->linearImpulse);
-	}
-	#ifdef PHYSJOINTSPHERE_WARM_START
-	// We reset the accumulated impulses in here if necessary.
-	physJointSphereWarmStart(joint, bodyA, bodyB);
-	#endif
 }
 
 /*
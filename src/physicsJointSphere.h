@@ -109,6 +109,10 @@ typedef struct physicsJointSphere {
 	// all other angular limits, we use two bits to say whether
 	// the lower or upper limits have been broken.
 	flags8_t limitStates;
+	// Limit states when the joint was last warm started. This lets
+	// us reset the accumulated impulses of any limits that have
+	// changed state since then, rather than when they're presolved.
+	flags8_t warmStartLimitStates;
 
 	// The hardness is a real number in [0, 1], where '1' gives
 	// a rigid constraint and '0' gives a totally soft constraint.
@@ -167,13 +171,11 @@ void physJointSphereInit(
 	const float minZ, const float maxZ
 );
 
-#ifdef PHYSJOINTSPHERE_WARM_START
 void physJointSphereWarmStart(
-	const physicsJointSphere *const restrict joint,
+	physicsJointSphere *const restrict joint,
 	physicsRigidBody *const restrict bodyA,
 	physicsRigidBody *const restrict bodyB
 );
-#endif
 void physJointSpherePresolve(
 	physicsJointSphere *const restrict joint,
 	physicsRigidBody *const restrict bodyA,
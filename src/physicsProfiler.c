@@ -0,0 +1,130 @@
+#include "physicsProfiler.h"
+
+
+#include <stdio.h>
+#include <string.h>
+
+
+// Names used when printing each phase and counter.
+static const char *const phaseNames[PHYSPROFILER_NUM_PHASES] = {
+	"bodies",
+	"broadphase",
+	"narrowphase",
+	"merge",
+	"pairs",
+	"graphs",
+	"presolve",
+	"velocity",
+	"integrate",
+	"position",
+	"sleep",
+	"continuous",
+	"total"
+};
+static const char *const counterNames[PHYSPROFILER_NUM_COUNTERS] = {
+	"pairs tested",
+	"cached separations",
+	"contacts created",
+	"contacts destroyed",
+	"separations created",
+	"separations destroyed",
+	"graphs solved",
+	"velocity iterations",
+	"position iterations"
+};
+
+
+// Forward-declare any helper functions!
+static float updateAverage(const float average, const float value, const size_t numSteps);
+
+
+void physProfilerInit(physicsProfiler *const restrict profiler){
+	memset(profiler, 0, sizeof(*profiler));
+}
+
+
+// Clear the statistics for the step that's about to begin.
+void physProfilerBeginStep(physicsProfiler *const restrict profiler){
+	memset(&profiler->cur, 0, sizeof(profiler->cur));
+}
+
+/*
+** Store the statistics for the step that just finished and
+** fold them into the rolling averages. The first step is
+** used as-is, so the averages don't have to ramp up from 0.
+*/
+void physProfilerEndStep(physicsProfiler *const restrict profiler){
+	size_t i;
+	size_t j;
+
+	for(i = 0; i < PHYSPROFILER_NUM_PHASES; ++i){
+		profiler->avgTimes[i] = updateAverage(profiler->avgTimes[i], profiler->cur.times[i], profiler->numSteps);
+	}
+	for(i = 0; i < PHYSPROFILER_NUM_COUNTERS; ++i){
+		profiler->avgCounters[i] = updateAverage(profiler->avgCounters[i], (float)profiler->cur.counters[i], profiler->numSteps);
+	}
+	for(i = 0; i < COLLIDER_NUM_TYPES; ++i){
+		for(j = 0; j < COLLIDER_NUM_TYPES; ++j){
+			profiler->avgPairTests[i][j] = updateAverage(profiler->avgPairTests[i][j], (float)profiler->cur.pairTests[i][j], profiler->numSteps);
+		}
+	}
+
+	profiler->last = profiler->cur;
+	++profiler->numSteps;
+}
+
+
+// Add the time elapsed since "start" to one of the step's phases.
+void physProfilerAddTime(physicsProfiler *const restrict profiler, const size_t phase, const timerVal start){
+	profiler->cur.times[phase] += timerStopFloat(start);
+}
+
+// Count a narrowphase test between two types of colliders.
+void physProfilerCountPair(physicsProfiler *const restrict profiler, const colliderType typeA, const colliderType typeB){
+	++profiler->cur.pairTests[typeA][typeB];
+}
+
+void physProfilerCount(physicsProfiler *const restrict profiler, const size_t counter, const size_t amount){
+	profiler->cur.counters[counter] += amount;
+}
+
+// Some counters, such as solver iterations, store the most we needed for any group.
+void physProfilerCountMax(physicsProfiler *const restrict profiler, const size_t counter, const size_t amount){
+	if(amount > profiler->cur.counters[counter]){
+		profiler->cur.counters[counter] = amount;
+	}
+}
+
+
+// Print the last step's statistics alongside the rolling averages.
+void physProfilerPrint(const physicsProfiler *const restrict profiler){
+	size_t i;
+	size_t j;
+
+	printf("Physics profile after %u steps (last / average):\n", (unsigned int)profiler->numSteps);
+	for(i = 0; i < PHYSPROFILER_NUM_PHASES; ++i){
+		printf("    %-22s %8.4f ms / %8.4f ms\n", phaseNames[i], profiler->last.times[i], profiler->avgTimes[i]);
+	}
+	for(i = 0; i < PHYSPROFILER_NUM_COUNTERS; ++i){
+		printf("    %-22s %8u    / %8.2f\n", counterNames[i], (unsigned int)profiler->last.counters[i], profiler->avgCounters[i]);
+	}
+	for(i = 0; i < COLLIDER_NUM_TYPES; ++i){
+		for(j = 0; j < COLLIDER_NUM_TYPES; ++j){
+			if(profiler->avgPairTests[i][j] > 0.f){
+				printf(
+					"    narrowphase %u-%u:      %8u    / %8.2f\n",
+					(unsigned int)i, (unsigned int)j,
+					(unsigned int)profiler->last.pairTests[i][j], profiler->avgPairTests[i][j]
+				);
+			}
+		}
+	}
+}
+
+
+static float updateAverage(const float average, const float value, const size_t numSteps){
+	if(numSteps == 0){
+		return(value);
+	}
+	return(average + PHYSPROFILER_AVERAGE_WEIGHT*(value - average));
+}
\ No newline at end of file
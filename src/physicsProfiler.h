@@ -0,0 +1,92 @@
+#ifndef physicsProfiler_h
+#define physicsProfiler_h
+
+
+#include <stddef.h>
+
+#include "settingsPhysics.h"
+
+#include "collider.h"
+#include "timer.h"
+
+
+// Weight given to the newest step when updating the rolling
+// averages. Smaller values give smoother, slower averages.
+#ifndef PHYSPROFILER_AVERAGE_WEIGHT
+	#define PHYSPROFILER_AVERAGE_WEIGHT 0.05f
+#endif
+
+
+// Phases of an island update that we time.
+#define PHYSPROFILER_PHASE_BODIES      0
+#define PHYSPROFILER_PHASE_BROADPHASE  1
+#define PHYSPROFILER_PHASE_NARROWPHASE 2
+#define PHYSPROFILER_PHASE_MERGE       3
+#define PHYSPROFILER_PHASE_PAIRS       4
+#define PHYSPROFILER_PHASE_GRAPHS      5
+#define PHYSPROFILER_PHASE_PRESOLVE    6
+#define PHYSPROFILER_PHASE_VELOCITY    7
+#define PHYSPROFILER_PHASE_INTEGRATE   8
+#define PHYSPROFILER_PHASE_POSITION    9
+#define PHYSPROFILER_PHASE_SLEEP       10
+#define PHYSPROFILER_PHASE_CONTINUOUS  11
+#define PHYSPROFILER_PHASE_TOTAL       12
+#define PHYSPROFILER_NUM_PHASES        13
+
+// Events that we count during an island update.
+#define PHYSPROFILER_COUNTER_PAIRS_TESTED          0
+#define PHYSPROFILER_COUNTER_SEPARATIONS_CACHED    1
+#define PHYSPROFILER_COUNTER_CONTACTS_CREATED      2
+#define PHYSPROFILER_COUNTER_CONTACTS_DESTROYED    3
+#define PHYSPROFILER_COUNTER_SEPARATIONS_CREATED   4
+#define PHYSPROFILER_COUNTER_SEPARATIONS_DESTROYED 5
+#define PHYSPROFILER_COUNTER_GRAPHS_SOLVED         6
+#define PHYSPROFILER_COUNTER_VELOCITY_ITERATIONS   7
+#define PHYSPROFILER_COUNTER_POSITION_ITERATIONS   8
+#define PHYSPROFILER_NUM_COUNTERS                  9
+
+
+/*
+** Timings (in milliseconds) and counters for a single step.
+** Only whole phases are timed, as timing every narrowphase
+** test costs more than some of the tests themselves. Tests
+** are still counted by the types of the colliders involved,
+** using the same layout as the narrowphase's collision table.
+*/
+typedef struct physicsProfilerStep {
+	float times[PHYSPROFILER_NUM_PHASES];
+	size_t counters[PHYSPROFILER_NUM_COUNTERS];
+	size_t pairTests[COLLIDER_NUM_TYPES][COLLIDER_NUM_TYPES];
+} physicsProfilerStep;
+
+/*
+** Stores the statistics of the step currently being
+** profiled, the statistics of the last full step and
+** exponential moving averages over all previous steps.
+*/
+typedef struct physicsProfiler {
+	physicsProfilerStep cur;
+	physicsProfilerStep last;
+
+	float avgTimes[PHYSPROFILER_NUM_PHASES];
+	float avgCounters[PHYSPROFILER_NUM_COUNTERS];
+	float avgPairTests[COLLIDER_NUM_TYPES][COLLIDER_NUM_TYPES];
+
+	size_t numSteps;
+} physicsProfiler;
+
+
+void physProfilerInit(physicsProfiler *const restrict profiler);
+
+void physProfilerBeginStep(physicsProfiler *const restrict profiler);
+void physProfilerEndStep(physicsProfiler *const restrict profiler);
+
+void physProfilerAddTime(physicsProfiler *const restrict profiler, const size_t phase, const timerVal start);
+void physProfilerCountPair(physicsProfiler *const restrict profiler, const colliderType typeA, const colliderType typeB);
+void physProfilerCount(physicsProfiler *const restrict profiler, const size_t counter, const size_t amount);
+void physProfilerCountMax(physicsProfiler *const restrict profiler, const size_t counter, const size_t amount);
+
+void physProfilerPrint(const physicsProfiler *const restrict profiler);
+
+
+#endif
\ No newline at end of file
@@ -58,6 +58,11 @@ void physRigidBodyInit(physicsRigidBody *const restrict body, const physicsRigid
 
 	body->joints = /** ALLOCATE NEW JOINT LIST **/NULL;
 
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	body->sleepTime = 0.f;
+	body->sleepNext = NULL;
+	#endif
+
 	body->flags = bodyDef->flags;
 }
 
@@ -368,6 +373,59 @@ return_t physRigidBodyIsCollidable(physicsRigidBody *const restrict body){
 	return(flagsContainsSubset(body->flags, PHYSRIGIDBODY_COLLIDE));
 }
 
+#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+return_t physRigidBodyIsAsleep(const physicsRigidBody *const restrict body){
+	return(flagsContainsSubset(body->flags, PHYSRIGIDBODY_ASLEEP));
+}
+
+// Return whether the body is moving slowly enough to fall asleep.
+return_t physRigidBodyIsResting(const physicsRigidBody *const restrict body){
+	return(
+		vec3MagnitudeSquaredVec3(&body->linearVelocity) <=
+			PHYSRIGIDBODY_SLEEP_LINEAR_TOLERANCE*PHYSRIGIDBODY_SLEEP_LINEAR_TOLERANCE &&
+		vec3MagnitudeSquaredVec3(&body->angularVelocity) <=
+			PHYSRIGIDBODY_SLEEP_ANGULAR_TOLERANCE*PHYSRIGIDBODY_SLEEP_ANGULAR_TOLERANCE
+	);
+}
+
+/*
+** Put a rigid body to sleep. The island is responsible for
+** linking the bodies that fall asleep together, as waking
+** any one of them should wake the rest of them.
+*/
+void physRigidBodySleep(physicsRigidBody *const restrict body){
+	vec3InitZero(&body->linearVelocity);
+	vec3InitZero(&body->angularVelocity);
+	vec3InitZero(&body->netForce);
+	vec3InitZero(&body->netTorque);
+
+	flagsSet(body->flags, PHYSRIGIDBODY_ASLEEP);
+}
+
+/*
+** Wake a sleeping rigid body, as well as every other
+** body that fell asleep at the same time as it did.
+*/
+void physRigidBodyWake(physicsRigidBody *const body){
+	if(physRigidBodyIsAsleep(body)){
+		physicsRigidBody *curBody = body;
+		do {
+			physicsCollider *curCollider = curBody->colliders;
+			// Nothing has moved since the body fell asleep, so its
+			// pairs are still valid. We need to refresh them so the
+			// island doesn't discard them before they're checked again.
+			for(; curCollider != NULL; curCollider = modulePhysicsColliderNext(curCollider)){
+				physColliderRefreshPairs(curCollider);
+			}
+
+			curBody->sleepTime = 0.f;
+			flagsUnset(curBody->flags, PHYSRIGIDBODY_ASLEEP);
+			curBody = curBody->sleepNext;
+		} while(curBody != body);
+	}
+}
+#endif
+
 
 /*
 ** Check whether two rigid bodies are allowed to collide.
@@ -477,12 +535,18 @@ void physRigidBodyIntegratePosition(physicsRigidBody *const restrict body, const
 
 // Add a translational force to a rigid body.
 void physRigidBodyApplyLinearForce(physicsRigidBody *const restrict body, const vec3 *const restrict F){
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	physRigidBodyWake(body);
+	#endif
 	vec3AddVec3(&body->netForce, F);
 }
 
 // Add a rotational force to a rigid body.
 void physRigidBodyApplyAngularForce(physicsRigidBody *const restrict body, const vec3 *const restrict r, const vec3 *const restrict F){
 	vec3 torque;
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	physRigidBodyWake(body);
+	#endif
 	vec3SubtractVec3Out(r, &body->centroid, &torque);
 	vec3CrossVec3P1(&torque, F);
 	vec3AddVec3(&body->netTorque, &torque);
@@ -496,56 +560,74 @@ void physRigidBodyApplyForce(physicsRigidBody *const restrict body, const vec3 *
 }
 
 
+/*
+** The impulse functions below only change the parts of a body's
+** velocity that are being simulated, just like the positional
+** ones further down. Bodies that aren't simulated at all are
+** never written to by the solver, which lets the parallel solver
+** share them between constraints of the same colour.
+*/
+
 // Add a translational impulse to a rigid body.
 void physRigidBodyApplyLinearImpulse(physicsRigidBody *const restrict body, const vec3 *const restrict J){
-	// Linear velocity.
-	vec3FmaP2(body->invMass, J, &body->linearVelocity);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_LINEAR)){
+		vec3FmaP2(body->invMass, J, &body->linearVelocity);
+	}
 }
 
 // Subtract a translational impulse from a rigid body.
 void physRigidBodyApplyLinearImpulseInverse(physicsRigidBody *const restrict body, const vec3 *const restrict J){
-	// Linear velocity.
-	vec3FmaP2(-body->invMass, J, &body->linearVelocity);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_LINEAR)){
+		vec3FmaP2(-body->invMass, J, &body->linearVelocity);
+	}
 }
 
 // Add a rotational impulse to a rigid body.
 void physRigidBodyApplyAngularImpulse(physicsRigidBody *const restrict body, vec3 J){
-	// Angular velocity.
-	mat3MultiplyVec3(&body->invInertiaGlobal, &J);
-	vec3AddVec3(&body->angularVelocity, &J);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_ANGULAR)){
+		mat3MultiplyVec3(&body->invInertiaGlobal, &J);
+		vec3AddVec3(&body->angularVelocity, &J);
+	}
 }
 
 // Subtract a rotational impulse from a rigid body.
 void physRigidBodyApplyAngularImpulseInverse(physicsRigidBody *const restrict body, vec3 J){
-	// Angular velocity.
-	mat3MultiplyVec3(&body->invInertiaGlobal, &J);
-	vec3SubtractVec3P1(&body->angularVelocity, &J);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_ANGULAR)){
+		mat3MultiplyVec3(&body->invInertiaGlobal, &J);
+		vec3SubtractVec3P1(&body->angularVelocity, &J);
+	}
 }
 
 // Add a translational and rotational impulse to a rigid body.
 void physRigidBodyApplyImpulse(physicsRigidBody *const restrict body, const vec3 *const restrict r, const vec3 *const restrict J){
-	vec3 impulse;
-
 	// Linear velocity.
-	vec3FmaP2(body->invMass, J, &body->linearVelocity);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_LINEAR)){
+		vec3FmaP2(body->invMass, J, &body->linearVelocity);
+	}
 
 	// Angular velocity.
-	vec3CrossVec3Out(r, J, &impulse);
-	mat3MultiplyVec3(&body->invInertiaGlobal, &impulse);
-	vec3AddVec3(&body->angularVelocity, &impulse);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_ANGULAR)){
+		vec3 impulse;
+		vec3CrossVec3Out(r, J, &impulse);
+		mat3MultiplyVec3(&body->invInertiaGlobal, &impulse);
+		vec3AddVec3(&body->angularVelocity, &impulse);
+	}
 }
 
 // Subtract a translational and rotational impulse from a rigid body.
 void physRigidBodyApplyImpulseInverse(physicsRigidBody *const restrict body, const vec3 *const restrict r, const vec3 *const restrict J){
-	vec3 impulse;
-
 	// Linear velocity.
-	vec3FmaP2(-body->invMass, J, &body->linearVelocity);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_LINEAR)){
+		vec3FmaP2(-body->invMass, J, &body->linearVelocity);
+	}
 
 	// Angular velocity.
-	vec3CrossVec3Out(r, J, &impulse);
-	mat3MultiplyVec3(&body->invInertiaGlobal, &impulse);
-	vec3SubtractVec3P1(&body->angularVelocity, &impulse);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_ANGULAR)){
+		vec3 impulse;
+		vec3CrossVec3Out(r, J, &impulse);
+		mat3MultiplyVec3(&body->invInertiaGlobal, &impulse);
+		vec3SubtractVec3P1(&body->angularVelocity, &impulse);
+	}
 }
 
 // Add a translational and "boosted" rotational impulse to a rigid body.
@@ -554,16 +636,19 @@ void physRigidBodyApplyImpulseBoost(
 	const vec3 *const restrict J, const vec3 *const restrict a
 ){
 
-	vec3 impulse;
-
 	// Linear velocity.
-	vec3FmaP2(body->invMass, J, &body->linearVelocity);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_LINEAR)){
+		vec3FmaP2(body->invMass, J, &body->linearVelocity);
+	}
 
 	// Angular velocity.
-	vec3CrossVec3Out(r, J, &impulse);
-	vec3AddVec3(&impulse, a);
-	mat3MultiplyVec3(&body->invInertiaGlobal, &impulse);
-	vec3AddVec3(&body->angularVelocity, &impulse);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_ANGULAR)){
+		vec3 impulse;
+		vec3CrossVec3Out(r, J, &impulse);
+		vec3AddVec3(&impulse, a);
+		mat3MultiplyVec3(&body->invInertiaGlobal, &impulse);
+		vec3AddVec3(&body->angularVelocity, &impulse);
+	}
 }
 
 // Subtract a translational and "boosted" rotational impulse from a rigid body.
@@ -572,16 +657,19 @@ void physRigidBodyApplyImpulseBoostInverse(
 	const vec3 *const restrict J, const vec3 *const restrict a
 ){
 
-	vec3 impulse;
-
 	// Linear velocity.
-	vec3FmaP2(-body->invMass, J, &body->linearVelocity);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_LINEAR)){
+		vec3FmaP2(-body->invMass, J, &body->linearVelocity);
+	}
 
 	// Angular velocity.
-	vec3CrossVec3Out(r, J, &impulse);
-	vec3AddVec3(&impulse, a);
-	mat3MultiplyVec3(&body->invInertiaGlobal, &impulse);
-	vec3SubtractVec3P1(&body->angularVelocity, &impulse);
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_ANGULAR)){
+		vec3 impulse;
+		vec3CrossVec3Out(r, J, &impulse);
+		vec3AddVec3(&impulse, a);
+		mat3MultiplyVec3(&body->invInertiaGlobal, &impulse);
+		vec3SubtractVec3P1(&body->angularVelocity, &impulse);
+	}
 }
 
 #ifdef PHYSCOLLIDER_USE_POSITIONAL_CORRECTION
@@ -803,6 +891,43 @@ void physRigidBodyUpdate(physicsRigidBody *const restrict body, const float dt){
 	physRigidBodyPositionFromCentroid(body);
 }
 
+/*
+** Update a rigid body when the solver is sub-stepping. This is the same
+** as "physRigidBodyUpdate", except that the solver integrates the body's
+** velocity for each substep, so the forces are kept until it's done.
+** Bodies that don't simulate linear motion would ignore gravity anyway.
+*/
+void physRigidBodyUpdateSubstepped(physicsRigidBody *const restrict body){
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_LINEAR)){
+		// Apply gravity.
+		const vec3 gravity = {.x = 0.f, .y = PHYSRIGIDBODY_GRAVITY * body->mass, .z = 0.f};
+		physRigidBodyApplyLinearForce(body, &gravity);
+	}
+	// Contacts are presolved before the velocity is integrated,
+	// so they need the global inertia tensor to be up to date.
+	if(flagsContainsSubset(body->flags, PHYSRIGIDBODY_SIMULATE_ANGULAR)){
+		physRigidBodyUpdateGlobalInertia(body);
+	}
+
+	physRigidBodyPositionFromCentroid(body);
+}
+
+#ifdef PHYSCONTACT_PACKED_SOLVER
+// Copy the parts of a rigid body used by the velocity solver.
+void physRigidBodyPackVelocity(const physicsRigidBody *const restrict body, physicsSolverBody *const restrict solverBody){
+	solverBody->linearVelocity = body->linearVelocity;
+	solverBody->angularVelocity = body->angularVelocity;
+	solverBody->invMass = body->invMass;
+	solverBody->invInertiaGlobal = body->invInertiaGlobal;
+}
+
+// Copy the solved velocities back into a rigid body.
+void physRigidBodyUnpackVelocity(physicsRigidBody *const restrict body, const physicsSolverBody *const restrict solverBody){
+	body->linearVelocity = solverBody->linearVelocity;
+	body->angularVelocity = solverBody->angularVelocity;
+}
+#endif
+
 
 void physRigidBodyDefDelete(physicsRigidBodyDef *const restrict bodyDef){
 	modulePhysicsColliderBaseFreeArray(&bodyDef->colliders);
@@ -30,6 +30,8 @@
 #define PHYSRIGIDBODY_TRANSLATED         0x10
 #define PHYSRIGIDBODY_ROTATED            0x20
 #define PHYSRIGIDBODY_TRANSFORMED        0x30
+// The body is resting and should not be simulated.
+#define PHYSRIGIDBODY_ASLEEP             0x40
 
 #define PHYSRIGIDBODY_DEFAULT_STATE (PHYSRIGIDBODY_SIMULATE | PHYSRIGIDBODY_COLLIDE | PHYSRIGIDBODY_TRANSFORMED)
 
@@ -38,6 +40,16 @@
 	#define PHYSRIGIDBODY_GRAVITY -9.80665f
 #endif
 
+#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	// Bodies moving slower than these speeds are considered to be at rest.
+	#ifndef PHYSRIGIDBODY_SLEEP_LINEAR_TOLERANCE
+		#define PHYSRIGIDBODY_SLEEP_LINEAR_TOLERANCE 0.01f
+	#endif
+	#ifndef PHYSRIGIDBODY_SLEEP_ANGULAR_TOLERANCE
+		#define PHYSRIGIDBODY_SLEEP_ANGULAR_TOLERANCE DEG_TO_RAD(2.f)
+	#endif
+#endif
+
 
 typedef struct physicsRigidBodyDef {
 	#warning "We don't allow colliders to be added, so why not make this a normal array?"
@@ -94,6 +106,18 @@ typedef struct physicsRigidBody {
 	// body is body A) are stored at the beginning of the list.
 	physicsJoint *joints;
 
+	// Index of the body in its island's graph arrays.
+	// This is only valid during the island's update.
+	size_t islandIndex;
+
+	#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+	// How long the body has been resting for.
+	float sleepTime;
+	// Bodies that fall asleep together are stored in a circular
+	// linked list, so we can wake all of them at the same time.
+	physicsRigidBody *sleepNext;
+	#endif
+
 	flags8_t flags;
 } physicsRigidBody;
 
@@ -120,6 +144,12 @@ void physRigidBodyIgnoreCollisions(physicsRigidBody *const restrict body);
 
 return_t physRigidBodyIsSimulated(physicsRigidBody *const restrict body);
 return_t physRigidBodyIsCollidable(physicsRigidBody *const restrict body);
+#ifdef PHYSRIGIDBODY_ALLOW_SLEEPING
+return_t physRigidBodyIsAsleep(const physicsRigidBody *const restrict body);
+return_t physRigidBodyIsResting(const physicsRigidBody *const restrict body);
+void physRigidBodySleep(physicsRigidBody *const restrict body);
+void physRigidBodyWake(physicsRigidBody *const body);
+#endif
 
 return_t physRigidBodyPermitCollision(const physicsRigidBody *const bodyA, const physicsRigidBody *const bodyB);
 
@@ -161,6 +191,12 @@ void physRigidBodyPositionFromCentroid(physicsRigidBody *const restrict body);
 void physRigidBodyUpdatePosition(physicsRigidBody *const restrict body);
 void physRigidBodyUpdateGlobalInertia(physicsRigidBody *const restrict body);
 void physRigidBodyUpdate(physicsRigidBody *const restrict body, const float dt);
+void physRigidBodyUpdateSubstepped(physicsRigidBody *const restrict body);
+
+#ifdef PHYSCONTACT_PACKED_SOLVER
+void physRigidBodyPackVelocity(const physicsRigidBody *const restrict body, physicsSolverBody *const restrict solverBody);
+void physRigidBodyUnpackVelocity(physicsRigidBody *const restrict body, const physicsSolverBody *const restrict solverBody);
+#endif
 
 void physRigidBodyDefDelete(physicsRigidBodyDef *const restrict bodyDef);
 void physRigidBodyDelete(physicsRigidBody *const restrict body);
@@ -18,6 +18,7 @@
 #include "moduleObject.h"
 #include "moduleParticle.h"
 #include "memoryManager.h"
+#include "memoryArena.h"
 
 #include "timer.h"
 #include "utilMath.h"
@@ -67,6 +68,9 @@ return_t programInit(program *const restrict prg, char *const restrict prgDir){
 	// Add the commands for our default list of cvars.
 	cmdSysAddFunction(&prg->cmdSys, "exit", &c_exit);
 	cmdSysAddFunction(&prg->cmdSys, "mousemove", &c_mousemove);
+	#ifdef PHYSISLAND_PROFILE
+	cmdSysAddFunction(&prg->cmdSys, "physprofile", &c_physprofile);
+	#endif
 
 	inputMngrKeyboardBind(&prg->inputMngr, SDL_SCANCODE_ESCAPE, "exit", sizeof("exit") - 1);
 
@@ -87,6 +91,9 @@ void programLoop(program *const restrict prg){
 		// Note: This loop freezes the game if our input and update
 		//       functions take longer than "prg->step.updateTime".
 		while(curTime >= nextUpdate){
+			// Scratch memory allocated during the last
+			// render is freed when this update ends.
+			memArenaGlobalNextFrame();
 			input(prg);
 			update(prg);
 			nextUpdate += prg->step.updateTimeScaled;
@@ -99,6 +106,7 @@ void programLoop(program *const restrict prg){
 				1.f - (nextUpdate - curTime) * prg->step.updateTickrateScaled,
 				0.f, 1.f
 			);
+			memArenaGlobalNextFrame();
 			render(prg);
 			// The framerate should be uncapped if renderTime is 0.
 			if(prg->step.renderTime > 0.f){
@@ -378,7 +386,9 @@ static void updateObjects(program *const restrict prg){
 
 /** TEMPORARY STUFF! **/
 #include "physicsIsland.h"
+#include "threadPool.h"
 physicsIsland island;
+threadPool workers;
 static void updatePhysics(program *const restrict prg){
 	physIslandUpdate(&island, prg->step.updateDelta);
 }
@@ -642,6 +652,13 @@ static return_t initResources(program *const restrict prg){
 
 	/** TEMPORARY PHYSICS STUFF **/
 	physIslandInit(&island);
+	// Use every other processor to help with the narrowphase.
+	if(threadPoolInit(&workers, threadNumProcessors() - 1)){
+		island.workers = &workers;
+	}
+	#ifdef PHYSISLAND_PROFILE
+	cv_phys_profiler = &island.profiler;
+	#endif
 	#if 1
 	// Create the base physics object.
 	objDef = moduleObjectDefAlloc();
@@ -1012,7 +1029,10 @@ static return_t setupModules(){
 	/** THIS IS TEMPORARY **/
 	debugDrawSetup();
 
-	memTreePrintAllSizes(&g_memManager);
+	memoryManagerPrintAllSizes(&g_memManager);
+	#ifdef MEMORY_REGION_LARGE_PAGES
+	memoryRegionPrintPages(g_memManager.region);
+	#endif
 	puts("Setup complete!\n");
 
 
@@ -1021,10 +1041,11 @@ static return_t setupModules(){
 
 static void cleanupModules(){
 	puts("Beginning cleanup...\n");
-	//memTreePrintAllSizes(&g_memManager);
+	//memoryManagerPrintAllSizes(&g_memManager);
 
 	/** YET MORE TEMPORARY PHYSICS STUFF **/
 	physIslandDelete(&island);
+	threadPoolDelete(&workers);
 	/** YET MORE TEMPORARY PARTICLE STUFF **/
 	particleSysDelete(&partSys);
 	particleSysDefDelete(&partSysDef);
@@ -1073,7 +1094,13 @@ static void cleanupModules(){
 	#endif
 	printf("\n");
 
-	memTreePrintAllSizes(&g_memManager);
+	// The main thread's scratch memory and the small blocks
+	// it has cached shouldn't count as leaks.
+	memArenaThreadDelete();
+	#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+	memoryManagerGlobalFlushCache();
+	#endif
+	memoryManagerPrintAllSizes(&g_memManager);
 	memoryManagerGlobalDelete();
 	puts("Cleanup complete!\n");
 }
\ No newline at end of file
@@ -10,10 +10,32 @@
 
 #define MEMORY_USE_GLOBAL_MANAGER
 #define MEMORY_USE_MODULE_MANAGER
+// Allow the global memory manager to be used by multiple threads.
+#define MEMORY_GLOBAL_MANAGER_THREAD_SAFE
+// Give each thread a cache of small blocks so that
+// most allocations don't need to take the lock.
+#define MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+// Use the two-level segregated fit allocator for the memory
+// managers rather than the red-black tree allocator. This has
+// constant time allocations and frees, but may waste more memory.
+//#define MEMORY_MANAGER_USE_TLSF
+// Write every operation performed by the global memory manager to
+// a trace file. These can be replayed by the memory benchmark.
+//#define MEMORY_GLOBAL_MANAGER_TRACE
 
 //#define MEMORYREGION_EXTEND_ALLOCATORS
 #define MEMORYREGION_EXTEND_MANAGERS
 
+// Back the memory managers' regions with large pages (2 MiB on
+// x86-64) when the system allows it, which greatly reduces the
+// number of TLB misses when working through the heap. Because
+// the modules' allocators get their memory from the global
+// memory manager, they are backed by large pages too.
+//#define MEMORY_REGION_LARGE_PAGES
+// Fault in every page of a region when it's allocated
+// rather than the first time each page is written to.
+//#define MEMORY_REGION_PREFAULT
+
 #define MEMPOOL_COUNT_USED_BLOCKS
 #define MEMFREELIST_COUNT_USED_BLOCKS
 #define MEMSINGLELIST_COUNT_USED_BLOCKS
@@ -41,6 +63,7 @@
 
 
 #define MEMTREE_DEBUG
+#define MEMTLSF_DEBUG
 
 
 #endif
\ No newline at end of file
@@ -8,7 +8,7 @@
 
 #include <string.h>
 
-#include "memoryManager.h"
+#include "memoryArena.h"
 
 
 // Forward-declare any helper functions!
@@ -33,7 +33,9 @@ void timsort(
 	size_t size = TIMSORT_RUN_SIZE;
 
 	// Allocate a temporary array to store a copy of our data when merging.
-	void *const tempArray = memoryManagerGlobalAlloc(arraySize * elementSize);
+	// This is only needed until we return, so we use the thread's arena.
+	const memArenaMarker marker = memArenaThreadGetMarker();
+	void *const tempArray = memArenaThreadAlloc(arraySize * elementSize);
 	if(tempArray == NULL){
 		/** MALLOC FAILED **/
 	}
@@ -109,7 +111,7 @@ void timsort(
 	}
 
 
-	memoryManagerGlobalFree(tempArray);
+	memArenaThreadRollback(&marker);
 }
 
 
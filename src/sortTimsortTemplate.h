@@ -69,7 +69,8 @@
 		type *subArray = array;                                                                                    \
 		size_t size = TIMSORT_RUN_SIZE;                                                                            \
                                                                                                                    \
-		type *const tempArray = memoryManagerGlobalAlloc(arraySize * sizeof(type));                                \
+		const memArenaMarker marker = memArenaThreadGetMarker();                                                   \
+		type *const tempArray = memArenaThreadAlloc(arraySize * sizeof(type));                                     \
 		if(tempArray == NULL){                                                                                     \
 			/** MALLOC FAILED **/                                                                                  \
 		}                                                                                                          \
@@ -115,7 +116,7 @@
 		}                                                                                                          \
                                                                                                                    \
                                                                                                                    \
-		memoryManagerGlobalFree(tempArray);                                                                        \
+		memArenaThreadRollback(&marker);                                                                           \
 	}
 
 // Make sure to use "insertionSortFlexibleDefine(name, type)" beforehand!
@@ -168,7 +169,8 @@
 		type *subArray = array;                                                                        \
 		size_t size = TIMSORT_RUN_SIZE;                                                                \
                                                                                                        \
-		type *const tempArray = memoryManagerGlobalAlloc(arraySize * sizeof(type));                    \
+		const memArenaMarker marker = memArenaThreadGetMarker();                                       \
+		type *const tempArray = memArenaThreadAlloc(arraySize * sizeof(type));                         \
 		if(tempArray == NULL){                                                                         \
 			/** MALLOC FAILED **/                                                                      \
 		}                                                                                              \
@@ -222,7 +224,7 @@
 		}                                                                                              \
                                                                                                        \
                                                                                                        \
-		memoryManagerGlobalFree(tempArray);                                                            \
+		memArenaThreadRollback(&marker);                                                               \
 	}
 
 
@@ -0,0 +1,143 @@
+#include "thread.h"
+
+
+#ifndef _WIN32
+	#include <sched.h>
+	#include <unistd.h>
+#endif
+
+
+// Start a new thread that begins executing "func".
+return_t threadCreate(thread *const restrict t, threadFunction func, void *const arg){
+	#ifdef _WIN32
+		*t = CreateThread(NULL, 0, func, arg, 0, NULL);
+		return(*t != NULL);
+	#else
+		return(pthread_create(t, NULL, func, arg) == 0);
+	#endif
+}
+
+// Wait for a thread to finish executing.
+void threadJoin(const thread t){
+	#ifdef _WIN32
+		WaitForSingleObject(t, INFINITE);
+		CloseHandle(t);
+	#else
+		pthread_join(t, NULL);
+	#endif
+}
+
+// Return the number of logical processors on the system.
+size_t threadNumProcessors(){
+	#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return(info.dwNumberOfProcessors);
+	#else
+		const long num = sysconf(_SC_NPROCESSORS_ONLN);
+		return((num > 0) ? (size_t)num : 1);
+	#endif
+}
+
+// Let another thread run on this thread's processor.
+void threadYield(){
+	#ifdef _WIN32
+		SwitchToThread();
+	#else
+		sched_yield();
+	#endif
+}
+
+
+void threadMutexInit(threadMutex *const restrict mutex){
+	#ifdef _WIN32
+		InitializeCriticalSection(mutex);
+	#else
+		pthread_mutex_init(mutex, NULL);
+	#endif
+}
+
+void threadMutexLock(threadMutex *const restrict mutex){
+	#ifdef _WIN32
+		EnterCriticalSection(mutex);
+	#else
+		pthread_mutex_lock(mutex);
+	#endif
+}
+
+void threadMutexUnlock(threadMutex *const restrict mutex){
+	#ifdef _WIN32
+		LeaveCriticalSection(mutex);
+	#else
+		pthread_mutex_unlock(mutex);
+	#endif
+}
+
+void threadMutexDelete(threadMutex *const restrict mutex){
+	#ifdef _WIN32
+		DeleteCriticalSection(mutex);
+	#else
+		pthread_mutex_destroy(mutex);
+	#endif
+}
+
+
+void threadConditionInit(threadCondition *const restrict cond){
+	#ifdef _WIN32
+		InitializeConditionVariable(cond);
+	#else
+		pthread_cond_init(cond, NULL);
+	#endif
+}
+
+/*
+** Atomically unlock "mutex" and wait for the condition to be
+** signalled. The mutex is locked again before we return.
+*/
+void threadConditionWait(threadCondition *const restrict cond, threadMutex *const restrict mutex){
+	#ifdef _WIN32
+		SleepConditionVariableCS(cond, mutex, INFINITE);
+	#else
+		pthread_cond_wait(cond, mutex);
+	#endif
+}
+
+void threadConditionSignal(threadCondition *const restrict cond){
+	#ifdef _WIN32
+		WakeConditionVariable(cond);
+	#else
+		pthread_cond_signal(cond);
+	#endif
+}
+
+void threadConditionBroadcast(threadCondition *const restrict cond){
+	#ifdef _WIN32
+		WakeAllConditionVariable(cond);
+	#else
+		pthread_cond_broadcast(cond);
+	#endif
+}
+
+void threadConditionDelete(threadCondition *const restrict cond){
+	#ifdef _WIN32
+		// Windows condition variables don't need to be destroyed.
+		(void)cond;
+	#else
+		pthread_cond_destroy(cond);
+	#endif
+}
+
+
+/*
+** Spin until we acquire the lock. These should only be used for
+** very short critical sections, so we just yield if it's taken.
+*/
+void threadSpinlockLock(threadSpinlock *const restrict lock){
+	while(atomic_flag_test_and_set_explicit(lock, memory_order_acquire)){
+		threadYield();
+	}
+}
+
+void threadSpinlockUnlock(threadSpinlock *const restrict lock){
+	atomic_flag_clear_explicit(lock, memory_order_release);
+}
\ No newline at end of file
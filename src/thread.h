@@ -0,0 +1,65 @@
+#ifndef thread_h
+#define thread_h
+
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "utilTypes.h"
+
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define VC_EXTRALEAN
+	#include <windows.h>
+
+	typedef HANDLE thread;
+	typedef CRITICAL_SECTION threadMutex;
+	typedef CONDITION_VARIABLE threadCondition;
+
+	typedef DWORD threadReturn_t;
+	#define THREAD_CALL WINAPI
+#else
+	#include <pthread.h>
+
+	typedef pthread_t thread;
+	typedef pthread_mutex_t threadMutex;
+	typedef pthread_cond_t threadCondition;
+
+	typedef void *threadReturn_t;
+	#define THREAD_CALL
+#endif
+
+#define THREAD_RETURN_SUCCESS ((threadReturn_t)0)
+
+// Spinlocks don't need to be initialized or deleted, so
+// they can be used to guard statically allocated data.
+typedef atomic_flag threadSpinlock;
+#define THREAD_SPINLOCK_INIT ATOMIC_FLAG_INIT
+
+
+// Functions that threads begin executing should look like this.
+typedef threadReturn_t (THREAD_CALL *threadFunction)(void *const arg);
+
+
+return_t threadCreate(thread *const restrict t, threadFunction func, void *const arg);
+void threadJoin(const thread t);
+size_t threadNumProcessors();
+void threadYield();
+
+void threadMutexInit(threadMutex *const restrict mutex);
+void threadMutexLock(threadMutex *const restrict mutex);
+void threadMutexUnlock(threadMutex *const restrict mutex);
+void threadMutexDelete(threadMutex *const restrict mutex);
+
+void threadConditionInit(threadCondition *const restrict cond);
+void threadConditionWait(threadCondition *const restrict cond, threadMutex *const restrict mutex);
+void threadConditionSignal(threadCondition *const restrict cond);
+void threadConditionBroadcast(threadCondition *const restrict cond);
+void threadConditionDelete(threadCondition *const restrict cond);
+
+void threadSpinlockLock(threadSpinlock *const restrict lock);
+void threadSpinlockUnlock(threadSpinlock *const restrict lock);
+
+
+#endif
\ No newline at end of file
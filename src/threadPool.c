@@ -0,0 +1,167 @@
+#include "threadPool.h"
+
+
+#include "memoryManager.h"
+#include "memoryArena.h"
+
+
+// Forward-declare any helper functions!
+static void runJobs(threadPool *const pool, const size_t threadIndex);
+static threadReturn_t THREAD_CALL workerMain(void *const arg);
+
+
+/*
+** Start a pool with "numWorkers" worker threads. The pool
+** is still usable if this is zero, but every job will be
+** executed serially by the thread that submits the batch.
+*/
+return_t threadPoolInit(threadPool *const restrict pool, const size_t numWorkers){
+	size_t i;
+
+	pool->workers = NULL;
+	pool->numWorkers = 0;
+
+	threadMutexInit(&pool->lock);
+	threadConditionInit(&pool->workReady);
+	threadConditionInit(&pool->workDone);
+
+	pool->job = NULL;
+	pool->args = NULL;
+	pool->numJobs = 0;
+	atomic_init(&pool->nextJob, 0);
+	pool->numBusy = 0;
+	pool->batch = 0;
+	pool->quit = 0;
+
+	if(numWorkers > 0){
+		pool->workers = memoryManagerGlobalAlloc(numWorkers * sizeof(*pool->workers));
+		if(pool->workers == NULL){
+			/** MALLOC FAILED **/
+			return(0);
+		}
+
+		// The submitting thread always uses index 0,
+		// so the workers' indices start from 1.
+		for(i = 0; i < numWorkers; ++i){
+			threadPoolWorker *const worker = &pool->workers[i];
+			worker->pool = pool;
+			worker->index = i + 1;
+			if(!threadCreate(&worker->handle, &workerMain, worker)){
+				break;
+			}
+			++pool->numWorkers;
+		}
+	}
+
+	return(pool->numWorkers == numWorkers);
+}
+
+
+// Return the number of threads that may be executing jobs.
+size_t threadPoolNumThreads(const threadPool *const pool){
+	return(pool->numWorkers + 1);
+}
+
+/*
+** Run "numJobs" jobs across the pool's threads and
+** wait for all of them to finish before returning.
+*/
+void threadPoolRun(threadPool *const pool, threadPoolJob job, void *const args, const size_t numJobs){
+	// There's no point waking the workers if there's only one job.
+	if(pool->numWorkers == 0 || numJobs <= 1){
+		size_t i;
+		for(i = 0; i < numJobs; ++i){
+			(*job)(args, i, 0);
+		}
+		return;
+	}
+
+	threadMutexLock(&pool->lock);
+	pool->job = job;
+	pool->args = args;
+	pool->numJobs = numJobs;
+	atomic_store(&pool->nextJob, 0);
+	pool->numBusy = pool->numWorkers;
+	++pool->batch;
+	threadConditionBroadcast(&pool->workReady);
+	threadMutexUnlock(&pool->lock);
+
+	// Help out while we're waiting.
+	runJobs(pool, 0);
+
+	threadMutexLock(&pool->lock);
+	while(pool->numBusy > 0){
+		threadConditionWait(&pool->workDone, &pool->lock);
+	}
+	threadMutexUnlock(&pool->lock);
+}
+
+
+// Stop each of the pool's workers and wait for them to exit.
+void threadPoolDelete(threadPool *const restrict pool){
+	if(pool->workers != NULL){
+		size_t i;
+
+		threadMutexLock(&pool->lock);
+		pool->quit = 1;
+		threadConditionBroadcast(&pool->workReady);
+		threadMutexUnlock(&pool->lock);
+
+		for(i = 0; i < pool->numWorkers; ++i){
+			threadJoin(pool->workers[i].handle);
+		}
+		memoryManagerGlobalFree(pool->workers);
+	}
+
+	threadConditionDelete(&pool->workDone);
+	threadConditionDelete(&pool->workReady);
+	threadMutexDelete(&pool->lock);
+}
+
+
+// Keep taking jobs from the current batch until there are none left.
+static void runJobs(threadPool *const pool, const size_t threadIndex){
+	size_t i = atomic_fetch_add(&pool->nextJob, 1);
+	while(i < pool->numJobs){
+		(*pool->job)(pool->args, i, threadIndex);
+		i = atomic_fetch_add(&pool->nextJob, 1);
+	}
+}
+
+static threadReturn_t THREAD_CALL workerMain(void *const arg){
+	const threadPoolWorker *const worker = (threadPoolWorker *)arg;
+	threadPool *const pool = worker->pool;
+	size_t batch = 0;
+
+	threadMutexLock(&pool->lock);
+	for(;;){
+		// Sleep until a new batch has been submitted.
+		while(pool->batch == batch && !pool->quit){
+			threadConditionWait(&pool->workReady, &pool->lock);
+		}
+		if(pool->quit){
+			break;
+		}
+		batch = pool->batch;
+		threadMutexUnlock(&pool->lock);
+
+		runJobs(pool, worker->index);
+
+		threadMutexLock(&pool->lock);
+		// The last worker to finish lets the submitting thread know.
+		--pool->numBusy;
+		if(pool->numBusy == 0){
+			threadConditionSignal(&pool->workDone);
+		}
+	}
+	threadMutexUnlock(&pool->lock);
+
+	// Our scratch memory and any small blocks
+	// we've cached would leak otherwise.
+	memArenaThreadDelete();
+	#ifdef MEMORY_GLOBAL_MANAGER_THREAD_CACHE
+	memoryManagerGlobalFlushCache();
+	#endif
+
+	return(THREAD_RETURN_SUCCESS);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef threadPool_h
+#define threadPool_h
+
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#include "thread.h"
+
+#include "utilTypes.h"
+
+
+// Jobs are identified by their index in the current batch. The
+// thread index is in the range [0, threadPoolNumThreads(pool)),
+// so it can be used to index into per-thread buffers.
+typedef void (*threadPoolJob)(void *const args, const size_t jobIndex, const size_t threadIndex);
+
+typedef struct threadPool threadPool;
+typedef struct threadPoolWorker {
+	thread handle;
+	threadPool *pool;
+	size_t index;
+} threadPoolWorker;
+
+/*
+** A thread pool is used to run a batch of independent jobs
+** in parallel. The thread that submits the batch will also
+** help to run its jobs, and waits for all of them to finish.
+*/
+typedef struct threadPool {
+	threadPoolWorker *workers;
+	size_t numWorkers;
+
+	threadMutex lock;
+	// Signalled when a new batch is submitted or the pool is deleted.
+	threadCondition workReady;
+	// Signalled when the last worker finishes the current batch.
+	threadCondition workDone;
+
+	// The batch of jobs currently being executed.
+	threadPoolJob job;
+	void *args;
+	size_t numJobs;
+	atomic_size_t nextJob;
+
+	// Number of workers still running the current batch.
+	size_t numBusy;
+	// Incremented whenever a new batch is submitted.
+	size_t batch;
+	return_t quit;
+} threadPool;
+
+
+return_t threadPoolInit(threadPool *const restrict pool, const size_t numWorkers);
+
+size_t threadPoolNumThreads(const threadPool *const pool);
+void threadPoolRun(threadPool *const pool, threadPoolJob job, void *const args, const size_t numJobs);
+
+void threadPoolDelete(threadPool *const restrict pool);
+
+
+#endif
\ No newline at end of file
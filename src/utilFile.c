@@ -261,7 +261,7 @@ double readDoubleLE(FILE *const restrict file){
 	byte_t bytes[8];
 	bitDouble val;
 	fread((void *)bytes, sizeof(bytes), 1, file);
-	val.l =
+	val.i =
 		((uint64_t)bytes[0] << 56) |
 		((uint64_t)bytes[1] << 48) |
 		((uint64_t)bytes[2] << 40) |
@@ -270,14 +270,14 @@ double readDoubleLE(FILE *const restrict file){
 		((uint64_t)bytes[5] << 16) |
 		((uint64_t)bytes[6] << 8)  |
 		(uint64_t)bytes[7];
-	return(val.d);
+	return(val.f);
 }
 
 double readDoubleBE(FILE *const restrict file){
 	byte_t bytes[8];
 	bitDouble val;
 	fread((void *)bytes, sizeof(bytes), 1, file);
-	val.l =
+	val.i =
 		(uint64_t)bytes[0]         |
 		((uint64_t)bytes[1] << 8)  |
 		((uint64_t)bytes[2] << 16) |
@@ -286,5 +286,5 @@ double readDoubleBE(FILE *const restrict file){
 		((uint64_t)bytes[5] << 40) |
 		((uint64_t)bytes[6] << 48) |
 		((uint64_t)bytes[7] << 56);
-	return(val.d);
+	return(val.f);
 }
\ No newline at end of file
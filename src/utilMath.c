@@ -356,7 +356,7 @@ float planePointDist(
 	const float x, const float y, const float z
 ){
 
-	return(vec3Dot((vec3 *)plane, x, y, z) + plane->w);
+	return(plane->x*x + plane->y*y + plane->z*z + plane->w);
 }
 
 /*
@@ -404,7 +404,7 @@ void planePointProject(
 
 	// point - dist * planeNormal
 	vec3FmaOut(
-		-planePointDist(plane, point),
+		-planePointDistVec3(plane, point),
 		(vec3 *)plane, point, out
 	);
 }
@@ -422,7 +422,7 @@ void planePointProjectAlt(
 
 	// point - dist * planeNormal
 	vec3FmaOut(
-		-planePointDistAlt(planeNormal, planePoint, point),
+		-planePointDistVec3Alt(planeNormal, planePoint, point),
 		planeNormal, point, out
 	);
 }
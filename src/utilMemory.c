@@ -1,6 +1,46 @@
 #include "utilMemory.h"
 
 
+#include <string.h>
+
+
+#ifdef MEMORY_REGION_LARGE_PAGES
+#include <stdio.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define VC_EXTRALEAN
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/mman.h>
+#endif
+
+// Explicit huge pages can be pre-faulted by the kernel when they're
+// mapped. Transparent ones need to be touched after calling madvise.
+#if defined(MEMORY_REGION_PREFAULT) && defined(MAP_POPULATE)
+	#define MEMORY_REGION_MAP_POPULATE MAP_POPULATE
+#else
+	#define MEMORY_REGION_MAP_POPULATE 0
+#endif
+#endif
+
+
+// Blocks on a lock-free stack may still be read by a thread that
+// lost a race to pop them, so we access their next pointers atomically.
+#define memoryFreeStackBlockGetNext(block) ((_Atomic(void *) *)(block))
+
+
+// Forward-declare any helper functions!
+static void magazineCheckGeneration(memoryMagazine *const restrict magazine, const size_t generation);
+#ifdef MEMORY_REGION_LARGE_PAGES
+#ifdef MEMORY_REGION_PREFAULT
+static void prefaultPages(void *const restrict memory, const size_t size);
+#endif
+static size_t countLargePages(const void *const restrict memory, const size_t size);
+#endif
+
+
 // These low level functions will almost
 // certainly break things. The only time
 // we can expect them to work is when we
@@ -115,20 +155,350 @@ void memoryRegionInsertAfter(memoryRegion *region, memoryRegion *const newRegion
 }
 
 
+#ifdef MEMORY_REGION_LARGE_PAGES
+/*
+** Allocate memory for a region, backing it with large pages
+** if we can. The size is rounded up to a multiple of the large
+** page size, so "memoryRegionGetAllocSize" should be used to
+** find out how much memory we actually allocated.
+**
+** On Linux, we first try to take pages from the kernel's pool
+** of huge pages. This is usually empty unless it was set up
+** by the user, in which case we fall back to normal pages and
+** ask for transparent huge pages instead. These need the region
+** to be aligned to the large page size, so we map an extra page
+** and trim whatever we don't need. On Windows, large pages need
+** the "Lock pages in memory" privilege, which most users won't
+** have, so we fall back to regular pages if VirtualAlloc fails.
+*/
+void *memoryRegionAlloc(const size_t size){
+	const size_t allocSize = memoryRegionGetAllocSize(size);
+	void *memory;
+
+	#ifdef _WIN32
+	const size_t largePageSize = GetLargePageMinimum();
+	if(largePageSize > 0 && allocSize % largePageSize == 0){
+		// Large pages can't be paged out, so they're already resident.
+		memory = VirtualAlloc(NULL, allocSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if(memory != NULL){
+			return(memory);
+		}
+	}
+
+	memory = VirtualAlloc(NULL, allocSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	if(memory == NULL){
+		/** MALLOC FAILED **/
+		return(NULL);
+	}
+	#else
+	#ifdef MAP_HUGETLB
+	memory = mmap(
+		NULL, allocSize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MEMORY_REGION_MAP_POPULATE, -1, 0
+	);
+	if(memory != MAP_FAILED){
+		return(memory);
+	}
+	#endif
+
+	memory = mmap(NULL, allocSize + MEMORY_LARGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(memory == MAP_FAILED){
+		/** MALLOC FAILED **/
+		return(NULL);
+	}else{
+		// Unmap the memory before and after the aligned region.
+		const size_t headSize = (MEMORY_LARGE_PAGE_SIZE - ((uintptr_t)memory & (MEMORY_LARGE_PAGE_SIZE - 1))) & (MEMORY_LARGE_PAGE_SIZE - 1);
+		if(headSize > 0){
+			munmap(memory, headSize);
+		}
+		munmap(memoryAddPointer(memory, headSize + allocSize), MEMORY_LARGE_PAGE_SIZE - headSize);
+		memory = memoryAddPointer(memory, headSize);
+	}
+	#ifdef MADV_HUGEPAGE
+	madvise(memory, allocSize, MADV_HUGEPAGE);
+	#endif
+	#endif
+
+	#ifdef MEMORY_REGION_PREFAULT
+	prefaultPages(memory, allocSize);
+	#endif
+
+	return(memory);
+}
+
+// Free a region allocated by "memoryRegionAlloc".
+void memoryRegionFree(void *const restrict memory, const size_t size){
+	#ifdef _WIN32
+	VirtualFree(memory, 0, MEM_RELEASE);
+	#else
+	munmap(memory, memoryRegionGetAllocSize(size));
+	#endif
+}
+
+/*
+** Return the number of bytes in a sequence of regions
+** that are currently backed by large pages. Transparent
+** huge pages are only used for memory that has been
+** written to, so this may increase as a region is used.
+*/
+size_t memoryRegionLargePageBytes(const memoryRegion *region){
+	size_t largeBytes = 0;
+
+	for(; region != NULL; region = region->next){
+		largeBytes += countLargePages(region->start, memoryRegionGetAllocSize(memoryRegionFullSize(region)));
+	}
+
+	return(largeBytes);
+}
+
+// Print how much of a sequence of regions is backed by large pages.
+void memoryRegionPrintPages(const memoryRegion *region){
+	const memoryRegion *curRegion = region;
+	size_t totalBytes = 0;
+
+	for(; curRegion != NULL; curRegion = curRegion->next){
+		totalBytes += memoryRegionGetAllocSize(memoryRegionFullSize(curRegion));
+	}
+
+	printf(
+		"Large Pages: "PRINTF_SIZE_T" of "PRINTF_SIZE_T" bytes\n",
+		memoryRegionLargePageBytes(region), totalBytes
+	);
+}
+#endif
+
+
 /*
-** Free a sequence of memory regions that were
-** allocated using the regular memory functions.
+** Free a sequence of memory regions that
+** were allocated using "memoryRegionAlloc".
 */
 void memoryDeleteRegions(memoryRegion *region){
 	// Free every memory region in the allocator.
 	while(region != NULL){
 		memoryRegion *const next = region->next;
-
-		#if defined(_WIN32) || !defined(MEMORY_LOW_LEVEL)
-		memoryFree(region->start);
-		#else
-		memoryFree(region->start, memoryRegionFullSize(region));
-		#endif
+		memoryRegionFree(region->start, memoryRegionFullSize(region));
 		region = next;
 	}
+}
+
+
+/*
+** Set the first block of a lock-free stack. This
+** is not safe to call while the stack is in use.
+*/
+void memoryFreeStackInit(memoryFreeStack *const restrict stack, void *const restrict block){
+	atomic_store_explicit(stack, memoryTaggedPointerInit(block, 0), memory_order_relaxed);
+}
+
+// Remove the first block from a lock-free stack.
+void *memoryFreeStackPop(memoryFreeStack *const restrict stack){
+	memoryTaggedPointer head = atomic_load_explicit(stack, memory_order_acquire);
+
+	for(;;){
+		void *const block = memoryTaggedPointerGetPointer(head);
+		memoryTaggedPointer next;
+
+		if(block == NULL){
+			return(NULL);
+		}
+		// Another thread may take this block before we're done,
+		// in which case its next pointer could be garbage. The
+		// head's tag will have changed though, so the swap fails.
+		next = memoryTaggedPointerInit(
+			atomic_load_explicit(memoryFreeStackBlockGetNext(block), memory_order_relaxed),
+			memoryTaggedPointerGetTag(head) + 1
+		);
+		if(atomic_compare_exchange_weak_explicit(
+			stack, &head, next, memory_order_acquire, memory_order_acquire
+		)){
+			return(block);
+		}
+	}
+}
+
+/*
+** Add a chain of blocks to the front of a lock-free stack.
+** The blocks from "first" to "last" should already be linked.
+*/
+void memoryFreeStackPush(memoryFreeStack *const restrict stack, void *const first, void *const last){
+	memoryTaggedPointer head = atomic_load_explicit(stack, memory_order_relaxed);
+	memoryTaggedPointer newHead;
+
+	do {
+		atomic_store_explicit(
+			memoryFreeStackBlockGetNext(last), memoryTaggedPointerGetPointer(head), memory_order_relaxed
+		);
+		newHead = memoryTaggedPointerInit(first, memoryTaggedPointerGetTag(head));
+	} while(!atomic_compare_exchange_weak_explicit(
+		stack, &head, newHead, memory_order_release, memory_order_relaxed
+	));
+}
+
+/*
+** Link an array of blocks together so they can be pushed
+** onto a lock-free stack at once. We return the last block.
+*/
+void *memoryFreeStackLink(void **const restrict blocks, const size_t numBlocks){
+	void **curBlock = blocks;
+	void **const lastBlock = &blocks[numBlocks - 1];
+
+	for(; curBlock < lastBlock; ++curBlock){
+		atomic_store_explicit(memoryFreeStackBlockGetNext(*curBlock), curBlock[1], memory_order_relaxed);
+	}
+
+	return(*lastBlock);
+}
+
+
+// Return a generation that no allocator has used yet.
+size_t memoryMagazineNewGeneration(){
+	static atomic_size_t generation;
+	// Magazines start at zero, so we skip it.
+	return(atomic_fetch_add_explicit(&generation, 1, memory_order_relaxed) + 1);
+}
+
+/*
+** Take the most recently freed block from a magazine. If it's
+** empty, we return NULL and the caller should use the allocator.
+*/
+void *memoryMagazineAlloc(memoryMagazine *const restrict magazine, const size_t generation){
+	magazineCheckGeneration(magazine, generation);
+	if(magazine->numBlocks > 0){
+		return(magazine->blocks[--magazine->numBlocks]);
+	}
+
+	return(NULL);
+}
+
+/*
+** Add a block to a magazine. If the magazine is full, we
+** return half of it to the allocator's free stack first.
+** We return the number of blocks that were pushed.
+*/
+size_t memoryMagazineFree(memoryMagazine *const restrict magazine, memoryFreeStack *const restrict stack, const size_t generation, void *const restrict block){
+	size_t numPushed = 0;
+
+	magazineCheckGeneration(magazine, generation);
+	if(magazine->numBlocks >= MEMORY_MAGAZINE_SIZE){
+		numPushed = MEMORY_MAGAZINE_SIZE/2;
+		memoryFreeStackPush(stack, magazine->blocks[0], memoryFreeStackLink(magazine->blocks, numPushed));
+		// Keep the blocks that were freed most recently,
+		// as they're the most likely to still be cached.
+		memmove(
+			magazine->blocks, &magazine->blocks[numPushed],
+			(MEMORY_MAGAZINE_SIZE - numPushed) * sizeof(*magazine->blocks)
+		);
+		magazine->numBlocks = MEMORY_MAGAZINE_SIZE - numPushed;
+	}
+	magazine->blocks[magazine->numBlocks++] = block;
+
+	return(numPushed);
+}
+
+/*
+** Return every block in a magazine to the allocator's free stack.
+** We return the number of blocks that were pushed.
+*/
+size_t memoryMagazineFlush(memoryMagazine *const restrict magazine, memoryFreeStack *const restrict stack, const size_t generation){
+	size_t numPushed;
+
+	magazineCheckGeneration(magazine, generation);
+	numPushed = magazine->numBlocks;
+	if(numPushed > 0){
+		memoryFreeStackPush(stack, magazine->blocks[0], memoryFreeStackLink(magazine->blocks, numPushed));
+		magazine->numBlocks = 0;
+	}
+
+	return(numPushed);
+}
+
+
+#ifdef MEMORY_REGION_LARGE_PAGES
+#ifdef MEMORY_REGION_PREFAULT
+// Write to every page so they're all faulted in now.
+static void prefaultPages(void *const restrict memory, const size_t size){
+	volatile byte_t *page = memory;
+	const volatile byte_t *const end = memoryAddPointer(memory, size);
+
+	for(; page < end; page += MEMORY_SMALL_PAGE_SIZE){
+		*page = 0;
+	}
+}
+#endif
+
+/*
+** Return the number of bytes in the range "memory" to
+** "memory + size" that are backed by large pages. On Linux,
+** we find this by reading our mappings from "smaps". We
+** count the whole mapping if it uses explicit huge pages,
+** otherwise we only count its transparent huge pages.
+*/
+static size_t countLargePages(const void *const restrict memory, const size_t size){
+	size_t largeBytes = 0;
+
+	#if defined(_WIN32)
+	const byte_t *page = memory;
+	const byte_t *const end = memoryAddPointer(memory, size);
+
+	for(; page < end; page += MEMORY_LARGE_PAGE_SIZE){
+		PSAPI_WORKING_SET_EX_INFORMATION info;
+		info.VirtualAddress = (PVOID)page;
+		if(
+			QueryWorkingSetEx(GetCurrentProcess(), &info, sizeof(info)) &&
+			info.VirtualAttributes.Valid && info.VirtualAttributes.LargePage
+		){
+			largeBytes += MEMORY_LARGE_PAGE_SIZE;
+		}
+	}
+	#elif defined(__linux__)
+	FILE *const smaps = fopen("/proc/self/smaps", "r");
+	if(smaps != NULL){
+		const uintptr_t start = (uintptr_t)memory;
+		const uintptr_t end = start + size;
+		// The number of bytes in the current mapping that overlap
+		// the range. This is zero if the mapping is outside of it.
+		size_t overlap = 0;
+		char line[256];
+
+		while(fgets(line, sizeof(line), smaps) != NULL){
+			unsigned long long mapStart;
+			unsigned long long mapEnd;
+			unsigned long pageSize;
+
+			// Each mapping begins with a line containing its address range.
+			if(sscanf(line, "%llx-%llx ", &mapStart, &mapEnd) == 2){
+				if(mapStart < end && mapEnd > start){
+					overlap = ((mapEnd < end) ? mapEnd : end) - ((mapStart > start) ? mapStart : start);
+				}else{
+					overlap = 0;
+				}
+			}else if(overlap > 0){
+				if(sscanf(line, "KernelPageSize: %lu kB", &pageSize) == 1){
+					if(pageSize * MEMORY_KIBIBYTE >= MEMORY_LARGE_PAGE_SIZE){
+						largeBytes += overlap;
+						overlap = 0;
+					}
+				}else if(sscanf(line, "AnonHugePages: %lu kB", &pageSize) == 1){
+					pageSize *= MEMORY_KIBIBYTE;
+					largeBytes += (pageSize < overlap) ? pageSize : overlap;
+					overlap = 0;
+				}
+			}
+		}
+
+		fclose(smaps);
+	}
+	#endif
+
+	return(largeBytes);
+}
+#endif
+
+
+// Empty a magazine if its allocator has been cleared since it was last used.
+static void magazineCheckGeneration(memoryMagazine *const restrict magazine, const size_t generation){
+	if(magazine->generation != generation){
+		magazine->numBlocks = 0;
+		magazine->generation = generation;
+	}
 }
\ No newline at end of file
@@ -4,7 +4,10 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <limits.h>
+#include <stdatomic.h>
 
+#include "settingsMemory.h"
 #include "utilTypes.h"
 
 
@@ -45,13 +48,68 @@
 #define memoryGetRequiredSize(size) ((size) + sizeof(memoryRegion))
 
 // Get the size of the data controlled by a memory region.
-#define memoryRegionDataSize(region) ((uintptr_t)memorySubPointer((region)->start, (region)))
+#define memoryRegionDataSize(region) ((uintptr_t)memorySubPointer((region), (region)->start))
 // Get the total size of a memory region.
-#define memoryRegionFullSize(region) (((uintptr_t)memorySubPointer((region)->start, (region))) + sizeof(memoryRegion))
+#define memoryRegionFullSize(region) (((uintptr_t)memorySubPointer((region), (region)->start)) + sizeof(memoryRegion))
+
+// This is the size of the large pages we try to use for regions.
+#ifndef MEMORY_LARGE_PAGE_SIZE
+	#define MEMORY_LARGE_PAGE_SIZE (2 * MEMORY_MEBIBYTE)
+#endif
+// Pre-faulting writes to one byte in every page of this size.
+#ifndef MEMORY_SMALL_PAGE_SIZE
+	#define MEMORY_SMALL_PAGE_SIZE (4 * MEMORY_KIBIBYTE)
+#endif
+// Return the number of bytes that will actually be allocated for
+// a region of "size" bytes. Large pages can't be split, so we may
+// as well let the allocator use all of the last one.
+#ifdef MEMORY_REGION_LARGE_PAGES
+	#define memoryRegionGetAllocSize(size) \
+		(((size) + (MEMORY_LARGE_PAGE_SIZE - 1)) & ~((size_t)(MEMORY_LARGE_PAGE_SIZE - 1)))
+#else
+	#define memoryRegionGetAllocSize(size) (size)
+#endif
 
 // This can be used to exit from memory allocator loops early.
 #define memoryLoopExit(allocator, node) goto allocator##_EXIT_LOOP_##node
 
+// Lock-free free lists store a tag alongside the pointer to their
+// first block, which is incremented whenever a block is removed.
+// This way, a compare and swap will fail if another thread removed
+// the block and then added it back in the meantime (the ABA problem).
+// On 64-bit systems, we assume that addresses only use 48 bits.
+#if UINTPTR_MAX == UINT32_MAX
+	typedef uint_least64_t memoryTaggedPointer;
+	#define MEMORY_TAGGED_POINTER_BITS 32
+#else
+	typedef uintptr_t memoryTaggedPointer;
+	#define MEMORY_TAGGED_POINTER_BITS 48
+#endif
+#define MEMORY_TAGGED_POINTER_MASK ((((memoryTaggedPointer)1) << MEMORY_TAGGED_POINTER_BITS) - 1)
+// The tag needs enough bits that it's unlikely to wrap around
+// while a thread is preempted in the middle of popping a block.
+_Static_assert(
+	sizeof(memoryTaggedPointer) * CHAR_BIT >= MEMORY_TAGGED_POINTER_BITS + 16,
+	"Tagged pointers need at least 16 bits for the tag."
+);
+// Pointers must fit in their bits. We only assume
+// that they use fewer bits on 64-bit systems.
+_Static_assert(
+	sizeof(void *) * CHAR_BIT <= MEMORY_TAGGED_POINTER_BITS || sizeof(void *) == 8,
+	"Tagged pointers can't store every bit of the pointer."
+);
+
+#define memoryTaggedPointerInit(pointer, tag) \
+	(((memoryTaggedPointer)(uintptr_t)(pointer)) | (((memoryTaggedPointer)(tag)) << MEMORY_TAGGED_POINTER_BITS))
+#define memoryTaggedPointerGetPointer(tagged) ((void *)(uintptr_t)((tagged) & MEMORY_TAGGED_POINTER_MASK))
+#define memoryTaggedPointerGetTag(tagged) ((tagged) >> MEMORY_TAGGED_POINTER_BITS)
+
+// This is the number of free blocks each thread
+// may keep for itself when using a magazine.
+#ifndef MEMORY_MAGAZINE_SIZE
+	#define MEMORY_MAGAZINE_SIZE 32
+#endif
+
 // The main reason for using these flags
 // are for when we want to enable or
 // disable concurrent heap allocations.
@@ -85,6 +143,24 @@ typedef struct memoryRegion {
 } memoryRegion;
 
 
+// The head of a lock-free stack of free blocks. Each
+// block stores a pointer to the next in its first bytes.
+typedef _Atomic(memoryTaggedPointer) memoryFreeStack;
+
+// Concurrent allocators can be given a magazine, which
+// stores a small number of free blocks for a single thread.
+// Most allocations and frees can then be performed without
+// touching the allocator's free list, which is shared.
+typedef struct memoryMagazine {
+	void *blocks[MEMORY_MAGAZINE_SIZE];
+	size_t numBlocks;
+	// Allocators get a new generation whenever they are
+	// initialised or cleared. If this doesn't match the
+	// allocator's, the blocks have already been freed.
+	size_t generation;
+} memoryMagazine;
+
+
 void *memoryAlloc(const size_t size);
 #if defined(_WIN32) || !defined(MEMORY_LOW_LEVEL)
 void *memoryRealloc(void *const restrict block, const size_t size);
@@ -98,7 +174,30 @@ void memoryRegionAppend(memoryRegion **region, memoryRegion *const newRegion, vo
 void memoryRegionInsertBefore(memoryRegion **region, memoryRegion *const newRegion, void *const memory);
 void memoryRegionInsertAfter(memoryRegion *region, memoryRegion *const newRegion, void *const memory);
 
+#ifdef MEMORY_REGION_LARGE_PAGES
+void *memoryRegionAlloc(const size_t size);
+void memoryRegionFree(void *const restrict memory, const size_t size);
+size_t memoryRegionLargePageBytes(const memoryRegion *region);
+void memoryRegionPrintPages(const memoryRegion *region);
+#else
+	#define memoryRegionAlloc(size) memoryAlloc(size)
+	#if defined(_WIN32) || !defined(MEMORY_LOW_LEVEL)
+		#define memoryRegionFree(memory, size) memoryFree(memory)
+	#else
+		#define memoryRegionFree(memory, size) memoryFree(memory, size)
+	#endif
+#endif
 void memoryDeleteRegions(memoryRegion *region);
 
+void memoryFreeStackInit(memoryFreeStack *const restrict stack, void *const restrict block);
+void *memoryFreeStackPop(memoryFreeStack *const restrict stack);
+void memoryFreeStackPush(memoryFreeStack *const restrict stack, void *const first, void *const last);
+void *memoryFreeStackLink(void **const restrict blocks, const size_t numBlocks);
+
+size_t memoryMagazineNewGeneration();
+void *memoryMagazineAlloc(memoryMagazine *const restrict magazine, const size_t generation);
+size_t memoryMagazineFree(memoryMagazine *const restrict magazine, memoryFreeStack *const restrict stack, const size_t generation, void *const restrict block);
+size_t memoryMagazineFlush(memoryMagazine *const restrict magazine, memoryFreeStack *const restrict stack, const size_t generation);
+
 
 #endif
\ No newline at end of file